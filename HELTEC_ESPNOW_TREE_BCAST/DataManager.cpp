@@ -5,12 +5,22 @@
 #include "TreeNetwork.h"
 #include "MenuSystem.h"
 #include "OutputPolicy.h"
+#include "bulk_transfer.h"
+#include "tree_ota.h"
+#include "parent_failover.h"
+#include "bit_allocator.h"
+#include "child_table.h"
+#include "uplink.h"
+#include "report_aggregation.h"
+#include "io_slice.h"
+#include "heap_guard.h"
 #include <Preferences.h>
+#include <esp_rom_crc.h>
 
 // Logging macros
 #define MODULE_TITLE       "DATAMGR"
 #define MODULE_DEBUG_LEVEL 1
-#define dataLog(msg, lvl) debugPrint(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+#define dataLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
 
 // ============================================================================
 // SINGLETON IMPLEMENTATION
@@ -23,25 +33,33 @@ DataManager& DataManager::getInstance() {
 
 DataManager::DataManager() : 
     sequenceCounter(0),
+    ioSnapshotSeq(0),
+    ioWriterMux(portMUX_INITIALIZER_UNLOCKED),
     aggregatedDeviceCount(0),
-    preferences(nullptr) {
+    aggregatedUpdateSeq(0),
+    aggregateMux(portMUX_INITIALIZER_UNLOCKED),
+    preferences(nullptr),
+    nodeConfigSlot(1) {
     // Initialize MAC address to zeros
     memset(nodeMac, 0, 6);
-    memset(lastSenderMAC, 0, 6);
     
     // Initialize device data
     memset(&myDeviceData, 0, sizeof(DeviceSpecificData));
     
-    // Initialize distributed I/O data
-    memset(&distributedIOData, 0, sizeof(DistributedIOData));
+    // Initialize distributed I/O snapshot buffers
+    memset(ioSnapshot, 0, sizeof(ioSnapshot));
     
     // Initialize aggregation arrays
+#if NODE_ROLE_HAS_ROOT
     memset(globalDataArray, 0, sizeof(globalDataArray));
     memset(deviceHIDArray, 0, sizeof(deviceHIDArray));
     memset(deviceLastSeen, 0, sizeof(deviceLastSeen));
+    memset(deviceUpdateSeq, 0, sizeof(deviceUpdateSeq));
+#endif
     
     // Create preferences object
     preferences = new Preferences();
+    resetNodeConfig();
 }
 
 // ============================================================================
@@ -53,24 +71,25 @@ void DataManager::initialize() {
     WiFi.macAddress(nodeMac);
     
     // Initialize system status
-    systemStatus.currentStatus = "Initializing";
+    updateStatus("Initializing");
     systemStatus.uptime = millis();
     
     // Reset statistics
     resetNetworkStats();
     
-    // Load HID from NVM
-    if (loadHIDFromNVM()) {
-        systemStatus.isRoot = (systemStatus.myHID == ROOT_HID);
+    // Load the configuration record (HID, bit index, pins, policy, radio) in one read
+    loadConfigFromNVM();
+    
+    if (systemStatus.hidConfigured) {
         dataLog("HID loaded from NVM: " + formatHID(systemStatus.myHID) + 
                (systemStatus.isRoot ? " (ROOT)" : ""), 3);
     } else {
         dataLog("No HID configured - device not ready for tree network", 2);
     }
     
-    // Load bit index from NVM
-    if (loadBitIndexFromNVM()) {
+    if (systemStatus.bitIndexConfigured) {
         dataLog("Bit index loaded from NVM: " + String(systemStatus.myBitIndex), 3);
+        updateStatus("Bit index restored: " + String(systemStatus.myBitIndex));
     } else {
         dataLog("No bit index configured", 2);
     }
@@ -87,9 +106,13 @@ void DataManager::getNodeMAC(uint8_t* mac) const {
 // HIERARCHICAL ID MANAGEMENT
 // ============================================================================
 
-bool DataManager::setMyHID(uint16_t hid) {
-    if (hid == 0) {
-        dataLog("Invalid HID: 0", 1);
+bool DataManager::setMyHID(uint16_t hid, bool persist) {
+    if (!treeAddrIsValid(hid)) {
+        dataLog("Invalid HID " + String(hid) + ": expected " TREE_ADDR_RANGE_TEXT, 1);
+        return false;
+    }
+    if (!roleAllowsHID(hid)) {
+        dataLog("HID " + formatHID(hid) + " not allowed for this build's NODE_ROLE", 1);
         return false;
     }
     
@@ -97,7 +120,10 @@ bool DataManager::setMyHID(uint16_t hid) {
     systemStatus.isRoot = (hid == ROOT_HID);
     systemStatus.hidConfigured = true;
     
-    saveHIDToNVM();
+    nodeConfig.hid = hid;
+    if (persist) {
+        saveConfigToNVM();
+    }
     
     dataLog("HID set to: " + formatHID(hid) + (systemStatus.isRoot ? " (ROOT)" : ""), 3);
     
@@ -110,72 +136,35 @@ bool DataManager::setMyHID(uint16_t hid) {
     return true;
 }
 
+/**
+ * Root builds only take the root HID; router and leaf builds take any other
+ */
+bool DataManager::roleAllowsHID(uint16_t hid) const {
+#if NODE_ROLE == NODE_ROLE_ROOT
+    return hid == ROOT_HID;
+#elif NODE_ROLE_HAS_ROOT
+    return true;
+#else
+    return hid != ROOT_HID;
+#endif
+}
+
 bool DataManager::isValidChild(uint16_t childHID) const {
     if (!systemStatus.hidConfigured) return false;
     
-    // Child HID should have this node as parent
-    return isValidParentChild(systemStatus.myHID, childHID);
+    // Child HID should have this node as parent, or be fostered by it
+    return isValidParentChild(systemStatus.myHID, childHID) || failoverIsAdopted(childHID);
 }
 
 bool DataManager::isMyDescendant(uint16_t targetHID) const {
     if (!systemStatus.hidConfigured) return false;
     
-    // Convert HIDs to strings for prefix matching
-    String myHIDStr = String(systemStatus.myHID);
-    String targetHIDStr = String(targetHID);
-    
-    return targetHIDStr.startsWith(myHIDStr) && targetHID != systemStatus.myHID;
-}
-
-void DataManager::saveHIDToNVM() {
-    preferences->begin("tree_network", false);
-    preferences->putUShort("my_hid", systemStatus.myHID);
-    preferences->putBool("hid_configured", systemStatus.hidConfigured);
-    preferences->end();
-    dataLog("HID saved to NVM", 4);
-}
-
-bool DataManager::loadHIDFromNVM() {
-    dataLog("Loading HID from NVM...", 4);
-    
-    if (!preferences->begin("tree_network", true)) {
-        dataLog("ERROR: Failed to open preferences for reading HID", 1);
-        return false;
-    }
-    
-    bool configured = preferences->getBool("hid_configured", false);
-    dataLog("NVM hid_configured flag: " + String(configured ? "true" : "false"), 4);
-    
-    if (configured) {
-        systemStatus.myHID = preferences->getUShort("my_hid", 0);
-        systemStatus.hidConfigured = true;
-        systemStatus.isRoot = (systemStatus.myHID == ROOT_HID);
-        
-        dataLog("NVM HID value: " + String(systemStatus.myHID), 4);
-        
-        if (systemStatus.myHID == 0) {
-            dataLog("Invalid HID loaded from NVM: 0, clearing", 1);
-            systemStatus.hidConfigured = false;
-            systemStatus.isRoot = false;
-        } else {
-            dataLog("HID loaded from NVM: " + String(systemStatus.myHID), 2);
-        }
-    } else {
-        dataLog("No HID configuration found in NVM", 3);
-        systemStatus.myHID = 0;
-        systemStatus.hidConfigured = false;
-        systemStatus.isRoot = false;
-    }
-    
-    preferences->end();
-    return systemStatus.hidConfigured;
+    return treeAddrIsAncestor(systemStatus.myHID, targetHID);
 }
 
 void DataManager::clearHIDFromNVM() {
-    preferences->begin("tree_network", false);
-    preferences->remove("my_hid");
-    preferences->remove("hid_configured");
-    preferences->end();
+    nodeConfig.hid = UNCONFIGURED_HID;
+    saveConfigToNVM();
     
     systemStatus.myHID = 0;
     systemStatus.hidConfigured = false;
@@ -188,7 +177,7 @@ void DataManager::clearHIDFromNVM() {
 // BIT INDEX MANAGEMENT
 // ============================================================================
 
-bool DataManager::setMyBitIndex(uint8_t bitIndex) {
+bool DataManager::setMyBitIndex(uint8_t bitIndex, bool persist) {
     dataLog("setMyBitIndex called with value: " + String(bitIndex), 4);
     
     if (!isValidBitIndex(bitIndex)) {
@@ -200,8 +189,10 @@ bool DataManager::setMyBitIndex(uint8_t bitIndex) {
     systemStatus.myBitIndex = bitIndex;
     systemStatus.bitIndexConfigured = true;
     
-    dataLog("Bit index set in memory, now saving to NVM...", 4);
-    saveBitIndexToNVM();
+    nodeConfig.bitIndex = bitIndex;
+    if (persist) {
+        saveConfigToNVM();
+    }
     
     updateStatus("Bit index set: " + String(bitIndex));
     dataLog("My bit index configured: " + String(bitIndex), 2);
@@ -209,110 +200,279 @@ bool DataManager::setMyBitIndex(uint8_t bitIndex) {
     return true;
 }
 
-void DataManager::saveBitIndexToNVM() {
-    if (!preferences) {
-        dataLog("ERROR: Preferences not initialized, cannot save bit index", 1);
-        return;
-    }
+void DataManager::clearBitIndexFromNVM() {
+    nodeConfig.bitIndex = NODE_CONFIG_NO_BIT_INDEX;
+    saveConfigToNVM();
     
-    dataLog("Saving bit index to NVM: " + String(systemStatus.myBitIndex) + 
-           " (configured: " + String(systemStatus.bitIndexConfigured ? "true" : "false") + ")", 4);
+    systemStatus.myBitIndex = 255;
+    systemStatus.bitIndexConfigured = false;
     
-    if (!preferences->begin("tree_network", false)) {
-        dataLog("ERROR: Failed to open preferences for writing", 1);
-        return;
-    }
+    dataLog("Bit index cleared from NVM", 3);
+}
+
+// ============================================================================
+// COMBINED DEVICE CONFIGURATION
+// ============================================================================
+
+void DataManager::clearAllConfiguration() {
+    systemStatus.hidConfigured = false;
+    systemStatus.myHID = 0;
+    systemStatus.isRoot = false;
+    systemStatus.bitIndexConfigured = false;
+    systemStatus.myBitIndex = 255;
     
-    size_t bytesWritten1 = preferences->putUChar("my_bit_index", systemStatus.myBitIndex);
-    size_t bytesWritten2 = preferences->putBool("bit_idx_conf", systemStatus.bitIndexConfigured);
+    // One record write clears both fields together
+    nodeConfig.hid = UNCONFIGURED_HID;
+    nodeConfig.bitIndex = NODE_CONFIG_NO_BIT_INDEX;
+    saveConfigToNVM();
     
-    preferences->end();
+    updateStatus("All configuration cleared");
+    dataLog("All device configuration cleared", 2);
+}
+
+// ============================================================================
+// PERSISTENT CONFIGURATION RECORD
+// ============================================================================
+
+static const char* CONFIG_NAMESPACE = "tree_network";
+static const char* CONFIG_SLOT_KEYS[2] = {"cfg_a", "cfg_b"};
+
+static void setNodeConfigDefaults(NodeConfigRecord& record) {
+    memset(&record, 0, sizeof(record));
+    record.magic = NODE_CONFIG_MAGIC;
+    record.version = NODE_CONFIG_VERSION;
+    record.length = sizeof(NodeConfigRecord);
+    record.hid = UNCONFIGURED_HID;
+    record.hidFormat = TREE_ADDR_FORMAT_TAG;
+    record.bitIndex = NODE_CONFIG_NO_BIT_INDEX;
+    record.policyFlags = NODE_CFG_POLICY_AUTO_REPORT;
+    record.radioFlags = ENABLE_LONG_RANGE_MODE ? NODE_CFG_RADIO_LONG_RANGE : 0;
+}
+
+void DataManager::resetNodeConfig() {
+    setNodeConfigDefaults(nodeConfig);
+}
+
+uint32_t DataManager::calculateConfigCRC(const NodeConfigRecord& record) const {
+    return esp_rom_crc32_le(0, (const uint8_t*)&record, offsetof(NodeConfigRecord, crc));
+}
+
+bool DataManager::readConfigSlot(const char* key, NodeConfigRecord& record) {
+    uint8_t raw[sizeof(NodeConfigRecord)];
+    size_t len = preferences->getBytesLength(key);
+    if (len < offsetof(NodeConfigRecord, generation) + sizeof(uint32_t) || len > sizeof(raw)) {
+        return false;
+    }
+    preferences->getBytes(key, raw, len);
     
-    dataLog("Bit index saved to NVM: " + String(systemStatus.myBitIndex) + 
-           " (bytes written: " + String(bytesWritten1) + ", " + String(bytesWritten2) + ")", 3);
+    const NodeConfigRecord* stored = (const NodeConfigRecord*)raw;
+    if (stored->magic != NODE_CONFIG_MAGIC || stored->version == 0 ||
+        stored->version > NODE_CONFIG_VERSION || stored->length != len) {
+        return false;
+    }
     
-    delay(10);
+    // CRC covers everything the writer knew about except its trailing crc
+    uint32_t storedCRC;
+    memcpy(&storedCRC, raw + len - sizeof(uint32_t), sizeof(uint32_t));
+    if (esp_rom_crc32_le(0, raw, len - sizeof(uint32_t)) != storedCRC) {
+        return false;
+    }
+    
+    // Older (shorter) records: start from defaults, overlay the stored prefix
+    setNodeConfigDefaults(record);
+    memcpy(&record, raw, len - sizeof(uint32_t));
+    record.version = NODE_CONFIG_VERSION;
+    record.length = sizeof(NodeConfigRecord);
+    return true;
+}
+
+/**
+ * Read both slots in a single Preferences session and keep the newest valid
+ * record. Falls back to the pre-record per-key layout once, then rewrites it
+ * as a record.
+ */
+bool DataManager::loadConfigFromNVM() {
+    if (!preferences || !preferences->begin(CONFIG_NAMESPACE, true)) {
+        dataLog("ERROR: Failed to open preferences for reading config", 1);
+        resetNodeConfig();
+        applyNodeConfig();
+        return false;
+    }
     
-    // Verify the save by immediately reading it back
-    preferences->begin("tree_network", true);
-    bool savedConfigured = preferences->getBool("bit_idx_conf", false);
-    uint8_t savedBitIndex = preferences->getUChar("my_bit_index", 255);
+    NodeConfigRecord slots[2];
+    bool valid[2];
+    for (int i = 0; i < 2; i++) {
+        valid[i] = readConfigSlot(CONFIG_SLOT_KEYS[i], slots[i]);
+    }
     preferences->end();
     
-    if (savedConfigured == systemStatus.bitIndexConfigured && savedBitIndex == systemStatus.myBitIndex) {
-        dataLog("Bit index save verified successfully", 4);
-    } else {
-        dataLog("ERROR: Bit index save verification failed! Read val: " + String(savedBitIndex) + 
-               " (expected " + String(systemStatus.myBitIndex) + "), Read conf: " + String(savedConfigured) +
-               " (expected " + String(systemStatus.bitIndexConfigured) + ")", 1);
+    if (valid[0] || valid[1]) {
+        // Generation compare is wrap-safe
+        int newest = (valid[0] && (!valid[1] || (int32_t)(slots[0].generation - slots[1].generation) > 0)) ? 0 : 1;
+        nodeConfig = slots[newest];
+        nodeConfigSlot = newest;
+        dataLog("Config record loaded from slot " + String(newest ? "B" : "A") +
+               " gen " + String(nodeConfig.generation), 3);
+    } else if (!migrateLegacyConfig()) {
+        dataLog("No configuration record found in NVM", 3);
+        resetNodeConfig();
+        nodeConfigSlot = 1;   // First save goes to slot A
     }
+    
+    // Records written before hidFormat existed read back as decimal (0)
+    if (nodeConfig.hidFormat != TREE_ADDR_FORMAT_TAG) {
+        uint16_t converted = treeAddrConvert(nodeConfig.hid, nodeConfig.hidFormat);
+        if (converted == UNCONFIGURED_HID && nodeConfig.hid != UNCONFIGURED_HID) {
+            dataLog("Stored HID " + String(nodeConfig.hid) + " has no equivalent in this address format, clearing", 1);
+        } else {
+            dataLog("Stored HID " + String(nodeConfig.hid) + " converted to " + formatHID(converted), 2);
+        }
+        nodeConfig.hid = converted;
+        nodeConfig.hidFormat = TREE_ADDR_FORMAT_TAG;
+        saveConfigToNVM();
+    }
+    
+    applyNodeConfig();
+    return systemStatus.hidConfigured;
 }
 
-bool DataManager::loadBitIndexFromNVM() {
+/**
+ * Write nodeConfig to the slot *not* holding the current record, so the
+ * previous record stays intact until the new one is fully committed.
+ */
+bool DataManager::saveConfigToNVM() {
     if (!preferences) {
-        dataLog("ERROR: Preferences not initialized, cannot load bit index", 1);
+        dataLog("ERROR: Preferences not initialized, cannot save config", 1);
         return false;
     }
     
-    dataLog("Loading bit index from NVM...", 4);
+    uint8_t targetSlot = nodeConfigSlot ^ 1;
+    nodeConfig.magic = NODE_CONFIG_MAGIC;
+    nodeConfig.version = NODE_CONFIG_VERSION;
+    nodeConfig.length = sizeof(NodeConfigRecord);
+    nodeConfig.generation++;
+    nodeConfig.crc = calculateConfigCRC(nodeConfig);
     
-    if (!preferences->begin("tree_network", true)) {
-        dataLog("ERROR: Failed to open preferences for reading", 1);
+    if (!preferences->begin(CONFIG_NAMESPACE, false)) {
+        dataLog("ERROR: Failed to open preferences for writing config", 1);
         return false;
     }
+    size_t written = preferences->putBytes(CONFIG_SLOT_KEYS[targetSlot], &nodeConfig, sizeof(nodeConfig));
+    preferences->end();
     
-    systemStatus.bitIndexConfigured = preferences->getBool("bit_idx_conf", false);
-    dataLog("NVM bit_index_configured flag: " + String(systemStatus.bitIndexConfigured ? "true" : "false"), 4);
-    
-    if (systemStatus.bitIndexConfigured) {
-        systemStatus.myBitIndex = preferences->getUChar("my_bit_index", 255);
-        dataLog("NVM bit index value: " + String(systemStatus.myBitIndex), 4);
-        
-        if (!isValidBitIndex(systemStatus.myBitIndex)) {
-            dataLog("Invalid bit index loaded from NVM: " + String(systemStatus.myBitIndex) + ", clearing", 1);
-            systemStatus.bitIndexConfigured = false;
-            systemStatus.myBitIndex = 255;
-        } else {
-            dataLog("Bit index loaded from NVM: " + String(systemStatus.myBitIndex), 2);
-            updateStatus("Bit index restored: " + String(systemStatus.myBitIndex));
-        }
-    } else {
-        dataLog("No bit index configuration found in NVM", 3);
-        systemStatus.myBitIndex = 255;
+    if (written != sizeof(nodeConfig)) {
+        dataLog("ERROR: Config record write failed (slot " + String(targetSlot ? "B" : "A") + ")", 1);
+        return false;
     }
     
-    preferences->end();
-    return systemStatus.bitIndexConfigured;
+    nodeConfigSlot = targetSlot;
+    dataLog("Config record saved to slot " + String(targetSlot ? "B" : "A") +
+           " gen " + String(nodeConfig.generation), 4);
+    return true;
 }
 
-void DataManager::clearBitIndexFromNVM() {
-    preferences->begin("tree_network", false);
+bool DataManager::migrateLegacyConfig() {
+    if (!preferences->begin(CONFIG_NAMESPACE, false)) {
+        return false;
+    }
+    
+    bool hadHID = preferences->getBool("hid_configured", false);
+    bool hadBitIndex = preferences->getBool("bit_idx_conf", false);
+    if (!hadHID && !hadBitIndex) {
+        preferences->end();
+        return false;
+    }
+    
+    resetNodeConfig();
+    if (hadHID) {
+        nodeConfig.hid = preferences->getUShort("my_hid", UNCONFIGURED_HID);
+        nodeConfig.hidFormat = TREE_ADDR_TAG_DECIMAL;
+    }
+    if (hadBitIndex) {
+        nodeConfig.bitIndex = preferences->getUChar("my_bit_index", NODE_CONFIG_NO_BIT_INDEX);
+    }
+    preferences->end();
+    
+    nodeConfigSlot = 1;
+    if (!saveConfigToNVM()) {
+        return true;   // Keep the legacy keys; we'll retry next boot
+    }
+    
+    preferences->begin(CONFIG_NAMESPACE, false);
+    preferences->remove("my_hid");
+    preferences->remove("hid_configured");
     preferences->remove("my_bit_index");
     preferences->remove("bit_idx_conf");
     preferences->end();
     
-    systemStatus.myBitIndex = 255;
-    systemStatus.bitIndexConfigured = false;
-    
-    dataLog("Bit index cleared from NVM", 3);
+    dataLog("Migrated legacy HID/bit index keys to config record", 2);
+    return true;
 }
 
-// ============================================================================
-// COMBINED DEVICE CONFIGURATION
-// ============================================================================
+void DataManager::applyNodeConfig() {
+    if (nodeConfig.hid != UNCONFIGURED_HID && !roleAllowsHID(nodeConfig.hid)) {
+        dataLog("Stored HID " + formatHID(nodeConfig.hid) + " not allowed for this build's NODE_ROLE, ignoring", 1);
+        nodeConfig.hid = UNCONFIGURED_HID;
+    }
+    systemStatus.myHID = nodeConfig.hid;
+    systemStatus.hidConfigured = (nodeConfig.hid != UNCONFIGURED_HID);
+    systemStatus.isRoot = (nodeConfig.hid == ROOT_HID);
+    
+    if (nodeConfig.bitIndex != NODE_CONFIG_NO_BIT_INDEX && !isValidBitIndex(nodeConfig.bitIndex)) {
+        dataLog("Invalid bit index in config record: " + String(nodeConfig.bitIndex) + ", clearing", 1);
+        nodeConfig.bitIndex = NODE_CONFIG_NO_BIT_INDEX;
+    }
+    systemStatus.bitIndexConfigured = (nodeConfig.bitIndex != NODE_CONFIG_NO_BIT_INDEX);
+    systemStatus.myBitIndex = systemStatus.bitIndexConfigured ? nodeConfig.bitIndex : 255;
+}
 
-void DataManager::clearAllConfiguration() {
-    systemStatus.hidConfigured = false;
-    systemStatus.myHID = 0;
-    systemStatus.isRoot = false;
-    systemStatus.bitIndexConfigured = false;
-    systemStatus.myBitIndex = 255;
+bool DataManager::setPinMap(const uint8_t* inputPins, uint8_t inputCount,
+                            const uint8_t* outputPins, uint8_t outputCount, bool persist) {
+    if (inputCount > NODE_CONFIG_MAX_IO_PINS || outputCount > NODE_CONFIG_MAX_IO_PINS) {
+        dataLog("Pin map too large: " + String(inputCount) + "/" + String(outputCount), 1);
+        return false;
+    }
     
-    clearHIDFromNVM();
-    clearBitIndexFromNVM();
+    memset(nodeConfig.inputPins, 0, sizeof(nodeConfig.inputPins));
+    memset(nodeConfig.outputPins, 0, sizeof(nodeConfig.outputPins));
+    if (inputCount) memcpy(nodeConfig.inputPins, inputPins, inputCount);
+    if (outputCount) memcpy(nodeConfig.outputPins, outputPins, outputCount);
+    nodeConfig.inputCount = inputCount;
+    nodeConfig.outputCount = outputCount;
     
-    updateStatus("All configuration cleared");
-    dataLog("All device configuration cleared", 2);
+    return persist ? saveConfigToNVM() : true;
+}
+
+bool DataManager::setPolicyFlags(uint8_t policyFlags, bool persist) {
+    nodeConfig.policyFlags = policyFlags;
+    return persist ? saveConfigToNVM() : true;
+}
+
+bool DataManager::setRadioConfig(uint8_t radioFlags, uint8_t channel, int8_t txPowerQuarterDbm, bool persist) {
+    nodeConfig.radioFlags = radioFlags;
+    nodeConfig.channel = channel;
+    nodeConfig.txPowerQuarterDbm = txPowerQuarterDbm;
+    return persist ? saveConfigToNVM() : true;
+}
+
+bool DataManager::setFailoverMisses(uint8_t misses, bool persist) {
+    nodeConfig.failoverMisses = misses;
+    return persist ? saveConfigToNVM() : true;
+}
+
+bool DataManager::setTxInFlight(uint8_t frames, bool persist) {
+    nodeConfig.txInFlight = frames;
+    return persist ? saveConfigToNVM() : true;
+}
+
+bool DataManager::setChildChannel(uint8_t channel, bool persist) {
+    nodeConfig.childChannel = channel;
+    return persist ? saveConfigToNVM() : true;
+}
+
+bool DataManager::setReportWindow(uint8_t windowMs, bool persist) {
+    nodeConfig.reportWindowMs = windowMs;
+    return persist ? saveConfigToNVM() : true;
 }
 
 // ============================================================================
@@ -320,33 +480,41 @@ void DataManager::clearAllConfiguration() {
 // ============================================================================
 
 bool DataManager::updateDeviceData(uint16_t srcHID, const DeviceSpecificData& data) {
-    if (!systemStatus.isRoot) {
+    if (!isRoot()) {
         dataLog("Only root can aggregate device data", 2);
         return false;
     }
+#if NODE_ROLE_HAS_ROOT
     
     // Find existing entry or create new one
+    portENTER_CRITICAL(&aggregateMux);
     int index = findDeviceIndex(srcHID);
+    bool added = false;
     
-    if (index == -1) {
-        // Create new entry if space available
-        if (aggregatedDeviceCount >= MAX_AGGREGATED_DEVICES) {
-            dataLog("Maximum aggregated devices reached", 2);
-            return false;
-        }
-        
+    if (index == -1 && aggregatedDeviceCount < MAX_AGGREGATED_DEVICES) {
         index = aggregatedDeviceCount;
         deviceHIDArray[index] = srcHID;
         aggregatedDeviceCount++;
-        
+        added = true;
+    }
+    
+    if (index != -1) {
+        // Update data and timestamp
+        globalDataArray[index] = data;
+        deviceLastSeen[index] = millis();
+        deviceUpdateSeq[index] = ++aggregatedUpdateSeq;
+    }
+    portEXIT_CRITICAL(&aggregateMux);
+    
+    if (index == -1) {
+        dataLog("Maximum aggregated devices reached", 2);
+        return false;
+    }
+    if (added) {
         dataLog("New device added to aggregation: " + formatHID(srcHID) + 
                " (total: " + String(aggregatedDeviceCount) + ")", 3);
     }
     
-    // Update data and timestamp
-    globalDataArray[index] = data;
-    deviceLastSeen[index] = millis();
-    
     dataLog("Updated aggregated data for device " + formatHID(srcHID) + 
            " at index " + String(index), 4);
     
@@ -363,32 +531,59 @@ bool DataManager::updateDeviceData(uint16_t srcHID, const DeviceSpecificData& da
     }
     
     return true;
+#else
+    return false;
+#endif
 }
 
 const DeviceSpecificData* DataManager::getDeviceData(uint16_t srcHID) const {
-    if (!systemStatus.isRoot) return nullptr;
+    if (!isRoot()) return nullptr;
     
+#if NODE_ROLE_HAS_ROOT
     int index = findDeviceIndex(srcHID);
     if (index == -1) return nullptr;
     
     return &globalDataArray[index];
+#else
+    return nullptr;
+#endif
 }
 
 int DataManager::findDeviceIndex(uint16_t srcHID) const {
+#if NODE_ROLE_HAS_ROOT
     for (int i = 0; i < aggregatedDeviceCount; i++) {
         if (deviceHIDArray[i] == srcHID) {
             return i;
         }
     }
+#endif
     return -1;
 }
 
+bool DataManager::getAggregatedDevice(uint8_t index, AggregatedDeviceInfo& out) const {
+#if NODE_ROLE_HAS_ROOT
+    portENTER_CRITICAL(&aggregateMux);
+    bool valid = index < aggregatedDeviceCount;
+    if (valid) {
+        out.hid = deviceHIDArray[index];
+        out.lastSeenMs = deviceLastSeen[index];
+        out.updateSeq = deviceUpdateSeq[index];
+        out.data = globalDataArray[index];
+    }
+    portEXIT_CRITICAL(&aggregateMux);
+    return valid;
+#else
+    return false;
+#endif
+}
+
 void DataManager::showAggregatedDevices() const {
-    if (!systemStatus.isRoot) {
+    if (!isRoot()) {
         dataLog("Only root has aggregated data", 2);
         return;
     }
     
+#if NODE_ROLE_HAS_ROOT
     dataLog("Devices: " + String(aggregatedDeviceCount) + "/" + String(MAX_AGGREGATED_DEVICES), 3);
     
     dataLog("Aggregated devices (" + String(aggregatedDeviceCount) + "):", 3);
@@ -397,21 +592,56 @@ void DataManager::showAggregatedDevices() const {
         dataLog("  [" + String(i) + "] HID:" + formatHID(deviceHIDArray[i]) + 
                " LastSeen:" + String(secondsAgo) + "s ago", 3);
     }
+#endif
 }
 
 void DataManager::clearAggregatedData() {
-    if (!systemStatus.isRoot) {
+    if (!isRoot()) {
         dataLog("Only root can clear aggregated data", 2);
         return;
     }
     
+#if NODE_ROLE_HAS_ROOT
+    portENTER_CRITICAL(&aggregateMux);
     memset(globalDataArray, 0, sizeof(globalDataArray));
     memset(deviceHIDArray, 0, sizeof(deviceHIDArray));
     memset(deviceLastSeen, 0, sizeof(deviceLastSeen));
+    memset(deviceUpdateSeq, 0, sizeof(deviceUpdateSeq));
     aggregatedDeviceCount = 0;
+    aggregatedUpdateSeq++;
+    portEXIT_CRITICAL(&aggregateMux);
     
     updateStatus("Aggregated data cleared");
     dataLog("All aggregated device data cleared", 3);
+#endif
+}
+
+bool DataManager::removeAggregatedDevice(uint16_t srcHID) {
+#if NODE_ROLE_HAS_ROOT
+    portENTER_CRITICAL(&aggregateMux);
+    int index = findDeviceIndex(srcHID);
+    if (index == -1) {
+        portEXIT_CRITICAL(&aggregateMux);
+        return false;
+    }
+    
+    // Keep the table dense: move the last entry into the freed slot
+    int last = aggregatedDeviceCount - 1;
+    if (index != last) {
+        globalDataArray[index] = globalDataArray[last];
+        deviceHIDArray[index] = deviceHIDArray[last];
+        deviceLastSeen[index] = deviceLastSeen[last];
+        deviceUpdateSeq[index] = deviceUpdateSeq[last];
+    }
+    aggregatedDeviceCount--;
+    aggregatedUpdateSeq++;
+    portEXIT_CRITICAL(&aggregateMux);
+    
+    dataLog("Device removed from aggregation: " + formatHID(srcHID), 3);
+    return true;
+#else
+    return false;
+#endif
 }
 
 // ============================================================================
@@ -510,7 +740,7 @@ bool DataManager::shouldProcessMessage(uint16_t destHID, uint16_t srcHID) const
 }
 
 bool DataManager::shouldForwardUpstream(uint16_t destHID, uint16_t broadcasterHID) const {
-    if (!systemStatus.hidConfigured) return false;
+    if (!NODE_ROLE_FORWARDS || !systemStatus.hidConfigured) return false;
     
     // Don't forward if I'm the root - I'm the final destination
     if (systemStatus.isRoot) return false;
@@ -518,7 +748,7 @@ bool DataManager::shouldForwardUpstream(uint16_t destHID, uint16_t broadcasterHI
     // Forward upstream if:
     // 1. Message is addressed to the root (destHID == ROOT_HID), OR
     // 2. Message is addressed to my ancestor (destHID is my parent/grandparent/etc)
-    // AND the broadcaster is my valid child
+    // AND the broadcaster is my valid (or fostered) child
     
     bool shouldForward = false;
     
@@ -527,19 +757,12 @@ bool DataManager::shouldForwardUpstream(uint16_t destHID, uint16_t broadcasterHI
         shouldForward = true;
     } else if (destHID != systemStatus.myHID) {
         // Check if destination is my ancestor (parent, grandparent, etc.)
-        uint16_t currentHID = systemStatus.myHID;
-        while (currentHID > ROOT_HID) {
-            currentHID = currentHID / 10; // Move up one level
-            if (currentHID == destHID) {
-                shouldForward = true;
-                break;
-            }
-        }
+        shouldForward = treeAddrIsAncestor(destHID, systemStatus.myHID);
     }
     
     if (shouldForward) {
         // Security check: verify immediate broadcaster is my child
-        if (isValidParentChild(systemStatus.myHID, broadcasterHID)) {
+        if (isValidChild(broadcasterHID)) {
             return true;
         } else {
             // Security violation: immediate broadcaster claims to be my child but isn't
@@ -553,11 +776,11 @@ bool DataManager::shouldForwardUpstream(uint16_t destHID, uint16_t broadcasterHI
 }
 
 bool DataManager::shouldForwardDownstream(uint16_t destHID, uint16_t broadcasterHID) const {
-    if (!systemStatus.hidConfigured) return false;
+    if (!NODE_ROLE_FORWARDS || !systemStatus.hidConfigured) return false;
     
-    // Filter 1: Packet from my hierarchical parent?
+    // Filter 1: Packet from my hierarchical parent (or foster parent)?
     // Use broadcaster_hid to validate immediate sender
-    uint16_t myParentHID = getParentHID();
+    uint16_t myParentHID = getUpstreamHID();
     if (broadcasterHID != myParentHID) {
         return false; // Not from my immediate parent, ignore
     }
@@ -567,8 +790,8 @@ bool DataManager::shouldForwardDownstream(uint16_t destHID, uint16_t broadcaster
         return false; // Will be processed, not forwarded
     }
     
-    // Filter 3: Is target my descendant?
-    if (isMyDescendant(destHID)) {
+    // Filter 3: Is target my descendant, or in a subtree I'm fostering?
+    if (isMyDescendant(destHID) || failoverCoversHID(destHID)) {
         return true; // Forward to descendant
     }
     
@@ -576,7 +799,7 @@ bool DataManager::shouldForwardDownstream(uint16_t destHID, uint16_t broadcaster
 }
 
 bool DataManager::isValidParentChild(uint16_t parentHID, uint16_t childHID) const {
-    return (childHID / 10 == parentHID);
+    return childHID != UNCONFIGURED_HID && treeAddrParent(childHID) == parentHID;
 }
 
 // ============================================================================
@@ -600,6 +823,12 @@ bool DataManager::handleIncomingTreeMessage(const uint8_t* data, int len, const
     if (rssi != 0) {
         updateSignalStrength(rssi);
     }
+    bool learn = !heapSoakInjecting();   // Soak frames must not leave synthetic state behind
+    if (learn) {
+        failoverNoteFrame(header);
+        childTableNoteFrame(header, rssi);
+        uplinkNoteFrame(header, senderMAC);
+    }
     
     dataLog("Tree message: Type=" + String(header->msg_type, HEX) + 
            " From=" + formatHID(header->src_hid) + 
@@ -617,10 +846,22 @@ bool DataManager::handleIncomingTreeMessage(const uint8_t* data, int len, const
     // --- SPECIAL HANDLING FOR DOWNSTREAM BROADCASTS ---
     // These messages are processed by all nodes that receive them from their parent,
     // so we handle them before the standard routing checks.
-    if (static_cast<TreeMessageType>(header->msg_type) == MSG_DISTRIBUTED_IO_UPDATE) {
+    if (static_cast<TreeMessageType>(header->msg_type) == MSG_DISTRIBUTED_IO_UPDATE ||
+        static_cast<TreeMessageType>(header->msg_type) == MSG_DISTRIBUTED_IO_SLICE) {
         processDistributedIOUpdate(header, payload, payloadLen, senderMAC);
         return true; // Message handled
     }
+    if (static_cast<TreeMessageType>(header->msg_type) == MSG_OTA_ANNOUNCE ||
+        static_cast<TreeMessageType>(header->msg_type) == MSG_OTA_BLOCK) {
+        treeOtaHandleFrame(header, payload, payloadLen);   // Checks the broadcaster is our parent
+        return true;
+    }
+    if (static_cast<TreeMessageType>(header->msg_type) == MSG_LINK_BEACON ||
+        static_cast<TreeMessageType>(header->msg_type) == MSG_ADOPT_REQUEST ||
+        static_cast<TreeMessageType>(header->msg_type) == MSG_ADOPT_ACK) {
+        // Single hop: only the addressee (or every neighbour, for beacons) acts on these
+        return failoverHandleFrame(header, payload, payloadLen, rssi);
+    }
 
     // Check routing decisions for all other message types
     bool shouldProcess = shouldProcessMessage(header->dest_hid, header->src_hid);
@@ -628,7 +869,7 @@ bool DataManager::handleIncomingTreeMessage(const uint8_t* data, int len, const
     bool shouldForwardDown = shouldForwardDownstream(header->dest_hid, header->broadcaster_hid);
     
     // Security check for upstream messages
-    if (shouldForwardUp && !isValidParentChild(systemStatus.myHID, header->broadcaster_hid)) {
+    if (shouldForwardUp && !isValidChild(header->broadcaster_hid)) {
         dataLog("Security violation: " + formatHID(header->broadcaster_hid) + " claims to be child of " + formatHID(systemStatus.myHID), 1);
         incrementSecurityViolations();
         incrementMessagesIgnored();
@@ -642,6 +883,10 @@ bool DataManager::handleIncomingTreeMessage(const uint8_t* data, int len, const
                 processDataReport(header, payload, payloadLen, senderMAC);
                 break;
                 
+            case MSG_DEVICE_DATA_BATCH:
+                processDataBatch(header, payload, payloadLen, senderMAC);
+                break;
+                
             case MSG_DISTRIBUTED_IO_UPDATE:
                 processDistributedIOUpdate(header, payload, payloadLen, senderMAC);
                 break;
@@ -655,7 +900,23 @@ bool DataManager::handleIncomingTreeMessage(const uint8_t* data, int len, const
                 processAcknowledgement(header, payload, payloadLen, senderMAC);
                 break;
                 
-            // Note: Bit index assignment is now done via menu, not dynamic protocol
+            case MSG_BULK_DATA:
+                bulkHandleFragment(header, payload, payloadLen);
+                break;
+                
+            case MSG_BULK_ACK:
+                bulkHandleAck(header, payload, payloadLen);
+                break;
+                
+            case MSG_OTA_STATUS:
+                treeOtaHandleFrame(header, payload, payloadLen);
+                break;
+                
+            case MSG_REQUEST_BIT_INDEX:
+            case MSG_ASSIGN_BIT_INDEX:
+            case MSG_CONFIRM_BIT_INDEX:
+                bitAllocHandleFrame(header, payload, payloadLen);
+                break;
                 
             default:
                 dataLog("Unknown tree message type: " + String(header->msg_type, HEX), 2);
@@ -665,6 +926,10 @@ bool DataManager::handleIncomingTreeMessage(const uint8_t* data, int len, const
     
     // Forward message if needed (implementation would be in ESP-NOW wrapper)
     if (shouldForwardUp || shouldForwardDown) {
+        if (shouldForwardUp && learn) {
+            childTableNoteForward(header->broadcaster_hid);
+            ioSliceNoteFrame(header, payload, payloadLen);
+        }
         incrementMessagesForwarded();
         dataLog("Message needs forwarding: Up=" + String(shouldForwardUp) + 
                " Down=" + String(shouldForwardDown), 4);
@@ -685,14 +950,16 @@ bool DataManager::handleIncomingTreeMessage(const uint8_t* data, int len, const
 
 void DataManager::processDataReport(const TreeMessageHeader* header, const uint8_t* payload, 
                                     size_t payloadLen, const uint8_t* sender) {
-    if (payloadLen != sizeof(DeviceSpecificData)) {
+    // Current nodes append a TopologyTrailer (child_table.h); older ones don't
+    if (payloadLen != sizeof(DeviceSpecificData) &&
+        payloadLen != sizeof(DeviceSpecificData) + sizeof(TopologyTrailer)) {
         dataLog("Invalid data report size: " + String(payloadLen), 2);
         return;
     }
     
     const DeviceSpecificData* data = (const DeviceSpecificData*)payload;
         
-    if (systemStatus.isRoot) {
+    if (isRoot()) {
         // Root node should only accept data reports from its direct children.
         // The broadcaster_hid identifies the node that sent the message to us.
         if (!isValidChild(header->broadcaster_hid)) {
@@ -708,8 +975,13 @@ void DataManager::processDataReport(const TreeMessageHeader* header, const uint8
                "Input:" + String(data->input_states, BIN) + 
                " BitIndex:" + String(data->bit_index), 2);
         
-        updateDeviceData(header->src_hid, *data);
-        updateStatus("Data from " + formatHID(header->src_hid));
+        storeReport(header->src_hid, *data,
+                    payloadLen > sizeof(DeviceSpecificData) ? payload + sizeof(DeviceSpecificData) : nullptr);
+        aggNoteRootFrame(1);
+        if (!heapSoakInjecting()) {
+            ioSliceNoteFrame(header, payload, payloadLen);
+        }
+        updateStatusf("Data from %u", header->src_hid);
         
         dataLog("Data report from " + formatHID(header->src_hid) + 
                " - In:" + String(data->input_states, BIN) + 
@@ -721,6 +993,54 @@ void DataManager::processDataReport(const TreeMessageHeader* header, const uint8
     }
 }
 
+void DataManager::processDataBatch(const TreeMessageHeader* header, const uint8_t* payload, 
+                                   size_t payloadLen, const uint8_t* sender) {
+    uint8_t count = payloadLen >= 1 ? payload[0] : 0;
+    if (count == 0 || count > AGG_MAX_RECORDS || payloadLen != 1 + count * sizeof(AggregatedReportRecord)) {
+        dataLog("Invalid data batch size: " + String(payloadLen), 2);
+        return;
+    }
+    
+    if (!isRoot()) {
+        dataLog("MULTI-HOP: Intermediate node " + formatHID(systemStatus.myHID) + 
+               " forwarding " + String(count) + " reports from " + formatHID(header->src_hid), 2);
+        return;
+    }
+    
+    // Same rule as single reports: only from a direct child
+    if (!isValidChild(header->broadcaster_hid)) {
+        dataLog("Security: Root ignoring data batch from non-child broadcaster " + formatHID(header->broadcaster_hid), 2);
+        incrementSecurityViolations();
+        return;
+    }
+    
+    for (uint8_t i = 0; i < count; i++) {
+        AggregatedReportRecord record;
+        memcpy(&record, payload + 1 + i * sizeof(record), sizeof(record));
+        storeReport(record.src_hid, record.data,
+                    (record.flags & AGG_RECORD_HAS_TRAILER) ? (const uint8_t*)&record.trailer : nullptr);
+    }
+    aggNoteRootFrame(count);
+    if (!heapSoakInjecting()) {
+        ioSliceNoteFrame(header, payload, payloadLen);
+    }
+    updateStatusf("%u reports via %u", count, header->broadcaster_hid);
+    dataLog("Data batch of " + String(count) + " reports from " + formatHID(header->src_hid), 3);
+}
+
+void DataManager::storeReport(uint16_t srcHID, const DeviceSpecificData& data, const uint8_t* trailer) {
+    updateDeviceData(srcHID, data);
+    if (heapSoakInjecting()) {
+        return;                     // Synthetic HIDs must not take real bits
+    }
+    bitAllocNoteReport(srcHID, data.bit_index);
+    if (trailer) {
+        TopologyTrailer topology;
+        memcpy(&topology, trailer, sizeof(topology));
+        childTableNoteTopology(srcHID, topology);
+    }
+}
+
 void DataManager::processCommand(const TreeMessageHeader* header, const uint8_t* payload, 
                                size_t payloadLen, const uint8_t* sender) {
     // Non-root nodes process commands addressed to them
@@ -729,8 +1049,12 @@ void DataManager::processCommand(const TreeMessageHeader* header, const uint8_t*
         
         switch(cmdType) {
             case MSG_COMMAND_SET_OUTPUTS:
-                if (payloadLen == 1) {
-                    uint8_t outputState = payload[0];
+                if (payloadLen >= 1) {
+                    // uint16_t little-endian; older senders send the low 8 outputs only
+                    uint16_t outputState = payload[0];
+                    if (payloadLen >= 2) {
+                        memcpy(&outputState, payload, sizeof(outputState));
+                    }
                     IO_DEVICE.updateOutputs(outputState);
                     dataLog("CMD: Set Outputs to " + String(outputState, BIN), 2);
                 }
@@ -747,12 +1071,28 @@ void DataManager::processDistributedIOUpdate(const TreeMessageHeader* header, co
     dataLog("CHILD: Received MSG_DISTRIBUTED_IO_UPDATE - size=" + String(payloadLen) + 
            " src=" + formatHID(header->src_hid) + " broadcaster=" + formatHID(header->broadcaster_hid), 2);
     
-    // Handle legacy (4 bytes), legacy multi-input (12 bytes), and current (sizeof(DistributedIOData)) formats
+    // A slice (io_slice.h) or a legacy 3-plane frame is expanded to the full
+    // frame; bits outside it read as zero
+    DistributedIOData sliced;
+    if (header->msg_type == MSG_DISTRIBUTED_IO_SLICE) {
+        if (!ioSliceDecode(payload, payloadLen, sliced)) {
+            dataLog("CHILD: Invalid distributed I/O slice size: " + String(payloadLen), 1);
+            return;
+        }
+        payload = (const uint8_t*)&sliced;
+        payloadLen = sizeof(sliced);
+    }
+    
+    // Handle legacy (4 bytes), legacy multi-input (12 bytes), legacy 3+3 planes (24 bytes)
+    // and current (sizeof(DistributedIOData)) formats
     const int LEGACY_ONE_INPUT_BYTES = 4;
     const int LEGACY_THREE_INPUTS_BYTES = 12; // 3 words inputs only
-    if (payloadLen != sizeof(DistributedIOData) && payloadLen != LEGACY_ONE_INPUT_BYTES && payloadLen != LEGACY_THREE_INPUTS_BYTES) {
+    const int LEGACY_THREE_PLANES_BYTES = 2 * LEGACY_IO_PLANES * SHARED_DATA_WORDS * sizeof(uint32_t);
+    if (payloadLen != sizeof(DistributedIOData) && payloadLen != LEGACY_ONE_INPUT_BYTES &&
+        payloadLen != LEGACY_THREE_INPUTS_BYTES && payloadLen != LEGACY_THREE_PLANES_BYTES) {
         dataLog("CHILD: Invalid distributed I/O update size: " + String(payloadLen) +
-               " (expected " + String(sizeof(DistributedIOData)) + ", " + String(LEGACY_THREE_INPUTS_BYTES) + " or " + String(LEGACY_ONE_INPUT_BYTES) + ")", 1);
+               " (expected " + String(sizeof(DistributedIOData)) + ", " + String(LEGACY_THREE_PLANES_BYTES) + ", " +
+               String(LEGACY_THREE_INPUTS_BYTES) + " or " + String(LEGACY_ONE_INPUT_BYTES) + ")", 1);
         return;
     }
 
@@ -761,9 +1101,10 @@ void DataManager::processDistributedIOUpdate(const TreeMessageHeader* header, co
     // important than the chain of trust established by the broadcaster_hid.
     // The check for src_hid == ROOT_HID has been removed as it breaks multi-hop forwarding.
 
-    // A non-root node should only accept messages from its direct parent.
+    // A non-root node should only accept messages from its direct parent
+    // (or its foster parent after a failover).
     // The broadcaster_hid identifies the node that sent the message to us.
-    uint16_t expectedParent = getParentHID();
+    uint16_t expectedParent = getUpstreamHID();
     dataLog("CHILD: Security check - my HID: " + formatHID(systemStatus.myHID) + 
            ", expected parent: " + formatHID(expectedParent) + 
            ", broadcaster: " + formatHID(header->broadcaster_hid), 3);
@@ -775,33 +1116,39 @@ void DataManager::processDistributedIOUpdate(const TreeMessageHeader* header, co
         return;
     }
     
-    DistributedIOData receivedData;
-    memset(&receivedData, 0, sizeof(DistributedIOData));
-    
     if (payloadLen == LEGACY_ONE_INPUT_BYTES) {
-        // Backward compatibility: old 4-byte format (single input)
-        // Copy the single word to input 0 of the new structure
-        memcpy(&receivedData.sharedData[0][0], payload, 4);
+        // Backward compatibility: old 4-byte format (single input) lands in input 0
         dataLog("CHILD: Received legacy 4-byte format, mapping to Input 1", 2);
     } else if (payloadLen == LEGACY_THREE_INPUTS_BYTES) {
         // Legacy 12-byte format: inputs only (3 words). Outputs remain zero.
-        memcpy(&receivedData.sharedData[0][0], payload, LEGACY_THREE_INPUTS_BYTES);
         dataLog("CHILD: Received legacy 12-byte multi-input format (inputs only)", 2);
+    } else if (payloadLen == LEGACY_THREE_PLANES_BYTES) {
+        // Legacy 3 I + 3 Q planes: Q no longer follows I directly, so move it
+        memset(&sliced, 0, sizeof(sliced));
+        memcpy(sliced.sharedData, payload, LEGACY_THREE_PLANES_BYTES / 2);
+        memcpy(sliced.sharedOutputs, payload + LEGACY_THREE_PLANES_BYTES / 2, LEGACY_THREE_PLANES_BYTES / 2);
+        payload = (const uint8_t*)&sliced;
+        payloadLen = sizeof(sliced);
+        dataLog("CHILD: Received legacy 3-plane inputs+outputs format", 2);
     } else {
-        // Current format: full inputs+outputs struct
-        memcpy(&receivedData, payload, sizeof(DistributedIOData));
         dataLog("CHILD: Received current inputs+outputs format", 2);
     }
     
+    // Get old shared data before updating (for backward compatibility logging)
+    uint32_t oldSharedData = getSharedData();
+    
+    // All remaining formats are prefixes of DistributedIOData, so the payload is
+    // decoded straight into the snapshot back buffer (zero-filling the rest).
+    publishDistributedIOFrame(payload, payloadLen);
+    
+    DistributedIOData receivedData;
+    readDistributedIOSharedData(receivedData);
+    
     dataLog("CHILD: Device " + formatHID(systemStatus.myHID) + 
            " received shared data update from root (via " + formatHID(header->broadcaster_hid) + ") - " +
            "SharedData:" + formatDistributedIOData(receivedData), 2);
     
-    // Get old shared data before updating (for backward compatibility logging)
-    uint32_t oldSharedData = getDistributedIOSharedData().sharedData[0][0];
-    
-    // Update both DataManager's state (for display) and IoDevice's state (for outputs)
-    setDistributedIOSharedData(receivedData);
+    // DataManager's snapshot is already current (for display); update IoDevice's state (for outputs)
     IO_DEVICE.processSharedDataUpdate(receivedData);
     
     // Log button press/release events to console (backward compatibility)
@@ -815,10 +1162,13 @@ void DataManager::processDistributedIOUpdate(const TreeMessageHeader* header, co
 }
 
 void DataManager::forwardDistributedIOUpdateToChildren(const DistributedIOData& sharedData) {
+    if (!NODE_ROLE_FORWARDS) {
+        return; // Leaf build: no children
+    }
     dataLog("Forwarding shared data to my children via broadcast", 3);
 
-    // Send a single broadcast message to all listening children
-    TREE_NET.sendBroadcastTreeCommand(MSG_DISTRIBUTED_IO_UPDATE, (const uint8_t*)&sharedData, sizeof(DistributedIOData));
+    // Send a single broadcast message to all listening children, cut down to their bits
+    ioSliceSend(sharedData);
 }
 
 void DataManager::processAcknowledgement(const TreeMessageHeader* header, const uint8_t* payload, 
@@ -842,8 +1192,8 @@ void DataManager::processAcknowledgement(const TreeMessageHeader* header, const
 // ============================================================================
 
 void DataManager::updateLastSender(const uint8_t* senderMAC) {
-    networkStats.lastSenderMAC = formatMAC(senderMAC);
-    memcpy(lastSenderMAC, senderMAC, 6);
+    memcpy(networkStats.lastSenderMAC, senderMAC, 6);
+    networkStats.hasLastSender = true;
     networkStats.lastMessageTime = millis();
 }
 
@@ -854,7 +1204,8 @@ void DataManager::resetNetworkStats() {
     networkStats.messagesIgnored = 0;
     networkStats.securityViolations = 0;
     networkStats.lastMessageTime = 0;
-    networkStats.lastSenderMAC = "None";
+    memset(networkStats.lastSenderMAC, 0, 6);
+    networkStats.hasLastSender = false;
     networkStats.signalStrength = 0.0f;
     dataLog("Network statistics reset", 3);
 }
@@ -863,10 +1214,19 @@ void DataManager::resetNetworkStats() {
 // SYSTEM STATUS
 // ============================================================================
 
-void DataManager::updateStatus(const String& newStatus) {
-    systemStatus.previousStatus = systemStatus.currentStatus;
-    systemStatus.currentStatus = newStatus;
-    dataLog("Status updated: " + newStatus, 4);
+void DataManager::updateStatus(const char* newStatus) {
+    memcpy(systemStatus.previousStatus, systemStatus.currentStatus, STATUS_TEXT_LEN);
+    strlcpy(systemStatus.currentStatus, newStatus, STATUS_TEXT_LEN);
+    dataLog("Status updated: " + String(newStatus), 4);
+}
+
+void DataManager::updateStatusf(const char* format, ...) {
+    char text[STATUS_TEXT_LEN];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    updateStatus(text);
 }
 
 // ============================================================================
@@ -878,7 +1238,7 @@ void DataManager::computeAndBroadcastDistributedIO() {
     return; // Distributed I/O disabled for debugging
     #endif
     
-    if (!systemStatus.isRoot) {
+    if (!isRoot()) {
         return; // Only root computes distributed I/O
     }
     
@@ -923,14 +1283,32 @@ void DataManager::computeAndBroadcastDistributedIO() {
     }
 }
 
+#if NODE_ROLE_HAS_ROOT
+/**
+ * Set bitIndex in sharedData[N] for every input N active in states. Walks the
+ * set bits only, so idle devices and unused planes cost nothing.
+ */
+static void foldInputStates(DistributedIOData& sharedData, uint16_t states, uint8_t bitIndex) {
+    int wordIndex = bitIndex / BITS_PER_WORD;
+    uint32_t mask = 1UL << (bitIndex % BITS_PER_WORD);
+    uint32_t pending = states;
+    while (pending) {
+        int inputIndex = __builtin_ctz(pending);
+        pending &= pending - 1;
+        sharedData.sharedData[inputIndex][wordIndex] |= mask;
+    }
+}
+#endif
+
 /**
  * build the tree-wide distributed I/O frame (inputs and outputs)
  *
  * Overview
- * - I (Inputs): 3 × 32-bit bitmaps. Each bitIndex corresponds to one device.
+ * - I (Inputs): 16 × 32-bit bitmaps. Each bitIndex corresponds to one device.
  *   If a device reports its local Input N active, we set bit "bitIndex" in
- *   sharedData[N]. The root folds its own inputs and all aggregated devices.
- * - Q (Outputs): 3 × 32-bit bitmaps. These are root-owned and define the
+ *   sharedData[N]. The root folds its own inputs and all aggregated devices,
+ *   visiting only the set bits of each input_states word.
+ * - Q (Outputs): 16 × 32-bit bitmaps. These are root-owned and define the
  *   target output state for every device (per-output line) at its bitIndex.
  *   Children do not compute outputs; they simply apply Q at their own bitIndex.
  *
@@ -948,6 +1326,7 @@ DistributedIOData DataManager::computeSharedDataFromInputs() const {
     memset(&sharedData, 0, sizeof(DistributedIOData));
 
     dataLog("Computing shared data from inputs...", 4);
+#if NODE_ROLE_HAS_ROOT
 
     // --- Fold the root node's own inputs into I ---
     if (isDeviceFullyConfigured()) {
@@ -961,19 +1340,9 @@ DistributedIOData DataManager::computeSharedDataFromInputs() const {
             return sharedData;
         }
         
-        // Process all three inputs (Input 1..3 => indices 0..2)
-        for (int inputIndex = 0; inputIndex < MAX_INPUTS; inputIndex++) {
-            // Check if this input is active (bit 0, 1, or 2)
-            if ((myData.input_states & (1 << inputIndex)) != 0) {
-                int wordIndex = myBitIndex / BITS_PER_WORD;
-                int bitInWord = myBitIndex % BITS_PER_WORD;
-                sharedData.sharedData[inputIndex][wordIndex] |= (1UL << bitInWord);
-                dataLog("Root Input " + String(inputIndex + 1) + " active -> setting bit " + 
-                       String(myBitIndex) + " in sharedData[" + String(inputIndex) + "]", 2);
-            } else {
-                dataLog("Root Input " + String(inputIndex + 1) + " not active", 4);
-            }
-        }
+        foldInputStates(sharedData, myData.input_states, myBitIndex);
+        dataLog("Root inputs " + String(myData.input_states, BIN) + " -> bit " + String(myBitIndex) +
+               " set in their sharedData planes", 2);
     } else {
         dataLog("Root not fully configured - HID:" + String(isHIDConfigured()) + 
                " BitIndex:" + String(isBitIndexConfigured()), 2);
@@ -992,19 +1361,9 @@ DistributedIOData DataManager::computeSharedDataFromInputs() const {
             continue;
         }
         
-        // Process all three inputs for this device
-        for (int inputIndex = 0; inputIndex < MAX_INPUTS; inputIndex++) {
-            // Check if this input is active (bit 0, 1, or 2)
-            if ((deviceData.input_states & (1 << inputIndex)) != 0) {
-                int wordIndex = deviceBitIndex / BITS_PER_WORD;
-                int bitInWord = deviceBitIndex % BITS_PER_WORD;
-                sharedData.sharedData[inputIndex][wordIndex] |= (1UL << bitInWord);
-                
-                dataLog("Device " + formatHID(deviceHIDArray[i]) + 
-                       " (bit " + String(deviceBitIndex) + ") Input " + String(inputIndex + 1) + 
-                       " active -> setting its bit in sharedData[" + String(inputIndex) + "]", 4);
-            }
-        }
+        foldInputStates(sharedData, deviceData.input_states, deviceBitIndex);
+        dataLog("Device " + formatHID(deviceHIDArray[i]) + " (bit " + String(deviceBitIndex) +
+               ") inputs " + String(deviceData.input_states, BIN) + " folded into sharedData", 4);
     }
     
     // --- Compute Q (Outputs) ---
@@ -1012,17 +1371,69 @@ DistributedIOData DataManager::computeSharedDataFromInputs() const {
     OutputPolicy::computeOutputsFromInputs(sharedData);
 
     dataLog("Final shared data computed: " + formatDistributedIOData(sharedData), 3);
+#endif
     return sharedData;
 }
 
 // NOTE: Output policy moved to OutputPolicy.{h,cpp}
 
 void DataManager::setDistributedIOSharedData(const DistributedIOData& sharedData) {
-    distributedIOData = sharedData;
+    publishDistributedIOFrame((const uint8_t*)&sharedData, sizeof(DistributedIOData));
+}
+
+/**
+ * Writer side of the shared I/O seqlock.
+ *
+ * The frame is written into the back buffer while the sequence counter is odd,
+ * then the counter is bumped to the next even value, which flips front/back.
+ * Readers of the current front buffer are never disturbed by this write; they
+ * only retry if a second publish starts before they finish copying.
+ */
+void DataManager::publishDistributedIOFrame(const uint8_t* frame, size_t len) {
+    if (len > sizeof(DistributedIOData)) {
+        len = sizeof(DistributedIOData);
+    }
+    
+    portENTER_CRITICAL(&ioWriterMux);
+    uint32_t seq = ioSnapshotSeq + 1;   // Odd: write in progress
+    __atomic_store_n(&ioSnapshotSeq, seq, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);   // smp_wmb: odd count visible before the buffer writes
+    
+    uint8_t* back = (uint8_t*)&ioSnapshot[((seq >> 1) + 1) & 1];
+    memcpy(back, frame, len);
+    memset(back + len, 0, sizeof(DistributedIOData) - len);
+    
+    __atomic_store_n(&ioSnapshotSeq, seq + 1, __ATOMIC_RELEASE);  // Even: new front published
+    portEXIT_CRITICAL(&ioWriterMux);
+}
+
+/**
+ * Reader side of the shared I/O seqlock. Lock-free, callable from any task on
+ * either core. Returns the version of the copied snapshot.
+ */
+uint32_t DataManager::readDistributedIOSharedData(DistributedIOData& out) const {
+    for (;;) {
+        uint32_t start = __atomic_load_n(&ioSnapshotSeq, __ATOMIC_ACQUIRE);
+        memcpy(&out, (const void*)&ioSnapshot[(start >> 1) & 1], sizeof(DistributedIOData));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t end = __atomic_load_n(&ioSnapshotSeq, __ATOMIC_RELAXED);
+        
+        // Our buffer is only rewritten by the publish after the next one, which
+        // starts when the counter reaches (start & ~1) + 3.
+        if (end - (start & ~1u) < 3) {
+            return start >> 1;
+        }
+    }
+}
+
+uint32_t DataManager::getDistributedIOVersion() const {
+    return __atomic_load_n(&ioSnapshotSeq, __ATOMIC_ACQUIRE) >> 1;
 }
 
 DistributedIOData DataManager::getDistributedIOSharedData() const {
-    return distributedIOData;
+    DistributedIOData snapshot;
+    readDistributedIOSharedData(snapshot);
+    return snapshot;
 }
 
 void DataManager::broadcastDistributedIOUpdate(const DistributedIOData& sharedData) {
@@ -1042,7 +1453,7 @@ void DataManager::broadcastDistributedIOUpdate(const DistributedIOData& sharedDa
 // ============================================================================
 
 String DataManager::getDistributedIOStatus() const {
-    if (!systemStatus.isRoot) {
+    if (!isRoot()) {
         return "Not root";
     }
     
@@ -1064,13 +1475,23 @@ String DataManager::formatMAC(const uint8_t* mac) const {
 }
 
 String DataManager::formatHID(uint16_t hid) const {
-    return String(hid);
+    char text[TREE_ADDR_FORMAT_LEN];
+    treeAddrFormat(hid, text, sizeof(text));
+    return String(text);
 }
 
 String DataManager::formatDistributedIOData(const DistributedIOData& data) const {
+    // Trailing all-zero planes past the first LEGACY_IO_PLANES are left out
+    int planes = LEGACY_IO_PLANES;
+    for (int index = LEGACY_IO_PLANES; index < MAX_INPUTS; index++) {
+        for (int wordIndex = 0; wordIndex < MAX_DISTRIBUTED_IO_BITS / 32; wordIndex++) {
+            if (data.sharedData[index][wordIndex] || data.sharedOutputs[index][wordIndex]) planes = index + 1;
+        }
+    }
+    
     String result = "";
     // Inputs (I)
-    for (int inputIndex = 0; inputIndex < MAX_INPUTS; inputIndex++) {
+    for (int inputIndex = 0; inputIndex < planes; inputIndex++) {
         if (inputIndex > 0) result += " | ";
         result += "I" + String(inputIndex + 1) + ":";
         for (int wordIndex = 0; wordIndex < MAX_DISTRIBUTED_IO_BITS / 32; wordIndex++) {
@@ -1082,7 +1503,7 @@ String DataManager::formatDistributedIOData(const DistributedIOData& data) const
     }
     result += " || ";
     // Outputs (Q)
-    for (int outIndex = 0; outIndex < MAX_INPUTS; outIndex++) {
+    for (int outIndex = 0; outIndex < planes; outIndex++) {
         if (outIndex > 0) result += " | ";
         result += "Q" + String(outIndex + 1) + ":";
         for (int wordIndex = 0; wordIndex < MAX_DISTRIBUTED_IO_BITS / 32; wordIndex++) {
@@ -1124,17 +1545,26 @@ void DataManager::setDistributedIOBit(int inputIndex, int bitIndex, bool value)
         return;
     }
     
-    DistributedIOData data = getDistributedIOSharedData();
     int wordIndex = bitIndex / BITS_PER_WORD;
     int bitInWord = bitIndex % BITS_PER_WORD;
     
+    // Read-modify-write must happen under the writer lock so that concurrent
+    // bit updates (main loop vs. ESP-NOW receive task) are not lost.
+    portENTER_CRITICAL(&ioWriterMux);
+    uint32_t seq = ioSnapshotSeq;
+    const DistributedIOData* front = &ioSnapshot[(seq >> 1) & 1];
+    DistributedIOData* back = &ioSnapshot[((seq >> 1) + 1) & 1];
+    
+    __atomic_store_n(&ioSnapshotSeq, seq + 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);   // smp_wmb: odd count visible before the buffer writes
+    memcpy(back, (const void*)front, sizeof(DistributedIOData));
     if (value) {
-        data.sharedData[inputIndex][wordIndex] |= (1UL << bitInWord);
+        back->sharedData[inputIndex][wordIndex] |= (1UL << bitInWord);
     } else {
-        data.sharedData[inputIndex][wordIndex] &= ~(1UL << bitInWord);
+        back->sharedData[inputIndex][wordIndex] &= ~(1UL << bitInWord);
     }
-    
-    setDistributedIOSharedData(data);
+    __atomic_store_n(&ioSnapshotSeq, seq + 2, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&ioWriterMux);
 }
 
 bool DataManager::getDistributedIOBit(int inputIndex, int bitIndex) const {
@@ -1149,7 +1579,9 @@ bool DataManager::getDistributedIOBit(int inputIndex, int bitIndex) const {
     int wordIndex = bitIndex / BITS_PER_WORD;
     int bitPosition = bitIndex % BITS_PER_WORD;
     
-    return (distributedIOData.sharedData[inputIndex][wordIndex] & (1UL << bitPosition)) != 0;
+    DistributedIOData snapshot;
+    readDistributedIOSharedData(snapshot);
+    return (snapshot.sharedData[inputIndex][wordIndex] & (1UL << bitPosition)) != 0;
 }
 
 bool DataManager::getMyBitState(int inputIndex) const {
@@ -1182,12 +1614,19 @@ bool DataManager::getMyBitState() const {
 
 uint32_t DataManager::getSharedData() const {
     // Return the first word of input 0 distributed I/O data as uint32 for compatibility
-    return distributedIOData.sharedData[0][0];
+    DistributedIOData snapshot;
+    readDistributedIOSharedData(snapshot);
+    return snapshot.sharedData[0][0];
 }
 
 uint16_t DataManager::getParentHID() const {
     if (systemStatus.isRoot || !systemStatus.hidConfigured) {
         return 0; // Root has no parent
     }
-    return systemStatus.myHID / 10;
+    return treeAddrParent(systemStatus.myHID);
+}
+
+uint16_t DataManager::getUpstreamHID() const {
+    uint16_t fosterHID = failoverGetFosterHID();
+    return fosterHID ? fosterHID : getParentHID();
 } 
\ No newline at end of file
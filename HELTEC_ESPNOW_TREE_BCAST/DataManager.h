@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include "tree_address.h"
 
 // Forward declaration
 class Preferences;
@@ -13,41 +14,82 @@ class Preferences;
 
 #define ROOT_HID 1
 #define UNCONFIGURED_HID 0
-#define MAX_HID_VALUE 999
+#define MAX_HID_VALUE 999            // Decimal HIDs (tree_address.h)
 #define BROADCAST_HID 0xFFFF
 
 // Distributed I/O Configuration 
 #define MAX_DISTRIBUTED_IO_BITS 32
-#define MAX_INPUTS 3
+#define MAX_INPUTS 16                // I and Q planes; one per local input/output point
 #define SHARED_DATA_WORDS 1
 #define BITS_PER_WORD 32
 
 // Maximum number of devices the root node can track
 #define MAX_AGGREGATED_DEVICES 64
 
+// ============================================================================
+// BUILD ROLE
+// ============================================================================
+
+/**
+ * @brief Compile-time node role.
+ *
+ * NODE_ROLE_ANY builds one image for every node; whether it is the root is
+ * decided at runtime from its HID. The other roles leave out what the node
+ * can never use:
+ * - NODE_ROLE_ROOT   - HID 1 only. Never forwards.
+ * - NODE_ROLE_ROUTER - any HID but 1. No device table, topology table,
+ *   shared-data fold or output policy. isRoot() is a constant false, so
+ *   root-only branches are compiled out in every module.
+ * - NODE_ROLE_LEAF   - as ROUTER, and never forwards. Give a leaf build no
+ *   children; frames for them are dropped.
+ *
+ * A stored HID the role can't take is treated as unconfigured. Router and
+ * leaf builds put the freed RAM into deeper TX queues (tx_queue.h). The
+ * ROLE command reports the role and the RAM its tables and queues take.
+ *
+ * Set here, or per build with -DNODE_ROLE=2 in build_opt.h or
+ * compiler.cpp.extra_flags.
+ */
+#define NODE_ROLE_ANY    0
+#define NODE_ROLE_ROOT   1
+#define NODE_ROLE_ROUTER 2
+#define NODE_ROLE_LEAF   3
+
+#ifndef NODE_ROLE
+#define NODE_ROLE NODE_ROLE_ANY
+#endif
+
+#define NODE_ROLE_HAS_ROOT  (NODE_ROLE == NODE_ROLE_ANY || NODE_ROLE == NODE_ROLE_ROOT)
+#define NODE_ROLE_FORWARDS  (NODE_ROLE == NODE_ROLE_ANY || NODE_ROLE == NODE_ROLE_ROUTER)
+
 // ============================================================================
 // DATA STRUCTURES
 // ============================================================================
 
 /**
- * @brief Distributed I/O data structure - 3 inputs x 32 bits each AND 3 outputs x 32 bits each
+ * @brief Distributed I/O data structure - 16 inputs x 32 bits each AND 16 outputs x 32 bits each
  * Structure:
  *  - sharedData[inputIndex][bitIndex]      -> aggregated Inputs (I)
  *  - sharedOutputs[outputIndex][bitIndex]  -> root-defined Outputs (Q)
+ *
+ * Frames from firmware with 3 planes (4, 12 or 24 bytes) are still accepted;
+ * the planes they lack read as zero.
  */
 typedef struct {
     // Inputs (I)
-    uint32_t sharedData[MAX_INPUTS][MAX_DISTRIBUTED_IO_BITS / 32];   // 3 inputs x 1 word each
+    uint32_t sharedData[MAX_INPUTS][MAX_DISTRIBUTED_IO_BITS / 32];   // 16 inputs x 1 word each
     // Outputs (Q)
-    uint32_t sharedOutputs[MAX_INPUTS][MAX_DISTRIBUTED_IO_BITS / 32]; // 3 outputs x 1 word each
+    uint32_t sharedOutputs[MAX_INPUTS][MAX_DISTRIBUTED_IO_BITS / 32]; // 16 outputs x 1 word each
 } __attribute__((packed)) DistributedIOData;
 
+#define LEGACY_IO_PLANES 3           // Planes sent by firmware before 16-point I/O
+
 /**
  * @brief Device-specific data payload
  */
 typedef struct {
-    uint8_t  input_states;
-    uint8_t  output_states;
+    uint16_t input_states;           // Bit n = local input n (up to MAX_INPUTS)
+    uint16_t output_states;          // Bit n = local output n
     uint16_t memory_states;
     uint16_t analog_values[2];
     uint16_t integer_values[2];
@@ -55,22 +97,48 @@ typedef struct {
     uint8_t  reserved;
 } __attribute__((packed)) DeviceSpecificData;
 
+/**
+ * @brief Consistent copy of one entry of the root's aggregated device table
+ */
+typedef struct {
+    uint16_t hid;
+    uint32_t lastSeenMs;        // millis() of the device's last report
+    uint32_t updateSeq;         // Table update counter value at that report
+    DeviceSpecificData data;
+} AggregatedDeviceInfo;
+
 /**
  * @brief Message types for tree network communication
  */
 enum TreeMessageType : uint8_t {
     MSG_DEVICE_DATA_REPORT    = 0x01,
+    MSG_DEVICE_DATA_BATCH     = 0x04,    // Several reports combined by a forwarder (report_aggregation.h)
     MSG_DISTRIBUTED_IO_UPDATE = 0x22,
+    MSG_DISTRIBUTED_IO_SLICE  = 0x23,    // Only the subtree's bits (io_slice.h)
     // The following message types are still defined but not fully implemented
     // in the current simplified protocol.
     MSG_ACKNOWLEDGEMENT       = 0x02,
     MSG_NACK                  = 0x03,
     MSG_COMMAND_SET_OUTPUTS   = 0x10,
     
-    // Bit assignment protocol messages
+    // Bit assignment protocol messages (bit_allocator.h)
     MSG_REQUEST_BIT_INDEX     = 0x30,    // Device requests bit assignment
     MSG_ASSIGN_BIT_INDEX      = 0x31,    // Root assigns bit index
     MSG_CONFIRM_BIT_INDEX     = 0x32,    // Device confirms assignment
+    
+    // Fragmented bulk transfers (bulk_transfer.h)
+    MSG_BULK_DATA             = 0x40,    // One fragment of a large payload
+    MSG_BULK_ACK              = 0x41,    // Received-fragment bitmap (selective NACK)
+    
+    // Firmware distribution (tree_ota.h)
+    MSG_OTA_ANNOUNCE          = 0x50,    // Parent offers an image (broadcast)
+    MSG_OTA_BLOCK             = 0x51,    // One image block (broadcast)
+    MSG_OTA_STATUS            = 0x52,    // Child progress and missing-block bitmap
+    
+    // Parent failover (parent_failover.h); one hop, never forwarded
+    MSG_LINK_BEACON           = 0x60,    // Liveness and upstream status (broadcast)
+    MSG_ADOPT_REQUEST         = 0x61,    // Orphan asks a neighbour to stand in for its parent
+    MSG_ADOPT_ACK             = 0x62,    // Foster accepts or refuses
 };
 
 /**
@@ -111,6 +179,76 @@ typedef struct {
     uint8_t  status;          // 0 = accepted, 1 = rejected
 } __attribute__((packed)) BitIndexConfirmation;
 
+// ============================================================================
+// PERSISTENT CONFIGURATION
+// ============================================================================
+
+#define NODE_CONFIG_MAGIC         0x4E43   // "NC"
+#define NODE_CONFIG_VERSION       1
+#define NODE_CONFIG_MAX_IO_PINS   16       // Pin map capacity (boards may use fewer)
+#define NODE_CONFIG_NO_BIT_INDEX  0xFF
+
+// policyFlags
+#define NODE_CFG_POLICY_AUTO_REPORT  0x01  // Report upstream on input change
+#define NODE_CFG_POLICY_TEST_MODE    0x02
+
+// radioFlags
+#define NODE_CFG_RADIO_LONG_RANGE    0x01
+
+/**
+ * @brief Complete persistent node configuration, stored as one NVM blob.
+ *
+ * Written alternately to two Preferences slots ("cfg_a"/"cfg_b"); each write
+ * bumps generation, and at boot the valid slot with the highest generation
+ * wins. A torn or corrupted write therefore falls back to the previous record
+ * instead of leaving HID and bit index out of step.
+ *
+ * Records from older firmware (lower version, shorter length) are accepted;
+ * fields past their length take default values. Append new fields before crc.
+ */
+typedef struct {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  length;                            // sizeof(NodeConfigRecord) when written
+    uint32_t generation;
+    
+    // Network identity
+    uint16_t hid;                               // UNCONFIGURED_HID = not set
+    uint8_t  bitIndex;                          // NODE_CONFIG_NO_BIT_INDEX = not set
+    
+    // I/O pin map (count 0 = board default)
+    uint8_t  inputCount;
+    uint8_t  outputCount;
+    uint8_t  inputPins[NODE_CONFIG_MAX_IO_PINS];
+    uint8_t  outputPins[NODE_CONFIG_MAX_IO_PINS];
+    
+    // Behaviour
+    uint8_t  policyFlags;                       // NODE_CFG_POLICY_*
+    uint8_t  outputPolicyId;                    // 0 = compiled-in OutputPolicy
+    
+    // Radio
+    uint8_t  radioFlags;                        // NODE_CFG_RADIO_*
+    uint8_t  channel;                           // 0 = leave as is
+    int8_t   txPowerQuarterDbm;                 // 0 = leave as is
+    
+    // Parent failover
+    uint8_t  failoverMisses;                    // Beacon intervals without the parent; 0 = default
+    
+    // Transmit queue
+    uint8_t  txInFlight;                        // Frames handed to the driver at once; 0 = default
+    
+    // HID encoding
+    uint8_t  hidFormat;                         // TREE_ADDR_FORMAT_TAG the hid was written with
+    
+    // Channel bridge
+    uint8_t  childChannel;                      // Children's channel; 0 = same as this node
+    
+    // Report aggregation
+    uint8_t  reportWindowMs;                    // Hold child reports this long; 0 = forward at once
+    
+    uint32_t crc;                               // CRC-32 of all preceding bytes
+} __attribute__((packed)) NodeConfigRecord;
+
 /**
  * @brief Network statistics for display and monitoring
  */
@@ -121,16 +259,20 @@ struct NetworkStats {
     uint32_t messagesIgnored = 0;
     uint32_t securityViolations = 0;
     uint32_t lastMessageTime = 0;
-    String lastSenderMAC = "None";
+    uint8_t lastSenderMAC[6] = {0};   // Raw bytes; format with formatMAC() when displayed
+    bool hasLastSender = false;
     float signalStrength = 0.0f;
 };
 
+// Fixed-size status text so the receive path can update it without heap allocation
+#define STATUS_TEXT_LEN 32
+
 /**
  * @brief System status information
  */
 struct SystemStatus {
-    String currentStatus = "Ready";
-    String previousStatus = "";
+    char currentStatus[STATUS_TEXT_LEN] = "Ready";
+    char previousStatus[STATUS_TEXT_LEN] = "";
     uint32_t uptime = 0;
     uint16_t myHID = 0;
     bool isRoot = false;
@@ -152,20 +294,21 @@ public:
     void getNodeMAC(uint8_t* mac) const;
     
     // HID Management
-    bool setMyHID(uint16_t hid);
-    bool setHID(uint16_t hid) { return setMyHID(hid); } // Alias for compatibility
+    bool setMyHID(uint16_t hid, bool persist = true);
+    bool setHID(uint16_t hid, bool persist = true) { return setMyHID(hid, persist); } // Alias for compatibility
     uint16_t getMyHID() const { return systemStatus.myHID; }
     uint16_t getHID() const { return systemStatus.myHID; } // Alias for compatibility
     uint16_t getParentHID() const;
-    bool isRoot() const { return systemStatus.isRoot; }
+    uint16_t getUpstreamHID() const;      // Parent, or the foster while failed over
+    bool isRoot() const { return NODE_ROLE_HAS_ROOT && systemStatus.isRoot; }
     bool isHIDConfigured() const { return systemStatus.hidConfigured; }
     bool isValidChild(uint16_t childHID) const;
     bool isMyDescendant(uint16_t targetHID) const;
     void clearHIDFromNVM();
     
     // Bit Index Management
-    bool setMyBitIndex(uint8_t bitIndex);
-    bool setBitIndex(uint8_t bitIndex) { return setMyBitIndex(bitIndex); } // Alias for compatibility
+    bool setMyBitIndex(uint8_t bitIndex, bool persist = true);
+    bool setBitIndex(uint8_t bitIndex, bool persist = true) { return setMyBitIndex(bitIndex, persist); } // Alias for compatibility
     uint8_t getMyBitIndex() const { return systemStatus.myBitIndex; }
     uint8_t getBitIndex() const { return systemStatus.myBitIndex; } // Alias for compatibility
     bool isBitIndexConfigured() const { return systemStatus.bitIndexConfigured; }
@@ -177,6 +320,17 @@ public:
     bool isConfigured() const { return isDeviceFullyConfigured(); } // Alias for compatibility
     void clearAllConfiguration();
     
+    // Persistent Configuration (single versioned record, read once at boot)
+    const NodeConfigRecord& getNodeConfig() const { return nodeConfig; }
+    bool setPinMap(const uint8_t* inputPins, uint8_t inputCount,
+                   const uint8_t* outputPins, uint8_t outputCount, bool persist = true);
+    bool setPolicyFlags(uint8_t policyFlags, bool persist = true);
+    bool setRadioConfig(uint8_t radioFlags, uint8_t channel, int8_t txPowerQuarterDbm, bool persist = true);
+    bool setFailoverMisses(uint8_t misses, bool persist = true);
+    bool setTxInFlight(uint8_t frames, bool persist = true);
+    bool setChildChannel(uint8_t channel, bool persist = true);
+    bool setReportWindow(uint8_t windowMs, bool persist = true);
+    
     // Device Data Management
     void setMyDeviceData(const DeviceSpecificData& data) { myDeviceData = data; }
     const DeviceSpecificData& getMyDeviceData() const { return myDeviceData; }
@@ -184,14 +338,19 @@ public:
     bool updateDeviceData(uint16_t srcHID, const DeviceSpecificData& data);
     const DeviceSpecificData* getDeviceData(uint16_t srcHID) const;
     uint8_t getAggregatedDeviceCount() const { return aggregatedDeviceCount; }
+    bool getAggregatedDevice(uint8_t index, AggregatedDeviceInfo& out) const;
+    uint32_t getAggregatedUpdateSeq() const { return aggregatedUpdateSeq; }   // Bumped on every table change
     void showAggregatedDevices() const;
     void clearAggregatedData();
+    bool removeAggregatedDevice(uint16_t srcHID);
     
     // Distributed I/O Control
     void computeAndBroadcastDistributedIO();
     DistributedIOData computeSharedDataFromInputs() const;
     void setDistributedIOSharedData(const DistributedIOData& sharedData);
     DistributedIOData getDistributedIOSharedData() const;
+    uint32_t readDistributedIOSharedData(DistributedIOData& out) const;   // Returns snapshot version
+    uint32_t getDistributedIOVersion() const;                             // Bumped on every publish
     uint32_t getSharedData() const; // Get shared data as uint32 for compatibility
     void broadcastDistributedIOUpdate(const DistributedIOData& sharedData);
     void forwardDistributedIOUpdateToChildren(const DistributedIOData& sharedData);
@@ -215,6 +374,7 @@ public:
     bool handleIncomingTreeMessage(const uint8_t* data, int len, const uint8_t* senderMAC, int rssi = 0);
     bool createTreeMessage(uint8_t* buffer, size_t bufferSize, uint16_t destHID, 
                           TreeMessageType msgType, const uint8_t* payload, size_t payloadLen);
+    bool validateTreeMessage(const uint8_t* data, int len);
     
     // Routing Logic
     bool shouldProcessMessage(uint16_t destHID, uint16_t srcHID) const;
@@ -225,10 +385,13 @@ public:
     const NetworkStats& getNetworkStats() const { return networkStats; }
     void resetNetworkStats();
     const SystemStatus& getSystemStatus() const { return systemStatus; }
-    void updateStatus(const String& newStatus);
-    String getCurrentStatus() const { return systemStatus.currentStatus; }
+    void updateStatus(const char* newStatus);
+    void updateStatus(const String& newStatus) { updateStatus(newStatus.c_str()); }
+    void updateStatusf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    String getCurrentStatus() const { return String(systemStatus.currentStatus); }
+    const char* getCurrentStatusText() const { return systemStatus.currentStatus; }
     void update();
-    const uint8_t* getLastSenderMAC() const { return lastSenderMAC; }
+    const uint8_t* getLastSenderMAC() const { return networkStats.hasLastSender ? networkStats.lastSenderMAC : nullptr; }
 
     // Formatting Utilities
     String formatMAC(const uint8_t* mac) const;
@@ -241,8 +404,8 @@ public:
     void incrementMessagesForwarded() { networkStats.messagesForwarded++; }
     
     // NVM access (public for SerialCommandHandler)
-    bool loadHIDFromNVM();
-    bool loadBitIndexFromNVM();
+    bool loadConfigFromNVM();
+    bool saveConfigToNVM();
 
 private:
     DataManager();
@@ -250,8 +413,11 @@ private:
     DataManager& operator=(const DataManager&) = delete;
     
     // NVM access (private methods)
-    void saveHIDToNVM();
-    void saveBitIndexToNVM();
+    bool readConfigSlot(const char* key, NodeConfigRecord& record);
+    bool migrateLegacyConfig();
+    void resetNodeConfig();
+    void applyNodeConfig();
+    uint32_t calculateConfigCRC(const NodeConfigRecord& record) const;
 
     // Internal data members
     uint8_t nodeMac[6];
@@ -261,21 +427,39 @@ private:
     NetworkStats networkStats;
     
     DeviceSpecificData myDeviceData;
-    DistributedIOData distributedIOData;
+    
+    // Shared I/O snapshot: seqlock-protected double buffer.
+    // ioSnapshotSeq is odd while a writer fills the back buffer; the front
+    // buffer is ioSnapshot[(seq >> 1) & 1] and stays untouched until the
+    // *next* publish starts, so readers never block and rarely retry.
+    alignas(4) DistributedIOData ioSnapshot[2];
+    volatile uint32_t ioSnapshotSeq;
+    portMUX_TYPE ioWriterMux;   // Serializes writers only (root: loop + Wi-Fi task)
+    void publishDistributedIOFrame(const uint8_t* frame, size_t len);
     
     // Root node data aggregation
+#if NODE_ROLE_HAS_ROOT
     DeviceSpecificData globalDataArray[MAX_AGGREGATED_DEVICES];
     uint16_t deviceHIDArray[MAX_AGGREGATED_DEVICES];
     uint32_t deviceLastSeen[MAX_AGGREGATED_DEVICES];
+    uint32_t deviceUpdateSeq[MAX_AGGREGATED_DEVICES];
+#endif
     uint8_t aggregatedDeviceCount;
+    volatile uint32_t aggregatedUpdateSeq;
+    mutable portMUX_TYPE aggregateMux;   // Table is written from the Wi-Fi task, read from loop()
     int findDeviceIndex(uint16_t srcHID) const;
     
     Preferences* preferences;
+    NodeConfigRecord nodeConfig;        // Last record loaded from / saved to NVM
+    uint8_t nodeConfigSlot;             // Slot holding nodeConfig (0 = A, 1 = B)
+    
+    bool roleAllowsHID(uint16_t hid) const;
     
     // Message processing functions
-    bool validateTreeMessage(const uint8_t* data, int len);
     bool isValidParentChild(uint16_t parentHID, uint16_t childHID) const;
     void processDataReport(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen, const uint8_t* sender);
+    void processDataBatch(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen, const uint8_t* sender);
+    void storeReport(uint16_t srcHID, const DeviceSpecificData& data, const uint8_t* trailer);   // TopologyTrailer or nullptr
     void processCommand(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen, const uint8_t* sender);
     void processAcknowledgement(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen, const uint8_t* sender);
     void processDistributedIOUpdate(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen, const uint8_t* sender);
@@ -286,9 +470,6 @@ private:
     void incrementSecurityViolations() { networkStats.securityViolations++; }
     void updateLastSender(const uint8_t* senderMAC);
     void updateSignalStrength(float rssi) { networkStats.signalStrength = rssi; }
-    
-    // Last sender MAC address storage
-    uint8_t lastSenderMAC[6];
 
       // Output policy lives in OutputPolicy.{h,cpp}
 };
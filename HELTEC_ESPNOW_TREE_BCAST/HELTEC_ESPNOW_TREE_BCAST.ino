@@ -8,6 +8,19 @@
 #include "MenuSystem.h"
 #include "IoDevice.h"
 #include "SerialCommandHandler.h"
+#include "heap_guard.h"
+#include "boot_profiler.h"
+#include "bulk_transfer.h"
+#include "tree_ota.h"
+#include "parent_failover.h"
+#include "bit_allocator.h"
+#include "child_table.h"
+#include "tx_queue.h"
+#include "uplink.h"
+#include "rate_control.h"
+#include "channel_bridge.h"
+#include "report_aggregation.h"
+#include "frame_auth.h"
 
 // ============================================================================
 // GLOBAL VARIABLES
@@ -29,32 +42,65 @@ bool menuNeedsUpdate = false; // Flag to track if menu needs update due to user
 // SETUP FUNCTION
 // ============================================================================
 
+/**
+ * @brief Settle delay between init phases; skipped in fast boot
+ */
+static void bootDelay(unsigned long ms) {
+    #if !ENABLE_FAST_BOOT
+    delay(ms);
+    #endif
+}
+
+/**
+ * @brief Send the first data report straight from setup() so the parent sees
+ *        this node again without waiting for an input change or auto-report
+ */
+static void sendBootReport() {
+    if (!DATA_MGR.isHIDConfigured() || DATA_MGR.isRoot()) {
+        return;
+    }
+    IO_DEVICE.updateDeviceDataFromIO();   // Inputs were sampled by configurePins()
+    sendDataReportToParent();
+}
+
 void setup() {
     Serial.begin(115200);
+    #if !ENABLE_FAST_BOOT
     while (!Serial && millis() < 3000); // Wait up to 3 seconds for Serial
+    #endif
+    bootMark("serial");
     
     Serial.println("\n=== ESP-NOW Tree Network Starting ===");
     
-    // Initialize core systems with small delays to prevent stack buildup
+    // Display init runs in the background; nothing draws until the menu
+    // system is initialized below
+    #if ENABLE_OLED && ENABLE_FAST_BOOT
+    setupDisplayAsync();
+    #endif
+    
+    // Initialize core systems
     DATA_MGR.initialize();
-    delay(100);
+    bootMark("data_mgr");
+    bootDelay(100);
     
     TREE_NET.initialize();
-    delay(100);
+    bootMark("tree_net");
+    bootDelay(100);
+    
+    IO_DEVICE.initialize();
+    bootMark("io_device");
+    bootDelay(100);
     
-    Serial.println("About to initialize IoDevice...");
-    IO_DEVICE.initialize();  // Re-enable with debugging
-    Serial.println("IoDevice initialization complete");
-    delay(100);
+    treeOtaInit();
+    bitAllocInit();
+    frameAuthInit();
     
-    // Initialize display system
-    #if ENABLE_OLED
+    #if ENABLE_OLED && !ENABLE_FAST_BOOT
     setupDisplay();
     Serial.println("OLED display initialized");
-    #else
-    Serial.println("OLED display disabled - using Serial output");
+    bootMark("oled");
+    bootDelay(100);
     #endif
-    delay(100);
     
     // Initialize ESP-NOW
     if (espnowInit()) {
@@ -62,21 +108,37 @@ void setup() {
     } else {
         Serial.println("ESP-NOW initialization failed!");
     }
-    delay(100);
+    bootMark("espnow");
+    
+    #if ENABLE_FAST_BOOT
+    sendBootReport();
+    bootMark("boot_report");
+    #endif
+    bootDelay(100);
+    
+    #if ENABLE_OLED && ENABLE_FAST_BOOT
+    waitForDisplayReady();
+    Serial.println("OLED display initialized");
+    bootMark("oled");
+    #elif !ENABLE_OLED
+    Serial.println("OLED display disabled - using Serial output");
+    #endif
     
     // Initialize menu system
     MENU_SYS.initialize();
-    delay(100);
+    bootDelay(100);
     
     // Initialize serial command handler
     SERIAL_CMD.initialize();
-    delay(100);
+    bootDelay(100);
     
     // Initialize button
     setupButton(BUTTON_PIN);
+    bootMark("setup_done");
     
     Serial.println("=== Setup Complete ===\n");
     DATA_MGR.updateStatus("System Ready");
+    bootProfilerPrint();
     
     // Print initial button statistics
     printButtonDebugStats();
@@ -108,14 +170,27 @@ void loop() {
     // PRIORITY 3: Core system updates (medium priority)
     DATA_MGR.update();
     TREE_NET.processAutoReporting();
+    failoverUpdate();                     // Link beacons, parent liveness and failover
+    bitAllocUpdate();                     // Bit index requests and the root's leases
+    childTableUpdate();                   // Forwarding load window
+    txQueueUpdate();                      // Retry frames the radio had no room for
+    uplinkUpdate();                       // Drop peers of replaced parent MACs
+    rateUpdate();                         // Per-peer PHY rate steps
+    bridgeUpdate();                       // Channel dwell schedule and held frames
+    aggUpdate();                          // Send batched child reports when their window closes
+    frameAuthUpdate();                    // Reserve the next block of frame counters in NVM
     
     // PRIORITY 4: I/O operations (lower priority, but still important)
-    if (millis() > 1000) {
+    // Fast boot has already reported once from setup(), so no warm-up hold-off
+    if (ENABLE_FAST_BOOT || millis() > 1000) {
         IO_DEVICE.scanInputs();           // Scan for input changes
         IO_DEVICE.checkAndSendReport();   // Handle auto-reporting based on I/O changes
     }
     
     // PRIORITY 5: Network operations (lowest priority)
+    bulkUpdate();                         // Bulk transfers go after this pass's I/O reports
+    treeOtaUpdate();                      // So do firmware blocks
+    
     if (continuousBroadcastEnabled && millis() - lastBroadcastTime >= BROADCAST_INTERVAL) {
         lastBroadcastTime = millis();
     }
@@ -139,6 +214,8 @@ void loop() {
     }
     
     // PRIORITY 7: Debug operations (lowest priority)
+    allocGuardPoll();   // Report heap allocations on the receive path
+    
     static unsigned long lastButtonStatsTime = 0;
     if (millis() - lastButtonStatsTime >= 10000) {
         printButtonDebugStats();
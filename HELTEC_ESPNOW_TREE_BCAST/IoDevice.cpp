@@ -1,12 +1,13 @@
 #include "IoDevice.h"
 #include "TreeNetwork.h"
 #include "espnow_wrapper.h"
+#include "io_slice.h"
 #include "debug.h"
 
 // Logging macros
 #define MODULE_TITLE       "IO_DEVICE"
 #define MODULE_DEBUG_LEVEL 1
-#define ioLog(msg, lvl) debugPrint(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+#define ioLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
 
 // ============================================================================
 // SINGLETON IMPLEMENTATION
@@ -58,22 +59,35 @@ void IoDevice::initialize() {
     inputChangeCount = 0;
     lastInputChangeTime = 0;
     currentOutputStates = 0;
-    autoReportOnChange = true;
     lastReportTime = 0;
     
+    // Policy flags come from the persistent config record (read once at boot)
+    const NodeConfigRecord& config = DATA_MGR.getNodeConfig();
+    autoReportOnChange = (config.policyFlags & NODE_CFG_POLICY_AUTO_REPORT) != 0;
+    testModeEnabled = (config.policyFlags & NODE_CFG_POLICY_TEST_MODE) != 0;
+    
     ioLog("Member variables initialized", 4);
     
     #if ENABLE_IO_DEVICE_PINS
-    // Heltec V3 pin configuration
-    // Input pins: 7, 6, 5 (as requested) - GPIO_0 handled by button system
-    // Output pins: 4, 3, 2 (as requested)
+    // Heltec V3 default pin configuration, used until a pin map is saved
+    // (CONFIG_SAVE io_map, up to MAX_INPUT_PINS inputs and MAX_OUTPUT_PINS outputs)
+    // Input pins: 7, 6, 5 - GPIO_0 handled by button system
+    // Output pins: 4, 3, 2
     // OLED uses: GPIO17 (SDA), GPIO18 (SCL), GPIO21 (RST), GPIO36 (VEXT)
     // Button uses: GPIO0 (boot/prog button) - handled separately by button system
-    uint8_t defaultInputs[] = {7, 6, 5};     // 3 input pins (7,6,5 as requested)
-    uint8_t defaultOutputs[] = {4, 3, 2};   // 3 output pins (4,3,2 as requested)
-    
-    ioLog("About to configure pins", 4);
-    configurePins(defaultInputs, 3, defaultOutputs, 3);
+    uint8_t defaultInputs[] = {7, 6, 5};
+    uint8_t defaultOutputs[] = {4, 3, 2};
+    
+    // A stored pin map overrides the board defaults
+    if (config.inputCount > 0 || config.outputCount > 0) {
+        uint8_t storedInputs = config.inputCount > MAX_INPUT_PINS ? MAX_INPUT_PINS : config.inputCount;
+        uint8_t storedOutputs = config.outputCount > MAX_OUTPUT_PINS ? MAX_OUTPUT_PINS : config.outputCount;
+        ioLog("Using stored pin map", 3);
+        configurePins(config.inputPins, storedInputs, config.outputPins, storedOutputs);
+    } else {
+        ioLog("About to configure pins", 4);
+        configurePins(defaultInputs, 3, defaultOutputs, 3);
+    }
     ioLog("Pin configuration complete", 3);
     #else
     ioLog("Pin configuration disabled for debugging", 2);
@@ -178,7 +192,7 @@ void IoDevice::scanInputs() {
     }
     lastInputScan = now;
     
-    uint8_t rawStates = readInputPins();
+    uint16_t rawStates = readInputPins();
     
     // If the raw state is different from the last time we checked, it means things are unstable.
     // We reset the debounce timer.
@@ -204,8 +218,8 @@ void IoDevice::scanInputs() {
     previousInputStates = rawStates;
 }
 
-uint8_t IoDevice::readInputPins() {
-    uint8_t states = 0;
+uint16_t IoDevice::readInputPins() {
+    uint16_t states = 0;
     
     if (!pinsConfigured || inputCount == 0) {
         return states;
@@ -230,12 +244,12 @@ uint8_t IoDevice::readInputPins() {
             states |= 0x01; // Set bit 0
         }
         
-        // Process remaining physical input pins (1-7) normally
+        // Process remaining physical input pins normally
         for (int i = 1; i < inputCount; i++) {
             bool pinState = digitalRead(inputPins[i]);
             // For pull-up inputs: HIGH = not pressed, LOW = pressed
             if (pinState == LOW) {  // Pin pulled low = button pressed = set bit to 1
-                states |= (1 << i);
+                states |= (1U << i);
             }
         }
     } else {
@@ -244,7 +258,7 @@ uint8_t IoDevice::readInputPins() {
             bool pinState = digitalRead(inputPins[i]);
             // For pull-up inputs: HIGH = not pressed, LOW = pressed
             if (pinState == LOW) {  // Pin pulled low = button pressed = set bit to 1
-                states |= (1 << i);
+                states |= (1U << i);
             }
             
             // Debug output for GPIO 0 changes
@@ -266,7 +280,7 @@ uint8_t IoDevice::readInputPins() {
 // OUTPUT MANAGEMENT
 // ============================================================================
 
-void IoDevice::updateOutputs(uint8_t outputStates) {
+void IoDevice::updateOutputs(uint16_t outputStates) {
     if (!pinsConfigured) {
         ioLog("Pins not configured", 2);
         return;
@@ -280,8 +294,8 @@ void IoDevice::updateOutputs(uint8_t outputStates) {
 
 void IoDevice::updateOutputsFromSharedData(const DistributedIOData& sharedData) {
     // New mapping: outputs are root-controlled per device bit index.
-    // For each local output N (0..2), set state from sharedOutputs[N][my_bit_index].
-    uint8_t outputStates = 0;
+    // For each local output N (0..outputCount-1), set state from sharedOutputs[N][my_bit_index].
+    uint16_t outputStates = 0;
 
     uint8_t myBitIndex = DATA_MGR.getMyBitIndex();
     if (!DATA_MGR.isValidBitIndex(myBitIndex)) {
@@ -289,12 +303,13 @@ void IoDevice::updateOutputsFromSharedData(const DistributedIOData& sharedData)
         myBitIndex = 0;
     }
 
-    int bitInWord = myBitIndex % 32;
+    int wordIndex = myBitIndex / BITS_PER_WORD;
+    int bitInWord = myBitIndex % BITS_PER_WORD;
     for (int outputIndex = 0; outputIndex < outputCount; outputIndex++) {
-        uint32_t word = sharedData.sharedOutputs[outputIndex][0];
+        uint32_t word = sharedData.sharedOutputs[outputIndex][wordIndex];
         bool state = ((word >> bitInWord) & 0x01) != 0;
         if (state) {
-            outputStates |= (1 << outputIndex);
+            outputStates |= (1U << outputIndex);
         }
     }
 
@@ -308,7 +323,7 @@ void IoDevice::updateOutputsFromSharedData(const DistributedIOData& sharedData)
     updateDeviceDataFromIO();
 }
 
-void IoDevice::writeOutputPins(uint8_t states) {
+void IoDevice::writeOutputPins(uint16_t states) {
     if (!pinsConfigured || outputCount == 0) {
         return;
     }
@@ -350,8 +365,8 @@ void IoDevice::broadcastSharedData() {
     
     ioLog("ROOT: Broadcasting shared data: " + DATA_MGR.formatDistributedIOData(data), 2);
     
-    // Send a single broadcast message to all listening children
-    TREE_NET.sendBroadcastTreeCommand(MSG_DISTRIBUTED_IO_UPDATE, (const uint8_t*)&data, sizeof(DistributedIOData));
+    // Send a single broadcast message to all listening children, cut down to their bits
+    ioSliceSend(data);
 }
 
 void IoDevice::processSharedDataUpdate(const DistributedIOData& newSharedData) {
@@ -419,14 +434,14 @@ void IoDevice::updateDeviceDataFromIO() {
     
     // Debug: Log what we're about to send to DataManager
     ioLog("Updating DataManager with input_states: " + String(data.input_states, BIN) + 
-          " (" + String(data.input_states) + "), output_states: " + String(data.output_states, BIN), 1);
+          " (" + String(data.input_states) + "), output_states: " + String(data.output_states, BIN), 4);
     
     DATA_MGR.setMyDeviceData(data);
     
     // Debug: Verify what DataManager actually stored
     const DeviceSpecificData& storedData = DATA_MGR.getMyDeviceData();
     ioLog("DataManager now has input_states: " + String(storedData.input_states, BIN) + 
-          " (" + String(storedData.input_states) + "), output_states: " + String(storedData.output_states, BIN), 1);
+          " (" + String(storedData.input_states) + "), output_states: " + String(storedData.output_states, BIN), 4);
 }
 
 void IoDevice::processReceivedDeviceData(const DeviceSpecificData& data) {
@@ -15,15 +15,12 @@
 // Set to 0 to disable distributed I/O features (for debugging)
 #define ENABLE_DISTRIBUTED_IO 1
 
-// Maximum number of I/O pins supported
-#define MAX_INPUT_PINS 3
-#define MAX_OUTPUT_PINS 3
+// Maximum number of I/O pins supported: one shared I/Q plane each (MAX_INPUTS)
+#define MAX_INPUT_PINS MAX_INPUTS
+#define MAX_OUTPUT_PINS MAX_INPUTS
 #define DEBOUNCE_DELAY_MS 50
 #define INPUT_SCAN_INTERVAL_MS 10
 
-// Maximum number of inputs supported
-#define MAX_INPUTS 3
-
 // ============================================================================
 // I/O DEVICE CLASS
 // ============================================================================
@@ -48,18 +45,20 @@ public:
     // INPUT MANAGEMENT
     // ========================================================================
     void scanInputs();              // Call in main loop
-    uint8_t getCurrentInputStates() const { return currentInputStates; }
-    uint8_t getInputStates() const { return currentInputStates; } // Alias for compatibility
+    uint16_t getCurrentInputStates() const { return currentInputStates; }
+    uint16_t getInputStates() const { return currentInputStates; } // Alias for compatibility
+    uint8_t getInputCount() const { return inputCount; }
     bool hasInputChanged() const { return inputChanged; }
     void clearInputChangedFlag() { inputChanged = false; }
     
     // ========================================================================
     // OUTPUT MANAGEMENT  
     // ========================================================================
-    void updateOutputs(uint8_t outputStates);
+    void updateOutputs(uint16_t outputStates);
     void updateOutputsFromSharedData(const DistributedIOData& sharedData);
-    uint8_t getCurrentOutputStates() const { return currentOutputStates; }
-    uint8_t getOutputStates() const { return currentOutputStates; } // Alias for compatibility
+    uint16_t getCurrentOutputStates() const { return currentOutputStates; }
+    uint16_t getOutputStates() const { return currentOutputStates; } // Alias for compatibility
+    uint8_t getOutputCount() const { return outputCount; }
     
     // ========================================================================
     // INPUT CHANGE TRACKING
@@ -117,8 +116,8 @@ private:
     bool pinsConfigured;
     
     // Input state tracking
-    uint8_t currentInputStates;     // The final, debounced state for external use
-    uint8_t previousInputStates;    // The raw state from the previous scan, for debounce checking
+    uint16_t currentInputStates;    // The final, debounced state for external use
+    uint16_t previousInputStates;   // The raw state from the previous scan, for debounce checking
     unsigned long lastInputScan;
     unsigned long lastDebounceTime;   // A single debounce timer for all inputs
     bool inputChanged;
@@ -126,7 +125,7 @@ private:
     uint32_t lastInputChangeTime;   // Timestamp of last input change
     
     // Output state tracking
-    uint8_t currentOutputStates;
+    uint16_t currentOutputStates;
     
     // Shared data (32 bits)
     DistributedIOData distributedIOData;
@@ -140,8 +139,8 @@ private:
     
     // Helper functions
     void logIOOperation(const String& operation, bool success, const String& details = "");
-    uint8_t readInputPins();
-    void writeOutputPins(uint8_t states);
+    uint16_t readInputPins();
+    void writeOutputPins(uint16_t states);
     bool debounceInput(uint8_t pinIndex, bool currentState);
 };
 
@@ -6,11 +6,12 @@
 #include "helper.h"
 #include "oled.h"
 #include "IoDevice.h"
+#include "bit_allocator.h"
 
 // Logging macros
 #define MODULE_TITLE       "MENU_SYS"
 #define MODULE_DEBUG_LEVEL 1
-#define menuLog(msg, lvl) debugPrint(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+#define menuLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
 
 // Forward declarations for main application functions
 void setContinuousBroadcast(bool enabled);
@@ -21,13 +22,24 @@ bool isContinuousBroadcastEnabled();
 // ============================================================================
 
 // Static buffer definitions
-char HidConfigMenuProvider::textBuffers[6][20];
+char HidConfigMenuProvider::textBuffers[TREE_ADDR_MAX_CHILDREN + 1][24];
 char BitIndexConfigMenuProvider::textBuffers[10][25];
 
 HidConfigMenuProvider::HidConfigMenuProvider() : currentHid(1), hidConfigDepth(1) {
     menuLog("HidConfigMenuProvider created.", 4);
 }
 
+/**
+ * @brief Children offered under currentHid: all TREE_ADDR_MAX_CHILDREN, or
+ *        none at the deepest level (a node's children are all valid or none are)
+ */
+int HidConfigMenuProvider::childCount() const {
+    if (hidConfigDepth > TREE_ADDR_MAX_DEPTH || !treeAddrIsValid(treeAddrChild(currentHid, 0))) {
+        return 0;
+    }
+    return TREE_ADDR_MAX_CHILDREN;
+}
+
 // ============================================================================
 // BIT INDEX CONFIG MENU PROVIDER IMPLEMENTATION
 // ============================================================================
@@ -48,7 +60,9 @@ const char* HidConfigMenuProvider::getItemText(int index) {
 
     // Item 0 is always "Set HID"
     if (index == 0) {
-        snprintf(textBuffers[0], sizeof(textBuffers[0]), "Set HID: %lu", currentHid);
+        char path[TREE_ADDR_FORMAT_LEN];
+        treeAddrFormat(currentHid, path, sizeof(path));
+        snprintf(textBuffers[0], sizeof(textBuffers[0]), "Set HID: %s", path);
         return textBuffers[0];
     }
 
@@ -64,7 +78,9 @@ const char* HidConfigMenuProvider::getItemText(int index) {
     
     // Child nodes
     int childIndex = index - (hidConfigDepth > 1 ? 2 : 1);
-    snprintf(textBuffers[childIndex + 1], sizeof(textBuffers[childIndex + 1]), "Child: %lu%d", currentHid, childIndex + 1);
+    char path[TREE_ADDR_FORMAT_LEN];
+    treeAddrFormat(treeAddrChild(currentHid, childIndex), path, sizeof(path));
+    snprintf(textBuffers[childIndex + 1], sizeof(textBuffers[childIndex + 1]), "Child: %s", path);
     return textBuffers[childIndex + 1];
 }
 
@@ -75,8 +91,8 @@ void HidConfigMenuProvider::selectItem(int index) {
     // "Set HID"
     if (index == 0) {
         TREE_NET.setManualHID(currentHid);
-        DATA_MGR.updateStatus("HID Set: " + String(currentHid));
-        menuLog("HID configured to " + String(currentHid), 3);
+        DATA_MGR.updateStatus("HID Set: " + DATA_MGR.formatHID(currentHid));
+        menuLog("HID configured to " + DATA_MGR.formatHID(currentHid), 3);
         
         // Check if we're in device configuration mode
         if (MENU_SYS.isInDeviceConfigMode()) {
@@ -91,9 +107,9 @@ void HidConfigMenuProvider::selectItem(int index) {
 
     // "Go Up"
     if (hidConfigDepth > 1 && index == 1) {
-        currentHid /= 10;
+        currentHid = treeAddrParent(currentHid);
         hidConfigDepth--;
-        menuLog("HID config: up to " + String(currentHid), 4);
+        menuLog("HID config: up to " + DATA_MGR.formatHID(currentHid), 4);
         return;
     }
 
@@ -105,10 +121,10 @@ void HidConfigMenuProvider::selectItem(int index) {
 
     // Child nodes
     int childIndex = index - (hidConfigDepth > 1 ? 2 : 1);
-    if (hidConfigDepth < 4) {
-        currentHid = currentHid * 10 + (childIndex + 1);
+    if (childIndex < childCount()) {
+        currentHid = treeAddrChild(currentHid, childIndex);
         hidConfigDepth++;
-        menuLog("HID config: down to " + String(currentHid), 4);
+        menuLog("HID config: down to " + DATA_MGR.formatHID(currentHid), 4);
     }
 }
 
@@ -123,6 +139,9 @@ int BitIndexConfigMenuProvider::getItemCount() {
     if (hasPrevPage()) count++; // Prev Page
     if (hasNextPage()) count++; // Next Page
     
+    // Ask the root for a bit (first page only)
+    if (currentPage == 0) count++;
+    
     // Bit indices for current page
     count += BITS_PER_PAGE;
     
@@ -153,6 +172,14 @@ const char* BitIndexConfigMenuProvider::getItemText(int index) {
         itemIndex++;
     }
     
+    // Auto Assign
+    if (currentPage == 0) {
+        if (index == itemIndex) {
+            return "Auto Assign";
+        }
+        itemIndex++;
+    }
+    
     // Bit indices for current page
     uint8_t pageStart = getPageStartBit();
     for (int i = 0; i < BITS_PER_PAGE; i++) {
@@ -199,6 +226,18 @@ void BitIndexConfigMenuProvider::selectItem(int index) {
         itemIndex++;
     }
     
+    // Auto Assign
+    if (currentPage == 0) {
+        if (index == itemIndex) {
+            menuLog("User requested automatic bit index", 3);
+            bitAllocRequest(BIT_NO_PREFERENCE);
+            DATA_MGR.updateStatus("Bit requested");
+            MENU_SYS.exitBitIndexConfigMode();
+            return;
+        }
+        itemIndex++;
+    }
+    
     // Bit indices for current page
     uint8_t pageStart = getPageStartBit();
     for (int i = 0; i < BITS_PER_PAGE; i++) {
@@ -241,14 +280,9 @@ void consoleLogSharedDataChange(uint32_t oldSharedData, uint32_t newSharedData)
         uint32_t newBit = (newSharedData >> bitIndex) & 1;
         
         if (oldBit != newBit) {
-            String msg;
-            if (newBit == 1) {
-                // Button pressed
-                msg = "B" + String(bitIndex) + " Pressed";
-            } else {
-                // Button released
-                msg = "B" + String(bitIndex) + " Released";
-            }
+            // Called from the receive path: format into a stack buffer, not a String
+            char msg[CONSOLE_MESSAGE_LEN];
+            snprintf(msg, sizeof(msg), "B%d %s", bitIndex, newBit == 1 ? "Pressed" : "Released");
             MENU_SYS.addConsoleMessage(msg);
         }
     }
@@ -263,20 +297,20 @@ void consoleLogSharedDataChange(uint32_t oldSharedData, uint32_t newSharedData)
 ConsoleDisplay::ConsoleDisplay() : messageCount(0), oldestIndex(0) {
     // Initialize all messages to empty
     for (int i = 0; i < MAX_MESSAGES; i++) {
-        messages[i].message = "";
+        messages[i].message[0] = '\0';
         messages[i].timestamp = 0;
     }
 }
 
-void ConsoleDisplay::addMessage(const String& msg) {
+void ConsoleDisplay::addMessage(const char* msg) {
     if (messageCount < MAX_MESSAGES) {
         // Add to next available slot
-        messages[messageCount].message = msg;
+        strlcpy(messages[messageCount].message, msg, CONSOLE_MESSAGE_LEN);
         messages[messageCount].timestamp = millis();
         messageCount++;
     } else {
         // Replace oldest message
-        messages[oldestIndex].message = msg;
+        strlcpy(messages[oldestIndex].message, msg, CONSOLE_MESSAGE_LEN);
         messages[oldestIndex].timestamp = millis();
         oldestIndex = (oldestIndex + 1) % MAX_MESSAGES;
     }
@@ -286,14 +320,14 @@ void ConsoleDisplay::clear() {
     messageCount = 0;
     oldestIndex = 0;
     for (int i = 0; i < MAX_MESSAGES; i++) {
-        messages[i].message = "";
+        messages[i].message[0] = '\0';
         messages[i].timestamp = 0;
     }
 }
 
 const ConsoleMessage& ConsoleDisplay::getMessage(int index) const {
     if (index < 0 || index >= messageCount) {
-        static ConsoleMessage emptyMsg = {"", 0};
+        static ConsoleMessage emptyMsg = {{0}, 0};
         return emptyMsg;
     }
     
@@ -542,7 +576,7 @@ void MenuSystem::setConsoleMode(bool consoleMode) {
     }
 }
 
-void MenuSystem::addConsoleMessage(const String& msg) {
+void MenuSystem::addConsoleMessage(const char* msg) {
     consoleDisplay.addMessage(msg);
 }
 
@@ -560,6 +594,7 @@ void MenuSystem::showConsoleDisplay() {
 
 void MenuSystem::drawConsoleOLED() {
 #if ENABLE_OLED
+    uint32_t composeStart = micros();
     display.clearBuffer();
     
     // Header with HID and bit index info
@@ -623,16 +658,14 @@ void MenuSystem::drawConsoleOLED() {
         int y = startY + (i * lineHeight);
         
         // Truncate message if too long for display
-        String displayMsg = msg.message;
-        if (displayMsg.length() > 16) {
-            displayMsg = displayMsg.substring(0, 16);
-        }
+        char displayMsg[17];
+        strlcpy(displayMsg, msg.message, sizeof(displayMsg));
         
         display.setCursor(0, y);
         display.print(displayMsg);
     }
     
-    display.sendBuffer();
+    oledSubmitFrame(micros() - composeStart);
 #endif
 }
 
@@ -662,7 +695,8 @@ void MenuSystem::displayConsoleSerial() {
         
         for (int i = 0; i < messageCount && i < 10; i++) {
             const ConsoleMessage& msg = consoleDisplay.getMessage(i);
-            Serial.println("  " + msg.message);
+            Serial.print("  ");
+            Serial.println(msg.message);
         }
         
         Serial.println("======================");
@@ -672,19 +706,15 @@ void MenuSystem::displayConsoleSerial() {
 
 void MenuSystem::drawMenuOLED() {
 #if ENABLE_OLED
-    unsigned long drawStart = millis();
+    uint32_t composeStart = micros();
     
     display.clearBuffer();
-    unsigned long clearTime = millis() - drawStart;
-    
     display.setFont(u8g2_font_ncenB08_tr);
-    unsigned long fontTime = millis() - drawStart - clearTime;
 
     // Get the menu title
     const char* title = (menuStackDepth > 0) ? menuStack[menuStackDepth - 1].menu[menuStack[menuStackDepth - 1].selectedIndex].text : "Main Menu";
     display.drawStr(0, 10, title);
     display.drawHLine(0, 12, 128);
-    unsigned long titleTime = millis() - drawStart - clearTime - fontTime;
 
     display.setFont(u8g2_font_ncenR08_tr);
     int menuSize = getCurrentMenuSize();
@@ -714,7 +744,6 @@ void MenuSystem::drawMenuOLED() {
         const char* itemText = getCurrentItemText(itemIndex);
         display.drawStr(10, y, itemText);
     }
-    unsigned long menuTime = millis() - drawStart - clearTime - fontTime - titleTime;
     
     // Draw scroll indicators if needed
     if (scrollOffset > 0) {
@@ -726,25 +755,8 @@ void MenuSystem::drawMenuOLED() {
         display.drawStr(120, 60, "v");
     }
     
-    unsigned long preSendTime = millis() - drawStart;
-    
-    // This is likely the blocking operation
-    display.sendBuffer();
-    
-    unsigned long totalTime = millis() - drawStart;
-    unsigned long sendTime = totalTime - preSendTime;
-    
-    // Log timing if it's taking too long
-    if (totalTime > 50) {
-        Serial.println("=== OLED MENU TIMING ANALYSIS ===");
-        Serial.println("Clear buffer: " + String(clearTime) + "ms");
-        Serial.println("Set font: " + String(fontTime) + "ms");
-        Serial.println("Draw title: " + String(titleTime) + "ms");
-        Serial.println("Draw menu items: " + String(menuTime) + "ms");
-        Serial.println("Send buffer: " + String(sendTime) + "ms");
-        Serial.println("Total time: " + String(totalTime) + "ms");
-        Serial.println("================================");
-    }
+    // Transfer happens in the render task; only changed tiles go over I2C
+    oledSubmitFrame(micros() - composeStart);
 #endif
 }
 
@@ -811,14 +823,12 @@ void MenuSystem::displaySerial() {
 
 void MenuSystem::drawStatusOLED() {
 #if ENABLE_OLED
-    unsigned long drawStart = millis();
-    
     static int lastSelectedIndex = -1;
     static const MenuItem* lastMenu = nullptr;
     static bool wasDynamic = false;
-    static uint8_t lastInputStates = 255; // Track I/O state changes
-    static uint8_t lastOutputStates = 255;
-    static uint32_t lastSharedData = 0xFFFFFFFF; // Track shared data changes
+    static uint32_t lastInputStates = 0xFFFFFFFF; // Track I/O state changes
+    static uint32_t lastOutputStates = 0xFFFFFFFF;
+    static uint32_t lastIOVersion = 0xFFFFFFFF; // Track shared I/O snapshot version
     static uint16_t lastHID = 0xFFFF; // Track HID changes
     static uint8_t lastBitIndex = 0xFF; // Track Bit Index changes
     static bool lastHIDConfigured = false; // Track HID configuration status
@@ -828,9 +838,9 @@ void MenuSystem::drawStatusOLED() {
 
     // Get current I/O states and shared data to check for changes
     const DeviceSpecificData& myData = DATA_MGR.getMyDeviceData();
-    uint8_t currentInputStates = myData.input_states;
-    uint8_t currentOutputStates = myData.output_states;
-    uint32_t currentSharedData = DATA_MGR.getDistributedIOSharedData().sharedData[0][0];
+    uint16_t currentInputStates = myData.input_states;
+    uint16_t currentOutputStates = myData.output_states;
+    uint32_t currentIOVersion = DATA_MGR.getDistributedIOVersion(); // Cheap: no snapshot copy
     
     // Get current configuration values
     uint16_t currentHID = DATA_MGR.getMyHID();
@@ -844,7 +854,7 @@ void MenuSystem::drawStatusOLED() {
                        currentMenu != lastMenu ||
                        currentInputStates != lastInputStates ||
                        currentOutputStates != lastOutputStates ||
-                       currentSharedData != lastSharedData ||
+                       currentIOVersion != lastIOVersion ||
                        currentHID != lastHID ||
                        currentBitIndex != lastBitIndex ||
                        currentHIDConfigured != lastHIDConfigured ||
@@ -860,7 +870,7 @@ void MenuSystem::drawStatusOLED() {
     wasDynamic = isDynamic;
     lastInputStates = currentInputStates;
     lastOutputStates = currentOutputStates;
-    lastSharedData = currentSharedData;
+    lastIOVersion = currentIOVersion;
     lastHID = currentHID;
     lastBitIndex = currentBitIndex;
     lastHIDConfigured = currentHIDConfigured;
@@ -878,8 +888,8 @@ void MenuSystem::drawStatusOLED() {
                       " Value: " + String(currentHID));
     }
 
+    uint32_t composeStart = micros();
     display.clearBuffer();
-    unsigned long clearTime = millis() - drawStart;
     
     // Header with HID and bit index info
     display.setFont(u8g2_font_ncenB08_tr);
@@ -924,18 +934,20 @@ void MenuSystem::drawStatusOLED() {
     } else {
         display.print("Device Not Configured");
     }
-    unsigned long headerTime = millis() - drawStart - clearTime;
     
     // I/O states section
     display.setFont(u8g2_font_ncenR08_tr);
     
-    uint8_t inputs = myData.input_states;
-    uint8_t outputs = myData.output_states;
+    uint16_t inputs = myData.input_states;
+    uint16_t outputs = myData.output_states;
     uint32_t shared = DATA_MGR.getDistributedIOSharedData().sharedData[0][0];
+    // Eight states fit beside the labels; nodes with more I/O show all sixteen
+    bool wideIO = IO_DEVICE.getInputCount() > 8 || IO_DEVICE.getOutputCount() > 8;
+    int topBit = wideIO ? 15 : 7;
     
     // Debug: Log what we're about to display
-    static uint8_t lastDisplayedInputs = 255; // Initialize to invalid value
-    static uint8_t lastDisplayedOutputs = 255;
+    static uint32_t lastDisplayedInputs = 0xFFFFFFFF; // Initialize to invalid value
+    static uint32_t lastDisplayedOutputs = 0xFFFFFFFF;
     static uint32_t lastDisplayedShared = 0xFFFFFFFF;
     
     if (inputs != lastDisplayedInputs || outputs != lastDisplayedOutputs || shared != lastDisplayedShared) {
@@ -950,18 +962,18 @@ void MenuSystem::drawStatusOLED() {
     
     // Input states (as binary)
     display.setCursor(0, 24);
-    display.print("Input: ");
-    for (int i = 7; i >= 0; i--) {
-        display.print((inputs & (1 << i)) ? "1" : "0");
-        if (i == 4) display.print(" "); // Space between nibbles
+    display.print(wideIO ? "In: " : "Input: ");
+    for (int i = topBit; i >= 0; i--) {
+        display.print((inputs & (1U << i)) ? "1" : "0");
+        if (i > 0 && (i % 4) == 0) display.print(" "); // Space between nibbles
     }
     
     // Output states (as binary)
     display.setCursor(0, 36);
-    display.print("Output:");
-    for (int i = 7; i >= 0; i--) {
-        display.print((outputs & (1 << i)) ? "1" : "0");
-        if (i == 4) display.print(" "); // Space between nibbles
+    display.print(wideIO ? "Out:" : "Output:");
+    for (int i = topBit; i >= 0; i--) {
+        display.print((outputs & (1U << i)) ? "1" : "0");
+        if (i > 0 && (i % 4) == 0) display.print(" "); // Space between nibbles
     }
     
     // Shared data (as binary bitmap)
@@ -976,7 +988,6 @@ void MenuSystem::drawStatusOLED() {
             display.print(" ");
         }
     }
-    unsigned long ioTime = millis() - drawStart - clearTime - headerTime;
     
     // Network stats section
     display.setCursor(0, 60);
@@ -992,27 +1003,9 @@ void MenuSystem::drawStatusOLED() {
     } else {
         display.print("RX: No traffic");
     }
-    unsigned long statsTime = millis() - drawStart - clearTime - headerTime - ioTime;
     
-    unsigned long preSendTime = millis() - drawStart;
-    
-    // This is likely the blocking operation
-    display.sendBuffer();
-    
-    unsigned long totalTime = millis() - drawStart;
-    unsigned long sendTime = totalTime - preSendTime;
-    
-    // Log timing if it's taking too long
-    if (totalTime > 50) {
-        Serial.println("=== OLED STATUS TIMING ANALYSIS ===");
-        Serial.println("Clear buffer: " + String(clearTime) + "ms");
-        Serial.println("Draw header: " + String(headerTime) + "ms");
-        Serial.println("Draw I/O states: " + String(ioTime) + "ms");
-        Serial.println("Draw stats: " + String(statsTime) + "ms");
-        Serial.println("Send buffer: " + String(sendTime) + "ms");
-        Serial.println("Total time: " + String(totalTime) + "ms");
-        Serial.println("===================================");
-    }
+    // Transfer happens in the render task; only changed tiles go over I2C
+    oledSubmitFrame(micros() - composeStart);
 #endif
 }
 
@@ -1041,14 +1034,14 @@ void MenuSystem::displayStatusSerial() {
         // I/O states
         const DeviceSpecificData& myData = DATA_MGR.getMyDeviceData();
         Serial.print("Input:  ");
-        for (int i = 7; i >= 0; i--) {
-            Serial.print((myData.input_states & (1 << i)) ? "1" : "0");
+        for (int i = 15; i >= 0; i--) {
+            Serial.print((myData.input_states & (1U << i)) ? "1" : "0");
         }
         Serial.println();
         
         Serial.print("Output: ");
-        for (int i = 7; i >= 0; i--) {
-            Serial.print((myData.output_states & (1 << i)) ? "1" : "0");
+        for (int i = 15; i >= 0; i--) {
+            Serial.print((myData.output_states & (1U << i)) ? "1" : "0");
         }
         Serial.println();
         
@@ -1166,6 +1159,18 @@ void actionToggleLongRange() {
         DATA_MGR.updateStatus(success ? "LR Mode ON" : "LR Toggle Failed");
     }
     
+    if (success) {
+        // Persist so the choice survives a reboot
+        const NodeConfigRecord& config = DATA_MGR.getNodeConfig();
+        uint8_t radioFlags = config.radioFlags;
+        if (isLongRangeModeEnabled()) {
+            radioFlags |= NODE_CFG_RADIO_LONG_RANGE;
+        } else {
+            radioFlags &= ~NODE_CFG_RADIO_LONG_RANGE;
+        }
+        DATA_MGR.setRadioConfig(radioFlags, config.channel, config.txPowerQuarterDbm);
+    }
+    
     String newState = isLongRangeModeEnabled() ? "ON" : "OFF";
     menuLog("Long Range mode toggled to " + newState, 3);
 }
@@ -1243,9 +1248,7 @@ void actionSetSharedData() {
     memset(&testData, 0, sizeof(DistributedIOData));
     testData.sharedData[0][0] = (1UL << testPattern); // Set one bit at a time (Input 1)
     // Mirror to outputs for testing (Q follows I by default)
-    testData.sharedOutputs[0][0] = testData.sharedData[0][0];
-    testData.sharedOutputs[1][0] = testData.sharedData[1][0];
-    testData.sharedOutputs[2][0] = testData.sharedData[2][0];
+    memcpy(testData.sharedOutputs, testData.sharedData, sizeof(testData.sharedOutputs));
     
     DATA_MGR.setDistributedIOSharedData(testData);
     IO_DEVICE.broadcastSharedData();
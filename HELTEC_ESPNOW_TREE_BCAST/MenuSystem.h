@@ -23,15 +23,17 @@ class HidConfigMenuProvider : public IDynamicMenuProvider {
 private:
     uint32_t currentHid;
     int hidConfigDepth;
-    static char textBuffers[6][20]; // Static buffers to avoid stack overflow
+    // Static buffers to avoid stack overflow: "Set HID" plus one per child
+    static char textBuffers[TREE_ADDR_MAX_CHILDREN + 1][24];
+
+    int childCount() const;
 
 public:
     HidConfigMenuProvider();
 
+    // Set, [Up], one entry per child, Back
     int getItemCount() override {
-        if (hidConfigDepth == 4) return 3; // Set, Up, Back
-        if (hidConfigDepth == 1) return 6; // Set, 4 children, Back
-        return 7; // Set, Up, 4 children, Back
+        return (hidConfigDepth > 1 ? 3 : 2) + childCount();
     }
 
     const char* getItemText(int index) override;
@@ -74,9 +76,12 @@ void consoleLogSharedDataChange(uint32_t oldSharedData, uint32_t newSharedData);
 // CONSOLE DISPLAY SYSTEM
 // ============================================================================
 
-// Console message buffer for data flow messages
+// Console message buffer for data flow messages.
+// Fixed-size text: messages are added from the ESP-NOW receive path.
+#define CONSOLE_MESSAGE_LEN 24
+
 struct ConsoleMessage {
-    String message;
+    char message[CONSOLE_MESSAGE_LEN];
     unsigned long timestamp;
 };
 
@@ -89,7 +94,8 @@ private:
     
 public:
     ConsoleDisplay();
-    void addMessage(const String& msg);
+    void addMessage(const char* msg);
+    void addMessage(const String& msg) { addMessage(msg.c_str()); }
     void clear();
     int getMessageCount() const { return messageCount; }
     const ConsoleMessage& getMessage(int index) const;
@@ -171,7 +177,8 @@ public:
     void proceedToBitIndexConfig();
     
     // Console message management
-    void addConsoleMessage(const String& msg);
+    void addConsoleMessage(const char* msg);
+    void addConsoleMessage(const String& msg) { addConsoleMessage(msg.c_str()); }
     void clearConsoleMessages();
 
 private:
@@ -16,13 +16,13 @@ namespace OutputPolicy {
 void computeOutputsFromInputs(DistributedIOData& ioFrame);
 
 // Helpers to read individual bit states from the I/Q frames (zero-based indices)
-// bitIndex: 0..31, inputIndex/outputIndex: 0..2 (I0..I2, Q0..Q2)
-bool getInputBit(const DistributedIOData& ioFrame, int bitIndex /*0-31*/, int inputIndex /*0-2*/);
-bool getOutputBit(const DistributedIOData& ioFrame, int bitIndex /*0-31*/, int outputIndex /*0-2*/);
+// bitIndex: 0..31, inputIndex/outputIndex: 0..15 (I0..I15, Q0..Q15)
+bool getInputBit(const DistributedIOData& ioFrame, int bitIndex /*0-31*/, int inputIndex /*0-15*/);
+bool getOutputBit(const DistributedIOData& ioFrame, int bitIndex /*0-31*/, int outputIndex /*0-15*/);
 
 // Helpers to set individual bit states in the I/Q frames (zero-based indices)
-void setInputBit(DistributedIOData& ioFrame, int bitIndex /*0-31*/, int inputIndex /*0-2*/, bool value);
-void setOutputBit(DistributedIOData& ioFrame, int bitIndex /*0-31*/, int outputIndex /*0-2*/, bool value);
+void setInputBit(DistributedIOData& ioFrame, int bitIndex /*0-31*/, int inputIndex /*0-15*/, bool value);
+void setOutputBit(DistributedIOData& ioFrame, int bitIndex /*0-31*/, int outputIndex /*0-15*/, bool value);
 
 } // namespace OutputPolicy
 
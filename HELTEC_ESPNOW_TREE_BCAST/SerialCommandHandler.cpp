@@ -1,5 +1,22 @@
 #include "SerialCommandHandler.h"
 #include <WiFi.h>
+#include "heap_guard.h"
+#include "boot_profiler.h"
+#include "bench.h"
+#include "oled.h"
+#include "frame_capture.h"
+#include "espnow_wrapper.h"
+#include "bulk_transfer.h"
+#include "tree_ota.h"
+#include "parent_failover.h"
+#include "bit_allocator.h"
+#include "tx_queue.h"
+#include "uplink.h"
+#include "rate_control.h"
+#include "channel_bridge.h"
+#include "report_aggregation.h"
+#include "io_slice.h"
+#include "frame_auth.h"
 
 // ============================================================================
 // GLOBAL INSTANCE
@@ -14,35 +31,131 @@ SerialCommandHandler SERIAL_CMD;
 SerialCommandHandler::SerialCommandHandler() {
     commandBuffer = "";
     commandComplete = false;
+    binaryLength = 0;
+    inBinaryFrame = false;
+    binaryOverflow = false;
+    binaryLastByteMs = 0;
+    binarySessionActive = false;
+    subTopics = 0;
+    subStatsHz = 0;
+    subMinIntervalMs = SERIAL_PUSH_MIN_INTERVAL_MS;
+    subSnapshotPending = 0;
+    subLeaseStartMs = 0;
+    memset(lastTopicPushMs, 0, sizeof(lastTopicPushMs));
+    pushSeq = 0;
+    memset(&lastPushedIO, 0, sizeof(lastPushedIO));
+    memset(&lastPushedStats, 0, sizeof(lastPushedStats));
+    lastPushedDeviceSeq = 0;
+    lastPushedDeviceCount = 0;
+    deviceScanCursor = 0;
+    deviceScanCount = 0;
+    deviceScanSeq = 0;
+    deviceScanReset = false;
+    replayActive = false;
 }
 
 void SerialCommandHandler::initialize() {
     Serial.println("Serial Command Handler initialized");
-    Serial.println("Available commands: CONFIG_SCHEMA, CONFIG_SAVE, CONFIG_LOAD, RESTART, STATUS, NETWORK_STATUS, NETWORK_STATS, IO_STATUS, DEVICE_DATA");
+    Serial.println("Available commands: CONFIG_SCHEMA, CONFIG_SAVE, CONFIG_LOAD, RESTART, STATUS, NETWORK_STATUS, NETWORK_STATS, IO_STATUS, DEVICE_DATA, SOAK, BOOT_PROFILE, DEVICE_TABLE, CAPTURE, REPLAY, BENCH, BULK, OTA, FAILOVER, BITALLOC, TOPOLOGY, TXQ, UPLINK, RATE, BRIDGE, AGG, SLICE, AUTH, ROLE");
+    Serial.println("Binary protocol v" + String(SERIAL_PROTOCOL_VERSION) + " available (COBS frames, send HELLO to negotiate)");
 }
 
 void SerialCommandHandler::update() {
+    // A frame left open with no closing 0x00 was a stray zero byte, not a frame
+    if (inBinaryFrame && binaryLength > 0 && millis() - binaryLastByteMs > SERIAL_FRAME_IDLE_TIMEOUT_MS) {
+        abandonBinaryFrame();
+    }
+    
     // Read serial input
     while (Serial.available()) {
         char c = Serial.read();
         
-        if (c == '\n' || c == '\r') {
-            if (commandBuffer.length() > 0) {
-                processCommand(commandBuffer);
-                commandBuffer = "";
+        // 0x00 never appears in text or inside a COBS frame: it opens and
+        // closes binary frames
+        if (c == 0x00) {
+            if (inBinaryFrame && binaryLength > 0) {
+                if (!binaryOverflow) {
+                    processBinaryFrame(binaryBuffer, binaryLength);
+                }
+                inBinaryFrame = false;
+            } else {
+                inBinaryFrame = true;   // Opening delimiter (or back-to-back frames)
+            }
+            binaryLength = 0;
+            binaryOverflow = false;
+            binaryLastByteMs = millis();
+            continue;
+        }
+        
+        if (inBinaryFrame) {
+            binaryLastByteMs = millis();
+            if (binaryOverflow) {
+                continue;   // Dropping a garbled frame until the closing 0x00
             }
-        } else {
-            commandBuffer += c;
-            
-            // Prevent buffer overflow
-            if (commandBuffer.length() >= MAX_COMMAND_LENGTH) {
-                sendResponse("ERROR: Command too long");
-                commandBuffer = "";
+            if (binaryLength < sizeof(binaryBuffer)) {
+                binaryBuffer[binaryLength++] = (uint8_t)c;
+            } else if (abandonBinaryFrame()) {
+                processTextChar(c);   // Too long for a frame: it was text all along
+            } else {
+                inBinaryFrame = true;
+                binaryOverflow = true;   // Drop it; the closing 0x00 resyncs
             }
+            continue;
+        }
+        
+        processTextChar(c);
+    }
+    
+    processSubscriptions();
+}
+
+void SerialCommandHandler::processTextChar(char c) {
+    if (c == '\n' || c == '\r') {
+        if (commandBuffer.length() > 0) {
+            processCommand(commandBuffer);
+            commandBuffer = "";
+        }
+    } else {
+        commandBuffer += c;
+        
+        // Prevent buffer overflow
+        if (commandBuffer.length() >= MAX_COMMAND_LENGTH) {
+            sendResponse("ERROR: Command too long");
+            commandBuffer = "";
         }
     }
 }
 
+/**
+ * @brief Leave a binary frame that turned out not to be one.
+ *
+ * A stray 0x00 on the line would otherwise swallow the text that follows it.
+ * Frames that fail to parse, outgrow the buffer or go idle without a closing
+ * 0x00 end here. If the buffered bytes are plain text, they are replayed to
+ * the text parser.
+ *
+ * @return true if the bytes were replayed as text
+ */
+bool SerialCommandHandler::abandonBinaryFrame() {
+    bool isText = binaryLength > 0;
+    for (size_t i = 0; i < binaryLength && isText; i++) {
+        uint8_t b = binaryBuffer[i];
+        isText = (b >= 0x20 && b < 0x7F) || b == '\t' || b == '\r' || b == '\n';
+    }
+    size_t length = binaryLength;
+    inBinaryFrame = false;
+    binaryLength = 0;
+    binaryOverflow = false;
+    
+    if (!isText) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        processTextChar((char)binaryBuffer[i]);
+    }
+    return true;
+}
+
 // ============================================================================
 // COMMAND PROCESSING
 // ============================================================================
@@ -80,6 +193,63 @@ void SerialCommandHandler::processCommand(const String& command) {
         case CMD_DEVICE_DATA:
             handleDeviceData();
             break;
+        case CMD_SOAK:
+            handleSoak(command);
+            break;
+        case CMD_BOOT_PROFILE:
+            handleBootProfile();
+            break;
+        case CMD_DEVICE_TABLE:
+            handleDeviceTable(command);
+            break;
+        case CMD_CAPTURE:
+            handleCapture(command);
+            break;
+        case CMD_REPLAY:
+            handleReplay(command);
+            break;
+        case CMD_BENCH:
+            handleBench(command);
+            break;
+        case CMD_BULK:
+            handleBulk(command);
+            break;
+        case CMD_OTA:
+            handleOta(command);
+            break;
+        case CMD_FAILOVER:
+            handleFailover(command);
+            break;
+        case CMD_BITALLOC:
+            handleBitAlloc(command);
+            break;
+        case CMD_TOPOLOGY:
+            handleTopology(command);
+            break;
+        case CMD_TXQ:
+            handleTxQueue(command);
+            break;
+        case CMD_UPLINK:
+            handleUplink(command);
+            break;
+        case CMD_RATE:
+            handleRate(command);
+            break;
+        case CMD_BRIDGE:
+            handleBridge(command);
+            break;
+        case CMD_AGG:
+            handleAgg(command);
+            break;
+        case CMD_SLICE:
+            handleSlice(command);
+            break;
+        case CMD_AUTH:
+            handleAuth(command);
+            break;
+        case CMD_ROLE:
+            handleRole(command);
+            break;
         default:
             sendResponse("ERROR: Unknown command");
             break;
@@ -103,8 +273,46 @@ SerialCommandHandler::CommandType SerialCommandHandler::parseCommand(const Strin
         return CMD_NETWORK_STATS;
     } else if (command.startsWith("IO_STATUS")) {
         return CMD_IO_STATUS;
+    } else if (command.startsWith("DEVICE_TABLE")) {
+        return CMD_DEVICE_TABLE;
     } else if (command.startsWith("DEVICE_DATA")) {
         return CMD_DEVICE_DATA;
+    } else if (command.startsWith("SOAK")) {
+        return CMD_SOAK;
+    } else if (command.startsWith("BOOT_PROFILE")) {
+        return CMD_BOOT_PROFILE;
+    } else if (command.startsWith("CAPTURE")) {
+        return CMD_CAPTURE;
+    } else if (command.startsWith("REPLAY")) {
+        return CMD_REPLAY;
+    } else if (command.startsWith("BENCH")) {
+        return CMD_BENCH;
+    } else if (command.startsWith("BULK")) {
+        return CMD_BULK;
+    } else if (command.startsWith("OTA")) {
+        return CMD_OTA;
+    } else if (command.startsWith("FAILOVER")) {
+        return CMD_FAILOVER;
+    } else if (command.startsWith("BITALLOC")) {
+        return CMD_BITALLOC;
+    } else if (command.startsWith("TOPOLOGY")) {
+        return CMD_TOPOLOGY;
+    } else if (command.startsWith("TXQ")) {
+        return CMD_TXQ;
+    } else if (command.startsWith("UPLINK")) {
+        return CMD_UPLINK;
+    } else if (command.startsWith("RATE")) {
+        return CMD_RATE;
+    } else if (command.startsWith("BRIDGE")) {
+        return CMD_BRIDGE;
+    } else if (command.startsWith("AGG")) {
+        return CMD_AGG;
+    } else if (command.startsWith("SLICE")) {
+        return CMD_SLICE;
+    } else if (command.startsWith("AUTH")) {
+        return CMD_AUTH;
+    } else if (command.startsWith("ROLE")) {
+        return CMD_ROLE;
     }
     
     return CMD_UNKNOWN;
@@ -138,9 +346,9 @@ void SerialCommandHandler::handleConfigSchema() {
     hierarchicalId["label"] = "Hierarchical ID (HID)";
     hierarchicalId["default"] = DATA_MGR.getHID();
     hierarchicalId["min"] = 1;
-    hierarchicalId["max"] = 999;
+    hierarchicalId["max"] = TREE_ADDR_MAX_HID;
     hierarchicalId["required"] = true;
-    hierarchicalId["description"] = "Device position in tree structure (1-999)";
+    hierarchicalId["description"] = "Device position in tree structure (" TREE_ADDR_RANGE_TEXT ")";
     
     JsonObject bitIndex = networkIdentity.createNestedObject("bit_index");
     bitIndex["type"] = "number";
@@ -187,6 +395,38 @@ void SerialCommandHandler::handleConfigSchema() {
     testMode["default"] = false;
     testMode["description"] = "Enable test mode for debugging";
     
+    JsonObject failoverMisses = systemBehavior.createNestedObject("failover_misses");
+    failoverMisses["type"] = "number";
+    failoverMisses["label"] = "Parent Failover Threshold (beacons)";
+    failoverMisses["default"] = FAILOVER_DEFAULT_MISSES;
+    failoverMisses["min"] = 1;
+    failoverMisses["max"] = FAILOVER_MAX_MISSES;
+    failoverMisses["description"] = "Missed parent beacons before attaching to another upstream node";
+    
+    JsonObject txInFlight = systemBehavior.createNestedObject("tx_in_flight");
+    txInFlight["type"] = "number";
+    txInFlight["label"] = "Frames In Flight";
+    txInFlight["default"] = TXQ_DEFAULT_IN_FLIGHT;
+    txInFlight["min"] = 1;
+    txInFlight["max"] = TXQ_MAX_IN_FLIGHT;
+    txInFlight["description"] = "Frames handed to the radio before waiting for a send completion";
+    
+    JsonObject childChannel = systemBehavior.createNestedObject("child_channel");
+    childChannel["type"] = "number";
+    childChannel["label"] = "Child Channel (bridge)";
+    childChannel["default"] = 0;
+    childChannel["min"] = 0;
+    childChannel["max"] = BRIDGE_MAX_CHANNEL;
+    childChannel["description"] = "Wi-Fi channel for this node's subtree; 0 keeps children on this node's channel";
+    
+    JsonObject reportWindow = systemBehavior.createNestedObject("report_window_ms");
+    reportWindow["type"] = "number";
+    reportWindow["label"] = "Report Aggregation Window (ms)";
+    reportWindow["default"] = 0;
+    reportWindow["min"] = 0;
+    reportWindow["max"] = AGG_MAX_WINDOW_MS;
+    reportWindow["description"] = "Hold child reports this long and forward them as one frame; 0 forwards each at once";
+    
     sendJsonResponse(doc);
 }
 
@@ -197,7 +437,7 @@ void SerialCommandHandler::handleConfigSave(const String& jsonData) {
     Serial.println("=== CONFIGURATION SAVE REQUEST ===");
     Serial.println("JSON data: " + jsonString);
     
-    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    StaticJsonDocument<JSON_IO_DOCUMENT_SIZE> doc;
     DeserializationError error = deserializeJson(doc, jsonString);
     
     if (error) {
@@ -223,8 +463,8 @@ void SerialCommandHandler::handleConfigSave(const String& jsonData) {
         if (networkIdentity.containsKey("hierarchical_id")) {
             int hid = networkIdentity["hierarchical_id"];
             Serial.println("Requested HID: " + String(hid));
-            if (hid >= 1 && hid <= 999) {
-                if (DATA_MGR.setHID(hid)) {
+            if (hid >= 1 && hid <= TREE_ADDR_MAX_HID && treeAddrIsValid(hid)) {
+                if (DATA_MGR.setHID(hid, false)) {
                     configChanged = true;
                     Serial.println("HID updated to: " + String(hid));
                 } else {
@@ -234,7 +474,7 @@ void SerialCommandHandler::handleConfigSave(const String& jsonData) {
                 }
             } else {
                 success = false;
-                errorMsg += "Invalid HID value; ";
+                errorMsg += "Invalid HID value (expected " TREE_ADDR_RANGE_TEXT "); ";
                 Serial.println("ERROR: Invalid HID value: " + String(hid));
             }
         }
@@ -243,7 +483,7 @@ void SerialCommandHandler::handleConfigSave(const String& jsonData) {
             int bitIndex = networkIdentity["bit_index"];
             Serial.println("Requested Bit Index: " + String(bitIndex));
             if (bitIndex >= 0 && bitIndex <= 31) {
-                if (DATA_MGR.setBitIndex(bitIndex)) {
+                if (DATA_MGR.setBitIndex(bitIndex, false)) {
                     configChanged = true;
                     Serial.println("Bit Index updated to: " + String(bitIndex));
                 } else {
@@ -278,15 +518,130 @@ void SerialCommandHandler::handleConfigSave(const String& jsonData) {
             Serial.println("Status interval updated to: " + String(interval) + "ms");
         }
         
+        uint8_t policyFlags = DATA_MGR.getNodeConfig().policyFlags;
+        
         if (systemBehavior.containsKey("auto_report")) {
             bool autoReport = systemBehavior["auto_report"];
+            IO_DEVICE.enableAutoReportOnInputChange(autoReport);
+            policyFlags = autoReport ? (policyFlags | NODE_CFG_POLICY_AUTO_REPORT) : (policyFlags & ~NODE_CFG_POLICY_AUTO_REPORT);
             Serial.println("Auto report updated to: " + String(autoReport ? "enabled" : "disabled"));
         }
         
         if (systemBehavior.containsKey("test_mode")) {
             bool testMode = systemBehavior["test_mode"];
+            IO_DEVICE.enableTestMode(testMode);
+            policyFlags = testMode ? (policyFlags | NODE_CFG_POLICY_TEST_MODE) : (policyFlags & ~NODE_CFG_POLICY_TEST_MODE);
             Serial.println("Test mode updated to: " + String(testMode ? "enabled" : "disabled"));
         }
+        
+        if (policyFlags != DATA_MGR.getNodeConfig().policyFlags) {
+            DATA_MGR.setPolicyFlags(policyFlags, false);
+            configChanged = true;
+        }
+        
+        if (systemBehavior.containsKey("failover_misses")) {
+            int misses = systemBehavior["failover_misses"];
+            if (misses < 1 || misses > FAILOVER_MAX_MISSES) {
+                success = false;
+                errorMsg += "failover_misses out of range; ";
+            } else if (misses != DATA_MGR.getNodeConfig().failoverMisses) {
+                DATA_MGR.setFailoverMisses(misses, false);
+                configChanged = true;
+                Serial.println("Failover threshold updated to: " + String(misses) + " beacons");
+            }
+        }
+        
+        if (systemBehavior.containsKey("tx_in_flight")) {
+            int frames = systemBehavior["tx_in_flight"];
+            if (frames < 1 || frames > TXQ_MAX_IN_FLIGHT) {
+                success = false;
+                errorMsg += "tx_in_flight out of range; ";
+            } else if (frames != DATA_MGR.getNodeConfig().txInFlight) {
+                DATA_MGR.setTxInFlight(frames, false);
+                configChanged = true;
+                Serial.println("Frames in flight updated to: " + String(frames));
+            }
+        }
+        
+        if (systemBehavior.containsKey("child_channel")) {
+            int channel = systemBehavior["child_channel"];
+            if (channel < 0 || channel > BRIDGE_MAX_CHANNEL) {
+                success = false;
+                errorMsg += "child_channel out of range; ";
+            } else if (channel != DATA_MGR.getNodeConfig().childChannel) {
+                DATA_MGR.setChildChannel(channel, false);
+                configChanged = true;
+                Serial.println("Child channel updated to: " + String(channel));
+            }
+        }
+        
+        if (systemBehavior.containsKey("report_window_ms")) {
+            int window = systemBehavior["report_window_ms"];
+            if (window < 0 || window > AGG_MAX_WINDOW_MS) {
+                success = false;
+                errorMsg += "report_window_ms out of range; ";
+            } else if (window != DATA_MGR.getNodeConfig().reportWindowMs) {
+                DATA_MGR.setReportWindow(window, false);
+                configChanged = true;
+                Serial.println("Report aggregation window updated to: " + String(window) + " ms");
+            }
+        }
+    }
+    
+    // Parse io_map: GPIO numbers per local input/output, in bit order. Empty
+    // arrays restore the board defaults. Pins are set up at boot only.
+    bool pinMapChanged = false;
+    if (doc.containsKey("io_map")) {
+        JsonObject ioMap = doc["io_map"];
+        const NodeConfigRecord& config = DATA_MGR.getNodeConfig();
+        uint8_t inputPins[MAX_INPUT_PINS];
+        uint8_t outputPins[MAX_OUTPUT_PINS];
+        uint8_t inputCount = config.inputCount > MAX_INPUT_PINS ? MAX_INPUT_PINS : config.inputCount;
+        uint8_t outputCount = config.outputCount > MAX_OUTPUT_PINS ? MAX_OUTPUT_PINS : config.outputCount;
+        memcpy(inputPins, config.inputPins, inputCount);
+        memcpy(outputPins, config.outputPins, outputCount);
+        bool valid = true;
+        
+        if (ioMap.containsKey("input_pins")) {
+            JsonArray pins = ioMap["input_pins"];
+            valid = valid && pins.size() <= MAX_INPUT_PINS;
+            inputCount = 0;
+            for (JsonVariant pin : pins) {
+                int gpio = pin.as<int>();
+                if (gpio < 0 || gpio > 48 || inputCount >= MAX_INPUT_PINS) {
+                    valid = false;
+                    break;
+                }
+                inputPins[inputCount++] = gpio;
+            }
+        }
+        
+        if (ioMap.containsKey("output_pins")) {
+            JsonArray pins = ioMap["output_pins"];
+            valid = valid && pins.size() <= MAX_OUTPUT_PINS;
+            outputCount = 0;
+            for (JsonVariant pin : pins) {
+                int gpio = pin.as<int>();
+                if (gpio < 0 || gpio > 48 || outputCount >= MAX_OUTPUT_PINS) {
+                    valid = false;
+                    break;
+                }
+                outputPins[outputCount++] = gpio;
+            }
+        }
+        
+        if (!valid) {
+            success = false;
+            errorMsg += "io_map needs at most " + String(MAX_INPUT_PINS) + " GPIOs (0-48) per list; ";
+        } else if (inputCount != config.inputCount || outputCount != config.outputCount ||
+                   memcmp(inputPins, config.inputPins, inputCount) != 0 ||
+                   memcmp(outputPins, config.outputPins, outputCount) != 0) {
+            DATA_MGR.setPinMap(inputPins, inputCount, outputPins, outputCount, false);
+            configChanged = true;
+            pinMapChanged = true;
+            Serial.println("Pin map updated to: " + String(inputCount) + " inputs, " + String(outputCount) +
+                           " outputs (applies after RESTART)");
+        }
     }
     
     // Verify changes were applied
@@ -295,17 +650,18 @@ void SerialCommandHandler::handleConfigSave(const String& jsonData) {
     Serial.println("HID after save: " + String(newHID) + " (was: " + String(oldHID) + ")");
     Serial.println("Bit Index after save: " + String(newBitIndex) + " (was: " + String(oldBitIndex) + ")");
     
+    // Commit every changed field with a single config record write
+    if (configChanged && !DATA_MGR.saveConfigToNVM()) {
+        success = false;
+        errorMsg += "Failed to write config to NVS; ";
+    }
+    
     if (success) {
         if (configChanged) {
             // Force immediate reload of configuration
             Serial.println("Forcing DataManager update...");
             DATA_MGR.update(); // Update data manager with new configuration
             
-            // Force reload from NVS to ensure changes are applied
-            Serial.println("Forcing reload from NVS...");
-            DATA_MGR.loadHIDFromNVM();
-            DATA_MGR.loadBitIndexFromNVM();
-            
             // Verify the changes were applied
             uint16_t finalHID = DATA_MGR.getHID();
             uint8_t finalBitIndex = DATA_MGR.getBitIndex();
@@ -318,7 +674,8 @@ void SerialCommandHandler::handleConfigSave(const String& jsonData) {
             
             Serial.println("Configuration applied immediately - no restart required");
         }
-        sendResponse("SUCCESS: Configuration saved and applied");
+        sendResponse(pinMapChanged ? "SUCCESS: Configuration saved and applied; pin map applies after RESTART"
+                                   : "SUCCESS: Configuration saved and applied");
         DATA_MGR.updateStatus("Config saved via web");
     } else {
         sendResponse("ERROR: " + errorMsg);
@@ -328,12 +685,9 @@ void SerialCommandHandler::handleConfigSave(const String& jsonData) {
 }
 
 void SerialCommandHandler::handleConfigLoad() {
-    // Force reload configuration from NVS to ensure we have the latest values
-    Serial.println("Forcing reload of configuration from NVS...");
-    
-    // Reload HID and Bit Index from NVS
-    bool hidLoaded = DATA_MGR.loadHIDFromNVM();
-    bool bitIndexLoaded = DATA_MGR.loadBitIndexFromNVM();
+    // The config record is read once at boot and kept in sync on every save,
+    // so the in-memory copy is authoritative - no NVS round trip needed here
+    const NodeConfigRecord& config = DATA_MGR.getNodeConfig();
     
     // Get current values from DataManager
     uint16_t currentHID = DATA_MGR.getHID();
@@ -341,8 +695,7 @@ void SerialCommandHandler::handleConfigLoad() {
     bool isConfigured = DATA_MGR.isConfigured();
     
     // Log current values for debugging
-    Serial.println("HID loaded from NVS: " + String(hidLoaded ? "YES" : "NO"));
-    Serial.println("Bit Index loaded from NVS: " + String(bitIndexLoaded ? "YES" : "NO"));
+    Serial.println("Config generation: " + String(config.generation));
     Serial.println("Current HID: " + String(currentHID));
     Serial.println("Current Bit Index: " + String(currentBitIndex));
     Serial.println("Is Configured: " + String(isConfigured ? "true" : "false"));
@@ -352,7 +705,7 @@ void SerialCommandHandler::handleConfigLoad() {
     MENU_SYS.updateDisplay(); // This will trigger OLED redraw with current values
     
     // Return current configuration values
-    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    StaticJsonDocument<JSON_IO_DOCUMENT_SIZE> doc;
     
     JsonObject networkIdentity = doc.createNestedObject("network_identity");
     networkIdentity["hierarchical_id"] = currentHID;
@@ -362,8 +715,27 @@ void SerialCommandHandler::handleConfigLoad() {
     JsonObject systemBehavior = doc.createNestedObject("system_behavior");
     systemBehavior["debug_level"] = "Basic"; // Default - could be stored in NVS
     systemBehavior["status_interval"] = 200; // Default - could be stored in NVS
-    systemBehavior["auto_report"] = true; // Default - could be stored in NVS
-    systemBehavior["test_mode"] = false; // Default - could be stored in NVS
+    systemBehavior["auto_report"] = (config.policyFlags & NODE_CFG_POLICY_AUTO_REPORT) != 0;
+    systemBehavior["test_mode"] = (config.policyFlags & NODE_CFG_POLICY_TEST_MODE) != 0;
+    systemBehavior["failover_misses"] = config.failoverMisses ? config.failoverMisses : FAILOVER_DEFAULT_MISSES;
+    systemBehavior["tx_in_flight"] = config.txInFlight ? config.txInFlight : TXQ_DEFAULT_IN_FLIGHT;
+    systemBehavior["child_channel"] = config.childChannel;
+    systemBehavior["report_window_ms"] = config.reportWindowMs;
+    
+    JsonObject ioMap = doc.createNestedObject("io_map");
+    JsonArray inputPins = ioMap.createNestedArray("input_pins");
+    for (uint8_t i = 0; i < config.inputCount; i++) {
+        inputPins.add(config.inputPins[i]);
+    }
+    JsonArray outputPins = ioMap.createNestedArray("output_pins");
+    for (uint8_t i = 0; i < config.outputCount; i++) {
+        outputPins.add(config.outputPins[i]);
+    }
+    
+    JsonObject radio = doc.createNestedObject("radio");
+    radio["long_range"] = (config.radioFlags & NODE_CFG_RADIO_LONG_RANGE) != 0;
+    radio["channel"] = config.channel;
+    radio["tx_power_qdbm"] = config.txPowerQuarterDbm;
     
     sendJsonResponse(doc);
 }
@@ -385,6 +757,22 @@ void SerialCommandHandler::handleStatus() {
     doc["uptime"] = millis();
     doc["free_heap"] = ESP.getFreeHeap();
     
+    if (isOLEDEnabled()) {
+        OledRenderStats render;
+        oledGetRenderStats(render);
+        JsonObject displayStats = doc.createNestedObject("display");
+        displayStats["frames_submitted"] = render.framesSubmitted;
+        displayStats["frames_sent"] = render.framesSent;
+        displayStats["frames_unchanged"] = render.framesUnchanged;
+        displayStats["frames_skipped"] = render.framesSkipped;
+        displayStats["tiles_sent"] = render.tilesSent;
+        displayStats["bytes_sent"] = render.bytesSent;
+        displayStats["compose_us"] = render.lastComposeUs;
+        displayStats["compose_max_us"] = render.maxComposeUs;
+        displayStats["transfer_us"] = render.lastTransferUs;
+        displayStats["transfer_max_us"] = render.maxTransferUs;
+    }
+    
     sendJsonResponse(doc);
 }
 
@@ -406,7 +794,7 @@ void SerialCommandHandler::handleNetworkStatus() {
 void SerialCommandHandler::handleNetworkStats() {
     StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
     
-    NetworkStats stats = DATA_MGR.getNetworkStats();
+    const NetworkStats& stats = DATA_MGR.getNetworkStats();
     
     doc["messages_sent"] = stats.messagesSent;
     doc["messages_received"] = stats.messagesReceived;
@@ -414,22 +802,30 @@ void SerialCommandHandler::handleNetworkStats() {
     doc["messages_ignored"] = stats.messagesIgnored;
     doc["security_violations"] = stats.securityViolations;
     doc["last_message_time"] = stats.lastMessageTime;
-    doc["last_sender_mac"] = stats.lastSenderMAC;
+    doc["last_sender_mac"] = stats.hasLastSender ? DATA_MGR.formatMAC(stats.lastSenderMAC) : String("None");
     doc["signal_strength"] = WiFi.RSSI();
     
     sendJsonResponse(doc);
 }
 
 void SerialCommandHandler::handleIOStatus() {
-    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    StaticJsonDocument<JSON_IO_DOCUMENT_SIZE> doc;
     
     // Get I/O states
-    uint8_t inputStates = IO_DEVICE.getInputStates();
-    uint8_t outputStates = IO_DEVICE.getOutputStates();
+    uint16_t inputStates = IO_DEVICE.getInputStates();
+    uint16_t outputStates = IO_DEVICE.getOutputStates();
+    
+    // Take one consistent snapshot so every field below describes the same frame
+    DistributedIOData distributedData;
+    DATA_MGR.readDistributedIOSharedData(distributedData);
+    uint8_t myBitIndex = DATA_MGR.getBitIndex();
     
     // Get shared data for all inputs (backward compatibility: input 0)
-    uint32_t sharedDataInput0 = DATA_MGR.getSharedData(); // Backward compatibility
-    bool myBitStateInput0 = DATA_MGR.getMyBitState(); // Backward compatibility
+    uint32_t sharedDataInput0 = distributedData.sharedData[0][0]; // Backward compatibility
+    bool myBitConfigured = DATA_MGR.isBitIndexConfigured() && myBitIndex < MAX_DISTRIBUTED_IO_BITS;
+    int myWord = myBitIndex / BITS_PER_WORD;
+    uint32_t myMask = 1UL << (myBitIndex % BITS_PER_WORD);
+    bool myBitStateInput0 = myBitConfigured && (distributedData.sharedData[0][myWord] & myMask) != 0; // Backward compatibility
     
     // Get shared inputs (I) and outputs (Q) arrays
     JsonArray sharedDataArray = doc.createNestedArray("shared_data");                 // Inputs (I) - legacy key
@@ -437,18 +833,14 @@ void SerialCommandHandler::handleIOStatus() {
     JsonArray sharedOutputArray = doc.createNestedArray("shared_output_array");       // Outputs (Q) - new key
     JsonArray myOutputStateArray = doc.createNestedArray("my_output_states_array");   // My output states - new key
     
-    DistributedIOData distributedData = DATA_MGR.getDistributedIOSharedData();
-    uint8_t myBitIndex = DATA_MGR.getBitIndex();
-    int bitInWord = (myBitIndex < 32) ? (myBitIndex % 32) : 0;
-    
-    for (int i = 0; i < 3; i++) {
+    for (int i = 0; i < MAX_INPUTS; i++) {
         // Inputs
         sharedDataArray.add(distributedData.sharedData[i][0]);
-        bool myBitState = DATA_MGR.getMyBitState(i);
+        bool myBitState = myBitConfigured && (distributedData.sharedData[i][myWord] & myMask) != 0;
         myBitStateArray.add(myBitState);
         // Outputs
         sharedOutputArray.add(distributedData.sharedOutputs[i][0]);
-        bool myOut = ((distributedData.sharedOutputs[i][0] >> bitInWord) & 0x01) != 0;
+        bool myOut = myBitConfigured && (distributedData.sharedOutputs[i][myWord] & myMask) != 0;
         myOutputStateArray.add(myOut);
     }
     
@@ -462,15 +854,15 @@ void SerialCommandHandler::handleIOStatus() {
     doc["input_change_count"] = IO_DEVICE.getInputChangeCount();
     doc["last_input_change"] = IO_DEVICE.getLastInputChangeTime();
     
-    // Individual pin states
+    // Individual pin states, one per configured pin
     JsonArray inputPins = doc.createNestedArray("input_pins");
-    for (int i = 0; i < 3; i++) {
-        inputPins.add((inputStates & (1 << i)) != 0);
+    for (int i = 0; i < IO_DEVICE.getInputCount(); i++) {
+        inputPins.add((inputStates & (1U << i)) != 0);
     }
     
     JsonArray outputPins = doc.createNestedArray("output_pins");
-    for (int i = 0; i < 3; i++) {
-        outputPins.add((outputStates & (1 << i)) != 0);
+    for (int i = 0; i < IO_DEVICE.getOutputCount(); i++) {
+        outputPins.add((outputStates & (1U << i)) != 0);
     }
     
     sendJsonResponse(doc);
@@ -490,4 +882,1483 @@ void SerialCommandHandler::handleDeviceData() {
     doc["uptime"] = millis();
     
     sendJsonResponse(doc);
-} 
\ No newline at end of file
+} 
+
+/**
+ * SOAK [hours] [frames_per_minute]
+ * Runs the heap soak test (see heap_guard.h) and reports heap fragmentation
+ * and allocation-guard results. Blocks the loop until the run finishes.
+ */
+void SerialCommandHandler::handleSoak(const String& command) {
+    uint32_t hours = HEAP_SOAK_DEFAULT_HOURS;
+    uint32_t framesPerMinute = HEAP_SOAK_DEFAULT_FRAMES_PER_MIN;
+    
+    String args = command.substring(4);
+    args.trim();
+    if (args.length() > 0) {
+        int space = args.indexOf(' ');
+        hours = args.substring(0, space < 0 ? args.length() : space).toInt();
+        if (space >= 0) {
+            framesPerMinute = args.substring(space + 1).toInt();
+        }
+    }
+    
+    sendResponse("SOAK running " + String(hours) + "h at " + String(framesPerMinute) + " frames/min");
+    
+    static HeapSoakReport report;   // ~450 bytes; keep it off the loop stack
+    if (!heapSoakRun(hours, framesPerMinute, report)) {
+        sendResponse("ERROR: SOAK requires a configured HID");
+        return;
+    }
+    
+    StaticJsonDocument<JSON_SOAK_DOCUMENT_SIZE> doc;
+    AllocGuardStats guard;
+    allocGuardGetStats(guard);
+    
+    doc["simulated_hours"] = report.simulatedHours;
+    doc["frames_injected"] = report.framesInjected;
+    doc["elapsed_ms"] = report.elapsedMs;
+    doc["tx_suppressed"] = report.txSuppressed;
+    doc["min_free_heap"] = report.minFreeBytes;
+    doc["max_fragmentation_pct"] = report.maxFragmentationPct;
+    doc["rx_path_alloc_violations"] = report.guardViolations;
+    doc["rx_path_allocations"] = report.guardAllocations;
+    doc["alloc_counting"] = !ENABLE_ALLOC_GUARD ? "off" : guard.exactCounting ? "exact" : "free_heap_delta";
+    
+    JsonArray hourArray = doc.createNestedArray("sample_hour");
+    JsonArray freeArray = doc.createNestedArray("free_heap");
+    JsonArray largestArray = doc.createNestedArray("largest_block");
+    JsonArray fragArray = doc.createNestedArray("fragmentation_pct");
+    for (int i = 0; i < report.sampleCount; i++) {
+        hourArray.add(report.samples[i].simulatedHour);
+        freeArray.add(report.samples[i].freeBytes);
+        largestArray.add(report.samples[i].largestBlock);
+        fragArray.add(report.samples[i].fragmentationPct);
+    }
+    
+    sendJsonResponse(doc);
+}
+
+/**
+ * BOOT_PROFILE
+ * Reports the boot phase timestamps recorded by boot_profiler. Fast boot
+ * doesn't wait for a serial monitor, so this is how to read them back.
+ */
+void SerialCommandHandler::handleBootProfile() {
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    
+    doc["fast_boot"] = ENABLE_FAST_BOOT ? true : false;
+    JsonArray phases = doc.createNestedArray("phases");
+    JsonArray times = doc.createNestedArray("time_us");
+    
+    const BootMark* marks;
+    uint8_t count = bootGetMarks(marks);
+    for (uint8_t i = 0; i < count; i++) {
+        phases.add(marks[i].phase);
+        times.add(marks[i].timeUs);
+    }
+    doc["first_report_us"] = bootGetFirstReportUs();
+    
+    sendJsonResponse(doc);
+}
+
+/**
+ * BENCH [iterations]
+ * Runs the hot path micro-benchmarks (bench.h) and reports ns/op and
+ * allocations per 1000 ops.
+ * auth_per_hop_ns is what frame_auth.h adds at each forwarding hop.
+ */
+void SerialCommandHandler::handleBench(const String& command) {
+    String args = command.substring(5);
+    args.trim();
+    uint32_t iterations = args.length() > 0 ? args.toInt() : BENCH_DEFAULT_ITERATIONS;
+    
+    BenchResult results[BENCH_MAX_CASES];
+    uint8_t count = benchRunAll(iterations, results, BENCH_MAX_CASES);
+    
+    StaticJsonDocument<JSON_SOAK_DOCUMENT_SIZE> doc;
+    AllocGuardStats guard;
+    allocGuardGetStats(guard);
+    doc["alloc_counting"] = guard.exactCounting ? "exact" : "free_heap_delta";
+    
+    uint32_t authPerHopNs = 0;
+    JsonArray cases = doc.createNestedArray("bench");
+    for (uint8_t i = 0; i < count; i++) {
+        JsonObject entry = cases.createNestedObject();
+        entry["name"] = results[i].name;
+        entry["iterations"] = results[i].iterations;
+        entry["ns_per_op"] = results[i].nsPerOp;
+        entry["allocs_per_1000_ops"] = results[i].allocsPer1000Ops;
+        if (strncmp(results[i].name, "auth_", 5) == 0) {
+            authPerHopNs += results[i].nsPerOp;   // One open and one seal
+        }
+    }
+    doc["auth_per_hop_ns"] = authPerHopNs;
+    
+    sendJsonResponse(doc);
+}
+
+/**
+ * DEVICE_TABLE [start] [count]
+ * Streams the root's aggregated device table, one "JSON_DEVICE: {...}" line
+ * per device, then a JSON_RESPONSE summary. Each line is serialized from its
+ * own small document straight to Serial, so memory use doesn't grow with the
+ * table size.
+ */
+void SerialCommandHandler::handleDeviceTable(const String& command) {
+    uint8_t count = DATA_MGR.getAggregatedDeviceCount();
+    int start = 0;
+    int limit = count;
+    
+    String args = command.substring(12);
+    args.trim();
+    if (args.length() > 0) {
+        int space = args.indexOf(' ');
+        start = args.substring(0, space < 0 ? args.length() : space).toInt();
+        if (space >= 0) {
+            limit = args.substring(space + 1).toInt();
+        }
+    }
+    if (start < 0) start = 0;
+    if (limit < 0) limit = 0;
+    
+    uint32_t updateSeq = DATA_MGR.getAggregatedUpdateSeq();
+    uint32_t now = millis();
+    int sent = 0;
+    
+    for (int i = start; i < count && sent < limit; i++) {
+        AggregatedDeviceInfo info;
+        if (!DATA_MGR.getAggregatedDevice(i, info)) {
+            break;   // Table shrank while streaming
+        }
+        
+        StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> record;
+        record["index"] = i;
+        record["hid"] = info.hid;
+        record["bit_index"] = info.data.bit_index;
+        record["input_states"] = info.data.input_states;
+        record["output_states"] = info.data.output_states;
+        record["memory_states"] = info.data.memory_states;
+        record["analog_value1"] = info.data.analog_values[0];
+        record["analog_value2"] = info.data.analog_values[1];
+        record["integer_value1"] = info.data.integer_values[0];
+        record["integer_value2"] = info.data.integer_values[1];
+        record["age_ms"] = now - info.lastSeenMs;
+        
+        Serial.print("JSON_DEVICE: ");
+        serializeJson(record, Serial);
+        Serial.println();
+        sent++;
+    }
+    
+    StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> doc;
+    JsonObject table = doc.createNestedObject("device_table");
+    table["total"] = count;
+    table["start"] = start;
+    table["sent"] = sent;
+    table["update_seq"] = updateSeq;
+    table["changed"] = DATA_MGR.getAggregatedUpdateSeq() != updateSeq;
+    sendJsonResponse(doc);
+}
+
+/**
+ * CAPTURE [ON|OFF|CLEAR|STATUS]
+ * Controls the raw frame capture ring (frame_capture.h). Captured frames are
+ * drained by subscribing to SMSG_TOPIC_CAPTURE on the binary channel.
+ */
+void SerialCommandHandler::handleCapture(const String& command) {
+    String arg = command.substring(7);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "ON") {
+        captureSetEnabled(true);
+    } else if (arg == "OFF") {
+        captureSetEnabled(false);
+    } else if (arg == "CLEAR") {
+        captureClear();
+    } else if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: CAPTURE [ON|OFF|CLEAR|STATUS]");
+        return;
+    }
+    
+    CaptureStats stats;
+    captureGetStats(stats);
+    
+    StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> doc;
+    JsonObject capture = doc.createNestedObject("capture");
+    capture["available"] = (bool)ENABLE_FRAME_CAPTURE;
+    capture["enabled"] = stats.enabled;
+    capture["captured"] = stats.captured;
+    capture["overwritten"] = stats.overwritten;
+    capture["pending"] = stats.pending;
+    capture["ring_size"] = FRAME_CAPTURE_RING_SIZE;
+    capture["snaplen"] = FRAME_CAPTURE_SNAPLEN;
+    sendJsonResponse(doc);
+}
+
+/**
+ * REPLAY BEGIN|END
+ * Replay mode mutes the radio so frames fed in with SMSG_REPLAY_FRAME only
+ * drive this node's state and routing decisions. Meant for a bench node:
+ * replayed data reports and shared I/O updates change its live state.
+ */
+void SerialCommandHandler::handleReplay(const String& command) {
+    String arg = command.substring(6);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "BEGIN") {
+        replayActive = true;
+        espnowSetTxMuted(true);
+        sendResponse("Replay started, radio TX muted");
+    } else if (arg == "END") {
+        replayActive = false;
+        espnowSetTxMuted(false);
+        sendResponse("Replay ended, radio TX restored");
+    } else {
+        sendResponse("ERROR: Usage: REPLAY BEGIN|END");
+    }
+}
+
+/**
+ * BULK [STATS|RESET] | BULK SEND <hid> <bytes>
+ * SEND starts a fragmented transfer of a test pattern to another node (see
+ * bulk_transfer.h); the receiver checks the pattern. STATS reports both
+ * directions, with goodput for the last completed transfer each way.
+ */
+void SerialCommandHandler::handleBulk(const String& command) {
+    String args = command.substring(4);
+    args.trim();
+    
+    if (args.startsWith("SEND")) {
+        args = args.substring(4);
+        args.trim();
+        int space = args.indexOf(' ');
+        if (space < 0) {
+            sendResponse("ERROR: Usage: BULK SEND <hid> <bytes>");
+            return;
+        }
+        long hid = args.substring(0, space).toInt();
+        long bytes = args.substring(space + 1).toInt();
+        if (hid <= 0 || hid >= BROADCAST_HID || !treeAddrIsValid(hid) || bytes <= 0 || bytes > BULK_MAX_PAYLOAD) {
+            sendResponse("ERROR: Usage: BULK SEND <hid> <bytes 1-" + String(BULK_MAX_PAYLOAD) + ">");
+            return;
+        }
+        if (!bulkSendTestPattern(hid, bytes)) {
+            sendResponse("ERROR: Bulk send not started (busy or HID not configured)");
+            return;
+        }
+    } else if (args == "RESET") {
+        bulkResetStats();
+    } else if (args.length() > 0 && args != "STATS") {
+        sendResponse("ERROR: Usage: BULK [STATS|RESET] | BULK SEND <hid> <bytes>");
+        return;
+    }
+    
+    BulkStats stats;
+    bulkGetStats(stats);
+    
+    StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> doc;
+    JsonObject bulk = doc.createNestedObject("bulk");
+    bulk["sending"] = stats.txActive;
+    bulk["tx_transfers"] = stats.txTransfers;
+    bulk["tx_failed"] = stats.txFailed;
+    bulk["tx_fragments"] = stats.txFragments;
+    bulk["tx_retransmits"] = stats.txRetransmits;
+    bulk["tx_goodput_bps"] = stats.lastTxBytes ? bulkGoodput(stats.lastTxBytes, stats.lastTxMs) : 0;
+    bulk["rx_transfers"] = stats.rxTransfers;
+    bulk["rx_fragments"] = stats.rxFragments;
+    bulk["rx_duplicates"] = stats.rxDuplicates;
+    bulk["rx_dropped"] = stats.rxDropped;
+    bulk["rx_goodput_bps"] = stats.lastRxBytes ? bulkGoodput(stats.lastRxBytes, stats.lastRxMs) : 0;
+    sendJsonResponse(doc);
+}
+
+/**
+ * OTA [STATUS|ABORT]
+ * Progress of a firmware distribution (tree_ota.h). Images are uploaded
+ * with the binary SMSG_OTA_* messages, e.g. by tools/tree_ota.
+ */
+void SerialCommandHandler::handleOta(const String& command) {
+    String arg = command.substring(3);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "ABORT") {
+        treeOtaAbort();
+    } else if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: OTA [STATUS|ABORT]");
+        return;
+    }
+    
+    TreeOtaStatus status;
+    treeOtaGetStatus(status);
+    
+    StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> doc;
+    JsonObject ota = doc.createNestedObject("ota");
+    ota["state"] = treeOtaStateName(status.state);
+    ota["error"] = status.error;
+    ota["image_size"] = status.imageSize;
+    ota["received"] = status.bytesReceived;
+    ota["blocks"] = status.blockCount;
+    ota["blocks_sent"] = status.blocksSent;
+    ota["repairs_pending"] = status.repairsPending;
+    ota["children_active"] = status.childrenActive;
+    ota["children_verified"] = status.childrenVerified;
+    ota["queue_drops"] = status.queueDrops;
+    sendJsonResponse(doc);
+}
+
+/**
+ * FAILOVER [STATUS]
+ * Parent liveness and failover state (parent_failover.h): current foster,
+ * nodes fostered here, and detection/outage times and added hops of the
+ * last failover. latency_added_ms estimates the extra per-message delay as
+ * added hops times half the adoption handshake round trip.
+ */
+void SerialCommandHandler::handleFailover(const String& command) {
+    String arg = command.substring(8);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: FAILOVER [STATUS]");
+        return;
+    }
+    
+    FailoverStatus status;
+    failoverGetStatus(status);
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject failover = doc.createNestedObject("failover");
+    failover["state"] = failoverStateName(status.state);
+    failover["parent"] = status.parentHID;
+    failover["foster"] = status.fosterHID;
+    failover["miss_threshold"] = status.missThreshold;
+    failover["parent_silent_ms"] = status.parentSilentMs;
+    failover["candidates"] = status.candidates;
+    JsonArray fostering = failover.createNestedArray("fostering");
+    for (uint8_t i = 0; i < status.adoptedCount; i++) {
+        fostering.add(status.adoptedHIDs[i]);
+    }
+    failover["failovers"] = status.failovers;
+    failover["recoveries"] = status.recoveries;
+    failover["refusals"] = status.refusals;
+    failover["detect_ms"] = status.lastDetectMs;
+    failover["outage_ms"] = status.lastOutageMs;
+    failover["adopt_rtt_ms"] = status.lastAdoptRttMs;
+    failover["added_hops"] = status.lastAddedHops;
+    int32_t addedLatencyMs = status.lastAddedHops * (int32_t)status.lastAdoptRttMs / 2;
+    failover["latency_added_ms"] = addedLatencyMs;
+    sendJsonResponse(doc);
+}
+
+/**
+ * BITALLOC [STATUS] | BITALLOC REQUEST [bit] | BITALLOC RELEASE <hid>
+ * Automatic bit index allocation (bit_allocator.h). REQUEST drops this
+ * node's bit and asks the root for one, preferring [bit] if free. RELEASE
+ * (root only) frees a node's lease. On the root, STATUS lists the HID
+ * holding each bit (0 = free).
+ */
+void SerialCommandHandler::handleBitAlloc(const String& command) {
+    String args = command.substring(8);
+    args.trim();
+    
+    if (args.startsWith("REQUEST")) {
+        args = args.substring(7);
+        args.trim();
+        long bit = args.length() > 0 ? args.toInt() : BIT_NO_PREFERENCE;
+        if (args.length() > 0 && (bit < 0 || bit >= MAX_DISTRIBUTED_IO_BITS)) {
+            sendResponse("ERROR: Usage: BITALLOC REQUEST [0-" + String(MAX_DISTRIBUTED_IO_BITS - 1) + "]");
+            return;
+        }
+        bitAllocRequest(bit);
+    } else if (args.startsWith("RELEASE")) {
+        long hid = args.substring(7).toInt();
+        if (!DATA_MGR.isRoot() || hid <= 0 || hid >= BROADCAST_HID || !treeAddrIsValid(hid)) {
+            sendResponse("ERROR: Usage: BITALLOC RELEASE <hid> (root only)");
+            return;
+        }
+        if (!bitAllocRelease(hid)) {
+            sendResponse("ERROR: " + String(hid) + " holds no bit");
+            return;
+        }
+    } else if (args.length() > 0 && args != "STATUS") {
+        sendResponse("ERROR: Usage: BITALLOC [STATUS] | BITALLOC REQUEST [bit] | BITALLOC RELEASE <hid>");
+        return;
+    }
+    
+    BitAllocStats stats;
+    bitAllocGetStats(stats);
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject alloc = doc.createNestedObject("bitalloc");
+    alloc["bit_index"] = DATA_MGR.isBitIndexConfigured() ? DATA_MGR.getMyBitIndex() : -1;
+    if (DATA_MGR.isRoot()) {
+        alloc["leased"] = stats.leasedCount;
+        alloc["pending"] = stats.pendingCount;
+        alloc["requests"] = stats.requests;
+        alloc["assigned"] = stats.assigned;
+        alloc["confirmed"] = stats.confirmed;
+        alloc["exhausted"] = stats.exhausted;
+        alloc["learned"] = stats.learned;
+        alloc["reclaimed"] = stats.reclaimed;
+        alloc["conflicts"] = stats.conflicts;
+        alloc["queue_drops"] = stats.queueDrops;
+        uint16_t hids[MAX_DISTRIBUTED_IO_BITS];
+        bitAllocGetLeases(hids, MAX_DISTRIBUTED_IO_BITS);
+        JsonArray leases = alloc.createNestedArray("leases");
+        for (uint16_t hid : hids) {
+            leases.add(hid);
+        }
+    } else {
+        alloc["requests_sent"] = stats.requestsSent;
+        alloc["commission_ms"] = stats.lastCommissionMs;
+    }
+    sendJsonResponse(doc);
+}
+
+/**
+ * Stream one topology line: a node, its live children and forwarding load
+ */
+void SerialCommandHandler::printTopologyNode(uint16_t hid, const TopologyTrailer& trailer, uint32_t ageMs) {
+    StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> record;
+    record["hid"] = hid;
+    record["parent"] = treeAddrParent(hid);
+    JsonArray children = record.createNestedArray("children");
+    for (uint8_t n = 0; n < TREE_ADDR_MAX_CHILDREN; n++) {
+        if (trailer.childMask & (1U << n)) {
+            children.add(treeAddrChild(hid, n));
+        }
+    }
+    record["fostered"] = trailer.fosteredCount;
+    record["fwd_per_s"] = trailer.forwardLoad;
+    record["age_ms"] = ageMs;
+    
+    Serial.print("JSON_NODE: ");
+    serializeJson(record, Serial);
+    Serial.println();
+}
+
+/**
+ * TOPOLOGY [CHILDREN]
+ * Without an argument (root only), streams the tree assembled from the child
+ * summaries in data reports (child_table.h): one "JSON_NODE: {...}" line per
+ * node with its live children, fostered count and frames forwarded per
+ * second, then a summary naming the busiest forwarder. CHILDREN streams this
+ * node's own child table as "JSON_CHILD: {...}" lines.
+ */
+void SerialCommandHandler::handleTopology(const String& command) {
+    String arg = command.substring(8);
+    arg.trim();
+    arg.toUpperCase();
+    uint32_t now = millis();
+    
+    if (arg == "CHILDREN") {
+        ChildInfo children[CHILD_TABLE_SIZE];
+        uint8_t count = childTableGetChildren(children, CHILD_TABLE_SIZE);
+        for (uint8_t i = 0; i < count; i++) {
+            StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> record;
+            record["hid"] = children[i].hid;
+            record["fostered"] = children[i].fostered;
+            record["live"] = now - children[i].lastHeardMs <= CHILD_TIMEOUT_MS;
+            record["rssi"] = children[i].rssi;
+            record["age_ms"] = now - children[i].lastHeardMs;
+            record["frames"] = children[i].framesHeard;
+            record["forwarded"] = children[i].framesForwarded;
+            
+            Serial.print("JSON_CHILD: ");
+            serializeJson(record, Serial);
+            Serial.println();
+        }
+        
+        StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> doc;
+        JsonObject table = doc.createNestedObject("children");
+        table["entries"] = count;
+        table["live"] = childTableActiveCount();
+        sendJsonResponse(doc);
+        return;
+    }
+    
+    if (arg.length() > 0) {
+        sendResponse("ERROR: Usage: TOPOLOGY [CHILDREN]");
+        return;
+    }
+    if (!DATA_MGR.isRoot()) {
+        sendResponse("ERROR: TOPOLOGY is root only; use TOPOLOGY CHILDREN");
+        return;
+    }
+    
+    TopologyTrailer rootTrailer;
+    childTableFillTrailer(rootTrailer);
+    printTopologyNode(DATA_MGR.getMyHID(), rootTrailer, 0);
+    
+    uint16_t busiestHID = DATA_MGR.getMyHID();
+    uint8_t busiestLoad = rootTrailer.forwardLoad;
+    uint8_t maxFanout = __builtin_popcount(rootTrailer.childMask) + rootTrailer.fosteredCount;
+    
+    static TopologyNode nodes[TOPOLOGY_MAX_NODES];    // Too big for the loop task stack
+    uint8_t count = childTableGetTopology(nodes, TOPOLOGY_MAX_NODES);
+    for (uint8_t i = 0; i < count; i++) {
+        printTopologyNode(nodes[i].hid, nodes[i].trailer, now - nodes[i].lastReportMs);
+        uint8_t fanout = __builtin_popcount(nodes[i].trailer.childMask) + nodes[i].trailer.fosteredCount;
+        if (fanout > maxFanout) maxFanout = fanout;
+        if (nodes[i].trailer.forwardLoad > busiestLoad) {
+            busiestLoad = nodes[i].trailer.forwardLoad;
+            busiestHID = nodes[i].hid;
+        }
+    }
+    
+    StaticJsonDocument<JSON_RECORD_DOCUMENT_SIZE> doc;
+    JsonObject topology = doc.createNestedObject("topology");
+    topology["nodes"] = count + 1;
+    topology["max_fanout"] = maxFanout;
+    topology["busiest"] = busiestHID;
+    topology["busiest_fwd_per_s"] = busiestLoad;
+    sendJsonResponse(doc);
+}
+
+/**
+ * TXQ [STATS|RESET]
+ * Prioritized transmit queue (tx_queue.h): frames in flight, NO_MEM retries,
+ * and per class the current and peak depth, drops, send errors, and average
+ * and worst queueing delay. RESET clears the counters.
+ */
+void SerialCommandHandler::handleTxQueue(const String& command) {
+    String arg = command.substring(3);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "RESET") {
+        txQueueResetStats();
+        sendResponse("SUCCESS: TX queue counters cleared");
+        return;
+    }
+    if (arg.length() > 0 && arg != "STATS") {
+        sendResponse("ERROR: Usage: TXQ [STATS|RESET]");
+        return;
+    }
+    
+    TxQueueStats stats;
+    txQueueGetStats(stats);
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject txq = doc.createNestedObject("txq");
+    txq["in_flight"] = stats.inFlight;
+    txq["max_in_flight"] = stats.maxInFlight;
+    txq["no_mem_retries"] = stats.noMemRetries;
+    txq["timeouts"] = stats.timeouts;
+    JsonArray classes = txq.createNestedArray("classes");
+    for (uint8_t i = 0; i < TXQ_CLASS_COUNT; i++) {
+        const TxQueueClassStats& cls = stats.classes[i];
+        JsonObject entry = classes.createNestedObject();
+        entry["class"] = txQueueClassName(i);
+        entry["depth"] = cls.depth;
+        entry["capacity"] = cls.capacity;
+        entry["peak"] = cls.peakDepth;
+        entry["queued"] = cls.queued;
+        entry["sent"] = cls.sent;
+        entry["drops"] = cls.drops;
+        entry["errors"] = cls.errors;
+        entry["avg_wait_ms"] = cls.sent ? cls.totalWaitMs / cls.sent : 0;
+        entry["max_wait_ms"] = cls.maxWaitMs;
+    }
+    sendJsonResponse(doc);
+}
+
+/**
+ * UPLINK [STATUS|RESET]
+ * Unicast uplink (uplink.h): the upstream node, whether upstream frames
+ * currently go unicast, and per learned link its MAC, age, and frames
+ * acknowledged and failed. RESET clears the counters.
+ */
+void SerialCommandHandler::handleUplink(const String& command) {
+    String arg = command.substring(6);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "RESET") {
+        uplinkResetStats();
+        sendResponse("SUCCESS: Uplink counters cleared");
+        return;
+    }
+    if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: UPLINK [STATUS|RESET]");
+        return;
+    }
+    
+    UplinkStatus status;
+    uplinkGetStatus(status);
+    uint32_t now = millis();
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject uplink = doc.createNestedObject("uplink");
+    uplink["upstream"] = status.upstreamHID;
+    uplink["mode"] = status.unicast ? "unicast" : "broadcast";
+    uplink["unicast_frames"] = status.unicastFrames;
+    uplink["broadcast_frames"] = status.broadcastFrames;
+    uplink["fallbacks"] = status.fallbacks;
+    uplink["mac_changes"] = status.macChanges;
+    JsonArray links = uplink.createNestedArray("links");
+    for (uint8_t i = 0; i < status.linkCount; i++) {
+        const UplinkInfo& info = status.links[i];
+        JsonObject link = links.createNestedObject();
+        link["hid"] = info.hid;
+        link["mac"] = macToString(info.mac);
+        link["heard_ms"] = now - info.lastHeardMs;
+        link["acked"] = info.acked;
+        link["failed"] = info.failed;
+        uint32_t total = info.acked + info.failed;
+        link["delivery_pct"] = total ? info.acked * 100 / total : 100;
+    }
+    sendJsonResponse(doc);
+}
+
+/**
+ * RATE [STATUS|RESET]
+ * Per-peer PHY rate (rate_control.h): the base rate used for broadcasts,
+ * estimated airtime saved, and per unicast peer its rate, RSSI, delivery
+ * and step counts. RESET clears the counters; rates are kept.
+ */
+void SerialCommandHandler::handleRate(const String& command) {
+    String arg = command.substring(4);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "RESET") {
+        rateResetStats();
+        sendResponse("SUCCESS: Rate counters cleared");
+        return;
+    }
+    if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: RATE [STATUS|RESET]");
+        return;
+    }
+    
+    RateStats stats;
+    rateGetStats(stats);
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject rate = doc.createNestedObject("rate");
+    rate["enabled"] = ENABLE_RATE_ADAPTATION ? true : false;
+    rate["base"] = rateStepName(stats.baseStep);
+    rate["airtime_saved_ms"] = stats.airtimeSavedUs / 1000;
+    rate["rate_changes"] = stats.rateChanges;
+    rate["apply_errors"] = stats.applyErrors;
+    JsonArray peers = rate.createNestedArray("peers");
+    for (uint8_t i = 0; i < stats.peerCount; i++) {
+        const RatePeerInfo& info = stats.peers[i];
+        JsonObject peer = peers.createNestedObject();
+        peer["mac"] = macToString(info.mac);
+        peer["rate"] = rateStepName(info.step);
+        if (info.rssi != INT8_MIN) {
+            peer["rssi"] = info.rssi;
+        }
+        peer["acked"] = info.acked;
+        peer["failed"] = info.failed;
+        peer["ups"] = info.stepUps;
+        peer["downs"] = info.stepDowns;
+        peer["airtime_ms"] = info.airtimeUs / 1000;
+        peer["saved_ms"] = info.airtimeSavedUs / 1000;
+    }
+    sendJsonResponse(doc);
+}
+
+/**
+ * BRIDGE [STATUS|RESET]
+ * Channel bridge (channel_bridge.h): whether this node is bridging, the
+ * side the radio is on, switch counts, and per side its channel, time
+ * spent there, and the delay of frames held for it. RESET clears the
+ * counters.
+ */
+void SerialCommandHandler::handleBridge(const String& command) {
+    String arg = command.substring(6);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "RESET") {
+        bridgeResetStats();
+        sendResponse("SUCCESS: Bridge counters cleared");
+        return;
+    }
+    if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: BRIDGE [STATUS|RESET]");
+        return;
+    }
+    
+    BridgeStats stats;
+    bridgeGetStats(stats);
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject bridge = doc.createNestedObject("bridge");
+    bridge["active"] = stats.active;
+    bridge["on"] = stats.side == BRIDGE_SIDE_CHILD ? "child" : "parent";
+    bridge["switches"] = stats.switches;
+    bridge["switch_errors"] = stats.switchErrors;
+    bridge["drain_timeouts"] = stats.drainTimeouts;
+    bridge["max_switch_us"] = stats.maxSwitchUs;
+    for (uint8_t i = 0; i < BRIDGE_SIDE_COUNT; i++) {
+        const BridgeSideStats& sideStats = stats.sides[i];
+        JsonObject entry = bridge.createNestedObject(i == BRIDGE_SIDE_CHILD ? "child" : "parent");
+        entry["channel"] = sideStats.channel;
+        entry["dwell_ms"] = sideStats.dwellMs;
+        entry["depth"] = sideStats.depth;
+        entry["peak_depth"] = sideStats.peakDepth;
+        entry["buffered"] = sideStats.buffered;
+        entry["flushed"] = sideStats.flushed;
+        entry["drops"] = sideStats.drops;
+        entry["avg_delay_ms"] = sideStats.flushed ? sideStats.totalDelayMs / sideStats.flushed : 0;
+        entry["max_delay_ms"] = sideStats.maxDelayMs;
+    }
+    sendJsonResponse(doc);
+}
+
+/**
+ * AGG [STATUS|RESET]
+ * Report aggregation (report_aggregation.h). On a forwarder: the window,
+ * reports held and batches sent. On the root: report frames and device
+ * reports received per second. RESET clears the counters.
+ */
+void SerialCommandHandler::handleAgg(const String& command) {
+    String arg = command.substring(3);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "RESET") {
+        aggResetStats();
+        sendResponse("SUCCESS: Aggregation counters cleared");
+        return;
+    }
+    if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: AGG [STATUS|RESET]");
+        return;
+    }
+    
+    AggStats stats;
+    aggGetStats(stats);
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject agg = doc.createNestedObject("aggregation");
+    agg["window_ms"] = stats.windowMs;
+    agg["pending"] = stats.pending;
+    agg["frames_absorbed"] = stats.framesAbsorbed;
+    agg["records_absorbed"] = stats.recordsAbsorbed;
+    agg["batches_sent"] = stats.batchesSent;
+    agg["full_flushes"] = stats.fullFlushes;
+    agg["frames_saved"] = stats.framesAbsorbed > stats.batchesSent ? stats.framesAbsorbed - stats.batchesSent : 0;
+    if (DATA_MGR.isRoot()) {
+        JsonObject root = agg.createNestedObject("root");
+        root["frames"] = stats.rootFrames;
+        root["records"] = stats.rootRecords;
+        root["frames_per_s"] = stats.rootFramesPerSec;
+        root["records_per_s"] = stats.rootRecordsPerSec;
+    }
+    sendJsonResponse(doc);
+}
+
+/**
+ * SLICE [STATUS|RESET]
+ * Subtree-sliced I/O updates (io_slice.h): downstream updates sent full,
+ * sliced or not at all, and the devices below this node with their bits.
+ * RESET clears the counters; learned devices are kept.
+ */
+void SerialCommandHandler::handleSlice(const String& command) {
+    String arg = command.substring(5);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "RESET") {
+        ioSliceResetStats();
+        sendResponse("SUCCESS: Slicing counters cleared");
+        return;
+    }
+    if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: SLICE [STATUS|RESET]");
+        return;
+    }
+    
+    IoSliceStats stats;
+    ioSliceGetStats(stats);
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject slice = doc.createNestedObject("io_slice");
+    slice["full_frames"] = stats.fullFrames;
+    slice["slice_frames"] = stats.sliceFrames;
+    slice["skipped"] = stats.skipped;
+    slice["bytes_saved"] = stats.bytesSaved;
+    slice["slices_received"] = stats.slicesReceived;
+    JsonArray devices = slice.createNestedArray("devices");
+    for (uint8_t i = 0; i < stats.deviceCount; i++) {
+        JsonObject device = devices.createNestedObject();
+        device["hid"] = stats.devices[i].hid;
+        device["via"] = stats.devices[i].via;
+        device["bit"] = stats.devices[i].bitIndex;
+    }
+    sendJsonResponse(doc);
+}
+
+/**
+ * AUTH [STATUS|RESET]
+ * Frame authentication (frame_auth.h): frames sealed and opened, and frames
+ * dropped for a bad tag, a replayed counter or a missing trailer.
+ * RESET clears the counters; replay windows are kept.
+ */
+void SerialCommandHandler::handleAuth(const String& command) {
+    String arg = command.substring(4);
+    arg.trim();
+    arg.toUpperCase();
+    
+    if (arg == "RESET") {
+        frameAuthResetStats();
+        sendResponse("SUCCESS: Authentication counters cleared");
+        return;
+    }
+    if (arg.length() > 0 && arg != "STATUS") {
+        sendResponse("ERROR: Usage: AUTH [STATUS|RESET]");
+        return;
+    }
+    
+    FrameAuthStats stats;
+    frameAuthGetStats(stats);
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject auth = doc.createNestedObject("frame_auth");
+    auth["enabled"] = ENABLE_FRAME_AUTH ? true : false;
+    auth["mode"] = FRAME_AUTH_ENCRYPT ? "ccm" : "tag_only";
+    auth["sealed"] = stats.sealed;
+    auth["opened"] = stats.opened;
+    auth["bad_tag"] = stats.badTag;
+    auth["replayed"] = stats.replayed;
+    auth["unsealed"] = stats.unsealed;
+    auth["seal_failures"] = stats.sealFailures;
+    auth["counter"] = stats.counter;
+    auth["peers"] = stats.peers;
+    sendJsonResponse(doc);
+}
+
+/**
+ * ROLE
+ * The compile-time NODE_ROLE and the RAM its role-specific tables and
+ * queues take. Compare the output of builds for each role.
+ */
+void SerialCommandHandler::handleRole(const String& command) {
+    static const char* ROLE_NAMES[] = { "any", "root", "router", "leaf" };
+    
+    TxQueueStats txq;
+    txQueueGetStats(txq);
+    uint16_t txqFrames = 0;
+    for (const TxQueueClassStats& cls : txq.classes) {
+        txqFrames += cls.capacity;
+    }
+    
+    StaticJsonDocument<JSON_DOCUMENT_SIZE> doc;
+    JsonObject role = doc.createNestedObject("role");
+    role["name"] = ROLE_NAMES[NODE_ROLE];
+    role["has_root"] = NODE_ROLE_HAS_ROOT ? true : false;
+    role["forwards"] = NODE_ROLE_FORWARDS ? true : false;
+    role["data_manager_bytes"] = sizeof(DataManager);
+    role["device_table_bytes"] = NODE_ROLE_HAS_ROOT
+        ? MAX_AGGREGATED_DEVICES * (sizeof(DeviceSpecificData) + sizeof(uint16_t) + 2 * sizeof(uint32_t)) : 0;
+    role["topology_bytes"] = TOPOLOGY_MAX_NODES * sizeof(TopologyNode);
+    role["txq_frames"] = txqFrames;
+    role["txq_bytes"] = txqFrames * (TXQ_MAX_FRAME + 12);   // Frame plus TxQueueEntry header
+    role["free_heap"] = ESP.getFreeHeap();
+    role["min_free_heap"] = ESP.getMinFreeHeap();
+    sendJsonResponse(doc);
+}
+
+// ============================================================================
+// BINARY PROTOCOL
+// ============================================================================
+
+void SerialCommandHandler::sendBinaryFrame(uint8_t msgId, uint8_t seq, const void* payload, size_t payloadLen) {
+    uint8_t frame[SERIAL_FRAME_MAX_ENCODED];
+    size_t frameLen = serialBuildFrame(msgId, seq, (const uint8_t*)payload, payloadLen, frame, sizeof(frame));
+    if (frameLen > 0) {
+        // One write call, so log lines from other tasks can't land mid-frame
+        Serial.write(frame, frameLen);
+    }
+}
+
+void SerialCommandHandler::sendBinaryError(uint8_t requestId, uint8_t seq, uint8_t errorCode) {
+    uint8_t payload[2] = { requestId, errorCode };
+    sendBinaryFrame(SMSG_ERROR | SMSG_RESPONSE_FLAG, seq, payload, sizeof(payload));
+}
+
+void SerialCommandHandler::processBinaryFrame(const uint8_t* encoded, size_t len) {
+    uint8_t raw[SERIAL_FRAME_MAX_RAW];
+    uint8_t msgId = 0;
+    uint8_t seq = 0;
+    const uint8_t* payload = nullptr;
+    size_t payloadLen = 0;
+    
+    uint8_t error = serialParseFrame(encoded, len, raw, msgId, seq, payload, payloadLen);
+    if (error) {
+        // Text after a stray 0x00: hand it back to the text parser
+        if (encoded == binaryBuffer && abandonBinaryFrame()) {
+            return;
+        }
+        sendBinaryError(msgId, seq, error);
+        return;
+    }
+    
+    if (msgId == SMSG_HELLO) {
+        handleBinaryHello(seq, payload, payloadLen);
+        return;
+    }
+    if (!binarySessionActive) {
+        sendBinaryError(msgId, seq, SMSG_ERR_NOT_NEGOTIATED);
+        return;
+    }
+    subLeaseStartMs = millis();   // Any request keeps a subscription alive
+    
+    switch (msgId) {
+        case SMSG_STATUS: {
+            SerialStatusPayload out;
+            fillStatusPayload(out);
+            sendBinaryFrame(msgId | SMSG_RESPONSE_FLAG, seq, &out, sizeof(out));
+            break;
+        }
+        case SMSG_NETWORK_STATUS: {
+            SerialNetworkStatusPayload out;
+            fillNetworkStatusPayload(out);
+            sendBinaryFrame(msgId | SMSG_RESPONSE_FLAG, seq, &out, sizeof(out));
+            break;
+        }
+        case SMSG_NETWORK_STATS: {
+            SerialNetworkStatsPayload out;
+            fillNetworkStatsPayload(out);
+            sendBinaryFrame(msgId | SMSG_RESPONSE_FLAG, seq, &out, sizeof(out));
+            break;
+        }
+        case SMSG_IO_STATUS: {
+            SerialIOStatusPayload out;
+            fillIOStatusPayload(out);
+            sendBinaryFrame(msgId | SMSG_RESPONSE_FLAG, seq, &out, sizeof(out));
+            break;
+        }
+        case SMSG_DEVICE_DATA: {
+            SerialDeviceDataPayload out;
+            fillDeviceDataPayload(out);
+            sendBinaryFrame(msgId | SMSG_RESPONSE_FLAG, seq, &out, sizeof(out));
+            break;
+        }
+        case SMSG_SUBSCRIBE:
+            handleBinarySubscribe(seq, payload, payloadLen);
+            break;
+        case SMSG_DEVICE_TABLE:
+            handleBinaryDeviceTable(seq, payload, payloadLen);
+            break;
+        case SMSG_REPLAY_FRAME:
+            handleBinaryReplayFrame(seq, payload, payloadLen);
+            break;
+        case SMSG_OTA_BEGIN:
+        case SMSG_OTA_DATA:
+        case SMSG_OTA_STATUS:
+            handleBinaryOta(msgId, seq, payload, payloadLen);
+            break;
+        default:
+            sendBinaryError(msgId, seq, SMSG_ERR_UNKNOWN_MSG);
+            break;
+    }
+}
+
+void SerialCommandHandler::handleBinaryHello(uint8_t seq, const uint8_t* payload, size_t payloadLen) {
+    if (payloadLen < sizeof(SerialHelloRequest)) {
+        sendBinaryError(SMSG_HELLO, seq, SMSG_ERR_BAD_LENGTH);
+        return;
+    }
+    
+    const SerialHelloRequest* request = (const SerialHelloRequest*)payload;
+    if (request->version < SERIAL_PROTOCOL_VERSION) {
+        // Version 1 hosts would misread the widened I/O payloads
+        binarySessionActive = false;
+        sendBinaryError(SMSG_HELLO, seq, SMSG_ERR_VERSION);
+        return;
+    }
+    
+    SerialHelloResponse response = {};
+    response.version = SERIAL_PROTOCOL_VERSION;
+    response.maxPayload = SERIAL_FRAME_MAX_PAYLOAD;
+    response.messageMask = (1UL << SMSG_HELLO) | (1UL << SMSG_STATUS) | (1UL << SMSG_NETWORK_STATUS) |
+                           (1UL << SMSG_NETWORK_STATS) | (1UL << SMSG_IO_STATUS) | (1UL << SMSG_DEVICE_DATA) |
+                           (1UL << SMSG_SUBSCRIBE) | (1UL << SMSG_DEVICE_TABLE) |
+                           (1UL << SMSG_REPLAY_FRAME) | (1UL << SMSG_OTA_BEGIN) | (1UL << SMSG_OTA_DATA) |
+                           (1UL << SMSG_OTA_STATUS);
+    binarySessionActive = true;
+    subTopics = 0;   // A new session starts unsubscribed
+    
+    sendBinaryFrame(SMSG_HELLO | SMSG_RESPONSE_FLAG, seq, &response, sizeof(response));
+}
+
+void SerialCommandHandler::fillStatusPayload(SerialStatusPayload& out) {
+    memset(&out, 0, sizeof(out));
+    out.uptimeMs = millis();
+    out.freeHeap = ESP.getFreeHeap();
+    out.minFreeHeap = ESP.getMinFreeHeap();
+    WiFi.macAddress(out.mac);
+}
+
+void SerialCommandHandler::fillNetworkStatusPayload(SerialNetworkStatusPayload& out) {
+    out.hid = DATA_MGR.getHID();
+    out.parentHid = TREE_NET.getParentHID();
+    out.bitIndex = DATA_MGR.getBitIndex();
+    out.treeDepth = TREE_NET.getTreeDepth();
+    out.childCount = TREE_NET.getChildCount();
+    out.flags = (TREE_NET.isRootDevice() ? SMSG_NET_FLAG_ROOT : 0) |
+                (DATA_MGR.isConfigured() ? SMSG_NET_FLAG_CONFIGURED : 0);
+}
+
+void SerialCommandHandler::fillNetworkStatsPayload(SerialNetworkStatsPayload& out) {
+    const NetworkStats& stats = DATA_MGR.getNetworkStats();
+    
+    memset(&out, 0, sizeof(out));
+    out.messagesSent = stats.messagesSent;
+    out.messagesReceived = stats.messagesReceived;
+    out.messagesForwarded = stats.messagesForwarded;
+    out.messagesIgnored = stats.messagesIgnored;
+    out.securityViolations = stats.securityViolations;
+    out.lastMessageTime = stats.lastMessageTime;
+    if (stats.hasLastSender) {
+        memcpy(out.lastSenderMAC, stats.lastSenderMAC, sizeof(out.lastSenderMAC));
+    }
+    out.rssi = (int8_t)WiFi.RSSI();
+}
+
+void SerialCommandHandler::fillIOStatusPayload(SerialIOStatusPayload& out) {
+    DistributedIOData distributedData;
+    uint32_t version = DATA_MGR.readDistributedIOSharedData(distributedData);
+    
+    out.inputStates = IO_DEVICE.getInputStates();
+    out.outputStates = IO_DEVICE.getOutputStates();
+    out.bitIndex = DATA_MGR.getBitIndex();
+    out.reserved = 0;
+    out.myBits = 0;
+    out.ioVersion = version;
+    out.inputChangeCount = IO_DEVICE.getInputChangeCount();
+    out.lastInputChangeMs = IO_DEVICE.getLastInputChangeTime();
+    memcpy(out.sharedInputs, distributedData.sharedData, sizeof(out.sharedInputs));
+    memcpy(out.sharedOutputs, distributedData.sharedOutputs, sizeof(out.sharedOutputs));
+    
+    if (DATA_MGR.isBitIndexConfigured() && out.bitIndex < MAX_DISTRIBUTED_IO_BITS) {
+        int word = out.bitIndex / BITS_PER_WORD;
+        uint32_t mask = 1UL << (out.bitIndex % BITS_PER_WORD);
+        for (int i = 0; i < MAX_INPUTS; i++) {
+            if (distributedData.sharedData[i][word] & mask) out.myBits |= (1UL << i);
+            if (distributedData.sharedOutputs[i][word] & mask) out.myBits |= (0x10000UL << i);
+        }
+    }
+}
+
+void SerialCommandHandler::fillDeviceDataPayload(SerialDeviceDataPayload& out) {
+    out.uptimeMs = millis();
+    out.data = DATA_MGR.getDeviceSpecificData();
+}
+
+void SerialCommandHandler::fillDeviceRecord(const AggregatedDeviceInfo& info, uint32_t now, SerialDeviceRecord& out) {
+    out.hid = info.hid;
+    out.bitIndex = info.data.bit_index;
+    out.inputStates = info.data.input_states;
+    out.outputStates = info.data.output_states;
+    out.reserved = 0;
+    out.analog[0] = info.data.analog_values[0];
+    out.analog[1] = info.data.analog_values[1];
+    out.ageMs = now - info.lastSeenMs;
+}
+
+void SerialCommandHandler::handleBinaryDeviceTable(uint8_t seq, const uint8_t* payload, size_t payloadLen) {
+    SerialDeviceTableRequest request = {};
+    if (payloadLen >= sizeof(request)) {
+        memcpy(&request, payload, sizeof(request));
+    }
+    uint8_t maxRecords = request.maxRecords;
+    if (maxRecords == 0 || maxRecords > SERIAL_DEVICE_TABLE_MAX_RECORDS) {
+        maxRecords = SERIAL_DEVICE_TABLE_MAX_RECORDS;
+    }
+    
+    uint8_t page[SERIAL_FRAME_MAX_PAYLOAD];
+    SerialDeviceTableHeader header;
+    header.updateSeq = DATA_MGR.getAggregatedUpdateSeq();
+    header.totalCount = DATA_MGR.getAggregatedDeviceCount();
+    header.startIndex = request.startIndex;
+    header.recordCount = 0;
+    header.reserved = 0;
+    
+    size_t pageLen = sizeof(header);
+    uint32_t now = millis();
+    for (uint8_t i = request.startIndex; i < header.totalCount && header.recordCount < maxRecords; i++) {
+        AggregatedDeviceInfo info;
+        if (!DATA_MGR.getAggregatedDevice(i, info)) {
+            break;
+        }
+        SerialDeviceRecord record;
+        fillDeviceRecord(info, now, record);
+        memcpy(page + pageLen, &record, sizeof(record));
+        pageLen += sizeof(record);
+        header.recordCount++;
+    }
+    memcpy(page, &header, sizeof(header));
+    
+    sendBinaryFrame(SMSG_DEVICE_TABLE | SMSG_RESPONSE_FLAG, seq, page, pageLen);
+}
+
+// ============================================================================
+// PUSH SUBSCRIPTIONS
+// ============================================================================
+
+void SerialCommandHandler::handleBinarySubscribe(uint8_t seq, const uint8_t* payload, size_t payloadLen) {
+    if (payloadLen < sizeof(SerialSubscribeRequest)) {
+        sendBinaryError(SMSG_SUBSCRIBE, seq, SMSG_ERR_BAD_LENGTH);
+        return;
+    }
+    
+    const SerialSubscribeRequest* request = (const SerialSubscribeRequest*)payload;
+    subTopics = request->topics & SMSG_TOPIC_ALL;
+    subStatsHz = (request->statsHz < SERIAL_PUSH_MAX_STATS_HZ) ? request->statsHz : SERIAL_PUSH_MAX_STATS_HZ;
+    subMinIntervalMs = (request->minIntervalMs > SERIAL_PUSH_MIN_INTERVAL_MS) ? request->minIntervalMs
+                                                                             : SERIAL_PUSH_MIN_INTERVAL_MS;
+    subSnapshotPending = subTopics;
+    subLeaseStartMs = millis();
+    deviceScanCursor = 0;
+    if (subTopics & SMSG_TOPIC_CAPTURE) {
+        captureSetEnabled(true);
+    }
+    
+    SerialSubscribeResponse response;
+    response.topics = subTopics;
+    response.statsHz = subStatsHz;
+    response.minIntervalMs = subMinIntervalMs;
+    sendBinaryFrame(SMSG_SUBSCRIBE | SMSG_RESPONSE_FLAG, seq, &response, sizeof(response));
+}
+
+void SerialCommandHandler::processSubscriptions() {
+    if (subTopics == 0) {
+        return;
+    }
+    
+    uint32_t now = millis();
+    if (now - subLeaseStartMs > SERIAL_SUBSCRIPTION_LEASE_MS) {
+        subTopics = 0;   // Host went away without unsubscribing
+        return;
+    }
+    
+    bool ioDue = topicPushDue(SMSG_TOPIC_IO, subMinIntervalMs, now);
+    bool sharedDue = topicPushDue(SMSG_TOPIC_SHARED, subMinIntervalMs, now);
+    if (ioDue || sharedDue) {
+        // One snapshot feeds both topics
+        SerialIOStatusPayload current;
+        fillIOStatusPayload(current);
+        if (ioDue) pushIOFields(current);
+        if (sharedDue) pushSharedFields(current);
+    }
+    
+    if (subStatsHz > 0) {
+        uint32_t statsInterval = 1000 / subStatsHz;
+        if (statsInterval < subMinIntervalMs) statsInterval = subMinIntervalMs;
+        if (topicPushDue(SMSG_TOPIC_STATS, statsInterval, now)) {
+            pushStatsFields();
+        }
+    }
+    
+    if (topicPushDue(SMSG_TOPIC_DEVICES, subMinIntervalMs, now)) {
+        pushDeviceUpdates();
+    }
+    
+    if (topicPushDue(SMSG_TOPIC_CAPTURE, 0, now)) {
+        pushCapturedFrames();
+    }
+}
+
+bool SerialCommandHandler::topicPushDue(uint8_t topic, uint32_t intervalMs, uint32_t now) {
+    if (!(subTopics & topic)) {
+        return false;
+    }
+    if (subSnapshotPending & topic) {
+        return true;
+    }
+    return now - lastTopicPushMs[__builtin_ctz(topic)] >= intervalMs;
+}
+
+bool SerialCommandHandler::sendPushFrame(uint8_t* push, size_t pushLen, uint8_t topic, uint8_t fieldMask) {
+    SerialPushHeader* header = (SerialPushHeader*)push;
+    header->pushSeq = pushSeq;
+    header->topic = topic;
+    header->fieldMask = fieldMask;
+    
+    uint8_t frame[SERIAL_FRAME_MAX_ENCODED];
+    size_t frameLen = serialBuildFrame(SMSG_PUSH, (uint8_t)pushSeq, push, pushLen, frame, sizeof(frame));
+    if (frameLen == 0) {
+        return false;
+    }
+    // Host not draining the port: defer rather than block loop(). Nothing is
+    // marked as sent, so the change goes out with the next push.
+    if (Serial.availableForWrite() < (int)frameLen) {
+        return false;
+    }
+    Serial.write(frame, frameLen);
+    pushSeq++;
+    lastTopicPushMs[__builtin_ctz(topic)] = millis();
+    return true;
+}
+
+/**
+ * @brief Append a field to a push body if it changed (or a full snapshot is due)
+ * @return bit when appended, 0 otherwise
+ */
+static uint8_t appendPushField(uint8_t* push, size_t& pushLen, const void* current, const void* previous,
+                               size_t size, uint8_t bit, bool full) {
+    if (!full && memcmp(current, previous, size) == 0) {
+        return 0;
+    }
+    memcpy(push + pushLen, current, size);
+    pushLen += size;
+    return bit;
+}
+
+void SerialCommandHandler::pushIOFields(const SerialIOStatusPayload& current) {
+    bool full = subSnapshotPending & SMSG_TOPIC_IO;
+    uint8_t push[SERIAL_FRAME_MAX_PAYLOAD];
+    size_t pushLen = sizeof(SerialPushHeader);
+    uint8_t fields = 0;
+    
+    fields |= appendPushField(push, pushLen, &current.inputStates, &lastPushedIO.inputStates,
+                              sizeof(current.inputStates), SMSG_PUSH_IO_INPUTS, full);
+    fields |= appendPushField(push, pushLen, &current.outputStates, &lastPushedIO.outputStates,
+                              sizeof(current.outputStates), SMSG_PUSH_IO_OUTPUTS, full);
+    fields |= appendPushField(push, pushLen, &current.inputChangeCount, &lastPushedIO.inputChangeCount,
+                              sizeof(current.inputChangeCount), SMSG_PUSH_IO_CHANGE_COUNT, full);
+    fields |= appendPushField(push, pushLen, &current.lastInputChangeMs, &lastPushedIO.lastInputChangeMs,
+                              sizeof(current.lastInputChangeMs), SMSG_PUSH_IO_LAST_CHANGE, full);
+    
+    if (fields == 0 || !sendPushFrame(push, pushLen, SMSG_TOPIC_IO, fields)) {
+        return;
+    }
+    lastPushedIO.inputStates = current.inputStates;
+    lastPushedIO.outputStates = current.outputStates;
+    lastPushedIO.inputChangeCount = current.inputChangeCount;
+    lastPushedIO.lastInputChangeMs = current.lastInputChangeMs;
+    subSnapshotPending &= ~SMSG_TOPIC_IO;
+}
+
+void SerialCommandHandler::pushSharedFields(const SerialIOStatusPayload& current) {
+    bool full = subSnapshotPending & SMSG_TOPIC_SHARED;
+    uint8_t push[SERIAL_FRAME_MAX_PAYLOAD];
+    size_t pushLen = sizeof(SerialPushHeader);
+    uint8_t fields = 0;
+    
+    fields |= appendPushField(push, pushLen, &current.ioVersion, &lastPushedIO.ioVersion,
+                              sizeof(current.ioVersion), SMSG_PUSH_SHARED_VERSION, full);
+    fields |= appendPushField(push, pushLen, current.sharedInputs, lastPushedIO.sharedInputs,
+                              sizeof(current.sharedInputs), SMSG_PUSH_SHARED_INPUTS, full);
+    fields |= appendPushField(push, pushLen, current.sharedOutputs, lastPushedIO.sharedOutputs,
+                              sizeof(current.sharedOutputs), SMSG_PUSH_SHARED_OUTPUTS, full);
+    fields |= appendPushField(push, pushLen, &current.myBits, &lastPushedIO.myBits,
+                              sizeof(current.myBits), SMSG_PUSH_SHARED_MY_BITS, full);
+    fields |= appendPushField(push, pushLen, &current.bitIndex, &lastPushedIO.bitIndex,
+                              sizeof(current.bitIndex), SMSG_PUSH_SHARED_BIT_INDEX, full);
+    
+    // The version alone moving (a snapshot republished with equal data) is
+    // not worth a frame
+    if ((fields & ~SMSG_PUSH_SHARED_VERSION) == 0 && !full) {
+        return;
+    }
+    if (!sendPushFrame(push, pushLen, SMSG_TOPIC_SHARED, fields)) {
+        return;
+    }
+    lastPushedIO.ioVersion = current.ioVersion;
+    memcpy(lastPushedIO.sharedInputs, current.sharedInputs, sizeof(lastPushedIO.sharedInputs));
+    memcpy(lastPushedIO.sharedOutputs, current.sharedOutputs, sizeof(lastPushedIO.sharedOutputs));
+    lastPushedIO.myBits = current.myBits;
+    lastPushedIO.bitIndex = current.bitIndex;
+    subSnapshotPending &= ~SMSG_TOPIC_SHARED;
+}
+
+void SerialCommandHandler::pushStatsFields() {
+    bool full = subSnapshotPending & SMSG_TOPIC_STATS;
+    SerialNetworkStatsPayload current;
+    fillNetworkStatsPayload(current);
+    
+    uint8_t push[SERIAL_FRAME_MAX_PAYLOAD];
+    size_t pushLen = sizeof(SerialPushHeader);
+    uint8_t fields = 0;
+    
+    // The six counters are consecutive uint32_t fields
+    const uint8_t* currentCounters = (const uint8_t*)&current.messagesSent;
+    const uint8_t* previousCounters = (const uint8_t*)&lastPushedStats.messagesSent;
+    for (int i = 0; i < 6; i++) {
+        fields |= appendPushField(push, pushLen, currentCounters + i * 4, previousCounters + i * 4,
+                                  sizeof(uint32_t), 1 << i, full);
+    }
+    fields |= appendPushField(push, pushLen, &current.rssi, &lastPushedStats.rssi,
+                              sizeof(current.rssi), SMSG_PUSH_STATS_RSSI, full);
+    fields |= appendPushField(push, pushLen, current.lastSenderMAC, lastPushedStats.lastSenderMAC,
+                              sizeof(current.lastSenderMAC), SMSG_PUSH_STATS_LAST_SENDER, full);
+    
+    if (fields == 0 || !sendPushFrame(push, pushLen, SMSG_TOPIC_STATS, fields)) {
+        return;
+    }
+    lastPushedStats = current;
+    subSnapshotPending &= ~SMSG_TOPIC_STATS;
+}
+
+void SerialCommandHandler::pushDeviceUpdates() {
+    uint8_t count = DATA_MGR.getAggregatedDeviceCount();
+    
+    // A device left the table mid-scan: entries may have moved, start over
+    if (deviceScanCursor > 0 && count < deviceScanCount) {
+        deviceScanCursor = 0;
+        subSnapshotPending |= SMSG_TOPIC_DEVICES;
+    }
+    
+    if (deviceScanCursor == 0) {
+        uint32_t tableSeq = DATA_MGR.getAggregatedUpdateSeq();
+        bool reset = (subSnapshotPending & SMSG_TOPIC_DEVICES) || count < lastPushedDeviceCount;
+        if (!reset && tableSeq == lastPushedDeviceSeq) {
+            return;
+        }
+        deviceScanSeq = tableSeq;
+        deviceScanCount = count;
+        deviceScanReset = reset;
+    }
+    
+    // The USB CDC TX buffer holds about one full frame, so send one per pass
+    // and resume from the cursor next time
+    uint8_t push[SERIAL_FRAME_MAX_PAYLOAD];
+    size_t pushLen = sizeof(SerialPushHeader);
+    uint8_t records = 0;
+    uint8_t index = deviceScanCursor;
+    uint32_t now = millis();
+    
+    for (; index < count && records < SERIAL_PUSH_MAX_DEVICE_RECORDS; index++) {
+        AggregatedDeviceInfo info;
+        if (!DATA_MGR.getAggregatedDevice(index, info)) {
+            break;
+        }
+        // Entries updated after the scan started are sent now and again next scan
+        if (!deviceScanReset && (int32_t)(info.updateSeq - lastPushedDeviceSeq) <= 0) {
+            continue;
+        }
+        
+        SerialDeviceRecord record;
+        fillDeviceRecord(info, now, record);
+        memcpy(push + pushLen, &record, sizeof(record));
+        pushLen += sizeof(record);
+        records++;
+    }
+    
+    // Only the first frame of a snapshot carries the reset flag; an empty
+    // reset frame tells the host the table is now empty
+    bool firstResetFrame = deviceScanReset && deviceScanCursor == 0;
+    if (records > 0 || firstResetFrame) {
+        uint8_t fields = records | (firstResetFrame ? SMSG_PUSH_DEVICES_RESET : 0);
+        if (!sendPushFrame(push, pushLen, SMSG_TOPIC_DEVICES, fields)) {
+            return;   // Retry the same frame next pass
+        }
+    }
+    
+    if (index < count) {
+        deviceScanCursor = index;
+        return;
+    }
+    deviceScanCursor = 0;
+    lastPushedDeviceSeq = deviceScanSeq;
+    lastPushedDeviceCount = count;
+    subSnapshotPending &= ~SMSG_TOPIC_DEVICES;
+}
+
+void SerialCommandHandler::pushCapturedFrames() {
+    uint8_t push[SERIAL_FRAME_MAX_PAYLOAD];
+    size_t pushLen = sizeof(SerialPushHeader);
+    uint8_t records = 0;
+    uint32_t lastSeq = 0;
+    
+    CapturedFrame frame;
+    uint32_t frameSeq;
+    while (capturePeek(records, frame, frameSeq)) {
+        size_t recordLen = CAPTURED_FRAME_HEADER_SIZE + frame.capLen;
+        if (pushLen + recordLen > sizeof(push)) {
+            break;
+        }
+        memcpy(push + pushLen, &frame, recordLen);
+        pushLen += recordLen;
+        lastSeq = frameSeq;
+        records++;
+    }
+    
+    if (records == 0) {
+        subSnapshotPending &= ~SMSG_TOPIC_CAPTURE;   // Nothing to snapshot for a stream
+        return;
+    }
+    if (sendPushFrame(push, pushLen, SMSG_TOPIC_CAPTURE, records)) {
+        captureConsumeThrough(lastSeq);
+        subSnapshotPending &= ~SMSG_TOPIC_CAPTURE;
+    }
+}
+
+// ============================================================================
+// CAPTURE REPLAY
+// ============================================================================
+
+void SerialCommandHandler::handleBinaryOta(uint8_t msgId, uint8_t seq, const uint8_t* payload, size_t payloadLen) {
+    if (msgId == SMSG_OTA_BEGIN) {
+        if (payloadLen < sizeof(SerialOtaBeginRequest)) {
+            sendBinaryError(msgId, seq, SMSG_ERR_BAD_LENGTH);
+            return;
+        }
+        const SerialOtaBeginRequest* request = (const SerialOtaBeginRequest*)payload;
+        if (!treeOtaBeginLocal(request->imageSize, request->sha256)) {
+            sendBinaryError(msgId, seq, SMSG_ERR_STATE);
+            return;
+        }
+    } else if (msgId == SMSG_OTA_DATA) {
+        if (payloadLen <= sizeof(SerialOtaDataHeader)) {
+            sendBinaryError(msgId, seq, SMSG_ERR_BAD_LENGTH);
+            return;
+        }
+        const SerialOtaDataHeader* chunk = (const SerialOtaDataHeader*)payload;
+        if (!treeOtaWriteLocal(chunk->offset, payload + sizeof(SerialOtaDataHeader),
+                               payloadLen - sizeof(SerialOtaDataHeader))) {
+            sendBinaryError(msgId, seq, SMSG_ERR_STATE);
+            return;
+        }
+    }
+    
+    TreeOtaStatus status;
+    treeOtaGetStatus(status);
+    SerialOtaStatusPayload out;
+    out.state = status.state;
+    out.error = status.error;
+    out.childrenActive = status.childrenActive;
+    out.childrenVerified = status.childrenVerified;
+    out.imageSize = status.imageSize;
+    out.bytesReceived = status.bytesReceived;
+    out.blockCount = status.blockCount;
+    out.blocksSent = status.blocksSent;
+    out.repairsPending = status.repairsPending;
+    out.reserved = 0;
+    sendBinaryFrame(msgId | SMSG_RESPONSE_FLAG, seq, &out, sizeof(out));
+}
+
+void SerialCommandHandler::handleBinaryReplayFrame(uint8_t seq, const uint8_t* payload, size_t payloadLen) {
+    if (!replayActive) {
+        sendBinaryError(SMSG_REPLAY_FRAME, seq, SMSG_ERR_STATE);
+        return;
+    }
+    if (payloadLen <= sizeof(SerialReplayFrameRequest)) {
+        sendBinaryError(SMSG_REPLAY_FRAME, seq, SMSG_ERR_BAD_LENGTH);
+        return;
+    }
+    
+    const SerialReplayFrameRequest* request = (const SerialReplayFrameRequest*)payload;
+    const uint8_t* frame = payload + sizeof(SerialReplayFrameRequest);
+    int frameLen = payloadLen - sizeof(SerialReplayFrameRequest);
+    
+    uint32_t mutedBefore = espnowGetMutedTxCount();
+    SerialReplayFrameResponse response;
+    response.verdict = espnowInjectFrame(request->srcMAC, frame, frameLen, request->rssi);
+    response.reserved = 0;
+    response.txSuppressed = espnowGetMutedTxCount() - mutedBefore;
+    
+    sendBinaryFrame(SMSG_REPLAY_FRAME | SMSG_RESPONSE_FLAG, seq, &response, sizeof(response));
+}
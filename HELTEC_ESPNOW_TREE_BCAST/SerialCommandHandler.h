@@ -7,6 +7,8 @@
 #include "IoDevice.h"
 #include "TreeNetwork.h"
 #include "MenuSystem.h"
+#include "serial_protocol.h"
+#include "child_table.h"
 
 // ============================================================================
 // SERIAL COMMAND HANDLER
@@ -16,10 +18,42 @@ class SerialCommandHandler {
 private:
     static const int MAX_COMMAND_LENGTH = 512;
     static const int JSON_DOCUMENT_SIZE = 1024;
+    static const int JSON_SOAK_DOCUMENT_SIZE = 2048;   // Room for the per-hour heap samples
+    static const int JSON_IO_DOCUMENT_SIZE = 3072;     // Room for 16-point pin maps and I/O planes
+    static const int JSON_RECORD_DOCUMENT_SIZE = 256;  // One DEVICE_TABLE line
     
     String commandBuffer;
     bool commandComplete;
     
+    // Binary channel (see serial_protocol.h); a 0x00 byte switches the
+    // input parser between text lines and COBS frames
+    uint8_t binaryBuffer[SERIAL_FRAME_MAX_ENCODED];
+    size_t binaryLength;
+    bool inBinaryFrame;
+    bool binaryOverflow;
+    uint32_t binaryLastByteMs;
+    bool binarySessionActive;
+    
+    // Push subscription (SMSG_SUBSCRIBE); lastPushed* hold what the host has
+    // already been sent so each push carries only changed fields
+    uint8_t subTopics;
+    uint8_t subStatsHz;
+    uint16_t subMinIntervalMs;
+    uint8_t subSnapshotPending;          // Topics whose next push is a full snapshot
+    uint32_t subLeaseStartMs;
+    uint32_t lastTopicPushMs[SMSG_TOPIC_COUNT];   // Indexed by topic bit number
+    uint16_t pushSeq;
+    SerialIOStatusPayload lastPushedIO;
+    SerialNetworkStatsPayload lastPushedStats;
+    uint32_t lastPushedDeviceSeq;
+    uint8_t lastPushedDeviceCount;
+    // Device table scans span several pushes (one frame per pass)
+    uint8_t deviceScanCursor;            // 0 = no scan in progress
+    uint8_t deviceScanCount;
+    uint32_t deviceScanSeq;
+    bool deviceScanReset;
+    bool replayActive;                   // REPLAY BEGIN .. REPLAY END
+    
     // Command types
     enum CommandType {
         CMD_CONFIG_SCHEMA,
@@ -31,6 +65,25 @@ private:
         CMD_NETWORK_STATS,
         CMD_IO_STATUS,
         CMD_DEVICE_DATA,
+        CMD_SOAK,
+        CMD_BOOT_PROFILE,
+        CMD_DEVICE_TABLE,
+        CMD_CAPTURE,
+        CMD_REPLAY,
+        CMD_BENCH,
+        CMD_BULK,
+        CMD_OTA,
+        CMD_FAILOVER,
+        CMD_BITALLOC,
+        CMD_TOPOLOGY,
+        CMD_TXQ,
+        CMD_UPLINK,
+        CMD_RATE,
+        CMD_BRIDGE,
+        CMD_AGG,
+        CMD_SLICE,
+        CMD_AUTH,
+        CMD_ROLE,
         CMD_UNKNOWN
     };
     
@@ -48,6 +101,54 @@ private:
     void handleNetworkStats();
     void handleIOStatus();
     void handleDeviceData();
+    void handleSoak(const String& command);
+    void handleBootProfile();
+    void handleDeviceTable(const String& command);
+    void handleCapture(const String& command);
+    void handleReplay(const String& command);
+    void handleBench(const String& command);
+    void handleBulk(const String& command);
+    void handleOta(const String& command);
+    void handleFailover(const String& command);
+    void handleBitAlloc(const String& command);
+    void handleTopology(const String& command);
+    void handleTxQueue(const String& command);
+    void handleUplink(const String& command);
+    void handleRate(const String& command);
+    void handleBridge(const String& command);
+    void handleAgg(const String& command);
+    void handleSlice(const String& command);
+    void handleAuth(const String& command);
+    void handleRole(const String& command);
+    void printTopologyNode(uint16_t hid, const TopologyTrailer& trailer, uint32_t ageMs);
+    
+    // Binary channel
+    void processTextChar(char c);
+    bool abandonBinaryFrame();
+    void processBinaryFrame(const uint8_t* encoded, size_t len);
+    void sendBinaryFrame(uint8_t msgId, uint8_t seq, const void* payload, size_t payloadLen);
+    void sendBinaryError(uint8_t requestId, uint8_t seq, uint8_t errorCode);
+    void handleBinaryHello(uint8_t seq, const uint8_t* payload, size_t payloadLen);
+    void fillStatusPayload(SerialStatusPayload& out);
+    void fillNetworkStatusPayload(SerialNetworkStatusPayload& out);
+    void fillNetworkStatsPayload(SerialNetworkStatsPayload& out);
+    void fillIOStatusPayload(SerialIOStatusPayload& out);
+    void fillDeviceDataPayload(SerialDeviceDataPayload& out);
+    void fillDeviceRecord(const AggregatedDeviceInfo& info, uint32_t now, SerialDeviceRecord& out);
+    void handleBinaryDeviceTable(uint8_t seq, const uint8_t* payload, size_t payloadLen);
+    
+    // Push subscriptions
+    void handleBinarySubscribe(uint8_t seq, const uint8_t* payload, size_t payloadLen);
+    void processSubscriptions();
+    bool topicPushDue(uint8_t topic, uint32_t intervalMs, uint32_t now);
+    bool sendPushFrame(uint8_t* push, size_t pushLen, uint8_t topic, uint8_t fieldMask);
+    void pushIOFields(const SerialIOStatusPayload& current);
+    void pushSharedFields(const SerialIOStatusPayload& current);
+    void pushStatsFields();
+    void pushDeviceUpdates();
+    void pushCapturedFrames();
+    void handleBinaryReplayFrame(uint8_t seq, const uint8_t* payload, size_t payloadLen);
+    void handleBinaryOta(uint8_t msgId, uint8_t seq, const uint8_t* payload, size_t payloadLen);
     
 public:
     SerialCommandHandler();
@@ -4,11 +4,12 @@
 #include "button.h"
 #include "oled.h"
 #include "MenuSystem.h"
+#include "child_table.h"
 
 // Logging macros
 #define MODULE_TITLE       "TREE_NET"
 #define MODULE_DEBUG_LEVEL 1
-#define treeLog(msg, lvl) debugPrint(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+#define treeLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
 
 // ============================================================================
 // DEMO DATA FOR TESTING
@@ -202,10 +203,12 @@ bool TreeNetwork::sendTestCommand() {
     }
     
     // For demo purposes, send a test command to a child device
-    uint16_t targetHID = getMyHID() * 10 + 1; // First child
-    uint8_t outputState = 0x55; // Test pattern
+    uint16_t targetHID = treeAddrChild(getMyHID(), 1); // First child
+    uint16_t outputState = 0x5555; // Test pattern
+    uint8_t payload[sizeof(outputState)];
+    memcpy(payload, &outputState, sizeof(payload));
     
-    bool success = sendTreeCommand(targetHID, MSG_COMMAND_SET_OUTPUTS, &outputState, 1);
+    bool success = sendTreeCommand(targetHID, MSG_COMMAND_SET_OUTPUTS, payload, sizeof(payload));
     logTreeOperation("Send Test Command", success, "To device " + DATA_MGR.formatHID(targetHID));
     
     if (success) {
@@ -228,8 +231,10 @@ bool TreeNetwork::sendCommandToDevice(uint16_t targetHID, TreeMessageType cmdTyp
     return success;
 }
 
-bool TreeNetwork::sendSetOutputsCommand(uint16_t targetHID, uint8_t outputStates) {
-    return sendCommandToDevice(targetHID, MSG_COMMAND_SET_OUTPUTS, &outputStates, 1);
+bool TreeNetwork::sendSetOutputsCommand(uint16_t targetHID, uint16_t outputStates) {
+    uint8_t payload[sizeof(outputStates)];
+    memcpy(payload, &outputStates, sizeof(payload));   // Little-endian, all 16 outputs
+    return sendCommandToDevice(targetHID, MSG_COMMAND_SET_OUTPUTS, payload, sizeof(payload));
 }
 
 bool TreeNetwork::sendBroadcastTreeCommand(TreeMessageType cmdType, const uint8_t* payload, size_t payloadLen) {
@@ -348,19 +353,11 @@ uint8_t TreeNetwork::getTreeDepth() const {
         return 0;
     }
     
-    uint16_t hid = getMyHID();
-    uint8_t depth = 0;
-    
-    while (hid > 0) {
-        depth++;
-        hid = hid / 10;
-    }
-    
-    return depth;
+    // Root counts as level 1
+    return treeAddrDepth(getMyHID()) + 1;
 }
 
 uint8_t TreeNetwork::getChildCount() const {
-    // For now, return 0 as child tracking is not fully implemented
-    // This could be enhanced to track actual child devices
-    return 0;
+    // Children (and fostered nodes) heard recently, see child_table.h
+    return childTableActiveCount();
 } 
\ No newline at end of file
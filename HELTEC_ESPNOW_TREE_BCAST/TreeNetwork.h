@@ -51,7 +51,7 @@ public:
     // ========================================================================
     bool sendTestCommand();
     bool sendCommandToDevice(uint16_t targetHID, TreeMessageType cmdType, const uint8_t* payload, size_t payloadLen);
-    bool sendSetOutputsCommand(uint16_t targetHID, uint8_t outputStates);
+    bool sendSetOutputsCommand(uint16_t targetHID, uint16_t outputStates);
     bool sendSetIntegersCommand(uint16_t targetHID, uint16_t val1, uint16_t val2);
     bool sendGetAllDataCommand(uint16_t targetHID);
     
@@ -0,0 +1,194 @@
+#include "bench.h"
+#include "debug.h"
+#include "DataManager.h"
+#include "heap_guard.h"
+#include "frame_auth.h"
+#include <esp_timer.h>
+
+// Logging macros for the benchmark module
+#define MODULE_TITLE       "BENCH"
+#define MODULE_DEBUG_LEVEL 1
+#define benchLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// FIXTURES
+// ============================================================================
+
+static DistributedIOData benchIO;
+static uint8_t benchFrame[TREE_MSG_OVERHEAD + sizeof(DistributedIOData)];
+static int benchFrameLen = 0;
+static uint8_t benchSealed[sizeof(benchFrame) + sizeof(FrameAuthTrailer)];
+static size_t benchSealedLen = 0;
+
+// (dest, broadcaster) pairs covering the routing branches for this node
+static uint16_t benchRoutes[4][2];
+
+// Results are folded in here so the compiler can't drop the work
+static volatile uint32_t benchSink = 0;
+
+static void benchPrepare() {
+    for (int i = 0; i < MAX_INPUTS; i++) {
+        for (int w = 0; w < SHARED_DATA_WORDS; w++) {
+            benchIO.sharedData[i][w] = 0xA5A50000UL | (i << 8) | w;
+            benchIO.sharedOutputs[i][w] = 0x5A5A0000UL | (i << 8) | w;
+        }
+    }
+    benchFrameLen = 0;
+    if (DATA_MGR.createTreeMessage(benchFrame, sizeof(benchFrame), BROADCAST_HID, MSG_DISTRIBUTED_IO_UPDATE,
+                                   (const uint8_t*)&benchIO, sizeof(benchIO))) {
+        benchFrameLen = benchFrame[1];
+    }
+    benchSealedLen = frameAuthSealBench(benchFrame, benchFrameLen, benchSealed, sizeof(benchSealed));
+
+    uint16_t myHID = DATA_MGR.getMyHID();
+    uint16_t parent = DATA_MGR.getParentHID();
+    uint16_t child = treeAddrIsValid(treeAddrChild(myHID, 1)) ? treeAddrChild(myHID, 1) : myHID;
+    benchRoutes[0][0] = ROOT_HID;      benchRoutes[0][1] = child;    // Report from a child
+    benchRoutes[1][0] = BROADCAST_HID; benchRoutes[1][1] = parent;   // Shared I/O from the parent
+    benchRoutes[2][0] = child;         benchRoutes[2][1] = parent;   // Command for a child
+    benchRoutes[3][0] = ROOT_HID;      benchRoutes[3][1] = myHID;    // My own echo
+}
+
+// ============================================================================
+// CASES
+// ============================================================================
+
+static void benchCrc8(uint32_t iterations) {
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        acc += DATA_MGR.calculateCRC8(benchFrame + 1, benchFrameLen - 3);
+    }
+    benchSink += acc;
+}
+
+static void benchCreate(uint32_t iterations) {
+    uint8_t frame[sizeof(benchFrame)];
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        acc += DATA_MGR.createTreeMessage(frame, sizeof(frame), BROADCAST_HID, MSG_DISTRIBUTED_IO_UPDATE,
+                                          (const uint8_t*)&benchIO, sizeof(benchIO));
+    }
+    benchSink += acc;
+}
+
+static void benchValidate(uint32_t iterations) {
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        acc += DATA_MGR.validateTreeMessage(benchFrame, benchFrameLen);
+    }
+    benchSink += acc;
+}
+
+static void benchForwardUp(uint32_t iterations) {
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        const uint16_t* route = benchRoutes[n & 3];
+        acc += DATA_MGR.shouldForwardUpstream(route[0], route[1]);
+    }
+    benchSink += acc;
+}
+
+static void benchForwardDown(uint32_t iterations) {
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        const uint16_t* route = benchRoutes[n & 3];
+        acc += DATA_MGR.shouldForwardDownstream(route[0], route[1]);
+    }
+    benchSink += acc;
+}
+
+static void benchComputeShared(uint32_t iterations) {
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        DistributedIOData shared = DATA_MGR.computeSharedDataFromInputs();
+        acc += shared.sharedData[0][0];
+    }
+    benchSink += acc;
+}
+
+static void benchFormat(uint32_t iterations) {
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        acc += DATA_MGR.formatDistributedIOData(benchIO).length();
+    }
+    benchSink += acc;
+}
+
+// Per-hop cost of frame_auth.h: a forwarder opens each frame and seals it again
+static void benchAuthSeal(uint32_t iterations) {
+    uint8_t sealed[sizeof(benchSealed)];
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        acc += frameAuthSealBench(benchFrame, benchFrameLen, sealed, sizeof(sealed));
+    }
+    benchSink += acc;
+}
+
+static void benchAuthOpen(uint32_t iterations) {
+    uint8_t opened[sizeof(benchSealed)];
+    uint32_t acc = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        acc += frameAuthOpenBench(benchSealed, benchSealedLen, opened);
+    }
+    benchSink += acc;
+}
+
+struct BenchCase {
+    const char* name;
+    void (*run)(uint32_t iterations);
+    uint8_t iterationDivisor;   // Slow cases run fewer iterations
+};
+
+static const BenchCase benchCases[] = {
+    { "crc8_frame",          benchCrc8,          1 },
+    { "create_io_update",    benchCreate,        1 },
+    { "validate_io_update",  benchValidate,      1 },
+    { "forward_upstream",    benchForwardUp,     1 },
+    { "forward_downstream",  benchForwardDown,   1 },
+    { "compute_shared_data", benchComputeShared, 4 },
+    { "format_io_data",      benchFormat,        10 },
+    { "auth_seal_io_update", benchAuthSeal,      4 },
+    { "auth_open_io_update", benchAuthOpen,      4 },
+};
+
+// ============================================================================
+// RUNNER
+// ============================================================================
+
+uint8_t benchRunAll(uint32_t iterations, BenchResult* results, uint8_t maxResults) {
+    if (iterations == 0) iterations = BENCH_DEFAULT_ITERATIONS;
+    if (iterations > BENCH_MAX_ITERATIONS) iterations = BENCH_MAX_ITERATIONS;
+    benchPrepare();
+
+    uint8_t count = 0;
+    for (const BenchCase& bench : benchCases) {
+        if (count >= maxResults) {
+            break;
+        }
+        uint32_t caseIterations = iterations / bench.iterationDivisor;
+        if (caseIterations == 0) caseIterations = 1;
+
+        uint64_t bestUs = UINT64_MAX;
+        uint32_t allocs = 0;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            uint32_t runAllocs = 0;
+            int64_t elapsedUs;
+            {
+                AllocGuardScope scope(bench.name, &runAllocs);
+                int64_t start = esp_timer_get_time();
+                bench.run(caseIterations);
+                elapsedUs = esp_timer_get_time() - start;
+            }
+            if ((uint64_t)elapsedUs < bestUs) bestUs = elapsedUs;
+            allocs = runAllocs;
+            vTaskDelay(1);   // Let the Wi-Fi and idle tasks run between runs
+        }
+
+        BenchResult& result = results[count++];
+        result.name = bench.name;
+        result.iterations = caseIterations;
+        result.nsPerOp = (uint32_t)(bestUs * 1000 / caseIterations);
+        result.allocsPer1000Ops = (uint32_t)((uint64_t)allocs * 1000 / caseIterations);
+    }
+    return count;
+}
@@ -0,0 +1,43 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// HOT PATH MICRO-BENCHMARKS
+// ============================================================================
+
+/**
+ * @brief On-device micro-benchmarks for the per-frame work.
+ *
+ * Each case runs its operation in a tight loop on the Arduino loop task and
+ * reports the best of BENCH_RUNS runs in ns/op, plus allocations/op. The
+ * allocation figure is exact with ENABLE_ALLOC_GUARD and
+ * CONFIG_HEAP_USE_HOOKS=y, and approximate otherwise (see heap_guard.h).
+ *
+ * Compare results between builds on the same board (Heltec WiFi LoRa 32
+ * V3, ESP32-S3 at 240 MHz, release build, debug levels as committed).
+ */
+#define BENCH_DEFAULT_ITERATIONS 2000
+#define BENCH_MAX_ITERATIONS     100000
+#define BENCH_RUNS               3
+#define BENCH_MAX_CASES          10
+
+struct BenchResult {
+    const char* name;
+    uint32_t iterations;
+    uint32_t nsPerOp;            // Best run
+    uint32_t allocsPer1000Ops;   // Allocations per 1000 operations
+};
+
+/**
+ * @brief Run every benchmark case.
+ *
+ * Runs on the caller's task and does not transmit: the cases call the
+ * message and routing helpers directly, never the radio.
+ *
+ * @return number of results written (up to maxResults)
+ */
+uint8_t benchRunAll(uint32_t iterations, BenchResult* results, uint8_t maxResults);
+
+#endif // BENCH_H
@@ -0,0 +1,480 @@
+#include "bit_allocator.h"
+#include "debug.h"
+#include "espnow_wrapper.h"
+#include <Preferences.h>
+
+// Logging macros for the bit allocator module
+#define MODULE_TITLE       "BITALLOC"
+#define MODULE_DEBUG_LEVEL 1
+#define bitAllocLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// ALLOCATOR STATE
+// ============================================================================
+
+static const char* LEASE_NAMESPACE = "bit_alloc";
+static const char* LEASE_KEY = "leases";
+static const char* LEASE_FORMAT_KEY = "hid_fmt";    // TREE_ADDR_FORMAT_TAG; absent = decimal
+
+struct BitLease {
+    uint16_t hid;               // 0 = free
+    bool     confirmed;         // Persisted; unconfirmed leases live in RAM only
+    uint32_t lastSeenMs;        // Last report or request from hid
+    uint32_t assignedMs;        // When an unconfirmed lease was (re)assigned
+};
+
+struct BitAllocEvent {
+    uint8_t  msgType;           // MSG_REQUEST_BIT_INDEX or MSG_CONFIRM_BIT_INDEX
+    uint16_t hid;
+    uint8_t  bit;
+    uint8_t  status;
+};
+
+// Root side
+static BitLease leases[MAX_DISTRIBUTED_IO_BITS];
+static BitAllocEvent events[BIT_ALLOC_QUEUE_SIZE];
+static uint8_t eventHead = 0;
+static uint8_t eventCount = 0;
+static bool leasesDirty = false;
+static uint32_t lastReclaimCheckMs = 0;
+static uint16_t conflictHID = 0;         // Latest conflict, logged from loop()
+static uint8_t conflictBit = 0;
+
+// Node side
+static bool assignmentPending = false;   // Written by the Wi-Fi task
+static uint8_t assignmentBit = 0;
+static uint8_t assignmentStatus = BIT_ASSIGN_OK;
+static bool requestScheduled = false;
+static uint8_t preferredBit = BIT_NO_PREFERENCE;
+static uint32_t nextRequestMs = 0;
+static uint32_t firstRequestMs = 0;
+
+static BitAllocStats stats;
+
+// Frames and reports arrive on the Wi-Fi task, everything else runs in loop()
+static portMUX_TYPE bitAllocMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// LEASE TABLE (root)
+// ============================================================================
+
+static int findLeaseLocked(uint16_t hid) {
+    for (int bit = 0; bit < MAX_DISTRIBUTED_IO_BITS; bit++) {
+        if (leases[bit].hid == hid) return bit;
+    }
+    return -1;
+}
+
+static void saveLeases() {
+    uint16_t hids[MAX_DISTRIBUTED_IO_BITS];
+    portENTER_CRITICAL(&bitAllocMux);
+    for (int bit = 0; bit < MAX_DISTRIBUTED_IO_BITS; bit++) {
+        hids[bit] = leases[bit].confirmed ? leases[bit].hid : 0;
+    }
+    leasesDirty = false;
+    portEXIT_CRITICAL(&bitAllocMux);
+
+    Preferences prefs;
+    if (prefs.begin(LEASE_NAMESPACE, false)) {
+        prefs.putBytes(LEASE_KEY, hids, sizeof(hids));
+        prefs.putUChar(LEASE_FORMAT_KEY, TREE_ADDR_FORMAT_TAG);
+        prefs.end();
+    } else {
+        bitAllocLog("Failed to open lease storage", 1);
+    }
+}
+
+/**
+ * @brief Lease a bit to hid: its current bit, else preferred if free, else the lowest free
+ * @return Bit index, or -1 if none is free
+ */
+static int allocate(uint16_t hid, uint8_t preferred, uint32_t now) {
+    portENTER_CRITICAL(&bitAllocMux);
+    int bit = findLeaseLocked(hid);
+    if (bit < 0) {
+        if (preferred < MAX_DISTRIBUTED_IO_BITS && leases[preferred].hid == 0) {
+            bit = preferred;
+        } else {
+            for (int b = 0; b < MAX_DISTRIBUTED_IO_BITS; b++) {
+                if (leases[b].hid == 0) {
+                    bit = b;
+                    break;
+                }
+            }
+        }
+        if (bit >= 0) {
+            leases[bit].hid = hid;
+            leases[bit].confirmed = false;
+        }
+    }
+    if (bit >= 0) {
+        leases[bit].lastSeenMs = now;
+        if (!leases[bit].confirmed) leases[bit].assignedMs = now;
+    }
+    portEXIT_CRITICAL(&bitAllocMux);
+    return bit;
+}
+
+static void confirmLease(uint16_t hid, uint8_t bit, bool accepted) {
+    if (bit >= MAX_DISTRIBUTED_IO_BITS) return;
+    portENTER_CRITICAL(&bitAllocMux);
+    if (leases[bit].hid == hid) {
+        if (accepted) {
+            if (!leases[bit].confirmed) leasesDirty = true;
+            leases[bit].confirmed = true;
+            stats.confirmed++;
+        } else {
+            if (leases[bit].confirmed) leasesDirty = true;
+            leases[bit].hid = 0;
+            leases[bit].confirmed = false;
+        }
+    }
+    portEXIT_CRITICAL(&bitAllocMux);
+}
+
+static void expireLeases(uint32_t now) {
+    bool checkAbsence = now - lastReclaimCheckMs >= BIT_RECLAIM_CHECK_MS;
+    if (checkAbsence) lastReclaimCheckMs = now;
+
+    uint16_t reclaimedHID = 0;
+    uint8_t reclaimedBit = 0;
+    portENTER_CRITICAL(&bitAllocMux);
+    for (int bit = 0; bit < MAX_DISTRIBUTED_IO_BITS; bit++) {
+        BitLease& lease = leases[bit];
+        if (lease.hid == 0 || lease.hid == ROOT_HID) continue;
+        if (!lease.confirmed && now - lease.assignedMs > BIT_PENDING_TIMEOUT_MS) {
+            lease.hid = 0;
+        } else if (checkAbsence && lease.confirmed && now - lease.lastSeenMs > BIT_LEASE_RECLAIM_MS) {
+            reclaimedHID = lease.hid;
+            reclaimedBit = bit;
+            lease.hid = 0;
+            lease.confirmed = false;
+            leasesDirty = true;
+            stats.reclaimed++;
+        }
+    }
+    portEXIT_CRITICAL(&bitAllocMux);
+
+    if (reclaimedHID != 0) {
+        bitAllocLog("Reclaimed bit " + String(reclaimedBit) + " from absent " + DATA_MGR.formatHID(reclaimedHID), 1);
+    }
+}
+
+// ============================================================================
+// RECEIVE PATH (Wi-Fi task)
+// ============================================================================
+
+static void queueEvent(uint8_t msgType, uint16_t hid, uint8_t bit, uint8_t status) {
+    portENTER_CRITICAL(&bitAllocMux);
+    if (eventCount < BIT_ALLOC_QUEUE_SIZE) {
+        BitAllocEvent& event = events[(eventHead + eventCount) % BIT_ALLOC_QUEUE_SIZE];
+        event.msgType = msgType;
+        event.hid = hid;
+        event.bit = bit;
+        event.status = status;
+        eventCount++;
+    } else {
+        stats.queueDrops++;     // The node asks again
+    }
+    portEXIT_CRITICAL(&bitAllocMux);
+}
+
+void bitAllocHandleFrame(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen) {
+#if ENABLE_BIT_ALLOCATOR
+    switch (static_cast<TreeMessageType>(header->msg_type)) {
+        case MSG_REQUEST_BIT_INDEX: {
+            if (!DATA_MGR.isRoot() || payloadLen != sizeof(BitIndexRequest)) return;
+            const BitIndexRequest* request = (const BitIndexRequest*)payload;
+            if (request->requesting_hid != header->src_hid) return;
+            queueEvent(MSG_REQUEST_BIT_INDEX, request->requesting_hid, request->preferred_bit, 0);
+            break;
+        }
+
+        case MSG_CONFIRM_BIT_INDEX: {
+            if (!DATA_MGR.isRoot() || payloadLen != sizeof(BitIndexConfirmation)) return;
+            const BitIndexConfirmation* confirmation = (const BitIndexConfirmation*)payload;
+            if (confirmation->confirming_hid != header->src_hid) return;
+            queueEvent(MSG_CONFIRM_BIT_INDEX, confirmation->confirming_hid, confirmation->confirmed_bit,
+                       confirmation->status);
+            break;
+        }
+
+        case MSG_ASSIGN_BIT_INDEX: {
+            if (DATA_MGR.isRoot() || payloadLen != sizeof(BitIndexAssignment)) return;
+            const BitIndexAssignment* assignment = (const BitIndexAssignment*)payload;
+            if (assignment->target_hid != DATA_MGR.getMyHID() || header->src_hid != ROOT_HID) return;
+            portENTER_CRITICAL(&bitAllocMux);
+            assignmentPending = true;
+            assignmentBit = assignment->assigned_bit;
+            assignmentStatus = assignment->status;
+            portEXIT_CRITICAL(&bitAllocMux);
+            break;
+        }
+
+        default:
+            break;
+    }
+#endif
+}
+
+void bitAllocNoteReport(uint16_t hid, uint8_t bitIndex) {
+#if ENABLE_BIT_ALLOCATOR
+    if (bitIndex >= MAX_DISTRIBUTED_IO_BITS) return;
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&bitAllocMux);
+    BitLease& lease = leases[bitIndex];
+    if (lease.hid == hid) {
+        lease.lastSeenMs = now;
+    } else if (lease.hid == 0) {
+        // Set by hand: adopt it so the bit isn't handed to anyone else
+        int oldBit = findLeaseLocked(hid);
+        if (oldBit >= 0) {
+            leases[oldBit].hid = 0;
+            leases[oldBit].confirmed = false;
+        }
+        lease.hid = hid;
+        lease.confirmed = true;
+        lease.lastSeenMs = now;
+        leasesDirty = true;
+        stats.learned++;
+    } else {
+        conflictHID = hid;
+        conflictBit = bitIndex;
+        stats.conflicts++;
+    }
+    portEXIT_CRITICAL(&bitAllocMux);
+#endif
+}
+
+// ============================================================================
+// LOOP TASK
+// ============================================================================
+
+static void sendAssignment(uint16_t hid, int bit) {
+    BitIndexAssignment assignment;
+    assignment.target_hid = hid;
+    assignment.assigned_bit = (bit >= 0) ? (uint8_t)bit : BIT_NO_PREFERENCE;
+    assignment.status = (bit >= 0) ? BIT_ASSIGN_OK : BIT_ASSIGN_NO_BITS;
+    sendTreeCommand(hid, MSG_ASSIGN_BIT_INDEX, (const uint8_t*)&assignment, sizeof(assignment));
+}
+
+static void sendConfirmation(uint8_t bit, uint8_t status) {
+    BitIndexConfirmation confirmation;
+    confirmation.confirming_hid = DATA_MGR.getMyHID();
+    confirmation.confirmed_bit = bit;
+    confirmation.status = status;
+    sendTreeCommand(ROOT_HID, MSG_CONFIRM_BIT_INDEX, (const uint8_t*)&confirmation, sizeof(confirmation));
+}
+
+static void processRootEvents(uint32_t now) {
+    while (true) {
+        BitAllocEvent event;
+        portENTER_CRITICAL(&bitAllocMux);
+        bool have = eventCount > 0;
+        if (have) {
+            event = events[eventHead];
+            eventHead = (eventHead + 1) % BIT_ALLOC_QUEUE_SIZE;
+            eventCount--;
+        }
+        portEXIT_CRITICAL(&bitAllocMux);
+        if (!have) break;
+
+        if (event.msgType == MSG_REQUEST_BIT_INDEX) {
+            stats.requests++;
+            int bit = allocate(event.hid, event.bit, now);
+            if (bit >= 0) {
+                stats.assigned++;
+                bitAllocLog("Assigning bit " + String(bit) + " to " + DATA_MGR.formatHID(event.hid), 2);
+            } else {
+                stats.exhausted++;
+                bitAllocLog("No free bit for " + DATA_MGR.formatHID(event.hid), 1);
+            }
+            sendAssignment(event.hid, bit);
+        } else {
+            confirmLease(event.hid, event.bit, event.status == BIT_CONFIRM_ACCEPTED);
+        }
+    }
+}
+
+static void updateRoot(uint32_t now) {
+    processRootEvents(now);
+
+    if (!DATA_MGR.isBitIndexConfigured()) {
+        int bit = allocate(ROOT_HID, preferredBit, now);
+        if (bit >= 0) {
+            confirmLease(ROOT_HID, bit, true);
+            DATA_MGR.setMyBitIndex(bit);
+            bitAllocLog("Root took bit " + String(bit), 2);
+        }
+        preferredBit = BIT_NO_PREFERENCE;
+    }
+
+    expireLeases(now);
+
+    if (conflictHID != 0) {
+        bitAllocLog(DATA_MGR.formatHID(conflictHID) + " reports bit " + String(conflictBit) +
+                    ", which is leased to another node", 1);
+        conflictHID = 0;
+    }
+
+    if (leasesDirty) {
+        saveLeases();
+    }
+}
+
+static void updateNode(uint32_t now) {
+    bool pending;
+    uint8_t bit;
+    uint8_t status;
+    portENTER_CRITICAL(&bitAllocMux);
+    pending = assignmentPending;
+    bit = assignmentBit;
+    status = assignmentStatus;
+    assignmentPending = false;
+    portEXIT_CRITICAL(&bitAllocMux);
+
+    if (pending) {
+        if (status != BIT_ASSIGN_OK) {
+            bitAllocLog("Root has no free bit, retrying later", 1);
+            nextRequestMs = now + BIT_REQUEST_FULL_BACKOFF_MS;
+        } else if (DATA_MGR.isBitIndexConfigured() && DATA_MGR.getMyBitIndex() != bit) {
+            sendConfirmation(bit, BIT_CONFIRM_REJECTED);    // Set by hand in the meantime
+        } else if (DATA_MGR.isBitIndexConfigured() || DATA_MGR.setMyBitIndex(bit)) {
+            sendConfirmation(bit, BIT_CONFIRM_ACCEPTED);
+            if (requestScheduled) {
+                stats.lastCommissionMs = now - firstRequestMs;
+                bitAllocLog("Bit " + String(bit) + " assigned in " + String(stats.lastCommissionMs) + " ms", 1);
+            }
+            requestScheduled = false;
+            preferredBit = BIT_NO_PREFERENCE;
+        }
+    }
+
+    if (DATA_MGR.isBitIndexConfigured()) {
+        requestScheduled = false;
+        return;
+    }
+
+    if (!requestScheduled) {
+        // Stagger by HID so nodes powered up together don't request at once
+        requestScheduled = true;
+        firstRequestMs = now;
+        nextRequestMs = now + (DATA_MGR.getMyHID() % BIT_REQUEST_STAGGER_SLOTS) * BIT_REQUEST_STAGGER_MS;
+    }
+
+    if ((int32_t)(now - nextRequestMs) >= 0) {
+        BitIndexRequest request;
+        request.requesting_hid = DATA_MGR.getMyHID();
+        request.preferred_bit = preferredBit;
+        sendTreeCommand(ROOT_HID, MSG_REQUEST_BIT_INDEX, (const uint8_t*)&request, sizeof(request));
+        stats.requestsSent++;
+        nextRequestMs = now + BIT_REQUEST_INTERVAL_MS;
+    }
+}
+
+void bitAllocInit() {
+#if ENABLE_BIT_ALLOCATOR
+    uint16_t hids[MAX_DISTRIBUTED_IO_BITS];
+    memset(hids, 0, sizeof(hids));
+
+    uint8_t storedFormat = TREE_ADDR_FORMAT_TAG;
+    Preferences prefs;
+    if (prefs.begin(LEASE_NAMESPACE, true)) {
+        if (prefs.getBytes(LEASE_KEY, hids, sizeof(hids)) != sizeof(hids)) {
+            memset(hids, 0, sizeof(hids));
+        }
+        storedFormat = prefs.getUChar(LEASE_FORMAT_KEY, TREE_ADDR_TAG_DECIMAL);
+        prefs.end();
+    }
+
+    // Leases written under another HID format (tree_address.h)
+    bool converted = false;
+    if (storedFormat != TREE_ADDR_FORMAT_TAG) {
+        for (int bit = 0; bit < MAX_DISTRIBUTED_IO_BITS; bit++) {
+            if (hids[bit] != 0) {
+                hids[bit] = treeAddrConvert(hids[bit], storedFormat);
+                converted = true;
+            }
+        }
+    }
+
+    // Absence is counted from now, so leases survive a root restart intact
+    uint32_t now = millis();
+    uint8_t count = 0;
+    for (int bit = 0; bit < MAX_DISTRIBUTED_IO_BITS; bit++) {
+        leases[bit].hid = hids[bit];
+        leases[bit].confirmed = hids[bit] != 0;
+        leases[bit].lastSeenMs = now;
+        leases[bit].assignedMs = now;
+        if (hids[bit] != 0) count++;
+    }
+    lastReclaimCheckMs = now;
+    bitAllocLog("Loaded " + String(count) + " bit leases", 3);
+    if (converted) {
+        saveLeases();
+    }
+#endif
+}
+
+void bitAllocUpdate() {
+#if ENABLE_BIT_ALLOCATOR
+    if (!DATA_MGR.isHIDConfigured()) {
+        return;
+    }
+
+    uint32_t now = millis();
+    if (DATA_MGR.isRoot()) {
+        updateRoot(now);
+    } else {
+        updateNode(now);
+    }
+#endif
+}
+
+// ============================================================================
+// CONTROL AND STATUS
+// ============================================================================
+
+void bitAllocRequest(uint8_t preferred) {
+    preferredBit = preferred;
+    requestScheduled = false;
+    if (DATA_MGR.isRoot()) {
+        bitAllocRelease(ROOT_HID);
+    }
+    DATA_MGR.clearBitIndexFromNVM();
+}
+
+bool bitAllocRelease(uint16_t hid) {
+    portENTER_CRITICAL(&bitAllocMux);
+    int bit = findLeaseLocked(hid);
+    if (bit >= 0) {
+        leases[bit].hid = 0;
+        leases[bit].confirmed = false;
+        leasesDirty = true;
+    }
+    portEXIT_CRITICAL(&bitAllocMux);
+    return bit >= 0;
+}
+
+void bitAllocGetLeases(uint16_t* hids, uint8_t count) {
+    if (count > MAX_DISTRIBUTED_IO_BITS) count = MAX_DISTRIBUTED_IO_BITS;
+    portENTER_CRITICAL(&bitAllocMux);
+    for (uint8_t bit = 0; bit < count; bit++) {
+        hids[bit] = leases[bit].hid;
+    }
+    portEXIT_CRITICAL(&bitAllocMux);
+}
+
+void bitAllocGetStats(BitAllocStats& out) {
+    portENTER_CRITICAL(&bitAllocMux);
+    out = stats;
+    out.leasedCount = 0;
+    out.pendingCount = 0;
+    for (const BitLease& lease : leases) {
+        if (lease.hid == 0) continue;
+        if (lease.confirmed) out.leasedCount++;
+        else out.pendingCount++;
+    }
+    portEXIT_CRITICAL(&bitAllocMux);
+}
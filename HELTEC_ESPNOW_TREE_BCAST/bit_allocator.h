@@ -0,0 +1,119 @@
+#ifndef BIT_ALLOCATOR_H
+#define BIT_ALLOCATOR_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+
+// ============================================================================
+// BIT INDEX ALLOCATOR CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Automatic bit index allocation, owned by the root.
+ *
+ * A node with a HID but no bit index sends MSG_REQUEST_BIT_INDEX to the root
+ * every BIT_REQUEST_INTERVAL_MS. Start times are staggered by HID, so a site
+ * powered up at once doesn't send all its requests together.
+ *
+ * The root keeps one lease per bit:
+ * - It honours preferred_bit when that bit is free.
+ * - Otherwise it gives the lowest free bit.
+ * - A node that asks again gets the bit it already holds.
+ *
+ * The assignment goes back down the tree as MSG_ASSIGN_BIT_INDEX. The node
+ * stores the bit and answers with MSG_CONFIRM_BIT_INDEX. Only confirmed
+ * leases are written to NVM, in Preferences namespace "bit_alloc".
+ * Unconfirmed assignments are released after BIT_PENDING_TIMEOUT_MS.
+ *
+ * Bits set by hand (menu or CONFIG_SAVE) are learned from data reports, so
+ * they are never handed out twice. A lease whose node has sent no report for
+ * BIT_LEASE_RECLAIM_MS is reclaimed. Absence is counted from the root's
+ * boot, so a root restart never shortens it.
+ *
+ * Set to 0 to leave bit indices entirely to manual configuration.
+ */
+#define ENABLE_BIT_ALLOCATOR 1
+
+#define BIT_REQUEST_INTERVAL_MS     1000
+#define BIT_REQUEST_STAGGER_MS      100     // Per HID step, over BIT_REQUEST_STAGGER_SLOTS
+#define BIT_REQUEST_STAGGER_SLOTS   10
+#define BIT_REQUEST_FULL_BACKOFF_MS 30000   // After "no available bits"
+#define BIT_PENDING_TIMEOUT_MS      10000   // Unconfirmed assignment is released after this
+#define BIT_LEASE_RECLAIM_MS        (7UL * 24 * 60 * 60 * 1000)   // One week without a report
+#define BIT_RECLAIM_CHECK_MS        60000
+#define BIT_ALLOC_QUEUE_SIZE        8
+#define BIT_NO_PREFERENCE           0xFF
+
+enum BitAssignStatus : uint8_t {
+    BIT_ASSIGN_OK      = 0,
+    BIT_ASSIGN_NO_BITS = 1
+};
+
+enum BitConfirmStatus : uint8_t {
+    BIT_CONFIRM_ACCEPTED = 0,
+    BIT_CONFIRM_REJECTED = 1
+};
+
+struct BitAllocStats {
+    // Root
+    uint32_t requests = 0;
+    uint32_t assigned = 0;          // Assignments sent (including repeats)
+    uint32_t confirmed = 0;
+    uint32_t exhausted = 0;         // Requests refused with no free bit
+    uint32_t learned = 0;           // Leases taken over from hand-set bits
+    uint32_t reclaimed = 0;
+    uint32_t conflicts = 0;         // Reports using a bit leased to another HID
+    uint32_t queueDrops = 0;
+    uint8_t  leasedCount = 0;
+    uint8_t  pendingCount = 0;
+    // Node
+    uint32_t requestsSent = 0;
+    uint32_t lastCommissionMs = 0;  // First request to confirmed assignment
+};
+
+// ============================================================================
+// BIT INDEX ALLOCATOR API
+// ============================================================================
+
+/**
+ * @brief Load the root's leases from NVM. Call once from setup().
+ */
+void bitAllocInit();
+
+/**
+ * @brief Request, assign, confirm, persist and reclaim. Call from loop().
+ */
+void bitAllocUpdate();
+
+/**
+ * @brief Receive path hook for MSG_REQUEST/ASSIGN/CONFIRM_BIT_INDEX.
+ *        Called from the Wi-Fi task; only queues the frame.
+ */
+void bitAllocHandleFrame(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen);
+
+/**
+ * @brief Root: note a data report so the sender's lease stays alive
+ *        (and hand-set bits are learned). Called from the Wi-Fi task.
+ */
+void bitAllocNoteReport(uint16_t hid, uint8_t bitIndex);
+
+/**
+ * @brief Node: drop the current bit index and ask the root for one
+ * @param preferredBit Bit to ask for, or BIT_NO_PREFERENCE
+ */
+void bitAllocRequest(uint8_t preferredBit);
+
+/**
+ * @brief Root: free the lease held by hid
+ * @return false if hid holds no lease
+ */
+bool bitAllocRelease(uint16_t hid);
+
+/**
+ * @brief Root: HID holding each bit (0 = free)
+ */
+void bitAllocGetLeases(uint16_t* hids, uint8_t count);
+
+void bitAllocGetStats(BitAllocStats& out);
+
+#endif // BIT_ALLOCATOR_H
@@ -0,0 +1,64 @@
+#include "boot_profiler.h"
+#include "debug.h"
+#include <esp_timer.h>
+
+// Logging macros for the boot profiler module
+#define MODULE_TITLE       "BOOT"
+#define MODULE_DEBUG_LEVEL 1
+#define bootLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// PROFILER STATE
+// ============================================================================
+
+static BootMark bootMarks[BOOT_PROFILE_MAX_MARKS];
+static uint8_t bootMarkCount = 0;
+static uint32_t firstReportUs = 0;
+
+// ============================================================================
+// BOOT PROFILER API
+// ============================================================================
+
+void bootMark(const char* phase) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    if (bootMarkCount >= BOOT_PROFILE_MAX_MARKS) {
+        return;
+    }
+    bootMarks[bootMarkCount].phase = phase;
+    bootMarks[bootMarkCount].timeUs = now;
+    bootMarkCount++;
+}
+
+void bootMarkFirstReport() {
+    if (firstReportUs != 0) {
+        return;
+    }
+    firstReportUs = (uint32_t)esp_timer_get_time();
+    bootLog("First data report at " + String(firstReportUs / 1000) + " ms after boot", 1);
+}
+
+void bootProfilerPrint() {
+    Serial.println("=== BOOT PROFILE (ms since esp_timer start) ===");
+    uint32_t previousUs = 0;
+    for (uint8_t i = 0; i < bootMarkCount; i++) {
+        Serial.printf("  %-12s %8.1f  (+%.1f)\n", bootMarks[i].phase,
+                      bootMarks[i].timeUs / 1000.0f,
+                      (bootMarks[i].timeUs - previousUs) / 1000.0f);
+        previousUs = bootMarks[i].timeUs;
+    }
+    if (firstReportUs != 0) {
+        Serial.printf("  %-12s %8.1f\n", "first_report", firstReportUs / 1000.0f);
+    } else {
+        Serial.println("  first_report (not sent yet)");
+    }
+    Serial.println("===============================================");
+}
+
+uint8_t bootGetMarks(const BootMark*& marks) {
+    marks = bootMarks;
+    return bootMarkCount;
+}
+
+uint32_t bootGetFirstReportUs() {
+    return firstReportUs;
+}
@@ -0,0 +1,66 @@
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// BOOT CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Fast boot: get back on the air as soon as possible after a reset.
+ *
+ * - Skips the wait for a serial monitor and the fixed settle delays in setup()
+ * - Initializes the OLED in a background task while ESP-NOW starts
+ * - Sends one data report from setup() instead of waiting for the first
+ *   input change or auto-report interval
+ *
+ * Set to 0 while debugging boot to get the old, slower sequence (early serial
+ * output is easier to catch with the 3 s monitor wait).
+ */
+#define ENABLE_FAST_BOOT 1
+
+#define BOOT_PROFILE_MAX_MARKS 16
+
+/**
+ * @brief One timestamped boot phase
+ */
+struct BootMark {
+    const char* phase;   // Must be a string literal
+    uint32_t timeUs;     // esp_timer time at the end of the phase
+};
+
+// ============================================================================
+// BOOT PROFILER API
+// ============================================================================
+
+/**
+ * @brief Record the end of a boot phase.
+ * @note Times are from esp_timer start, so ROM and 2nd-stage bootloader time
+ *       (typically 50-300 ms depending on bootloader log level) is not included.
+ */
+void bootMark(const char* phase);
+
+/**
+ * @brief Record the first MSG_DEVICE_DATA_REPORT handed to the radio.
+ *        Cheap after the first call; safe to call on every report.
+ */
+void bootMarkFirstReport();
+
+/**
+ * @brief Print the phase table to Serial
+ */
+void bootProfilerPrint();
+
+/**
+ * @brief Access the recorded marks
+ * @return number of marks (up to BOOT_PROFILE_MAX_MARKS)
+ */
+uint8_t bootGetMarks(const BootMark*& marks);
+
+/**
+ * @brief Time of the first data report, 0 if none has been sent yet
+ */
+uint32_t bootGetFirstReportUs();
+
+#endif // BOOT_PROFILER_H
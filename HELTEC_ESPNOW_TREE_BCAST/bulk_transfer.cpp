@@ -0,0 +1,547 @@
+#include "bulk_transfer.h"
+#include "debug.h"
+#include "espnow_wrapper.h"
+#include <esp_system.h>
+
+// Logging macros for the bulk transfer module
+#define MODULE_TITLE       "BULK"
+#define MODULE_DEBUG_LEVEL 1
+#define bulkLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// TRANSFER STATE
+// ============================================================================
+
+enum BulkSlotState : uint8_t {
+    BULK_SLOT_FREE = 0,
+    BULK_SLOT_RECEIVING,
+    BULK_SLOT_COMPLETE,         // Waiting for bulkUpdate() to deliver it
+    BULK_SLOT_DELIVERED         // Kept so late duplicates are still acknowledged
+};
+
+struct BulkRxSlot {
+    uint8_t  state;
+    uint16_t srcHID;
+    uint8_t  transferId;
+    uint8_t  kind;
+    uint8_t  fragCount;
+    uint16_t totalLen;
+    uint32_t receivedMask;
+    uint8_t  sinceAck;          // In-order fragments since the last ACK
+    bool     ackPending;
+    uint32_t firstMs;
+    uint32_t lastMs;
+#if ENABLE_BULK_TRANSFER
+    uint8_t  data[BULK_MAX_PAYLOAD];
+#endif
+};
+
+enum BulkTxResult : uint8_t {
+    BULK_TX_NONE = 0,
+    BULK_TX_DONE,
+    BULK_TX_FAILED
+};
+
+struct BulkTxState {
+    bool     active;
+    uint8_t  result;            // BulkTxResult, reported from loop()
+    uint16_t destHID;
+    uint8_t  transferId;
+    uint8_t  kind;
+    uint8_t  fragCount;
+    uint16_t totalLen;
+    uint32_t ackedMask;
+    uint32_t sentMask;          // Sent and not due for resend
+    uint32_t everSentMask;
+    uint16_t sendOrder[BULK_MAX_FRAGMENTS];   // txCounter when each fragment last went out
+    uint16_t txCounter;
+    uint8_t  retries;
+    uint32_t startMs;
+    uint32_t lastProgressMs;
+    uint32_t lastFragmentMs;
+    uint32_t busyUntilMs;
+};
+
+static BulkRxSlot rxSlots[BULK_RX_SLOTS];
+static BulkTxState tx;
+#if ENABLE_BULK_TRANSFER
+static uint8_t txBuffer[BULK_MAX_PAYLOAD];
+#endif
+// Seeded randomly on first use: a rebooted sender starting again from 0 would
+// match the receiver's DELIVERED slot and be acknowledged without delivery
+static uint8_t nextTransferId = 0;
+static bool transferIdSeeded = false;
+
+// Refusal for a sender that could not get a slot
+static bool busyAckPending = false;
+static uint16_t busyAckHID = 0;
+static uint8_t busyAckTransferId = 0;
+static uint8_t busyAckStatus = BULK_STATUS_BUSY;
+
+static BulkStats stats;
+static BulkReceiveHandler receiveHandler = nullptr;
+
+// Fragments and ACKs arrive on the Wi-Fi task, everything else runs in loop()
+static portMUX_TYPE bulkMux = portMUX_INITIALIZER_UNLOCKED;
+
+static_assert((BULK_MAX_PAYLOAD + BULK_FRAGMENT_DATA_MAX - 1) / BULK_FRAGMENT_DATA_MAX <= BULK_MAX_FRAGMENTS,
+              "BULK_MAX_PAYLOAD needs more fragments than the ACK bitmap holds");
+
+static uint8_t fragmentsFor(uint16_t len) {
+    return (len + BULK_FRAGMENT_DATA_MAX - 1) / BULK_FRAGMENT_DATA_MAX;
+}
+
+static uint16_t fragmentLen(uint16_t totalLen, uint8_t index) {
+    uint16_t remaining = totalLen - index * BULK_FRAGMENT_DATA_MAX;
+    return (remaining < BULK_FRAGMENT_DATA_MAX) ? remaining : BULK_FRAGMENT_DATA_MAX;
+}
+
+static uint32_t maskFor(uint8_t fragCount) {
+    return (fragCount >= 32) ? 0xFFFFFFFFUL : ((1UL << fragCount) - 1);
+}
+
+static uint8_t testPatternByte(uint16_t offset) {
+    return (uint8_t)(offset * 7 + (offset >> 8));
+}
+
+// ============================================================================
+// SENDING
+// ============================================================================
+
+static bool startSend(uint16_t destHID, uint8_t kind, uint16_t len) {
+    if (!DATA_MGR.isHIDConfigured()) {
+        bulkLog("Cannot send, HID not configured", 2);
+        return false;
+    }
+    if (destHID == BROADCAST_HID || destHID == DATA_MGR.getMyHID() || !treeAddrIsValid(destHID)) {
+        bulkLog("Cannot send to " + DATA_MGR.formatHID(destHID), 2);
+        return false;
+    }
+
+    uint32_t now = millis();
+    if (!transferIdSeeded) {
+        nextTransferId = (uint8_t)esp_random();   // Radio is up, so this is a true random number
+        transferIdSeeded = true;
+    }
+    portENTER_CRITICAL(&bulkMux);
+    tx.active = true;
+    tx.result = BULK_TX_NONE;
+    tx.destHID = destHID;
+    tx.transferId = nextTransferId++;
+    tx.kind = kind;
+    tx.fragCount = fragmentsFor(len);
+    tx.totalLen = len;
+    tx.ackedMask = 0;
+    tx.sentMask = 0;
+    tx.everSentMask = 0;
+    tx.txCounter = 0;
+    tx.retries = 0;
+    tx.startMs = now;
+    tx.lastProgressMs = now;
+    tx.lastFragmentMs = 0;
+    tx.busyUntilMs = now;
+    portEXIT_CRITICAL(&bulkMux);
+
+    bulkLog("Sending " + String(len) + " bytes to " + DATA_MGR.formatHID(destHID) + " in " +
+            String(tx.fragCount) + " fragments", 3);
+    return true;
+}
+
+bool bulkSend(uint16_t destHID, uint8_t kind, const uint8_t* data, uint16_t len) {
+#if ENABLE_BULK_TRANSFER
+    if (tx.active || !data || len == 0 || len > BULK_MAX_PAYLOAD) {
+        return false;
+    }
+    memcpy(txBuffer, data, len);
+    return startSend(destHID, kind, len);
+#else
+    return false;
+#endif
+}
+
+bool bulkSendTestPattern(uint16_t destHID, uint16_t len) {
+#if ENABLE_BULK_TRANSFER
+    if (tx.active || len == 0 || len > BULK_MAX_PAYLOAD) {
+        return false;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        txBuffer[i] = testPatternByte(i);
+    }
+    return startSend(destHID, BULK_KIND_TEST, len);
+#else
+    return false;
+#endif
+}
+
+bool bulkIsSending() {
+    return tx.active;
+}
+
+/**
+ * @brief Send the next fragment of the window, if pacing allows
+ */
+static void sendNextFragment(uint32_t now) {
+#if ENABLE_BULK_TRANSFER
+    if ((int32_t)(now - tx.busyUntilMs) < 0 ||
+        now - tx.lastFragmentMs < BULK_FRAGMENT_GAP_MS ||
+        now - espnowGetLastForegroundTxMs() < BULK_IO_HOLDOFF_MS) {
+        return;
+    }
+
+    uint8_t payload[sizeof(BulkFragmentHeader) + BULK_FRAGMENT_DATA_MAX];
+    BulkFragmentHeader frag;
+    int index = -1;
+
+    portENTER_CRITICAL(&bulkMux);
+    if (tx.active) {
+        uint8_t base = 0;
+        while (base < tx.fragCount && (tx.ackedMask & (1UL << base))) {
+            base++;
+        }
+        uint8_t end = (base + BULK_WINDOW < tx.fragCount) ? base + BULK_WINDOW : tx.fragCount;
+        for (uint8_t i = base; i < end; i++) {
+            uint32_t bit = 1UL << i;
+            if (!(tx.ackedMask & bit) && !(tx.sentMask & bit)) {
+                index = i;
+                break;
+            }
+        }
+        if (index >= 0) {
+            uint32_t bit = 1UL << index;
+            if (tx.everSentMask & bit) {
+                stats.txRetransmits++;
+            }
+            tx.sentMask |= bit;
+            tx.everSentMask |= bit;
+            tx.sendOrder[index] = ++tx.txCounter;
+            frag.transferId = tx.transferId;
+            frag.kind = tx.kind;
+            frag.fragIndex = index;
+            frag.fragCount = tx.fragCount;
+            frag.totalLen = tx.totalLen;
+        }
+    }
+    portEXIT_CRITICAL(&bulkMux);
+
+    if (index < 0) {
+        return;
+    }
+
+    uint16_t offset = index * BULK_FRAGMENT_DATA_MAX;
+    uint16_t dataLen = fragmentLen(frag.totalLen, index);
+    memcpy(payload, &frag, sizeof(frag));
+    memcpy(payload + sizeof(frag), txBuffer + offset, dataLen);
+
+    sendTreeCommand(tx.destHID, MSG_BULK_DATA, payload, sizeof(frag) + dataLen);
+    tx.lastFragmentMs = now;
+    stats.txFragments++;
+#endif
+}
+
+static void checkSendTimeout(uint32_t now) {
+    portENTER_CRITICAL(&bulkMux);
+    if (tx.active && (tx.sentMask & ~tx.ackedMask) && (int32_t)(now - tx.lastProgressMs) >= BULK_ACK_TIMEOUT_MS) {
+        // No ACK: resend whatever of the window is still unacknowledged
+        tx.sentMask = tx.ackedMask;
+        tx.lastProgressMs = now;
+        if (++tx.retries > BULK_MAX_RETRIES) {
+            tx.active = false;
+            tx.result = BULK_TX_FAILED;
+            stats.txFailed++;
+        }
+    }
+    portEXIT_CRITICAL(&bulkMux);
+}
+
+void bulkHandleAck(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen) {
+    if (!payload || payloadLen < sizeof(BulkAckPayload)) {
+        return;
+    }
+    BulkAckPayload ack;
+    memcpy(&ack, payload, sizeof(ack));
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&bulkMux);
+    if (tx.active && header->src_hid == tx.destHID && ack.transferId == tx.transferId) {
+        uint32_t received = ack.receivedMask & maskFor(tx.fragCount);
+        if (ack.status == BULK_STATUS_BUSY) {
+            // Receiver has no slot free: back off and start over
+            tx.sentMask = tx.ackedMask;
+            tx.busyUntilMs = now + BULK_BUSY_BACKOFF_MS;
+            tx.lastProgressMs = now + BULK_BUSY_BACKOFF_MS;
+            if (++tx.retries > BULK_MAX_RETRIES) {
+                tx.active = false;
+                tx.result = BULK_TX_FAILED;
+            }
+        } else if (ack.status == BULK_STATUS_INVALID) {
+            tx.active = false;
+            tx.result = BULK_TX_FAILED;
+        } else {
+            if (received & ~tx.ackedMask) {
+                tx.lastProgressMs = now;
+                tx.retries = 0;
+            }
+            tx.ackedMask |= received;
+
+            // Selective NACK: a hole the receiver reports is resent once a
+            // fragment sent after it has arrived, so it was not just in flight
+            uint16_t newestArrived = 0;
+            for (uint8_t i = 0; i < tx.fragCount; i++) {
+                if ((received & (1UL << i)) && tx.sendOrder[i] > newestArrived) {
+                    newestArrived = tx.sendOrder[i];
+                }
+            }
+            for (uint8_t i = 0; i < tx.fragCount; i++) {
+                uint32_t bit = 1UL << i;
+                if ((tx.sentMask & bit) && !(tx.ackedMask & bit) && tx.sendOrder[i] < newestArrived) {
+                    tx.sentMask &= ~bit;
+                }
+            }
+
+            if (ack.status == BULK_STATUS_COMPLETE || tx.ackedMask == maskFor(tx.fragCount)) {
+                tx.active = false;
+                tx.result = BULK_TX_DONE;
+            }
+        }
+        if (tx.result == BULK_TX_DONE) {
+            stats.txTransfers++;
+            stats.lastTxBytes = tx.totalLen;
+            stats.lastTxMs = now - tx.startMs;
+        } else if (tx.result == BULK_TX_FAILED) {
+            stats.txFailed++;
+        }
+    }
+    portEXIT_CRITICAL(&bulkMux);
+}
+
+// ============================================================================
+// RECEIVING
+// ============================================================================
+
+static void refuseFragment(uint16_t srcHID, uint8_t transferId, uint8_t status) {
+    busyAckPending = true;
+    busyAckHID = srcHID;
+    busyAckTransferId = transferId;
+    busyAckStatus = status;
+    stats.rxDropped++;
+}
+
+static BulkRxSlot* findSlotFor(uint16_t srcHID) {
+    BulkRxSlot* spare = nullptr;
+    for (BulkRxSlot& slot : rxSlots) {
+        if (slot.state != BULK_SLOT_FREE && slot.srcHID == srcHID) {
+            return &slot;
+        }
+        if (!spare && (slot.state == BULK_SLOT_FREE || slot.state == BULK_SLOT_DELIVERED)) {
+            spare = &slot;
+        }
+    }
+    if (spare) {
+        spare->state = BULK_SLOT_FREE;
+    }
+    return spare;
+}
+
+void bulkHandleFragment(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen) {
+#if ENABLE_BULK_TRANSFER
+    if (!payload || payloadLen < sizeof(BulkFragmentHeader)) {
+        return;
+    }
+    BulkFragmentHeader frag;
+    memcpy(&frag, payload, sizeof(frag));
+    const uint8_t* fragData = payload + sizeof(frag);
+    size_t dataLen = payloadLen - sizeof(frag);
+    uint32_t now = millis();
+
+    bool valid = frag.totalLen > 0 && frag.totalLen <= BULK_MAX_PAYLOAD &&
+                 frag.fragCount == fragmentsFor(frag.totalLen) && frag.fragIndex < frag.fragCount;
+    uint16_t offset = frag.fragIndex * BULK_FRAGMENT_DATA_MAX;
+    if (valid) {
+        valid = dataLen == fragmentLen(frag.totalLen, frag.fragIndex);
+    }
+
+    portENTER_CRITICAL(&bulkMux);
+    stats.rxFragments++;
+    if (!valid) {
+        refuseFragment(header->src_hid, frag.transferId, BULK_STATUS_INVALID);
+        portEXIT_CRITICAL(&bulkMux);
+        return;
+    }
+
+    BulkRxSlot* slot = findSlotFor(header->src_hid);
+    if (slot && slot->state != BULK_SLOT_FREE && slot->transferId != frag.transferId) {
+        if (slot->state == BULK_SLOT_COMPLETE) {
+            slot = nullptr;                 // Previous transfer not delivered yet
+        } else {
+            if (slot->state == BULK_SLOT_RECEIVING) {
+                stats.rxDropped++;          // Sender gave up on it
+            }
+            slot->state = BULK_SLOT_FREE;
+        }
+    }
+    if (!slot) {
+        refuseFragment(header->src_hid, frag.transferId, BULK_STATUS_BUSY);
+        portEXIT_CRITICAL(&bulkMux);
+        return;
+    }
+
+    if (slot->state == BULK_SLOT_FREE) {
+        slot->state = BULK_SLOT_RECEIVING;
+        slot->srcHID = header->src_hid;
+        slot->transferId = frag.transferId;
+        slot->kind = frag.kind;
+        slot->fragCount = frag.fragCount;
+        slot->totalLen = frag.totalLen;
+        slot->receivedMask = 0;
+        slot->sinceAck = 0;
+        slot->ackPending = false;
+        slot->firstMs = now;
+    }
+
+    uint32_t bit = 1UL << frag.fragIndex;
+    if (slot->state != BULK_SLOT_RECEIVING || (slot->receivedMask & bit)) {
+        stats.rxDuplicates++;
+        slot->ackPending = true;            // Our ACK was probably lost
+    } else {
+        memcpy(slot->data + offset, fragData, dataLen);
+        slot->receivedMask |= bit;
+        slot->lastMs = now;
+
+        if (slot->receivedMask == maskFor(slot->fragCount)) {
+            slot->state = BULK_SLOT_COMPLETE;
+            slot->ackPending = true;
+            stats.rxTransfers++;
+            stats.lastRxBytes = slot->totalLen;
+            stats.lastRxMs = now - slot->firstMs;
+        } else if (~slot->receivedMask & maskFor(frag.fragIndex)) {
+            slot->ackPending = true;        // Gap below this fragment: NACK it now
+        } else if (++slot->sinceAck >= BULK_ACK_EVERY) {
+            slot->ackPending = true;
+        }
+    }
+    portEXIT_CRITICAL(&bulkMux);
+#endif
+}
+
+/**
+ * @brief Send one pending ACK (slot or refusal) per call
+ */
+static void sendPendingAck() {
+    BulkAckPayload ack = {};
+    uint16_t destHID = 0;
+    bool send = false;
+
+    portENTER_CRITICAL(&bulkMux);
+    if (busyAckPending) {
+        busyAckPending = false;
+        destHID = busyAckHID;
+        ack.transferId = busyAckTransferId;
+        ack.status = busyAckStatus;
+        send = true;
+    } else {
+        for (BulkRxSlot& slot : rxSlots) {
+            if (slot.ackPending && slot.state != BULK_SLOT_FREE) {
+                slot.ackPending = false;
+                slot.sinceAck = 0;
+                destHID = slot.srcHID;
+                ack.transferId = slot.transferId;
+                ack.status = (slot.state == BULK_SLOT_RECEIVING) ? BULK_STATUS_OK : BULK_STATUS_COMPLETE;
+                ack.receivedMask = slot.receivedMask;
+                send = true;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&bulkMux);
+
+    if (send) {
+        sendTreeCommand(destHID, MSG_BULK_ACK, (const uint8_t*)&ack, sizeof(ack));
+    }
+}
+
+static void deliverCompleted(uint32_t now) {
+#if ENABLE_BULK_TRANSFER
+    for (BulkRxSlot& slot : rxSlots) {
+        portENTER_CRITICAL(&bulkMux);
+        bool complete = slot.state == BULK_SLOT_COMPLETE;
+        if (slot.state == BULK_SLOT_RECEIVING && now - slot.lastMs > BULK_RX_TIMEOUT_MS) {
+            slot.state = BULK_SLOT_FREE;
+            stats.rxDropped++;
+        } else if (slot.state == BULK_SLOT_DELIVERED && now - slot.lastMs > BULK_DELIVERED_HOLD_MS) {
+            slot.state = BULK_SLOT_FREE;    // The sender has stopped retrying by now
+        }
+        portEXIT_CRITICAL(&bulkMux);
+
+        if (!complete) {
+            continue;
+        }
+
+        // The receive path leaves COMPLETE slots' data alone, so no lock needed here
+        bulkLog("Received " + String(slot.totalLen) + " bytes from " + DATA_MGR.formatHID(slot.srcHID) + ", " +
+                String(bulkGoodput(slot.totalLen, slot.lastMs - slot.firstMs)) + " B/s", 3);
+        if (slot.kind == BULK_KIND_TEST) {
+            uint16_t errors = 0;
+            for (uint16_t i = 0; i < slot.totalLen; i++) {
+                if (slot.data[i] != testPatternByte(i)) errors++;
+            }
+            if (errors > 0) {
+                bulkLog("Test pattern from " + DATA_MGR.formatHID(slot.srcHID) + " has " + String(errors) +
+                        " bad bytes", 1);
+            }
+        } else if (receiveHandler) {
+            receiveHandler(slot.srcHID, slot.kind, slot.data, slot.totalLen);
+        }
+
+        portENTER_CRITICAL(&bulkMux);
+        slot.state = BULK_SLOT_DELIVERED;
+        slot.lastMs = now;
+        portEXIT_CRITICAL(&bulkMux);
+    }
+#endif
+}
+
+// ============================================================================
+// BULK TRANSFER API
+// ============================================================================
+
+void bulkUpdate() {
+    uint32_t now = millis();
+    deliverCompleted(now);
+    sendPendingAck();
+
+    checkSendTimeout(now);
+    if (tx.active) {
+        sendNextFragment(now);
+    }
+
+    if (tx.result != BULK_TX_NONE) {
+        if (tx.result == BULK_TX_DONE) {
+            bulkLog("Sent " + String(tx.totalLen) + " bytes to " + DATA_MGR.formatHID(tx.destHID) + ", " +
+                    String(bulkGoodput(stats.lastTxBytes, stats.lastTxMs)) + " B/s", 3);
+        } else {
+            bulkLog("Transfer to " + DATA_MGR.formatHID(tx.destHID) + " failed", 2);
+        }
+        tx.result = BULK_TX_NONE;
+    }
+}
+
+void bulkSetReceiveHandler(BulkReceiveHandler handler) {
+    receiveHandler = handler;
+}
+
+uint32_t bulkGoodput(uint16_t bytes, uint32_t elapsedMs) {
+    return (uint32_t)bytes * 1000 / (elapsedMs > 0 ? elapsedMs : 1);
+}
+
+void bulkGetStats(BulkStats& out) {
+    portENTER_CRITICAL(&bulkMux);
+    out = stats;
+    out.txActive = tx.active;
+    portEXIT_CRITICAL(&bulkMux);
+}
+
+void bulkResetStats() {
+    portENTER_CRITICAL(&bulkMux);
+    stats = BulkStats();
+    portEXIT_CRITICAL(&bulkMux);
+}
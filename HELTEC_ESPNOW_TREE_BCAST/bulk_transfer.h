@@ -0,0 +1,152 @@
+#ifndef BULK_TRANSFER_H
+#define BULK_TRANSFER_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+#include "frame_auth.h"
+
+// ============================================================================
+// BULK TRANSFER CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Fragmented transfers for payloads larger than one tree frame.
+ *
+ * A payload of up to BULK_MAX_PAYLOAD bytes is split into MSG_BULK_DATA
+ * fragments addressed to one HID. They travel through the tree like any
+ * other unicast frame, so intermediate nodes forward them unchanged.
+ *
+ * The sender keeps at most BULK_WINDOW unacknowledged fragments in flight.
+ * The receiver answers with MSG_BULK_ACK, which carries a bitmap of every
+ * fragment it holds. As soon as it sees a gap it acknowledges straight away,
+ * and the sender resends only the missing fragments (selective NACK). If no
+ * ACK arrives within BULK_ACK_TIMEOUT_MS, the unacknowledged part of the
+ * window is resent.
+ *
+ * Each receiver reassembles into a fixed pool of BULK_RX_SLOTS buffers, one
+ * per sending HID. A sender that finds the pool full gets BULK_STATUS_BUSY
+ * and retries later.
+ *
+ * Bulk traffic yields to everything else: all bulk TX happens from
+ * bulkUpdate() on the loop task, at most one fragment per pass, spaced by
+ * BULK_FRAGMENT_GAP_MS, and held off for BULK_IO_HOLDOFF_MS after any other
+ * frame went out.
+ *
+ * Set to 0 to compile bulk transfers out and free the buffers.
+ */
+#define ENABLE_BULK_TRANSFER 1
+
+#define BULK_MAX_PAYLOAD        2048
+#define BULK_MAX_FRAGMENTS      32      // Fits the ACK bitmap
+#define BULK_RX_SLOTS           2
+#define BULK_WINDOW             4
+#define BULK_ACK_EVERY          2       // In-order fragments per ACK
+#define BULK_ACK_TIMEOUT_MS     250
+#define BULK_MAX_RETRIES        6       // Timeouts without progress before giving up
+#define BULK_BUSY_BACKOFF_MS    500
+#define BULK_RX_TIMEOUT_MS      3000    // Idle reassembly slots are reclaimed after this
+// Delivered transfers still acknowledge late duplicates for this long; past the
+// sender's last retry a matching (HID, id) is treated as a new transfer
+#define BULK_DELIVERED_HOLD_MS  ((BULK_MAX_RETRIES + 2) * BULK_ACK_TIMEOUT_MS)
+#define BULK_FRAGMENT_GAP_MS    5
+#define BULK_IO_HOLDOFF_MS      20
+
+/**
+ * @brief Payload kinds, so receivers know what a completed transfer holds
+ */
+enum BulkKind : uint8_t {
+    BULK_KIND_TEST = 0x00,      // Test pattern from the BULK SEND command
+};
+
+enum BulkStatus : uint8_t {
+    BULK_STATUS_OK        = 0x00,   // Partial, see receivedMask
+    BULK_STATUS_COMPLETE  = 0x01,   // All fragments held
+    BULK_STATUS_BUSY      = 0x02,   // No free reassembly slot
+    BULK_STATUS_INVALID   = 0x03,   // Bad fragment header or size
+};
+
+/**
+ * @brief MSG_BULK_DATA payload header, followed by the fragment data
+ */
+typedef struct {
+    uint8_t  transferId;
+    uint8_t  kind;              // BulkKind
+    uint8_t  fragIndex;
+    uint8_t  fragCount;
+    uint16_t totalLen;
+} __attribute__((packed)) BulkFragmentHeader;
+
+// Largest fragment that still fits an ESP-NOW frame
+#define BULK_FRAGMENT_DATA_MAX (TREE_FRAME_MAX_LEN - TREE_MSG_OVERHEAD - sizeof(BulkFragmentHeader))
+
+/**
+ * @brief MSG_BULK_ACK payload
+ */
+typedef struct {
+    uint8_t  transferId;
+    uint8_t  status;            // BulkStatus
+    uint16_t reserved;
+    uint32_t receivedMask;      // Bit n set = fragment n held
+} __attribute__((packed)) BulkAckPayload;
+
+/**
+ * @brief Called on the loop task when a transfer addressed to this node completes
+ */
+typedef void (*BulkReceiveHandler)(uint16_t srcHID, uint8_t kind, const uint8_t* data, uint16_t len);
+
+struct BulkStats {
+    uint32_t txTransfers = 0;       // Completed sends
+    uint32_t txFailed = 0;
+    uint32_t txFragments = 0;       // Including retransmissions
+    uint32_t txRetransmits = 0;
+    uint32_t rxTransfers = 0;       // Completed receives
+    uint32_t rxFragments = 0;
+    uint32_t rxDuplicates = 0;
+    uint32_t rxDropped = 0;         // Refused (busy/invalid) or timed out
+    uint16_t lastTxBytes = 0;
+    uint32_t lastTxMs = 0;          // First fragment to final ACK
+    uint16_t lastRxBytes = 0;
+    uint32_t lastRxMs = 0;          // First to last fragment
+    bool txActive = false;
+};
+
+// ============================================================================
+// BULK TRANSFER API
+// ============================================================================
+
+/**
+ * @brief Start sending a payload to one node
+ * @return false if a send is already in progress or the request is invalid
+ * @note The payload is copied, so the caller's buffer can be reused
+ */
+bool bulkSend(uint16_t destHID, uint8_t kind, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Send len bytes of a known pattern; the receiver checks and logs it
+ */
+bool bulkSendTestPattern(uint16_t destHID, uint16_t len);
+
+bool bulkIsSending();
+
+/**
+ * @brief Drive retransmissions, ACKs and deliveries. Call from loop().
+ */
+void bulkUpdate();
+
+void bulkSetReceiveHandler(BulkReceiveHandler handler);
+
+/**
+ * @brief Receive path hooks, called from the Wi-Fi task; do not allocate
+ */
+void bulkHandleFragment(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen);
+void bulkHandleAck(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen);
+
+/**
+ * @brief Goodput of a finished transfer in bytes per second
+ */
+uint32_t bulkGoodput(uint16_t bytes, uint32_t elapsedMs);
+
+void bulkGetStats(BulkStats& out);
+void bulkResetStats();
+
+#endif // BULK_TRANSFER_H
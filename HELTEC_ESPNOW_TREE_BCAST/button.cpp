@@ -3,7 +3,7 @@
 
 #define MODULE_TITLE       "BTN"
 #define MODULE_DEBUG_LEVEL 1
-#define btnLog(msg,lvl) debugPrint(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+#define btnLog(msg,lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
 
 static uint8_t buttonPin;
 static bool lastState = HIGH; 
@@ -0,0 +1,292 @@
+#include "channel_bridge.h"
+#include "debug.h"
+#include "espnow_wrapper.h"
+#include "tx_queue.h"
+#include <esp_wifi.h>
+
+// Logging macros for the channel bridge module
+#define MODULE_TITLE       "BRIDGE"
+#define MODULE_DEBUG_LEVEL 1
+#define bridgeLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// BRIDGE STATE
+// ============================================================================
+
+#define BRIDGE_SIDE_BOTH 0xFF
+
+struct BridgeFrame {
+    uint8_t  mac[6];
+    uint8_t  len;
+    uint32_t heldMs;
+    uint8_t  data[BRIDGE_MAX_FRAME];
+};
+
+struct BridgeBuffer {
+    BridgeFrame frames[BRIDGE_BUFFER_DEPTH];
+    uint8_t head;
+    uint8_t count;
+};
+
+static BridgeBuffer buffers[BRIDGE_SIDE_COUNT];
+static uint8_t homeChannel = 0;             // Parent side; read back from the radio at init
+static bool active = false;
+static uint8_t side = BRIDGE_SIDE_PARENT;
+static bool switching = false;              // Draining before a switch; every frame is held
+static uint32_t dwellStartMs = 0;
+static uint32_t drainStartMs = 0;
+static uint32_t dwellCountedMs = 0;         // Dwell time is added to the stats up to here
+static BridgeStats stats;
+
+// Frames are held from both tasks and flushed from loop()
+static portMUX_TYPE bridgeMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t childChannel() {
+    uint8_t channel = DATA_MGR.getNodeConfig().childChannel;
+    return channel <= BRIDGE_MAX_CHANNEL ? channel : 0;
+}
+
+static bool bridgeWanted() {
+#if ENABLE_CHANNEL_BRIDGE
+    uint8_t channel = childChannel();
+    return homeChannel != 0 && channel != 0 && channel != homeChannel &&
+           DATA_MGR.isHIDConfigured() && !DATA_MGR.isRoot();
+#else
+    return false;
+#endif
+}
+
+static uint8_t sideChannel(uint8_t s) {
+    return s == BRIDGE_SIDE_CHILD ? childChannel() : homeChannel;
+}
+
+static uint32_t dwellMs(uint8_t s) {
+    return s == BRIDGE_SIDE_CHILD ? BRIDGE_CHILD_DWELL_MS : BRIDGE_PARENT_DWELL_MS;
+}
+
+/**
+ * @brief Which side of the bridge a frame belongs on, from its destination
+ */
+static uint8_t classify(const uint8_t* data, size_t len) {
+    if (len < TREE_MSG_OVERHEAD) {
+        return BRIDGE_SIDE_BOTH;
+    }
+    uint16_t dest = ((const TreeMessageHeader*)data)->dest_hid;
+    if (dest == BROADCAST_HID) {
+        return BRIDGE_SIDE_BOTH;
+    }
+    return DATA_MGR.isMyDescendant(dest) ? BRIDGE_SIDE_CHILD : BRIDGE_SIDE_PARENT;
+}
+
+static void holdLocked(uint8_t s, const uint8_t* peerAddr, const uint8_t* data, size_t len, uint32_t now) {
+    BridgeBuffer& buffer = buffers[s];
+    BridgeSideStats& sideStats = stats.sides[s];
+    if (buffer.count >= BRIDGE_BUFFER_DEPTH) {
+        sideStats.drops++;
+        return;
+    }
+    BridgeFrame& frame = buffer.frames[(buffer.head + buffer.count) % BRIDGE_BUFFER_DEPTH];
+    memcpy(frame.mac, peerAddr, 6);
+    memcpy(frame.data, data, len);
+    frame.len = len;
+    frame.heldMs = now;
+    buffer.count++;
+    sideStats.buffered++;
+    if (buffer.count > sideStats.peakDepth) sideStats.peakDepth = buffer.count;
+}
+
+/**
+ * @brief Send every frame held for one side. Runs in loop() after a switch.
+ */
+static void flush(uint8_t s) {
+    BridgeFrame frame;
+    for (;;) {
+        uint32_t now = millis();
+        portENTER_CRITICAL(&bridgeMux);
+        BridgeBuffer& buffer = buffers[s];
+        if (buffer.count == 0) {
+            portEXIT_CRITICAL(&bridgeMux);
+            return;
+        }
+        frame = buffer.frames[buffer.head];
+        buffer.head = (buffer.head + 1) % BRIDGE_BUFFER_DEPTH;
+        buffer.count--;
+        BridgeSideStats& sideStats = stats.sides[s];
+        uint32_t delayMs = now - frame.heldMs;
+        sideStats.flushed++;
+        sideStats.totalDelayMs += delayMs;
+        if (delayMs > sideStats.maxDelayMs) sideStats.maxDelayMs = delayMs;
+        portEXIT_CRITICAL(&bridgeMux);
+
+        if (!espnowQueueFrame(frame.mac, frame.data, frame.len)) {
+            portENTER_CRITICAL(&bridgeMux);
+            stats.sides[s].drops++;
+            portEXIT_CRITICAL(&bridgeMux);
+        }
+    }
+}
+
+static void switchTo(uint8_t s, uint32_t now) {
+    uint8_t channel = sideChannel(s);
+    uint32_t startUs = micros();
+    esp_err_t result = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    uint32_t elapsedUs = micros() - startUs;
+
+    portENTER_CRITICAL(&bridgeMux);
+    stats.sides[side].dwellMs += now - dwellCountedMs;
+    dwellCountedMs = now;
+    if (result == ESP_OK) {
+        side = s;
+        stats.switches++;
+        if (elapsedUs > stats.maxSwitchUs) stats.maxSwitchUs = elapsedUs;
+    } else {
+        stats.switchErrors++;
+    }
+    dwellStartMs = now;
+    switching = false;
+    portEXIT_CRITICAL(&bridgeMux);
+
+    if (result != ESP_OK) {
+        bridgeLog("Failed to switch to channel " + String(channel) + ": " + String(result), 2);
+    }
+}
+
+// ============================================================================
+// SEND PATH
+// ============================================================================
+
+void bridgeInit() {
+#if ENABLE_CHANNEL_BRIDGE
+    wifi_second_chan_t second;
+    if (esp_wifi_get_channel(&homeChannel, &second) != ESP_OK) {
+        homeChannel = 0;
+    }
+    bridgeLog("Home channel " + String(homeChannel), 3);
+#endif
+}
+
+bool bridgeHoldFrame(const uint8_t* peerAddr, const uint8_t* data, size_t len) {
+#if ENABLE_CHANNEL_BRIDGE
+    if (!active || len == 0 || len > BRIDGE_MAX_FRAME) {
+        return false;
+    }
+    uint8_t target = classify(data, len);
+    uint32_t now = millis();
+    bool held = true;
+
+    portENTER_CRITICAL(&bridgeMux);
+    if (target == BRIDGE_SIDE_BOTH) {
+        // A copy waits for the other channel; this one goes now unless switching
+        holdLocked(side ^ 1, peerAddr, data, len, now);
+        if (switching) {
+            holdLocked(side, peerAddr, data, len, now);
+        } else {
+            held = false;
+        }
+    } else if (target == side && !switching) {
+        held = false;
+    } else {
+        holdLocked(target, peerAddr, data, len, now);
+    }
+    portEXIT_CRITICAL(&bridgeMux);
+    return held;
+#else
+    return false;
+#endif
+}
+
+// ============================================================================
+// LOOP TASK AND QUERIES
+// ============================================================================
+
+void bridgeUpdate() {
+#if ENABLE_CHANNEL_BRIDGE
+    uint32_t now = millis();
+    bool wanted = bridgeWanted();
+
+    if (wanted != active) {
+        if (wanted) {
+            portENTER_CRITICAL(&bridgeMux);
+            active = true;
+            side = BRIDGE_SIDE_PARENT;
+            switching = false;
+            dwellStartMs = now;
+            dwellCountedMs = now;
+            portEXIT_CRITICAL(&bridgeMux);
+            bridgeLog("Bridging channel " + String(homeChannel) + " to " + String(childChannel()), 2);
+        } else {
+            // Back to the home channel for good; whatever was held goes out there
+            if (side != BRIDGE_SIDE_PARENT) {
+                switchTo(BRIDGE_SIDE_PARENT, now);
+            }
+            portENTER_CRITICAL(&bridgeMux);
+            active = false;
+            switching = false;
+            portEXIT_CRITICAL(&bridgeMux);
+            flush(BRIDGE_SIDE_PARENT);
+            flush(BRIDGE_SIDE_CHILD);
+            bridgeLog("Bridge off, staying on channel " + String(homeChannel), 2);
+        }
+        return;
+    }
+    if (!active) {
+        return;
+    }
+
+    if (!switching) {
+        if (now - dwellStartMs < dwellMs(side)) {
+            return;
+        }
+        portENTER_CRITICAL(&bridgeMux);
+        switching = true;
+        portEXIT_CRITICAL(&bridgeMux);
+        drainStartMs = now;
+    }
+
+    // Let frames already queued for this channel go out first
+    if (!txQueueIdle()) {
+        if (now - drainStartMs < BRIDGE_DRAIN_TIMEOUT_MS) {
+            return;
+        }
+        portENTER_CRITICAL(&bridgeMux);
+        stats.drainTimeouts++;
+        portEXIT_CRITICAL(&bridgeMux);
+    }
+
+    uint8_t next = side ^ 1;
+    switchTo(next, now);
+    if (side == next) {
+        flush(next);
+    }
+#endif
+}
+
+uint8_t bridgeParentListenPct() {
+    if (!active) {
+        return 100;
+    }
+    return BRIDGE_PARENT_DWELL_MS * 100 / (BRIDGE_PARENT_DWELL_MS + BRIDGE_CHILD_DWELL_MS);
+}
+
+void bridgeGetStats(BridgeStats& out) {
+    portENTER_CRITICAL(&bridgeMux);
+    out = stats;
+    out.active = active;
+    out.side = side;
+    for (int i = 0; i < BRIDGE_SIDE_COUNT; i++) {
+        out.sides[i].depth = buffers[i].count;
+    }
+    if (active) {
+        out.sides[side].dwellMs += millis() - dwellCountedMs;
+    }
+    portEXIT_CRITICAL(&bridgeMux);
+    out.sides[BRIDGE_SIDE_PARENT].channel = homeChannel;
+    out.sides[BRIDGE_SIDE_CHILD].channel = childChannel();
+}
+
+void bridgeResetStats() {
+    portENTER_CRITICAL(&bridgeMux);
+    stats = BridgeStats();
+    dwellCountedMs = millis();
+    portEXIT_CRITICAL(&bridgeMux);
+}
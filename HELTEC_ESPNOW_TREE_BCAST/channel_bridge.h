@@ -0,0 +1,112 @@
+#ifndef CHANNEL_BRIDGE_H
+#define CHANNEL_BRIDGE_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+
+// ============================================================================
+// CHANNEL BRIDGE CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Subtrees on their own Wi-Fi channel, joined by a bridge node.
+ *
+ * The whole tree used to share one channel, so every frame anywhere used
+ * airtime everywhere. A node with NodeConfigRecord::childChannel set (and
+ * different from its own channel) becomes a bridge. Its children are
+ * configured with channel = the bridge's childChannel. The subtree below
+ * it then runs on that channel, in parallel with the rest of the tree.
+ *
+ * The bridge's radio alternates between the two channels:
+ * - BRIDGE_PARENT_DWELL_MS on its own (parent side) channel, then
+ *   BRIDGE_CHILD_DWELL_MS on the child channel.
+ * - Outgoing frames are sorted by destination. Frames for the subtree go to
+ *   the child side; frames to BROADCAST_HID go to both sides; everything
+ *   else goes to the parent side.
+ * - A frame for the side the radio is not on is held in that side's buffer
+ *   (BRIDGE_BUFFER_DEPTH frames). The buffer is sent right after the next
+ *   switch to that side.
+ * - Before switching, the bridge stops handing frames to the transmit queue
+ *   (tx_queue.h) and waits up to BRIDGE_DRAIN_TIMEOUT_MS for it to empty,
+ *   so no frame goes out on the wrong channel.
+ *
+ * Frames sent to the bridge while it is on the other channel are lost.
+ * Keep dwell times short and put the split where little traffic crosses it.
+ * Failover (parent_failover.h) scales its parent silence limit by the
+ * parent side's share of the time.
+ *
+ * The delay each buffered frame spent waiting for its channel is counted
+ * per side (BRIDGE command), to help decide where to split the tree.
+ *
+ * The root ignores childChannel; set its own channel instead.
+ * Set to 0 to stay on one channel regardless of the config.
+ */
+#define ENABLE_CHANNEL_BRIDGE 1
+
+#define BRIDGE_PARENT_DWELL_MS      50
+#define BRIDGE_CHILD_DWELL_MS       50
+#define BRIDGE_DRAIN_TIMEOUT_MS     10      // Frames still in the driver after this are sent on the new channel
+#define BRIDGE_BUFFER_DEPTH         8       // Frames held per side
+#define BRIDGE_MAX_FRAME            250     // ESP_NOW_MAX_DATA_LEN
+#define BRIDGE_MAX_CHANNEL          13
+
+enum BridgeSide : uint8_t {
+    BRIDGE_SIDE_PARENT = 0,
+    BRIDGE_SIDE_CHILD  = 1,
+    BRIDGE_SIDE_COUNT
+};
+
+struct BridgeSideStats {
+    uint8_t  channel = 0;
+    uint8_t  depth = 0;
+    uint8_t  peakDepth = 0;
+    uint32_t buffered = 0;          // Frames held for this side
+    uint32_t flushed = 0;           // Held frames sent after a switch
+    uint32_t drops = 0;             // Buffer full, or the transmit queue refused the flush
+    uint32_t maxDelayMs = 0;        // Held until the switch to this side
+    uint32_t totalDelayMs = 0;      // Divide by flushed for the average
+    uint32_t dwellMs = 0;           // Time the radio spent on this side
+};
+
+struct BridgeStats {
+    bool     active = false;
+    uint8_t  side = BRIDGE_SIDE_PARENT;     // Side the radio is on now
+    uint32_t switches = 0;
+    uint32_t switchErrors = 0;              // esp_wifi_set_channel failures
+    uint32_t drainTimeouts = 0;             // Switched with frames still in the transmit queue
+    uint32_t maxSwitchUs = 0;               // Longest esp_wifi_set_channel call
+    BridgeSideStats sides[BRIDGE_SIDE_COUNT];
+};
+
+// ============================================================================
+// CHANNEL BRIDGE API
+// ============================================================================
+
+/**
+ * @brief Note the radio's home channel. Call once after espnowInit().
+ */
+void bridgeInit();
+
+/**
+ * @brief Send path hook; holds a frame whose side the radio is not on.
+ *        Safe from the loop task and the Wi-Fi task.
+ * @return true if the frame was taken (held or dropped) and must not be sent now
+ */
+bool bridgeHoldFrame(const uint8_t* peerAddr, const uint8_t* data, size_t len);
+
+/**
+ * @brief Run the dwell schedule, switch channels and send held frames.
+ *        Call from loop().
+ */
+void bridgeUpdate();
+
+/**
+ * @brief Percentage of time the radio listens on the parent's channel; 100
+ *        when this node is not bridging
+ */
+uint8_t bridgeParentListenPct();
+
+void bridgeGetStats(BridgeStats& out);
+void bridgeResetStats();
+
+#endif // CHANNEL_BRIDGE_H
@@ -0,0 +1,169 @@
+#include "child_table.h"
+
+// ============================================================================
+// TABLE STATE
+// ============================================================================
+
+static ChildInfo children[CHILD_TABLE_SIZE];
+static TopologyNode topology[TOPOLOGY_MAX_NODES];
+static uint8_t topologyCount = 0;
+
+static uint32_t forwardedInWindow = 0;
+static uint32_t windowStartMs = 0;
+static uint8_t forwardLoad = 0;          // Frames per second over the last full window
+
+// Frames arrive on the Wi-Fi task, queries come from loop()
+static portMUX_TYPE childMux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool isLive(const ChildInfo& child, uint32_t now) {
+    return child.hid != 0 && now - child.lastHeardMs <= CHILD_TIMEOUT_MS;
+}
+
+// ============================================================================
+// RECEIVE PATH (Wi-Fi task)
+// ============================================================================
+
+void childTableNoteFrame(const TreeMessageHeader* header, int8_t rssi) {
+#if ENABLE_CHILD_TABLE
+    uint16_t hid = header->broadcaster_hid;
+    uint16_t myHID = DATA_MGR.getMyHID();
+    if (hid == myHID || !DATA_MGR.isValidChild(hid)) {
+        return;
+    }
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&childMux);
+    int slot = -1;
+    int freeSlot = -1;
+    int oldest = 0;
+    for (int i = 0; i < CHILD_TABLE_SIZE; i++) {
+        if (children[i].hid == hid) {
+            slot = i;
+            break;
+        }
+        if (children[i].hid == 0 && freeSlot < 0) freeSlot = i;
+        if ((int32_t)(children[i].lastHeardMs - children[oldest].lastHeardMs) < 0) oldest = i;
+    }
+    if (slot < 0) {
+        slot = (freeSlot >= 0) ? freeSlot : oldest;
+        memset(&children[slot], 0, sizeof(ChildInfo));
+        children[slot].hid = hid;
+    }
+    ChildInfo& child = children[slot];
+    child.fostered = (treeAddrParent(hid) != myHID);
+    child.rssi = rssi;
+    child.lastHeardMs = now;
+    child.framesHeard++;
+    portEXIT_CRITICAL(&childMux);
+#endif
+}
+
+void childTableNoteForward(uint16_t childHID) {
+#if ENABLE_CHILD_TABLE
+    portENTER_CRITICAL(&childMux);
+    forwardedInWindow++;
+    for (ChildInfo& child : children) {
+        if (child.hid == childHID) {
+            child.framesForwarded++;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&childMux);
+#endif
+}
+
+void childTableNoteTopology(uint16_t srcHID, const TopologyTrailer& trailer) {
+#if ENABLE_CHILD_TABLE
+    uint32_t now = millis();
+    portENTER_CRITICAL(&childMux);
+    int slot = -1;
+    int oldest = 0;
+    for (int i = 0; i < topologyCount; i++) {
+        if (topology[i].hid == srcHID) {
+            slot = i;
+            break;
+        }
+        if ((int32_t)(topology[i].lastReportMs - topology[oldest].lastReportMs) < 0) oldest = i;
+    }
+    if (slot < 0) {
+        slot = (topologyCount < TOPOLOGY_MAX_NODES) ? topologyCount++ : oldest;
+        topology[slot].hid = srcHID;
+    }
+    topology[slot].lastReportMs = now;
+    topology[slot].trailer = trailer;
+    portEXIT_CRITICAL(&childMux);
+#endif
+}
+
+// ============================================================================
+// LOOP TASK AND QUERIES
+// ============================================================================
+
+void childTableUpdate() {
+#if ENABLE_CHILD_TABLE
+    uint32_t now = millis();
+    if (now - windowStartMs < CHILD_LOAD_WINDOW_MS) {
+        return;
+    }
+
+    portENTER_CRITICAL(&childMux);
+    uint32_t perSecond = forwardedInWindow * 1000 / (now - windowStartMs);
+    forwardedInWindow = 0;
+    portEXIT_CRITICAL(&childMux);
+
+    forwardLoad = perSecond > 255 ? 255 : perSecond;
+    windowStartMs = now;
+#endif
+}
+
+uint8_t childTableActiveCount() {
+    uint32_t now = millis();
+    uint8_t count = 0;
+    portENTER_CRITICAL(&childMux);
+    for (const ChildInfo& child : children) {
+        if (isLive(child, now)) count++;
+    }
+    portEXIT_CRITICAL(&childMux);
+    return count;
+}
+
+uint8_t childTableGetChildren(ChildInfo* out, uint8_t maxCount) {
+    uint8_t count = 0;
+    portENTER_CRITICAL(&childMux);
+    for (const ChildInfo& child : children) {
+        if (child.hid != 0 && count < maxCount) {
+            out[count++] = child;
+        }
+    }
+    portEXIT_CRITICAL(&childMux);
+    return count;
+}
+
+void childTableFillTrailer(TopologyTrailer& out) {
+    uint32_t now = millis();
+    uint16_t myHID = DATA_MGR.getMyHID();
+
+    out.childMask = 0;
+    out.fosteredCount = 0;
+    out.forwardLoad = forwardLoad;
+    portENTER_CRITICAL(&childMux);
+    for (const ChildInfo& child : children) {
+        if (!isLive(child, now)) continue;
+        if (treeAddrParent(child.hid) == myHID) {
+            out.childMask |= 1U << treeAddrChildIndex(child.hid);
+        } else {
+            out.fosteredCount++;
+        }
+    }
+    portEXIT_CRITICAL(&childMux);
+}
+
+uint8_t childTableGetTopology(TopologyNode* out, uint8_t maxCount) {
+    uint8_t count = 0;
+    portENTER_CRITICAL(&childMux);
+    for (uint8_t i = 0; i < topologyCount && count < maxCount; i++) {
+        out[count++] = topology[i];
+    }
+    portEXIT_CRITICAL(&childMux);
+    return count;
+}
@@ -0,0 +1,108 @@
+#ifndef CHILD_TABLE_H
+#define CHILD_TABLE_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+
+// ============================================================================
+// CHILD TABLE CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Direct children heard on the air, and the root's topology map.
+ *
+ * Every node keeps a fixed table of the children it has heard as
+ * broadcaster_hid. Fostered nodes (parent_failover.h) count as children.
+ * For each child the table holds last heard time, RSSI, frames heard, and
+ * frames forwarded upstream for it. A child not heard for
+ * CHILD_TIMEOUT_MS no longer counts, but its counters stay until the slot
+ * is needed.
+ *
+ * Each data report carries a TopologyTrailer after its DeviceSpecificData.
+ * The trailer summarizes the sender's live children and how many frames per
+ * second it forwarded over the last CHILD_LOAD_WINDOW_MS. The root keeps the
+ * latest trailer per reporting node. From these it assembles the tree
+ * (TOPOLOGY command), which shows the fan-out and forwarding load of every
+ * forwarder.
+ *
+ * The root accepts reports with or without the trailer. Roots older than
+ * this drop reports that carry it, so update the root first.
+ */
+#define ENABLE_CHILD_TABLE 1
+
+#define CHILD_TABLE_SIZE        (TREE_ADDR_MAX_CHILDREN + 4)   // Arithmetic children plus fostered nodes
+#define CHILD_TIMEOUT_MS        30000   // Children not heard this long are not counted
+#define CHILD_LOAD_WINDOW_MS    10000
+#if NODE_ROLE_HAS_ROOT
+#define TOPOLOGY_MAX_NODES      MAX_AGGREGATED_DEVICES
+#else
+#define TOPOLOGY_MAX_NODES      1       // Only the root assembles the topology (NODE_ROLE)
+#endif
+
+/**
+ * @brief Appended to MSG_DEVICE_DATA_REPORT after DeviceSpecificData
+ */
+typedef struct {
+    uint16_t childMask;         // Bit n set = child n (treeAddrChild) is alive
+    uint8_t  fosteredCount;     // Live fostered nodes (not in childMask)
+    uint8_t  forwardLoad;       // Frames forwarded per second, saturating at 255
+} __attribute__((packed)) TopologyTrailer;
+
+static_assert(TREE_ADDR_MAX_CHILDREN <= 16, "TopologyTrailer::childMask holds 16 children");
+
+struct ChildInfo {
+    uint16_t hid;
+    bool     fostered;
+    int8_t   rssi;              // Last frame
+    uint32_t lastHeardMs;
+    uint32_t framesHeard;
+    uint32_t framesForwarded;   // Upstream frames relayed for this child
+};
+
+struct TopologyNode {
+    uint16_t hid;
+    uint32_t lastReportMs;
+    TopologyTrailer trailer;
+};
+
+// ============================================================================
+// CHILD TABLE API
+// ============================================================================
+
+/**
+ * @brief Receive path hooks, called from the Wi-Fi task for every valid frame
+ */
+void childTableNoteFrame(const TreeMessageHeader* header, int8_t rssi);
+void childTableNoteForward(uint16_t childHID);
+
+/**
+ * @brief Roll the forwarding-load window. Call from loop().
+ */
+void childTableUpdate();
+
+/**
+ * @brief Children heard within CHILD_TIMEOUT_MS
+ */
+uint8_t childTableActiveCount();
+
+/**
+ * @brief Copy the table; returns the number of entries written
+ */
+uint8_t childTableGetChildren(ChildInfo* out, uint8_t maxCount);
+
+/**
+ * @brief This node's summary, as appended to its data reports
+ */
+void childTableFillTrailer(TopologyTrailer& out);
+
+/**
+ * @brief Root: store the trailer of a data report. Called from the Wi-Fi task.
+ */
+void childTableNoteTopology(uint16_t srcHID, const TopologyTrailer& trailer);
+
+/**
+ * @brief Root: copy the topology map; returns the number of nodes written
+ */
+uint8_t childTableGetTopology(TopologyNode* out, uint8_t maxCount);
+
+#endif // CHILD_TABLE_H
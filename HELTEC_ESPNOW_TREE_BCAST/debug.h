@@ -26,6 +26,29 @@ extern bool globalDebugEnabled;
  *   // => "[HID:1 B:0][SYNC][INFO][12345ms]: Sync started"
  *
  */
+/**
+ * @brief True when a message at messageLevel would actually be printed.
+ *
+ * Module log macros test this *before* evaluating their message argument, so
+ * filtered-out log lines never build a String (and never touch the heap).
+ * This matters on the ESP-NOW receive path, which runs for every frame.
+ */
+#define DEBUG_LOG_ENABLED(messageLevel, moduleDebugLevel) \
+    (globalDebugEnabled && (messageLevel) <= (moduleDebugLevel))
+
+/**
+ * @brief Lazy wrapper around debugPrint() used by the per-module log macros.
+ *
+ * Example:
+ *   #define dataLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+ */
+#define DEBUG_LOG(msg, moduleTitle, messageLevel, moduleDebugLevel)                 \
+    do {                                                                            \
+        if (DEBUG_LOG_ENABLED(messageLevel, moduleDebugLevel)) {                    \
+            debugPrint(msg, moduleTitle, messageLevel, moduleDebugLevel);           \
+        }                                                                           \
+    } while (0)
+
 inline String getLogPrefix() {
     String hidStr = DATA_MGR.isHIDConfigured() ? String(DATA_MGR.getMyHID()) : "---";
     String bitStr = DATA_MGR.isBitIndexConfigured() ? String(DATA_MGR.getMyBitIndex()) : "-";
@@ -2,11 +2,21 @@
 #include "debug.h"
 #include "DataManager.h"
 #include "MenuSystem.h"
+#include "heap_guard.h"
+#include "boot_profiler.h"
+#include "frame_capture.h"
+#include "child_table.h"
+#include "tx_queue.h"
+#include "uplink.h"
+#include "rate_control.h"
+#include "channel_bridge.h"
+#include "report_aggregation.h"
+#include "frame_auth.h"
 
 // Logging macros for the ESP-NOW module
 #define MODULE_TITLE       "ESP-NOW"
 #define MODULE_DEBUG_LEVEL 1
-#define espnowLog(msg,lvl) debugPrint(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+#define espnowLog(msg,lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
 
 // ============================================================================
 // HELPER FUNCTIONS
@@ -29,6 +39,13 @@ uint8_t broadcastMAC[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 // Long Range mode state
 static bool longRangeModeActive = false;
 
+// TX mute (soak/replay tests)
+static volatile bool txMuted = false;
+static volatile uint32_t mutedTxCount = 0;
+
+// Last transmission other than bulk/OTA traffic, so those can yield to it
+static volatile uint32_t lastForegroundTxMs = 0;
+
 // ============================================================================
 // ESP32 LONG RANGE MODE FUNCTIONS
 // ============================================================================
@@ -36,15 +53,21 @@ static bool longRangeModeActive = false;
 bool enableLongRangeMode() {
     espnowLog("Enabling ESP32 Long Range mode...", 3);
     
-    // Set WiFi to Long Range mode
-    esp_err_t result = esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_LR);
+    // Set WiFi to Long Range mode. With rate adaptation, 11b/g/n stay enabled
+    // so unicast peers can be moved to faster rates (rate_control.h).
+#if ENABLE_RATE_ADAPTATION
+    uint8_t protocol = WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N | WIFI_PROTOCOL_LR;
+#else
+    uint8_t protocol = WIFI_PROTOCOL_LR;
+#endif
+    esp_err_t result = esp_wifi_set_protocol(WIFI_IF_STA, protocol);
     if (result != ESP_OK) {
         espnowLog("Failed to enable LR mode on STA interface: " + String(result), 1);
         return false;
     }
     
     // Also set AP interface if available
-    esp_wifi_set_protocol(WIFI_IF_AP, WIFI_PROTOCOL_LR);
+    esp_wifi_set_protocol(WIFI_IF_AP, protocol);
     
     // Configure Long Range specific parameters
     wifi_country_t country = {
@@ -57,6 +80,7 @@ bool enableLongRangeMode() {
     esp_wifi_set_country(&country);
     
     longRangeModeActive = true;
+    rateOnModeChange();
     espnowLog("ESP32 Long Range mode enabled successfully", 3);
     
     return true;
@@ -75,6 +99,7 @@ bool disableLongRangeMode() {
     esp_wifi_set_protocol(WIFI_IF_AP, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N);
     
     longRangeModeActive = false;
+    rateOnModeChange();
     espnowLog("ESP32 Long Range mode disabled", 3);
     
     return true;
@@ -113,19 +138,46 @@ void onDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
     if (status == ESP_NOW_SEND_SUCCESS) {
         DATA_MGR.incrementMessagesSent();
     }
-    // Note: We are not explicitly tracking lost messages anymore,
-    // as the send status only indicates if the message was queued, not if it was ACKed.
-    // A more robust system would use ACKs to confirm delivery.
+    // For unicast uplink frames, status is the parent's 802.11 ACK
+    uplinkOnSent(mac_addr, status == ESP_NOW_SEND_SUCCESS);
+    rateNoteResult(mac_addr, status == ESP_NOW_SEND_SUCCESS);
+    // The driver has room again; release the next queued frame
+    txQueueOnSent();
+    // For unicast the status is the 802.11 MAC-layer ACK from the peer, which
+    // uplinkOnSent uses for retry and fallback. Broadcast is never ACKed, so
+    // there it only means the frame went out on air.
 }
 
-void onDataReceived(const esp_now_recv_info_t* info, const uint8_t* incomingData, int len) {
-    if (!info || !incomingData || len <= 0) return;
-    
-    int8_t rssi = info->rx_ctrl ? info->rx_ctrl->rssi : 0;
+/**
+ * @brief Receive path shared by the radio callback and frame injection.
+ *
+ * Runs once per frame in the Wi-Fi task, so it must not allocate: logs are
+ * lazy (only built when enabled) and status text uses fixed buffers.
+ *
+ * @return CaptureVerdict describing the routing decision
+ */
+static uint8_t processReceivedFrame(const uint8_t* srcMAC, const uint8_t* incomingData, int len, int8_t rssi,
+                                    bool injected) {
+    ALLOC_GUARD_SCOPE("espnow_rx");
+    
+#if ENABLE_FRAME_AUTH
+    // Injected frames were captured after opening, so only radio frames carry a trailer
+    uint8_t opened[TXQ_MAX_FRAME];
+    if (!injected) {
+        size_t openedLen = frameAuthOpen(srcMAC, incomingData, len, opened);
+        if (openedLen == 0) {
+            captureRecord(srcMAC, incomingData, len, rssi, CAPTURE_VERDICT_REJECTED);
+            return CAPTURE_VERDICT_REJECTED;
+        }
+        incomingData = opened;
+        len = openedLen;
+    }
+#endif
     
     // The entire system now uses a single, modern message format.
     // We pass all incoming data to the tree message handler.
-    bool handled = DATA_MGR.handleIncomingTreeMessage(incomingData, len, info->src_addr, rssi);
+    bool handled = DATA_MGR.handleIncomingTreeMessage(incomingData, len, srcMAC, rssi);
+    uint8_t verdict = handled ? CAPTURE_VERDICT_PROCESSED : CAPTURE_VERDICT_REJECTED;
     
     if (handled && len >= TREE_MSG_OVERHEAD) {
         const TreeMessageHeader* header = (const TreeMessageHeader*)incomingData;
@@ -139,8 +191,12 @@ void onDataReceived(const esp_now_recv_info_t* info, const uint8_t* incomingData
                      " From=" + DATA_MGR.formatHID(header->src_hid) + 
                      " To=" + DATA_MGR.formatHID(header->dest_hid) + 
                      " Via=" + DATA_MGR.formatHID(DATA_MGR.getMyHID()), 2);
-            // Forwarding doesn't need console messages for button events
-            forwardTreeMessage(incomingData, len, true);
+            // Reports may wait to go up with others (report_aggregation.h);
+            // soak reports must not still be held when TX is unmuted
+            if (heapSoakInjecting() || !aggAbsorbFrame(incomingData, len)) {
+                forwardTreeMessage(incomingData, len, true);
+            }
+            verdict = CAPTURE_VERDICT_FORWARD_UP;
         } else if (shouldForwardDown) {
             espnowLog("MULTI-HOP: Forwarding message DOWNSTREAM - Type=" + String(header->msg_type, HEX) + 
                      " From=" + DATA_MGR.formatHID(header->src_hid) + 
@@ -148,13 +204,44 @@ void onDataReceived(const esp_now_recv_info_t* info, const uint8_t* incomingData
                      " Via=" + DATA_MGR.formatHID(DATA_MGR.getMyHID()), 2);
             // Forwarding doesn't need console messages for button events
             forwardTreeMessage(incomingData, len, false);
+            verdict = CAPTURE_VERDICT_FORWARD_DOWN;
         }
     }
     
     // Update status with RSSI info for display
     if (rssi != 0) {
-    DATA_MGR.updateStatus("RX: " + String(rssi) + "dBm");
+        DATA_MGR.updateStatusf("RX: %ddBm", rssi);
     }
+    if (!injected) {
+        rateNoteRx(srcMAC, rssi);
+    }
+    
+    captureRecord(srcMAC, incomingData, len, rssi, verdict | (injected ? CAPTURE_FLAG_INJECTED : 0));
+    return verdict;
+}
+
+void onDataReceived(const esp_now_recv_info_t* info, const uint8_t* incomingData, int len) {
+    if (!info || !incomingData || len <= 0) return;
+    
+    int8_t rssi = info->rx_ctrl ? info->rx_ctrl->rssi : 0;
+    processReceivedFrame(info->src_addr, incomingData, len, rssi, false);
+}
+
+uint8_t espnowInjectFrame(const uint8_t* srcMAC, const uint8_t* data, int len, int8_t rssi) {
+    if (!srcMAC || !data || len <= 0) return CAPTURE_VERDICT_REJECTED;
+    return processReceivedFrame(srcMAC, data, len, rssi, true);
+}
+
+void espnowSetTxMuted(bool muted) {
+    txMuted = muted;
+}
+
+uint32_t espnowGetMutedTxCount() {
+    return mutedTxCount;
+}
+
+uint32_t espnowGetLastForegroundTxMs() {
+    return lastForegroundTxMs;
 }
 
 bool espnowInit() {
@@ -170,9 +257,13 @@ bool espnowInit() {
         return false;
     }
     
+    const NodeConfigRecord& config = DATA_MGR.getNodeConfig();
+    
     // Enable Long Range mode if configured
     #if ENABLE_LONG_RANGE_MODE
-    if (!enableLongRangeMode()) {
+    if (!(config.radioFlags & NODE_CFG_RADIO_LONG_RANGE)) {
+        espnowLog("Long Range mode off in stored config - using standard range", 3);
+    } else if (!enableLongRangeMode()) {
         espnowLog("Warning: Failed to enable Long Range mode", 2);
     } else {
         espnowLog("Long Range mode enabled - extended range available", 3);
@@ -181,6 +272,20 @@ bool espnowInit() {
     espnowLog("Long Range mode disabled - using standard range", 3);
     #endif
     
+    // Optional radio overrides from the stored config (0 = keep default)
+    if (config.channel != 0) {
+        result = esp_wifi_set_channel(config.channel, WIFI_SECOND_CHAN_NONE);
+        if (result != ESP_OK) {
+            espnowLog("Failed to set channel " + String(config.channel) + ": " + String(result), 2);
+        }
+    }
+    if (config.txPowerQuarterDbm != 0) {
+        result = esp_wifi_set_max_tx_power(config.txPowerQuarterDbm);
+        if (result != ESP_OK) {
+            espnowLog("Failed to set TX power: " + String(result), 2);
+        }
+    }
+    
     // Initialize ESP-NOW
     result = esp_now_init();
     if (result != ESP_OK) {
@@ -202,6 +307,8 @@ bool espnowInit() {
     if (result != ESP_OK) {
         espnowLog("Failed to add broadcast peer: " + String(result), 2);
     }
+    rateInit();
+    bridgeInit();
     
     String mode = isLongRangeModeEnabled() ? "Long Range" : "Standard";
     espnowLog("ESP-NOW initialized successfully in " + mode + " mode", 3);
@@ -211,18 +318,55 @@ bool espnowInit() {
 }
 
 void espnowSendData(const uint8_t* peerAddr, const uint8_t* data, size_t len){
-    esp_now_peer_info_t peerInfo = {};
-    memcpy(peerInfo.peer_addr, peerAddr, 6);
-    peerInfo.channel = 0;
-    peerInfo.encrypt = false;
-    esp_now_add_peer(&peerInfo);
+    if (txMuted) {
+        mutedTxCount++;
+        return;
+    }
     
-    esp_err_t result = esp_now_send(peerAddr, data, len);
-    if(result == ESP_OK){
-        espnowLog("Data queued for transmission", 3);
-    } else {
-        espnowLog("Failed to queue data: " + String(result), 2);
+    // Only register unknown peers; adding a peer allocates inside ESP-NOW
+    if (!esp_now_is_peer_exist(peerAddr)) {
+        esp_now_peer_info_t peerInfo = {};
+        memcpy(peerInfo.peer_addr, peerAddr, 6);
+        peerInfo.channel = 0;
+        peerInfo.encrypt = false;
+        if (esp_now_add_peer(&peerInfo) == ESP_OK) {
+            rateOnPeerAdded(peerAddr);
+        }
+    }
+    
+    if (len >= TREE_MSG_OVERHEAD) {
+        uint8_t msgType = ((const TreeMessageHeader*)data)->msg_type;
+        if (msgType != MSG_BULK_DATA && msgType != MSG_BULK_ACK && msgType != MSG_OTA_ANNOUNCE &&
+            msgType != MSG_OTA_BLOCK && msgType != MSG_OTA_STATUS) {
+            lastForegroundTxMs = millis();
+        }
+    }
+    
+    // A bridge holds frames for the channel it is not on (channel_bridge.h)
+    if (bridgeHoldFrame(peerAddr, data, len)) {
+        return;
     }
+    espnowQueueFrame(peerAddr, data, len);
+}
+
+bool espnowQueueFrame(const uint8_t* peerAddr, const uint8_t* data, size_t len) {
+#if ENABLE_FRAME_AUTH
+    // Sealed here, after the bridge hold, so the counter follows queueing order
+    uint8_t sealed[TXQ_MAX_FRAME];
+    size_t sealedLen = frameAuthSeal(data, len, sealed, sizeof(sealed));
+    if (sealedLen == 0) {
+        espnowLog("Frame could not be sealed, dropped", 2);
+        return false;
+    }
+    data = sealed;
+    len = sealedLen;
+#endif
+    if (!txQueueSubmit(peerAddr, data, len)) {
+        return false;
+    }
+    espnowLog("Data queued for transmission", 3);
+    rateNoteSend(peerAddr, len);
+    return true;
 }
 
 // ============================================================================
@@ -243,18 +387,26 @@ bool sendDataReportToParent() {
     // Data reports should always be addressed to the root (HID 1)
     // Intermediate nodes will automatically forward them based on routing logic
     uint16_t rootHID = ROOT_HID;
-    const DeviceSpecificData& myData = DATA_MGR.getMyDeviceData();
+    // Device data followed by this node's child summary for the root's topology map
+    uint8_t payload[sizeof(DeviceSpecificData) + sizeof(TopologyTrailer)];
+    TopologyTrailer trailer;
+    childTableFillTrailer(trailer);
+    memcpy(payload, &DATA_MGR.getMyDeviceData(), sizeof(DeviceSpecificData));
+    memcpy(payload + sizeof(DeviceSpecificData), &trailer, sizeof(trailer));
     
-    uint8_t buffer[TREE_MSG_OVERHEAD + sizeof(DeviceSpecificData)];
+    uint8_t buffer[TREE_MSG_OVERHEAD + sizeof(payload)];
     
     if (!DATA_MGR.createTreeMessage(buffer, sizeof(buffer), rootHID, 
                                    MSG_DEVICE_DATA_REPORT, 
-                                   (const uint8_t*)&myData, sizeof(DeviceSpecificData))) {
+                                   payload, sizeof(payload))) {
         espnowLog("Failed to create data report message", 2);
         return false;
     }
     
-    espnowSendData(broadcastMAC, buffer, sizeof(buffer));
+    uint8_t nextHop[6];
+    uplinkSelectMAC(nextHop);
+    espnowSendData(nextHop, buffer, sizeof(buffer));
+    bootMarkFirstReport();
     return true;
 }
 
@@ -299,7 +451,7 @@ bool sendAcknowledgement(uint16_t targetHID, uint8_t ackedSeqNum, bool isNack, u
 }
 
 bool forwardTreeMessage(const uint8_t* originalData, int len, bool isUpstream) {
-    if (len > 250) {
+    if (len > (int)TREE_FRAME_MAX_LEN) {
         espnowLog("Cannot forward message, too large", 1);
         return false;
     }
@@ -315,7 +467,14 @@ bool forwardTreeMessage(const uint8_t* originalData, int len, bool isUpstream) {
     uint8_t newCRC = DATA_MGR.calculateCRC8(buffer + 1, TREE_MSG_HEADER_SIZE - 1 + payloadLen);
     buffer[len - 2] = newCRC;
     
-    espnowSendData(broadcastMAC, buffer, len);
+    // Upstream goes unicast to the parent once its MAC is known (uplink.h)
+    uint8_t nextHop[6];
+    if (isUpstream) {
+        uplinkSelectMAC(nextHop);
+    } else {
+        memcpy(nextHop, broadcastMAC, 6);
+    }
+    espnowSendData(nextHop, buffer, len);
         DATA_MGR.incrementMessagesForwarded();
     
         return true;
@@ -340,11 +499,7 @@ void espnowSendBroadcastTest(){
     msg.timestamp = millis();
     strncpy(msg.testData, "TEST_DATA", sizeof(msg.testData));
     
-    esp_err_t result = esp_now_send(broadcastMAC, (uint8_t*)&msg, sizeof(msg));
-    if(result == ESP_OK){
-        espnowLog("Legacy broadcast test sent", 3);
-        DATA_MGR.incrementMessagesSent();
-    } else {
-        espnowLog("Failed to send legacy broadcast test: " + String(result), 2);
-    }
+    // Through the TX queue so pacing, in-flight accounting and sealing apply;
+    // onDataSent counts it once the driver reports it sent
+    espnowSendData(broadcastMAC, (const uint8_t*)&msg, sizeof(msg));
 }
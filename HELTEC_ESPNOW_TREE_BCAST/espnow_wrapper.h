@@ -72,6 +72,34 @@ bool sendAcknowledgement(uint16_t targetHID, uint8_t ackedSeqNum, bool isNack =
  */
 bool forwardTreeMessage(const uint8_t* originalData, int len, bool isUpstream);
 
+/**
+ * @brief Run a frame through the receive path as if it came off the radio
+ * @param srcMAC Sender MAC address (6 bytes)
+ * @param data Frame data
+ * @param len Frame length
+ * @param rssi Signal strength to report (0 = unknown)
+ * @return CaptureVerdict (frame_capture.h) describing the routing decision
+ * @note Used by the heap soak test and capture replay; runs in the caller's task
+ */
+uint8_t espnowInjectFrame(const uint8_t* srcMAC, const uint8_t* data, int len, int8_t rssi);
+
+/**
+ * @brief millis() when the last frame other than bulk transfer or OTA traffic was sent
+ * @note Bulk transfers and OTA hold off after this so they don't delay I/O traffic
+ */
+uint32_t espnowGetLastForegroundTxMs();
+
+/**
+ * @brief Drop outgoing frames instead of transmitting them (soak/replay tests)
+ * @param muted true to suppress esp_now_send
+ */
+void espnowSetTxMuted(bool muted);
+
+/**
+ * @brief Number of frames dropped while TX was muted
+ */
+uint32_t espnowGetMutedTxCount();
+
 // ============================================================================
 // LEGACY ESP-NOW FUNCTIONS
 // ============================================================================
@@ -116,9 +144,17 @@ String getCurrentPhyRate();
 
 /**
  * @brief Send arbitrary data to a specified peer address.
+ * @note Goes through the prioritized TX queue (tx_queue.h); a full queue drops the frame
  */
 void espnowSendData(const uint8_t* peerAddr, const uint8_t* data, size_t len);
 
+/**
+ * @brief Queue a frame that already went through espnowSendData()'s checks.
+ *        Used by the channel bridge to send frames it held.
+ * @return false if the TX queue dropped it
+ */
+bool espnowQueueFrame(const uint8_t* peerAddr, const uint8_t* data, size_t len);
+
 /**
  * @brief Test function to send a broadcast message with test data.
  */
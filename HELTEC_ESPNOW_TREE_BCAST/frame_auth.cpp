@@ -0,0 +1,339 @@
+#include "frame_auth.h"
+#include "debug.h"
+#include "DataManager.h"
+#include <Preferences.h>
+#include <esp_mac.h>
+#include <mbedtls/ccm.h>
+
+// Logging macros for the frame authentication module
+#define MODULE_TITLE       "AUTH"
+#define MODULE_DEBUG_LEVEL 1
+#define authLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+static const char* AUTH_NAMESPACE = "frame_auth";
+static const char* AUTH_LIMIT_KEY = "ctr_limit";
+
+#define FRAME_AUTH_NONCE_LEN 13
+
+// Nonce byte 11: benchmark frames use their own nonce space, so their private
+// counter can never repeat a nonce of a frame sent on air
+#define NONCE_DOMAIN_AIR    0
+#define NONCE_DOMAIN_BENCH  1
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+struct FrameAuthPeer {
+    uint8_t  mac[6];
+    bool     used;
+    uint32_t highest;           // Highest counter accepted
+    uint32_t window;            // Bit n set = highest - n accepted
+    uint32_t lastSeenMs;
+};
+
+static mbedtls_ccm_context ccm;
+static uint8_t ownMAC[6];
+static uint32_t counter = 0;
+static uint32_t reservedUntil = 0;      // Counters below this are reserved in NVM
+static bool reserveDue = false;
+static FrameAuthPeer peers[FRAME_AUTH_MAX_PEERS];
+static FrameAuthStats stats;
+static uint32_t benchCounter = 0;       // frameAuthSealBench() only
+
+// Frames are sealed on both tasks and opened on the Wi-Fi task. A mutex
+// rather than a spinlock: the AES accelerator driver may block.
+static SemaphoreHandle_t authMutex = nullptr;
+
+static void buildNonce(uint8_t* nonce, const uint8_t* mac, uint32_t frameCounter, uint8_t domain) {
+    memcpy(nonce, mac, 6);
+    memcpy(nonce + 6, &frameCounter, sizeof(frameCounter));
+    nonce[10] = FRAME_AUTH_ENCRYPT;
+    nonce[11] = domain;
+    nonce[12] = 0;
+}
+
+/**
+ * @brief Encrypt or tag frame into out and fill in trailer.tag
+ * @return mbedtls result, 0 on success
+ */
+static int sealLocked(const uint8_t* frame, size_t len, uint8_t* out, FrameAuthTrailer& trailer, uint8_t domain) {
+    uint8_t nonce[FRAME_AUTH_NONCE_LEN];
+    buildNonce(nonce, ownMAC, trailer.counter, domain);
+#if FRAME_AUTH_ENCRYPT
+    memcpy(out, frame, TREE_MSG_HEADER_SIZE);
+    return mbedtls_ccm_encrypt_and_tag(&ccm, len - TREE_MSG_HEADER_SIZE, nonce, sizeof(nonce),
+                                       frame, TREE_MSG_HEADER_SIZE,
+                                       frame + TREE_MSG_HEADER_SIZE, out + TREE_MSG_HEADER_SIZE,
+                                       trailer.tag, FRAME_AUTH_TAG_LEN);
+#else
+    memcpy(out, frame, len);
+    return mbedtls_ccm_encrypt_and_tag(&ccm, 0, nonce, sizeof(nonce), frame, len, nullptr, nullptr,
+                                       trailer.tag, FRAME_AUTH_TAG_LEN);
+#endif
+}
+
+/**
+ * @brief Check the tag of a frame (trailer already split off) into out
+ * @return mbedtls result, 0 if authentic
+ */
+static int openLocked(const uint8_t* mac, const uint8_t* frame, size_t frameLen, uint8_t* out,
+                      const FrameAuthTrailer& trailer, uint8_t domain) {
+    uint8_t nonce[FRAME_AUTH_NONCE_LEN];
+    buildNonce(nonce, mac, trailer.counter, domain);
+#if FRAME_AUTH_ENCRYPT
+    memcpy(out, frame, TREE_MSG_HEADER_SIZE);
+    return mbedtls_ccm_auth_decrypt(&ccm, frameLen - TREE_MSG_HEADER_SIZE, nonce, sizeof(nonce),
+                                    frame, TREE_MSG_HEADER_SIZE,
+                                    frame + TREE_MSG_HEADER_SIZE, out + TREE_MSG_HEADER_SIZE,
+                                    trailer.tag, FRAME_AUTH_TAG_LEN);
+#else
+    int rc = mbedtls_ccm_auth_decrypt(&ccm, 0, nonce, sizeof(nonce), frame, frameLen, nullptr, nullptr,
+                                      trailer.tag, FRAME_AUTH_TAG_LEN);
+    if (rc == 0) {
+        memcpy(out, frame, frameLen);
+    }
+    return rc;
+#endif
+}
+
+/**
+ * @brief Reserve FRAME_AUTH_COUNTER_RESERVE counters from 'from' in NVM
+ * @return the new limit, or 0 if it could not be written
+ */
+static uint32_t writeReservation(uint32_t from) {
+    uint32_t limit = from > UINT32_MAX - FRAME_AUTH_COUNTER_RESERVE ? UINT32_MAX : from + FRAME_AUTH_COUNTER_RESERVE;
+    Preferences prefs;
+    if (!prefs.begin(AUTH_NAMESPACE, false)) {
+        return 0;
+    }
+    bool ok = prefs.putUInt(AUTH_LIMIT_KEY, limit) == sizeof(limit);
+    prefs.end();
+    return ok ? limit : 0;
+}
+
+/**
+ * @brief Replay window check for an authenticated frame; records it if new
+ */
+static bool acceptCounterLocked(const uint8_t* mac, uint32_t frameCounter) {
+    uint32_t now = millis();
+    FrameAuthPeer* peer = nullptr;
+    for (FrameAuthPeer& candidate : peers) {
+        if (candidate.used && memcmp(candidate.mac, mac, 6) == 0) {
+            peer = &candidate;
+            break;
+        }
+    }
+    if (!peer) {
+        peer = &peers[0];
+        for (FrameAuthPeer& candidate : peers) {
+            if (!candidate.used) {
+                peer = &candidate;
+                break;
+            }
+            if ((int32_t)(candidate.lastSeenMs - peer->lastSeenMs) < 0) peer = &candidate;
+        }
+        memcpy(peer->mac, mac, 6);
+        peer->used = true;
+        peer->highest = frameCounter;
+        peer->window = 1;
+        peer->lastSeenMs = now;
+        return true;
+    }
+
+    peer->lastSeenMs = now;
+    if (frameCounter > peer->highest) {
+        uint32_t shift = frameCounter - peer->highest;
+        peer->window = shift >= FRAME_AUTH_REPLAY_WINDOW ? 1 : (peer->window << shift) | 1;
+        peer->highest = frameCounter;
+        return true;
+    }
+    uint32_t offset = peer->highest - frameCounter;
+    if (offset >= FRAME_AUTH_REPLAY_WINDOW || (peer->window & (1UL << offset))) {
+        return false;
+    }
+    peer->window |= 1UL << offset;
+    return true;
+}
+
+// ============================================================================
+// INITIALIZATION
+// ============================================================================
+
+void frameAuthInit() {
+    static const uint8_t key[16] = FRAME_AUTH_KEY;
+    mbedtls_ccm_init(&ccm);
+    if (mbedtls_ccm_setkey(&ccm, MBEDTLS_CIPHER_ID_AES, key, 128) != 0) {
+        authLog("Key setup failed", 1);
+        return;
+    }
+    esp_read_mac(ownMAC, ESP_MAC_WIFI_STA);
+
+#if ENABLE_FRAME_AUTH
+    // Resume from the last reservation; counters below it may have been used
+    Preferences prefs;
+    if (prefs.begin(AUTH_NAMESPACE, true)) {
+        counter = prefs.getUInt(AUTH_LIMIT_KEY, 0);
+        prefs.end();
+    }
+    reservedUntil = writeReservation(counter);
+    if (reservedUntil == 0) {
+        authLog("Counter reservation could not be written, sealing disabled", 1);
+    }
+    authLog("Frame counter resumes at " + String(counter), 3);
+#else
+    // Only BENCH seals frames, and they are never sent
+    reservedUntil = UINT32_MAX;
+#endif
+    authMutex = xSemaphoreCreateMutex();
+}
+
+// ============================================================================
+// SEAL AND OPEN
+// ============================================================================
+
+size_t frameAuthSeal(const uint8_t* frame, size_t len, uint8_t* out, size_t outSize) {
+    if (!authMutex || !frame) {
+        return 0;
+    }
+    size_t sealedLen = len + sizeof(FrameAuthTrailer);
+
+    xSemaphoreTake(authMutex, portMAX_DELAY);
+    if (len < TREE_MSG_HEADER_SIZE || sealedLen > outSize || sealedLen > 250 || counter >= reservedUntil) {
+        stats.sealFailures++;
+        xSemaphoreGive(authMutex);
+        return 0;
+    }
+    FrameAuthTrailer trailer;
+    trailer.counter = counter++;
+    if (reservedUntil - counter < FRAME_AUTH_COUNTER_RESERVE / 2 && reservedUntil < UINT32_MAX) {
+        reserveDue = true;
+    }
+
+    int rc = sealLocked(frame, len, out, trailer, NONCE_DOMAIN_AIR);
+    if (rc == 0) {
+        stats.sealed++;
+    } else {
+        stats.sealFailures++;
+    }
+    xSemaphoreGive(authMutex);
+
+    if (rc != 0) {
+        return 0;
+    }
+    memcpy(out + len, &trailer, sizeof(trailer));
+    return sealedLen;
+}
+
+size_t frameAuthOpen(const uint8_t* srcMAC, const uint8_t* frame, size_t len, uint8_t* out) {
+    if (!authMutex || !srcMAC || !frame) {
+        return 0;
+    }
+    if (len < TREE_MSG_HEADER_SIZE + sizeof(FrameAuthTrailer)) {
+        xSemaphoreTake(authMutex, portMAX_DELAY);
+        stats.unsealed++;
+        xSemaphoreGive(authMutex);
+        return 0;
+    }
+    size_t frameLen = len - sizeof(FrameAuthTrailer);
+    FrameAuthTrailer trailer;
+    memcpy(&trailer, frame + frameLen, sizeof(trailer));
+
+    xSemaphoreTake(authMutex, portMAX_DELAY);
+    int rc = openLocked(srcMAC, frame, frameLen, out, trailer, NONCE_DOMAIN_AIR);
+    bool accepted = false;
+    if (rc != 0) {
+        stats.badTag++;
+    } else if (!acceptCounterLocked(srcMAC, trailer.counter)) {
+        stats.replayed++;
+    } else {
+        stats.opened++;
+        accepted = true;
+    }
+    xSemaphoreGive(authMutex);
+
+    return accepted ? frameLen : 0;
+}
+
+size_t frameAuthSealBench(const uint8_t* frame, size_t len, uint8_t* out, size_t outSize) {
+    size_t sealedLen = len + sizeof(FrameAuthTrailer);
+    if (!authMutex || !frame || len < TREE_MSG_HEADER_SIZE || sealedLen > outSize || sealedLen > 250) {
+        return 0;
+    }
+    FrameAuthTrailer trailer;
+    xSemaphoreTake(authMutex, portMAX_DELAY);
+    trailer.counter = benchCounter++;
+    int rc = sealLocked(frame, len, out, trailer, NONCE_DOMAIN_BENCH);
+    xSemaphoreGive(authMutex);
+
+    if (rc != 0) {
+        return 0;
+    }
+    memcpy(out + len, &trailer, sizeof(trailer));
+    return sealedLen;
+}
+
+size_t frameAuthOpenBench(const uint8_t* frame, size_t len, uint8_t* out) {
+    if (!authMutex || !frame || len < TREE_MSG_HEADER_SIZE + sizeof(FrameAuthTrailer)) {
+        return 0;
+    }
+    size_t frameLen = len - sizeof(FrameAuthTrailer);
+    FrameAuthTrailer trailer;
+    memcpy(&trailer, frame + frameLen, sizeof(trailer));
+
+    xSemaphoreTake(authMutex, portMAX_DELAY);
+    int rc = openLocked(ownMAC, frame, frameLen, out, trailer, NONCE_DOMAIN_BENCH);
+    xSemaphoreGive(authMutex);
+    return rc == 0 ? frameLen : 0;
+}
+
+// ============================================================================
+// LOOP TASK AND QUERIES
+// ============================================================================
+
+void frameAuthUpdate() {
+#if ENABLE_FRAME_AUTH
+    if (!authMutex || !reserveDue) {
+        return;
+    }
+    xSemaphoreTake(authMutex, portMAX_DELAY);
+    uint32_t from = reservedUntil;
+    xSemaphoreGive(authMutex);
+
+    // NVM is written outside the lock so the Wi-Fi task never waits on flash
+    uint32_t limit = writeReservation(from);
+    if (limit == 0) {
+        authLog("Counter reservation could not be written", 1);
+        return;
+    }
+    xSemaphoreTake(authMutex, portMAX_DELAY);
+    reservedUntil = limit;
+    reserveDue = false;
+    xSemaphoreGive(authMutex);
+    authLog("Frame counters reserved up to " + String(limit), 3);
+#endif
+}
+
+void frameAuthGetStats(FrameAuthStats& out) {
+    if (!authMutex) {
+        out = FrameAuthStats();
+        return;
+    }
+    xSemaphoreTake(authMutex, portMAX_DELAY);
+    out = stats;
+    out.counter = counter;
+    out.peers = 0;
+    for (const FrameAuthPeer& peer : peers) {
+        if (peer.used) out.peers++;
+    }
+    xSemaphoreGive(authMutex);
+}
+
+void frameAuthResetStats() {
+    if (!authMutex) {
+        return;
+    }
+    xSemaphoreTake(authMutex, portMAX_DELAY);
+    stats = FrameAuthStats();
+    xSemaphoreGive(authMutex);
+}
@@ -0,0 +1,137 @@
+#ifndef FRAME_AUTH_H
+#define FRAME_AUTH_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// FRAME AUTHENTICATION CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Hop-by-hop AES-CCM authentication of every ESP-NOW frame.
+ *
+ * Peers are added with encrypt=false. Until now the only check on a frame
+ * was its broadcaster_hid against the tree, which any radio can fake. With
+ * this on, each transmission is sealed just before it is queued:
+ * - A FrameAuthTrailer is appended: the sender's 32-bit frame counter and
+ *   a FRAME_AUTH_TAG_LEN byte CCM tag.
+ * - The tag covers the tree header. With FRAME_AUTH_ENCRYPT it also covers
+ *   the rest of the frame, which is encrypted. Without it, the whole frame
+ *   is authenticated only and stays readable on air.
+ * - The 13-byte nonce is the sender's MAC, the counter and the mode. The
+ *   MAC is used rather than the HID because HIDs repeat on unconfigured
+ *   nodes and change when a node is re-addressed.
+ *
+ * Forwarders open a frame, route it and seal it again with their own
+ * counter, so the tag is checked at every hop.
+ *
+ * Receivers keep a FRAME_AUTH_REPLAY_WINDOW frame window per sender MAC.
+ * A frame with a bad tag, a repeated counter or a counter older than the
+ * window is dropped, as is a frame without a trailer.
+ *
+ * The windows live in RAM only. After a receiver reboots, or evicts a sender
+ * because more than FRAME_AUTH_MAX_PEERS are in range, the first frame it
+ * sees from that sender sets the window. A recorded old frame replayed at
+ * that moment is accepted once, and it then blocks the sender's older
+ * counters for the rest of the window. Keep FRAME_AUTH_MAX_PEERS at or above
+ * the number of nodes a receiver can hear, and treat a node's reboot as a
+ * replay opportunity. Commands that must not repeat need their own check.
+ *
+ * The counter is reserved in NVM FRAME_AUTH_COUNTER_RESERVE frames ahead,
+ * so it never repeats across restarts. Change FRAME_AUTH_KEY before the
+ * counter reaches 2^32; sealing stops there.
+ *
+ * The key schedule is set up once at boot, and the AES blocks run on the
+ * ESP32 accelerator through mbedtls. BENCH reports the cost of sealing and
+ * opening an I/O update even with this off, so it can be checked against
+ * the per-hop budget first. It uses frameAuthSealBench(), which never
+ * touches the frame counter, its reservation or the statistics.
+ *
+ * Every node needs the same key and settings; update them all together.
+ * Frames are FRAME_AUTH_OVERHEAD bytes longer, so bulk fragments,
+ * aggregated batches and OTA blocks shrink to fit (TREE_FRAME_MAX_LEN).
+ *
+ * Set to 0 to send and accept frames without a trailer.
+ */
+#define ENABLE_FRAME_AUTH 0
+
+#define FRAME_AUTH_ENCRYPT          1       // 1 = AES-CCM, 0 = tag only
+#define FRAME_AUTH_TAG_LEN          8
+#define FRAME_AUTH_REPLAY_WINDOW    32      // Bits in FrameAuthPeer::window
+#define FRAME_AUTH_MAX_PEERS        16      // Senders tracked; the oldest is replaced
+#define FRAME_AUTH_COUNTER_RESERVE  65536   // Counter values reserved per NVM write
+
+// 128-bit network key. Change it for every site.
+#define FRAME_AUTH_KEY { 0x3B, 0x9E, 0x47, 0xD2, 0x81, 0x6C, 0xF0, 0x25, \
+                         0xA8, 0x13, 0x5D, 0xE6, 0x7F, 0xC4, 0x0A, 0x92 }
+
+typedef struct {
+    uint32_t counter;
+    uint8_t  tag[FRAME_AUTH_TAG_LEN];
+} __attribute__((packed)) FrameAuthTrailer;
+
+#if ENABLE_FRAME_AUTH
+#define FRAME_AUTH_OVERHEAD sizeof(FrameAuthTrailer)
+#else
+#define FRAME_AUTH_OVERHEAD 0
+#endif
+
+// Largest tree frame that still fits one ESP-NOW frame once sealed
+#define TREE_FRAME_MAX_LEN (250 - FRAME_AUTH_OVERHEAD)
+
+struct FrameAuthStats {
+    uint32_t sealed = 0;
+    uint32_t opened = 0;
+    uint32_t badTag = 0;
+    uint32_t replayed = 0;              // Counter repeated or older than the window
+    uint32_t unsealed = 0;              // Too short to carry a trailer
+    uint32_t sealFailures = 0;          // Too long, or counter reservation used up
+    uint32_t counter = 0;               // Next counter this node sends
+    uint8_t  peers = 0;                 // Senders with a replay window
+};
+
+// ============================================================================
+// FRAME AUTHENTICATION API
+// ============================================================================
+
+/**
+ * @brief Set up the key schedule and restore the counter reservation.
+ *        Call before espnowInit().
+ */
+void frameAuthInit();
+
+/**
+ * @brief Seal a tree frame: encrypt or tag it and append the trailer
+ * @return sealed length, or 0 if it could not be sealed
+ */
+size_t frameAuthSeal(const uint8_t* frame, size_t len, uint8_t* out, size_t outSize);
+
+/**
+ * @brief Check and strip the trailer of a frame from srcMAC
+ * @return opened length, or 0 if the frame must be dropped
+ */
+size_t frameAuthOpen(const uint8_t* srcMAC, const uint8_t* frame, size_t len, uint8_t* out);
+
+/**
+ * @brief Benchmark-only seal: a private counter and its own nonce space.
+ *        Leaves the frame counter, its NVM reservation and the stats alone.
+ * @return sealed length, or 0 if it could not be sealed
+ */
+size_t frameAuthSealBench(const uint8_t* frame, size_t len, uint8_t* out, size_t outSize);
+
+/**
+ * @brief Open a frame sealed by frameAuthSealBench(); no replay window, no stats
+ * @return opened length, or 0 if the tag is wrong
+ */
+size_t frameAuthOpenBench(const uint8_t* frame, size_t len, uint8_t* out);
+
+/**
+ * @brief Write the next counter reservation when it is running out.
+ *        Call from loop().
+ */
+void frameAuthUpdate();
+
+void frameAuthGetStats(FrameAuthStats& out);
+void frameAuthResetStats();
+
+#endif // FRAME_AUTH_H
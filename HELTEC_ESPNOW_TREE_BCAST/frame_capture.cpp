@@ -0,0 +1,107 @@
+#include "frame_capture.h"
+#include <esp_timer.h>
+
+// ============================================================================
+// CAPTURE STATE
+// ============================================================================
+
+#if ENABLE_FRAME_CAPTURE
+static CapturedFrame captureRing[FRAME_CAPTURE_RING_SIZE];
+#endif
+static uint8_t captureHead = 0;     // Next slot to write
+static uint8_t captureCount = 0;
+static uint32_t captureNextSeq = 0; // Sequence number of the next frame recorded
+static uint32_t captureClearSeq = 0;
+static uint32_t captureOverwritten = 0;
+static volatile bool captureEnabled = false;
+
+// Written from the Wi-Fi task, read from loop()
+static portMUX_TYPE captureMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t captureSlot(uint8_t offset) {
+    return (captureHead + FRAME_CAPTURE_RING_SIZE - captureCount + offset) % FRAME_CAPTURE_RING_SIZE;
+}
+
+// ============================================================================
+// FRAME CAPTURE API
+// ============================================================================
+
+void captureSetEnabled(bool enabled) {
+    captureEnabled = ENABLE_FRAME_CAPTURE && enabled;
+}
+
+bool captureIsEnabled() {
+    return captureEnabled;
+}
+
+void captureRecord(const uint8_t* srcMAC, const uint8_t* data, int len, int8_t rssi, uint8_t verdict) {
+#if ENABLE_FRAME_CAPTURE
+    if (!captureEnabled || len <= 0) {
+        return;
+    }
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint8_t capLen = (len < FRAME_CAPTURE_SNAPLEN) ? len : FRAME_CAPTURE_SNAPLEN;
+
+    portENTER_CRITICAL(&captureMux);
+    CapturedFrame& frame = captureRing[captureHead];
+    frame.timeUs = now;
+    memcpy(frame.srcMAC, srcMAC, sizeof(frame.srcMAC));
+    frame.rssi = rssi;
+    frame.verdict = verdict;
+    frame.origLen = (len < 255) ? len : 255;
+    frame.capLen = capLen;
+    memcpy(frame.data, data, capLen);
+
+    captureHead = (captureHead + 1) % FRAME_CAPTURE_RING_SIZE;
+    if (captureCount < FRAME_CAPTURE_RING_SIZE) {
+        captureCount++;
+    } else {
+        captureOverwritten++;   // Oldest frame was just replaced
+    }
+    captureNextSeq++;
+    portEXIT_CRITICAL(&captureMux);
+#endif
+}
+
+bool capturePeek(uint8_t offset, CapturedFrame& out, uint32_t& frameSeq) {
+#if ENABLE_FRAME_CAPTURE
+    portENTER_CRITICAL(&captureMux);
+    bool valid = offset < captureCount;
+    if (valid) {
+        const CapturedFrame& frame = captureRing[captureSlot(offset)];
+        memcpy(&out, &frame, CAPTURED_FRAME_HEADER_SIZE + frame.capLen);
+        frameSeq = captureNextSeq - captureCount + offset;
+    }
+    portEXIT_CRITICAL(&captureMux);
+    return valid;
+#else
+    return false;
+#endif
+}
+
+void captureConsumeThrough(uint32_t frameSeq) {
+    portENTER_CRITICAL(&captureMux);
+    uint32_t oldestSeq = captureNextSeq - captureCount;
+    int32_t consumed = (int32_t)(frameSeq + 1 - oldestSeq);
+    if (consumed > 0) {
+        captureCount = ((uint32_t)consumed < captureCount) ? captureCount - consumed : 0;
+    }
+    portEXIT_CRITICAL(&captureMux);
+}
+
+void captureClear() {
+    portENTER_CRITICAL(&captureMux);
+    captureCount = 0;
+    captureClearSeq = captureNextSeq;
+    captureOverwritten = 0;
+    portEXIT_CRITICAL(&captureMux);
+}
+
+void captureGetStats(CaptureStats& out) {
+    portENTER_CRITICAL(&captureMux);
+    out.captured = captureNextSeq - captureClearSeq;
+    out.overwritten = captureOverwritten;
+    out.pending = captureCount;
+    portEXIT_CRITICAL(&captureMux);
+    out.enabled = captureEnabled;
+}
@@ -0,0 +1,96 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// FRAME CAPTURE CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Raw frame capture for field debugging.
+ *
+ * While capture is on, every frame that reaches the receive path is copied
+ * into a RAM ring together with its arrival time, RSSI, sender MAC and the
+ * routing verdict the node reached for it. The ring is drained over serial
+ * as SMSG_TOPIC_CAPTURE pushes (see serial_protocol.h) and can be decoded or
+ * replayed with tools/frame_capture.
+ *
+ * When the ring is full the oldest frame is overwritten, so a node left
+ * capturing with no host attached keeps the most recent history.
+ *
+ * Set to 0 to compile capture out and free the ring.
+ */
+#define ENABLE_FRAME_CAPTURE 1
+
+#define FRAME_CAPTURE_RING_SIZE 48
+#define FRAME_CAPTURE_SNAPLEN   160   // Longer frames are truncated (origLen keeps the real size)
+
+/**
+ * @brief What the receive path did with a frame
+ */
+enum CaptureVerdict : uint8_t {
+    CAPTURE_VERDICT_REJECTED     = 0x00,   // Failed validation or not for this node
+    CAPTURE_VERDICT_PROCESSED    = 0x01,   // Handled locally, not forwarded
+    CAPTURE_VERDICT_FORWARD_UP   = 0x02,   // Handled and forwarded upstream
+    CAPTURE_VERDICT_FORWARD_DOWN = 0x03,   // Handled and forwarded downstream
+    CAPTURE_VERDICT_MASK         = 0x7F,
+    CAPTURE_FLAG_INJECTED        = 0x80    // Came from espnowInjectFrame (soak/replay), not the radio
+};
+
+/**
+ * @brief One captured frame. The serial record is this struct truncated to
+ *        capLen bytes of data.
+ */
+typedef struct {
+    uint32_t timeUs;            // esp_timer time at arrival
+    uint8_t  srcMAC[6];
+    int8_t   rssi;
+    uint8_t  verdict;           // CaptureVerdict | CAPTURE_FLAG_INJECTED
+    uint8_t  origLen;           // Frame length on the air
+    uint8_t  capLen;            // Bytes stored in data (<= FRAME_CAPTURE_SNAPLEN)
+    uint8_t  data[FRAME_CAPTURE_SNAPLEN];
+} __attribute__((packed)) CapturedFrame;
+
+#define CAPTURED_FRAME_HEADER_SIZE (sizeof(CapturedFrame) - FRAME_CAPTURE_SNAPLEN)
+
+struct CaptureStats {
+    uint32_t captured = 0;      // Frames recorded since capture was last cleared
+    uint32_t overwritten = 0;   // Frames lost because the ring was full
+    uint8_t pending = 0;        // Frames waiting to be drained
+    bool enabled = false;
+};
+
+// ============================================================================
+// FRAME CAPTURE API
+// ============================================================================
+
+void captureSetEnabled(bool enabled);
+bool captureIsEnabled();
+
+/**
+ * @brief Record a frame. Called from the Wi-Fi task; does not allocate.
+ */
+void captureRecord(const uint8_t* srcMAC, const uint8_t* data, int len, int8_t rssi, uint8_t verdict);
+
+/**
+ * @brief Copy the frame offset places from the oldest without removing it
+ * @param frameSeq Set to the frame's capture sequence number
+ * @return false if fewer than offset + 1 frames are pending
+ */
+bool capturePeek(uint8_t offset, CapturedFrame& out, uint32_t& frameSeq);
+
+/**
+ * @brief Remove pending frames up to and including frameSeq (after they were
+ *        sent). Frames overwritten meanwhile are not counted twice.
+ */
+void captureConsumeThrough(uint32_t frameSeq);
+
+/**
+ * @brief Drop all pending frames and reset the counters
+ */
+void captureClear();
+
+void captureGetStats(CaptureStats& out);
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,343 @@
+#include "heap_guard.h"
+#include "debug.h"
+#include "DataManager.h"
+#include "IoDevice.h"
+#include "espnow_wrapper.h"
+#include <esp_heap_caps.h>
+
+// Logging macros for the heap guard module
+#define MODULE_TITLE       "HEAP"
+#define MODULE_DEBUG_LEVEL 1
+#define heapLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// GUARD STATE
+// ============================================================================
+
+/**
+ * @brief Per-core guard slot. Only the owning task's allocations are counted.
+ */
+struct AllocGuardSlot {
+    TaskHandle_t task;
+    uint8_t depth;
+    uint32_t allocCount;
+    uint32_t allocBytes;
+    size_t freeAtEntry;
+    const char* path;
+};
+
+static AllocGuardSlot guardSlots[portNUM_PROCESSORS];
+static AllocGuardStats guardStats;
+static portMUX_TYPE guardStatsMux = portMUX_INITIALIZER_UNLOCKED;
+
+#if ENABLE_ALLOC_GUARD && ALLOC_GUARD_EXACT
+/**
+ * @brief ESP-IDF heap hook, called for every successful allocation.
+ *        Must not allocate, log or block.
+ */
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    AllocGuardSlot& slot = guardSlots[xPortGetCoreID()];
+    if (slot.depth > 0 && slot.task == xTaskGetCurrentTaskHandle()) {
+        slot.allocCount++;
+        slot.allocBytes += size;
+    }
+}
+#endif
+
+// ============================================================================
+// GUARD SCOPE
+// ============================================================================
+
+AllocGuardScope::AllocGuardScope(const char* pathName, uint32_t* countOut) : slotIndex(-1), countOut(countOut) {
+    int core = xPortGetCoreID();
+    AllocGuardSlot& slot = guardSlots[core];
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (countOut) {
+        *countOut = 0;
+    }
+
+    // Another task on this core owns the slot (we preempted it): stay inactive
+    if (slot.depth > 0 && slot.task != self) {
+        return;
+    }
+
+    slotIndex = core;
+    if (slot.depth++ == 0) {
+        slot.task = self;
+        slot.path = pathName;
+        slot.allocCount = 0;
+        slot.allocBytes = 0;
+        slot.freeAtEntry = ALLOC_GUARD_EXACT ? 0 : heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    }
+}
+
+AllocGuardScope::~AllocGuardScope() {
+    if (slotIndex < 0) {
+        return;
+    }
+
+    AllocGuardSlot& slot = guardSlots[slotIndex];
+    if (--slot.depth > 0) {
+        return;   // Outermost scope does the accounting
+    }
+
+    uint32_t count = slot.allocCount;
+    uint32_t bytes = slot.allocBytes;
+    #if !ALLOC_GUARD_EXACT
+    size_t freeNow = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    if (freeNow < slot.freeAtEntry) {
+        count = 1;
+        bytes = slot.freeAtEntry - freeNow;
+    }
+    #endif
+    slot.task = nullptr;
+
+    if (countOut) {
+        *countOut = count;
+        return;
+    }
+
+    portENTER_CRITICAL(&guardStatsMux);
+    guardStats.scopesCompleted++;
+    if (count > 0) {
+        guardStats.violations++;
+        guardStats.allocations += count;
+        guardStats.lastViolationBytes = bytes;
+        guardStats.lastViolationPath = slot.path;
+    }
+    portEXIT_CRITICAL(&guardStatsMux);
+}
+
+void allocGuardGetStats(AllocGuardStats& out) {
+    portENTER_CRITICAL(&guardStatsMux);
+    out = guardStats;
+    portEXIT_CRITICAL(&guardStatsMux);
+}
+
+void allocGuardReset() {
+    portENTER_CRITICAL(&guardStatsMux);
+    guardStats = AllocGuardStats();
+    portEXIT_CRITICAL(&guardStatsMux);
+}
+
+void allocGuardPoll() {
+    #if ENABLE_ALLOC_GUARD
+    static uint32_t reportedViolations = 0;
+    static unsigned long lastReportTime = 0;
+
+    if (millis() - lastReportTime < 5000) {
+        return;
+    }
+
+    AllocGuardStats stats;
+    allocGuardGetStats(stats);
+    if (stats.violations < reportedViolations) {
+        reportedViolations = 0;   // Counters were reset
+    }
+    if (stats.violations == reportedViolations) {
+        return;
+    }
+
+    heapLog("Heap allocation on guarded path '" + String(stats.lastViolationPath ? stats.lastViolationPath : "?") +
+           "': " + String(stats.violations - reportedViolations) + " new violation(s), last " +
+           String(stats.lastViolationBytes) + " bytes" + (stats.exactCounting ? "" : " (approximate)"), 1);
+    reportedViolations = stats.violations;
+    lastReportTime = millis();
+    #endif
+}
+
+// ============================================================================
+// HEAP SOAK TEST
+// ============================================================================
+
+// Synthetic devices used on the root (descendants not already in the table)
+#define SOAK_MAX_SYNTHETIC_DEVICES 32
+
+static void takeHeapSample(uint32_t simulatedHour, HeapSoakReport& report) {
+    HeapSoakSample sample;
+    sample.simulatedHour = simulatedHour;
+    sample.freeBytes = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    sample.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+    sample.fragmentationPct = sample.freeBytes ? 100 - (uint8_t)((uint64_t)sample.largestBlock * 100 / sample.freeBytes) : 0;
+
+    if (report.sampleCount == 0 || sample.freeBytes < report.minFreeBytes) {
+        report.minFreeBytes = sample.freeBytes;
+    }
+    if (sample.fragmentationPct > report.maxFragmentationPct) {
+        report.maxFragmentationPct = sample.fragmentationPct;
+    }
+    if (report.sampleCount < HEAP_SOAK_MAX_SAMPLES) {
+        report.samples[report.sampleCount++] = sample;
+    }
+}
+
+/**
+ * @brief Build a frame as if it had been broadcast by another node.
+ */
+static int buildSoakFrame(uint8_t* buffer, size_t bufferSize, uint16_t destHID, uint16_t srcHID,
+                          uint16_t broadcasterHID, TreeMessageType msgType,
+                          const uint8_t* payload, size_t payloadLen) {
+    if (!DATA_MGR.createTreeMessage(buffer, bufferSize, destHID, msgType, payload, payloadLen)) {
+        return 0;
+    }
+
+    TreeMessageHeader* header = (TreeMessageHeader*)buffer;
+    header->src_hid = srcHID;
+    header->broadcaster_hid = broadcasterHID;
+    buffer[TREE_MSG_HEADER_SIZE + payloadLen] = DATA_MGR.calculateCRC8(buffer + 1, TREE_MSG_HEADER_SIZE - 1 + payloadLen);
+    return TREE_MSG_OVERHEAD + payloadLen;
+}
+
+// Task running heapSoakRun(); frames it injects are synthetic
+static volatile TaskHandle_t soakTask = nullptr;
+
+bool heapSoakInjecting() {
+    return soakTask != nullptr && soakTask == xTaskGetCurrentTaskHandle();
+}
+
+static void soakMAC(uint16_t hid, uint8_t* mac) {
+    // Locally administered address derived from the synthetic HID
+    mac[0] = 0x02; mac[1] = 0x50; mac[2] = 0x4B; mac[3] = 0x00;
+    mac[4] = hid >> 8; mac[5] = hid & 0xFF;
+}
+
+bool heapSoakRun(uint32_t simulatedHours, uint32_t framesPerMinute, HeapSoakReport& report) {
+    if (!DATA_MGR.isHIDConfigured()) {
+        return false;
+    }
+
+    report = HeapSoakReport();
+    report.simulatedHours = constrain(simulatedHours, 1UL, (uint32_t)HEAP_SOAK_MAX_HOURS);
+    framesPerMinute = constrain(framesPerMinute, 1UL, 6000UL);
+
+    const bool isRoot = DATA_MGR.isRoot();
+    const uint16_t myHID = DATA_MGR.getMyHID();
+    const uint32_t framesPerHour = framesPerMinute * 60;
+    const uint32_t totalFrames = framesPerHour * report.simulatedHours;
+    const uint32_t sampleStride = (report.simulatedHours + HEAP_SOAK_MAX_SAMPLES - 2) / (HEAP_SOAK_MAX_SAMPLES - 1);
+
+    // Root: pick synthetic descendants that are not real devices in the table
+    uint16_t syntheticHIDs[SOAK_MAX_SYNTHETIC_DEVICES];
+    int syntheticCount = 0;
+    if (isRoot) {
+        // Root descendants: children first, then grandchildren
+        const uint16_t perLevel = TREE_ADDR_MAX_CHILDREN;
+        for (uint16_t i = 0; i < perLevel * (perLevel + 1) && syntheticCount < SOAK_MAX_SYNTHETIC_DEVICES; i++) {
+            uint16_t hid = (i < perLevel) ? treeAddrChild(ROOT_HID, i)
+                                          : treeAddrChild(treeAddrChild(ROOT_HID, (i - perLevel) / perLevel),
+                                                          (i - perLevel) % perLevel);
+            if (hid != UNCONFIGURED_HID && DATA_MGR.getDeviceData(hid) == nullptr) {
+                syntheticHIDs[syntheticCount++] = hid;
+            }
+        }
+        if (syntheticCount == 0) {
+            return false;
+        }
+    }
+
+    // Non-root: shared I/O is restored afterwards; outputs stay as they are now
+    DistributedIOData savedIO;
+    DATA_MGR.readDistributedIOSharedData(savedIO);
+
+    heapLog("Heap soak: " + String(report.simulatedHours) + "h at " + String(framesPerMinute) +
+           " frames/min (" + String(totalFrames) + " frames)", 3);
+
+    AllocGuardStats guardBefore;
+    allocGuardGetStats(guardBefore);
+    espnowSetTxMuted(true);
+    soakTask = xTaskGetCurrentTaskHandle();
+    uint32_t mutedBefore = espnowGetMutedTxCount();
+    uint32_t startMs = millis();
+    takeHeapSample(0, report);
+
+    uint8_t frame[TREE_MSG_OVERHEAD + sizeof(DistributedIOData)];
+    uint8_t mac[6];
+
+    for (uint32_t n = 0; n < totalFrames; n++) {
+        int len = 0;
+
+        if (isRoot) {
+            // Data report from a synthetic descendant, relayed by its top-level ancestor
+            uint16_t src = syntheticHIDs[n % syntheticCount];
+            uint16_t broadcaster = src;
+            while (treeAddrParent(broadcaster) != ROOT_HID) {
+                broadcaster = treeAddrParent(broadcaster);
+            }
+            DeviceSpecificData data;
+            memset(&data, 0, sizeof(data));
+            data.input_states = (n / syntheticCount) & 0x07;
+            data.bit_index = src % MAX_DISTRIBUTED_IO_BITS;
+            if (data.bit_index == DATA_MGR.getMyBitIndex()) {
+                // The root applies Q at its own bit: keep its outputs untouched
+                data.bit_index = (data.bit_index + 1) % MAX_DISTRIBUTED_IO_BITS;
+            }
+            len = buildSoakFrame(frame, sizeof(frame), ROOT_HID, src, broadcaster,
+                                 MSG_DEVICE_DATA_REPORT, (const uint8_t*)&data, sizeof(data));
+            soakMAC(broadcaster, mac);
+        } else if ((n & 1) == 0 || !treeAddrIsValid(treeAddrChild(myHID, TREE_ADDR_MAX_CHILDREN - 1))) {
+            // Shared I/O update from my parent: inputs toggle, outputs unchanged
+            DistributedIOData io = savedIO;
+            for (int i = 0; i < MAX_INPUTS; i++) {
+                io.sharedData[i][0] = (n * 2654435761UL) >> (i * 3 % 32);
+            }
+            uint16_t parent = DATA_MGR.getParentHID();
+            len = buildSoakFrame(frame, sizeof(frame), BROADCAST_HID, ROOT_HID, parent,
+                                 MSG_DISTRIBUTED_IO_UPDATE, (const uint8_t*)&io, sizeof(io));
+            soakMAC(parent, mac);
+        } else {
+            // Data report from one of my children, to be forwarded upstream
+            uint16_t child = treeAddrChild(myHID, (n / 2) % TREE_ADDR_MAX_CHILDREN);
+            DeviceSpecificData data;
+            memset(&data, 0, sizeof(data));
+            data.input_states = (n / 20) & 0x07;
+            data.bit_index = child % MAX_DISTRIBUTED_IO_BITS;
+            len = buildSoakFrame(frame, sizeof(frame), ROOT_HID, child, child,
+                                 MSG_DEVICE_DATA_REPORT, (const uint8_t*)&data, sizeof(data));
+            soakMAC(child, mac);
+        }
+
+        if (len > 0) {
+            espnowInjectFrame(mac, frame, len, -60 - (int8_t)(n % 30));
+            report.framesInjected++;
+        }
+
+        // Keep the Wi-Fi and idle tasks running
+        if ((n % 200) == 199) {
+            vTaskDelay(1);
+        }
+
+        if ((n + 1) % framesPerHour == 0) {
+            uint32_t hour = (n + 1) / framesPerHour;
+            if (hour % sampleStride == 0 || hour == report.simulatedHours) {
+                takeHeapSample(hour, report);
+            }
+        }
+    }
+
+    soakTask = nullptr;
+    report.elapsedMs = millis() - startMs;
+    report.txSuppressed = espnowGetMutedTxCount() - mutedBefore;
+
+    AllocGuardStats guardAfter;
+    allocGuardGetStats(guardAfter);
+    report.guardViolations = guardAfter.violations - guardBefore.violations;
+    report.guardAllocations = guardAfter.allocations - guardBefore.allocations;
+
+    // Undo the synthetic state before real traffic is transmitted again
+    if (isRoot) {
+        for (int i = 0; i < syntheticCount; i++) {
+            DATA_MGR.removeAggregatedDevice(syntheticHIDs[i]);
+        }
+    } else {
+        DATA_MGR.setDistributedIOSharedData(savedIO);
+        IO_DEVICE.processSharedDataUpdate(savedIO);
+    }
+    espnowSetTxMuted(false);
+    if (isRoot) {
+        DATA_MGR.computeAndBroadcastDistributedIO();
+    }
+
+    heapLog("Heap soak done in " + String(report.elapsedMs) + "ms, max fragmentation " +
+           String(report.maxFragmentationPct) + "%, guard violations " + String(report.guardViolations), 3);
+    return true;
+}
@@ -0,0 +1,146 @@
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// ALLOCATION GUARD CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Enable the heap allocation guard for hot paths. Debug builds only.
+ *
+ * Code wrapped in ALLOC_GUARD_SCOPE() must not touch the heap. While such a
+ * scope is open, every allocation made by the owning task is counted and the
+ * scope is flagged as a violation; allocGuardPoll() reports it from loop().
+ *
+ * - Exact counting needs CONFIG_HEAP_USE_HOOKS=y in sdkconfig (ESP-IDF or
+ *   Arduino-as-component builds), which enables esp_heap_trace_alloc_hook().
+ * - Stock Arduino builds fall back to comparing the free heap on scope entry
+ *   and exit. That only catches allocations that outlive the scope and can be
+ *   skewed by other tasks allocating concurrently.
+ *
+ * Off by default: ALLOC_GUARD_SCOPE() then compiles away and the receive
+ * path pays nothing. Set to 1 while checking hot paths for allocations.
+ * BENCH allocations/op do not depend on this flag.
+ */
+#define ENABLE_ALLOC_GUARD 0
+
+#if ENABLE_ALLOC_GUARD && defined(CONFIG_HEAP_USE_HOOKS)
+#define ALLOC_GUARD_EXACT 1
+#else
+#define ALLOC_GUARD_EXACT 0
+#endif
+
+/**
+ * @brief Counters accumulated over all guarded scopes since the last reset
+ */
+struct AllocGuardStats {
+    uint32_t scopesCompleted = 0;
+    uint32_t violations = 0;          // Scopes that allocated at least once
+    uint32_t allocations = 0;         // Allocations seen inside guarded scopes
+    uint32_t lastViolationBytes = 0;
+    const char* lastViolationPath = nullptr;
+    bool exactCounting = ALLOC_GUARD_EXACT;
+};
+
+/**
+ * @brief RAII marker for a code path that must not allocate.
+ *
+ * Scopes nest per task. State is tracked per core, so the guarded task must
+ * stay on one core for the duration of the scope (true for the Wi-Fi task
+ * and the Arduino loop task, which are both pinned).
+ */
+class AllocGuardScope {
+public:
+    /**
+     * @param countOut When set, the scope only counts: the allocation count is
+     *                 written here on exit and no violation is recorded
+     *                 (used by the BENCH allocations/op figure)
+     */
+    explicit AllocGuardScope(const char* pathName, uint32_t* countOut = nullptr);
+    ~AllocGuardScope();
+
+private:
+    AllocGuardScope(const AllocGuardScope&) = delete;
+    AllocGuardScope& operator=(const AllocGuardScope&) = delete;
+
+    int8_t slotIndex;   // -1 when this scope is inactive
+    uint32_t* countOut;
+};
+
+#if ENABLE_ALLOC_GUARD
+#define ALLOC_GUARD_SCOPE(pathName) AllocGuardScope allocGuardScope_(pathName)
+#else
+#define ALLOC_GUARD_SCOPE(pathName) do {} while (0)
+#endif
+
+/**
+ * @brief Copy the current guard counters
+ */
+void allocGuardGetStats(AllocGuardStats& out);
+
+/**
+ * @brief Reset the guard counters
+ */
+void allocGuardReset();
+
+/**
+ * @brief Log new violations. Call from loop() only: logging itself allocates.
+ */
+void allocGuardPoll();
+
+// ============================================================================
+// HEAP SOAK TEST
+// ============================================================================
+
+#define HEAP_SOAK_DEFAULT_HOURS 24
+#define HEAP_SOAK_MAX_HOURS 168
+#define HEAP_SOAK_DEFAULT_FRAMES_PER_MIN 60
+#define HEAP_SOAK_MAX_SAMPLES 25   // Start + up to 24 evenly spaced samples
+
+struct HeapSoakSample {
+    uint32_t simulatedHour;
+    uint32_t freeBytes;
+    uint32_t largestBlock;
+    uint8_t fragmentationPct;   // 100 - largest free block / total free
+};
+
+struct HeapSoakReport {
+    uint32_t simulatedHours = 0;
+    uint32_t framesInjected = 0;
+    uint32_t elapsedMs = 0;
+    uint32_t minFreeBytes = 0;
+    uint8_t maxFragmentationPct = 0;
+    uint32_t guardViolations = 0;     // Violations raised during the soak
+    uint32_t guardAllocations = 0;
+    uint32_t txSuppressed = 0;        // Frames the node tried to transmit
+    uint8_t sampleCount = 0;
+    HeapSoakSample samples[HEAP_SOAK_MAX_SAMPLES];
+};
+
+/**
+ * @brief Feed synthetic tree traffic through the real receive path.
+ *
+ * Simulates simulatedHours of traffic at framesPerMinute, time-compressed
+ * (frames are injected back to back). The frame mix follows the node's role:
+ * the root sees data reports from synthetic descendants; other nodes see
+ * shared I/O updates from their parent plus child reports to forward.
+ * Radio TX is muted for the duration, and the synthetic devices and shared
+ * I/O state are removed/restored afterwards.
+ *
+ * @return false if the node is not configured (HID required)
+ */
+bool heapSoakRun(uint32_t simulatedHours, uint32_t framesPerMinute, HeapSoakReport& report);
+
+/**
+ * @brief True while the calling task is injecting soak frames.
+ *
+ * The receive path then skips everything that would learn from the
+ * synthetic HIDs and MACs, or hold their reports for later: bit leases,
+ * child and topology tables, parent liveness, uplink MACs, I/O slicing and
+ * report aggregation. Real frames on the Wi-Fi task are not affected.
+ */
+bool heapSoakInjecting();
+
+#endif // HEAP_GUARD_H
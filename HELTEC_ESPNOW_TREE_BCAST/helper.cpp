@@ -7,7 +7,7 @@
  */
 #define MODULE_TITLE       "HELP"
 #define MODULE_DEBUG_LEVEL 1
-#define helpLog(msg, lvl) debugPrint(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+#define helpLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
 
 // Status messages
 static String statusMsg1 = "Ready";
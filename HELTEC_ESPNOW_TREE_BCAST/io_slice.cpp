@@ -0,0 +1,211 @@
+#include "io_slice.h"
+#include "debug.h"
+#include "TreeNetwork.h"
+#include "child_table.h"
+#include "report_aggregation.h"
+
+// Logging macros for the I/O slicing module
+#define MODULE_TITLE       "SLICE"
+#define MODULE_DEBUG_LEVEL 1
+#define sliceLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// SUBTREE TABLE
+// ============================================================================
+
+static IoSliceDevice devices[IO_SLICE_MAX_DEVICES];
+static IoSliceStats stats;
+
+// Reports are learned on the Wi-Fi task, updates are sent from either task
+static portMUX_TYPE sliceMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void noteDeviceLocked(uint16_t hid, uint16_t via, uint8_t bitIndex, uint32_t now) {
+    if (hid == UNCONFIGURED_HID || bitIndex >= MAX_DISTRIBUTED_IO_BITS) {
+        return;
+    }
+    int slot = -1;
+    for (int i = 0; i < IO_SLICE_MAX_DEVICES && slot < 0; i++) {
+        if (devices[i].hid == hid) slot = i;
+    }
+    for (int i = 0; i < IO_SLICE_MAX_DEVICES && slot < 0; i++) {
+        if (devices[i].hid == 0) slot = i;
+    }
+    if (slot < 0) {
+        slot = 0;
+        for (int i = 1; i < IO_SLICE_MAX_DEVICES; i++) {
+            if ((int32_t)(devices[i].lastSeenMs - devices[slot].lastSeenMs) < 0) slot = i;
+        }
+    }
+    devices[slot].hid = hid;
+    devices[slot].via = via;
+    devices[slot].bitIndex = bitIndex;
+    devices[slot].lastSeenMs = now;
+}
+
+static bool liveLocked(const IoSliceDevice& device, uint32_t now) {
+    return device.hid != 0 && now - device.lastSeenMs <= IO_SLICE_ENTRY_TIMEOUT_MS;
+}
+
+// ============================================================================
+// LEARNING
+// ============================================================================
+
+void ioSliceNoteFrame(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen) {
+#if ENABLE_IO_SLICING
+    if (!payload) {
+        return;
+    }
+    uint32_t now = millis();
+    uint16_t via = header->broadcaster_hid;
+
+    if (header->msg_type == MSG_DEVICE_DATA_REPORT && payloadLen >= sizeof(DeviceSpecificData)) {
+        const DeviceSpecificData* data = (const DeviceSpecificData*)payload;
+        portENTER_CRITICAL(&sliceMux);
+        noteDeviceLocked(header->src_hid, via, data->bit_index, now);
+        portEXIT_CRITICAL(&sliceMux);
+    } else if (header->msg_type == MSG_DEVICE_DATA_BATCH && payloadLen >= 1) {
+        uint8_t count = payload[0];
+        if (payloadLen != 1 + count * sizeof(AggregatedReportRecord)) {
+            return;
+        }
+        portENTER_CRITICAL(&sliceMux);
+        for (uint8_t i = 0; i < count; i++) {
+            AggregatedReportRecord record;
+            memcpy(&record, payload + 1 + i * sizeof(record), sizeof(record));
+            noteDeviceLocked(record.src_hid, via, record.data.bit_index, now);
+        }
+        portEXIT_CRITICAL(&sliceMux);
+    }
+#endif
+}
+
+// ============================================================================
+// SENDING AND RECEIVING
+// ============================================================================
+
+static void fillEntry(const DistributedIOData& data, uint8_t bitIndex, IoSliceEntry& entry) {
+    uint8_t word = bitIndex / BITS_PER_WORD;
+    uint8_t bit = bitIndex % BITS_PER_WORD;
+    entry.bit_index = bitIndex;
+    entry.inputs = 0;
+    entry.outputs = 0;
+    for (int i = 0; i < MAX_INPUTS; i++) {
+        if ((data.sharedData[i][word] >> bit) & 1) entry.inputs |= 1U << i;
+        if ((data.sharedOutputs[i][word] >> bit) & 1) entry.outputs |= 1U << i;
+    }
+}
+
+void ioSliceSend(const DistributedIOData& data) {
+#if ENABLE_IO_SLICING && ENABLE_CHILD_TABLE
+    uint32_t now = millis();
+    ChildInfo children[CHILD_TABLE_SIZE];
+    uint8_t childCount = childTableGetChildren(children, CHILD_TABLE_SIZE);
+
+    // Bits every live child's subtree needs, and whether each child's own bit is known
+    uint32_t needed[MAX_DISTRIBUTED_IO_BITS / BITS_PER_WORD] = {};
+    uint8_t liveChildren = 0;
+    bool allKnown = true;
+    portENTER_CRITICAL(&sliceMux);
+    for (const IoSliceDevice& device : devices) {
+        if (liveLocked(device, now)) {
+            needed[device.bitIndex / BITS_PER_WORD] |= 1UL << (device.bitIndex % BITS_PER_WORD);
+        }
+    }
+    for (uint8_t i = 0; i < childCount; i++) {
+        if (now - children[i].lastHeardMs > CHILD_TIMEOUT_MS) continue;
+        liveChildren++;
+        bool known = false;
+        for (const IoSliceDevice& device : devices) {
+            if (device.hid == children[i].hid && liveLocked(device, now)) {
+                known = true;
+                break;
+            }
+        }
+        allKnown = allKnown && known;
+    }
+    portEXIT_CRITICAL(&sliceMux);
+
+    if (liveChildren == 0) {
+        portENTER_CRITICAL(&sliceMux);
+        stats.skipped++;
+        portEXIT_CRITICAL(&sliceMux);
+        sliceLog("No live children, I/O update not forwarded", 4);
+        return;
+    }
+
+    uint8_t payload[1 + MAX_DISTRIBUTED_IO_BITS * sizeof(IoSliceEntry)];
+    uint8_t count = 0;
+    for (uint8_t bitIndex = 0; bitIndex < MAX_DISTRIBUTED_IO_BITS; bitIndex++) {
+        if ((needed[bitIndex / BITS_PER_WORD] >> (bitIndex % BITS_PER_WORD)) & 1) {
+            IoSliceEntry entry;
+            fillEntry(data, bitIndex, entry);
+            memcpy(payload + 1 + count * sizeof(IoSliceEntry), &entry, sizeof(entry));
+            count++;
+        }
+    }
+    payload[0] = count;
+    size_t sliceLen = 1 + count * sizeof(IoSliceEntry);
+
+    if (allKnown && sliceLen < sizeof(DistributedIOData)) {
+        TREE_NET.sendBroadcastTreeCommand(MSG_DISTRIBUTED_IO_SLICE, payload, sliceLen);
+        portENTER_CRITICAL(&sliceMux);
+        stats.sliceFrames++;
+        stats.bytesSaved += sizeof(DistributedIOData) - sliceLen;
+        portEXIT_CRITICAL(&sliceMux);
+        return;
+    }
+    portENTER_CRITICAL(&sliceMux);
+    stats.fullFrames++;
+    portEXIT_CRITICAL(&sliceMux);
+#endif
+    TREE_NET.sendBroadcastTreeCommand(MSG_DISTRIBUTED_IO_UPDATE, (const uint8_t*)&data, sizeof(DistributedIOData));
+}
+
+bool ioSliceDecode(const uint8_t* payload, size_t payloadLen, DistributedIOData& out) {
+    if (!payload || payloadLen < 1 || payloadLen != 1 + payload[0] * sizeof(IoSliceEntry)) {
+        return false;
+    }
+    memset(&out, 0, sizeof(out));
+    for (uint8_t i = 0; i < payload[0]; i++) {
+        IoSliceEntry entry;
+        memcpy(&entry, payload + 1 + i * sizeof(IoSliceEntry), sizeof(entry));
+        if (entry.bit_index >= MAX_DISTRIBUTED_IO_BITS) {
+            return false;
+        }
+        uint8_t word = entry.bit_index / BITS_PER_WORD;
+        uint32_t mask = 1UL << (entry.bit_index % BITS_PER_WORD);
+        for (uint32_t pending = entry.inputs; pending; pending &= pending - 1) {
+            out.sharedData[__builtin_ctz(pending)][word] |= mask;
+        }
+        for (uint32_t pending = entry.outputs; pending; pending &= pending - 1) {
+            out.sharedOutputs[__builtin_ctz(pending)][word] |= mask;
+        }
+    }
+    portENTER_CRITICAL(&sliceMux);
+    stats.slicesReceived++;
+    portEXIT_CRITICAL(&sliceMux);
+    return true;
+}
+
+// ============================================================================
+// STATISTICS
+// ============================================================================
+
+void ioSliceGetStats(IoSliceStats& out) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&sliceMux);
+    out = stats;
+    out.deviceCount = 0;
+    for (const IoSliceDevice& device : devices) {
+        if (liveLocked(device, now)) {
+            out.devices[out.deviceCount++] = device;
+        }
+    }
+    portEXIT_CRITICAL(&sliceMux);
+}
+
+void ioSliceResetStats() {
+    portENTER_CRITICAL(&sliceMux);
+    stats = IoSliceStats();
+    portEXIT_CRITICAL(&sliceMux);
+}
@@ -0,0 +1,90 @@
+#ifndef IO_SLICE_H
+#define IO_SLICE_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+
+// ============================================================================
+// I/O SLICING CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Downstream I/O updates carry only the bits the subtree uses.
+ *
+ * Every MSG_DISTRIBUTED_IO_UPDATE used to carry the whole I and Q frame to
+ * every node, though a node only applies Q at its own bit index. Now each
+ * forwarder (the root included) learns the bit index of every device below
+ * it, from the upstream reports and batches it relays. Its downstream update
+ * then goes out in one of three ways:
+ * - Nothing, when no child has been heard for CHILD_TIMEOUT_MS (a leaf).
+ * - A MSG_DISTRIBUTED_IO_SLICE holding only the learned bits: a count, then
+ *   one IoSliceEntry per bit with its I and Q states. This is used when it
+ *   is smaller than the full frame.
+ * - The full frame otherwise. It is also sent when a live child's own bit
+ *   is not known yet, so new children still get their outputs.
+ *
+ * A node that receives a slice sees zero at every bit outside it, in both
+ * I and Q. Displays of the whole shared bitmap on such nodes show their
+ * subtree only.
+ *
+ * Entries not refreshed for IO_SLICE_ENTRY_TIMEOUT_MS are dropped, so a
+ * moved or re-indexed device falls out after a few report intervals.
+ *
+ * Nodes without this code drop slice frames, so update every node.
+ * Needs the child table (ENABLE_CHILD_TABLE) to know which children are live.
+ * Set to 0 to always send the full frame.
+ */
+#define ENABLE_IO_SLICING 1
+
+#define IO_SLICE_MAX_DEVICES        MAX_DISTRIBUTED_IO_BITS
+#define IO_SLICE_ENTRY_TIMEOUT_MS   20000   // Four auto-report intervals
+
+typedef struct {
+    uint8_t  bit_index;
+    uint16_t inputs;            // Bit n: sharedData[n] at bit_index (I)
+    uint16_t outputs;           // Bit n: sharedOutputs[n] at bit_index (Q)
+} __attribute__((packed)) IoSliceEntry;
+
+struct IoSliceDevice {
+    uint16_t hid;
+    uint16_t via;               // Child the report came through
+    uint8_t  bitIndex;
+    uint32_t lastSeenMs;
+};
+
+struct IoSliceStats {
+    uint32_t fullFrames = 0;            // Sent with the whole bitmap
+    uint32_t sliceFrames = 0;           // Sent as a slice
+    uint32_t skipped = 0;               // Not sent: no live children
+    uint32_t bytesSaved = 0;            // Payload bytes saved against full frames
+    uint32_t slicesReceived = 0;
+    uint8_t  deviceCount = 0;
+    IoSliceDevice devices[IO_SLICE_MAX_DEVICES];
+};
+
+// ============================================================================
+// I/O SLICING API
+// ============================================================================
+
+/**
+ * @brief Learn bit indices from an upstream report or batch this node relays
+ *        or, on the root, accepts. Called from the Wi-Fi task.
+ */
+void ioSliceNoteFrame(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen);
+
+/**
+ * @brief Send this node's downstream I/O update: nothing, a slice, or the
+ *        full frame
+ */
+void ioSliceSend(const DistributedIOData& data);
+
+/**
+ * @brief Expand a slice payload; bits not in it are zero
+ * @return false if the payload is malformed
+ */
+bool ioSliceDecode(const uint8_t* payload, size_t payloadLen, DistributedIOData& out);
+
+void ioSliceGetStats(IoSliceStats& out);
+void ioSliceResetStats();
+
+#endif // IO_SLICE_H
@@ -4,7 +4,7 @@
 // Logging macros for the OLED module
 #define MODULE_TITLE       "OLED"
 #define MODULE_DEBUG_LEVEL 3
-#define oledLog(msg,lvl) debugPrint(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+#define oledLog(msg,lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
 
 #if ENABLE_OLED
 // Create a global U8G2 display object
@@ -19,9 +19,124 @@ U8G2_MIRROR_VERTICAL	Display content is vertically mirrored (v2.29.x)
 
 */
 
-U8G2_SSD1306_128X64_NONAME_F_SW_I2C display(
+U8G2_SSD1306_128X64_NONAME_F_HW_I2C display(
     U8G2_R0,
-    /* clock=*/SCL_OLED, /* data=*/SDA_OLED, /* reset=*/RST_OLED);
+    /* reset=*/RST_OLED, /* clock=*/SCL_OLED, /* data=*/SDA_OLED);
+
+// ============================================================================
+// RENDER PIPELINE
+// ============================================================================
+// loop() draws into the U8G2 buffer and submits a copy (pendingFrame). The
+// render task diffs it tile by tile against what the panel shows (panelFrame)
+// and sends only the changed 8x8 tiles, one run per page.
+
+static uint8_t pendingFrame[OLED_FRAME_BYTES];
+static uint8_t panelFrame[OLED_FRAME_BYTES];   // Render task only
+static bool framePending = false;
+static portMUX_TYPE frameMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t renderTaskHandle = nullptr;
+static OledRenderStats renderStats;
+
+static void transmitPendingFrame() {
+    uint16_t dirtyMask[OLED_PAGES];
+    uint8_t dirtyTiles = 0;
+    
+    // Diff and adopt the pending frame in one short critical section; the
+    // slow I2C part below runs from panelFrame, which only this task touches
+    portENTER_CRITICAL(&frameMux);
+    if (!framePending) {
+        portEXIT_CRITICAL(&frameMux);
+        return;
+    }
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        dirtyMask[page] = 0;
+        for (uint8_t tile = 0; tile < OLED_TILE_COLUMNS; tile++) {
+            size_t offset = (page * OLED_TILE_COLUMNS + tile) * 8;
+            if (memcmp(pendingFrame + offset, panelFrame + offset, 8) != 0) {
+                memcpy(panelFrame + offset, pendingFrame + offset, 8);
+                dirtyMask[page] |= (1 << tile);
+                dirtyTiles++;
+            }
+        }
+    }
+    framePending = false;
+    portEXIT_CRITICAL(&frameMux);
+    
+    if (dirtyTiles == 0) {
+        portENTER_CRITICAL(&frameMux);
+        renderStats.framesUnchanged++;
+        renderStats.lastDirtyTiles = 0;
+        portEXIT_CRITICAL(&frameMux);
+        return;
+    }
+    
+    uint32_t transferStart = micros();
+    u8x8_t* u8x8 = display.getU8x8();
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        uint16_t mask = dirtyMask[page];
+        uint8_t tile = 0;
+        while (mask && tile < OLED_TILE_COLUMNS) {
+            if (!(mask & (1 << tile))) {
+                tile++;
+                continue;
+            }
+            uint8_t runStart = tile;
+            while (tile < OLED_TILE_COLUMNS && (mask & (1 << tile))) {
+                mask &= ~(1 << tile);
+                tile++;
+            }
+            u8x8_DrawTile(u8x8, runStart, page, tile - runStart,
+                          panelFrame + (page * OLED_TILE_COLUMNS + runStart) * 8);
+        }
+    }
+    uint32_t transferUs = micros() - transferStart;
+    
+    portENTER_CRITICAL(&frameMux);
+    renderStats.framesSent++;
+    renderStats.tilesSent += dirtyTiles;
+    renderStats.bytesSent += dirtyTiles * 8;
+    renderStats.lastDirtyTiles = dirtyTiles;
+    renderStats.lastTransferUs = transferUs;
+    if (transferUs > renderStats.maxTransferUs) {
+        renderStats.maxTransferUs = transferUs;
+    }
+    portEXIT_CRITICAL(&frameMux);
+}
+
+static void renderTask(void* param) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        transmitPendingFrame();
+    }
+}
+
+void oledSubmitFrame(uint32_t composeUs) {
+    const uint8_t* buffer = display.getBufferPtr();
+    if (!buffer || !renderTaskHandle) {
+        return;
+    }
+    
+    portENTER_CRITICAL(&frameMux);
+    if (framePending) {
+        renderStats.framesSkipped++;
+    }
+    memcpy(pendingFrame, buffer, OLED_FRAME_BYTES);
+    framePending = true;
+    renderStats.framesSubmitted++;
+    renderStats.lastComposeUs = composeUs;
+    if (composeUs > renderStats.maxComposeUs) {
+        renderStats.maxComposeUs = composeUs;
+    }
+    portEXIT_CRITICAL(&frameMux);
+    
+    xTaskNotifyGive(renderTaskHandle);
+}
+
+void oledGetRenderStats(OledRenderStats& out) {
+    portENTER_CRITICAL(&frameMux);
+    out = renderStats;
+    portEXIT_CRITICAL(&frameMux);
+}
 
 void VextON(){
     // If your board uses a transistor to power the display externally:
@@ -39,12 +154,52 @@ void VextOFF(){
 void setupDisplay(){
     oledLog("setupDisplay => initializing OLED",3); // INFO
     VextON(); // if you do external power
-    display.begin();
+    display.setBusClock(OLED_I2C_CLOCK_HZ);
+    display.begin();   // Clears the panel, so panelFrame (all zero) matches it
     display.setFont(u8g2_font_ncenB08_tr);
     display.setCursor(0,0);
+    
+    if (!renderTaskHandle &&
+        xTaskCreatePinnedToCore(renderTask, "oled_render", OLED_RENDER_TASK_STACK, nullptr,
+                                OLED_RENDER_TASK_PRIORITY, &renderTaskHandle, OLED_RENDER_TASK_CORE) != pdPASS) {
+        renderTaskHandle = nullptr;
+        oledLog("Failed to start render task - display updates disabled",1); // ERROR
+    }
     oledLog("OLED display ready",3); // INFO
 }
 
+// Display init task: panel reset and init take long enough that it pays to
+// run them while the radio starts up on the other core.
+static SemaphoreHandle_t displayReadySem = nullptr;
+static volatile bool displayReady = false;
+
+static void displayInitTask(void* param) {
+    setupDisplay();
+    displayReady = true;
+    xSemaphoreGive(displayReadySem);
+    vTaskDelete(nullptr);
+}
+
+void setupDisplayAsync(){
+    displayReady = false;
+    if (!displayReadySem) {
+        displayReadySem = xSemaphoreCreateBinary();
+    }
+    if (!displayReadySem ||
+        xTaskCreatePinnedToCore(displayInitTask, "oled_init", 4096, nullptr, 1, nullptr, 0) != pdPASS) {
+        oledLog("Display init task failed, initializing inline",2); // WARNING
+        setupDisplay();
+        displayReady = true;
+    }
+}
+
+void waitForDisplayReady(){
+    // No timeout: until the init task finishes it owns U8G2 and the I2C bus
+    while (!displayReady && displayReadySem) {
+        xSemaphoreTake(displayReadySem, portMAX_DELAY);
+    }
+}
+
 bool isOLEDEnabled() {
     return true;
 }
@@ -64,6 +219,20 @@ void setupDisplay(){
     oledLog("setupDisplay => OLED disabled, no-op",3); // INFO
 }
 
+void setupDisplayAsync(){
+    setupDisplay();
+}
+
+void waitForDisplayReady(){
+}
+
+void oledSubmitFrame(uint32_t composeUs){
+}
+
+void oledGetRenderStats(OledRenderStats& out){
+    out = OledRenderStats();
+}
+
 bool isOLEDEnabled() {
     return false;
 }
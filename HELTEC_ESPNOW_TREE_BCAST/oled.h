@@ -22,20 +22,81 @@
 // Button pin - using GPIO_0 (boot/prog button)
 #define BUTTON_PIN   GPIO_NUM_0    // Keep as GPIO_0 for boot/prog button
 
+// ============================================================================
+// RENDER CONFIGURATION
+// ============================================================================
+
+#define OLED_I2C_CLOCK_HZ          400000   // SSD1306 fast-mode I2C
+#define OLED_RENDER_TASK_PRIORITY  1        // Below the Wi-Fi task and loop()
+#define OLED_RENDER_TASK_CORE      0
+#define OLED_RENDER_TASK_STACK     3072
+
+#define OLED_TILE_COLUMNS          16       // 128 px / 8
+#define OLED_PAGES                 8        // 64 px / 8
+#define OLED_FRAME_BYTES           (OLED_TILE_COLUMNS * OLED_PAGES * 8)
+
 #if ENABLE_OLED
 /**
  * @brief The main U8G2 display object for a 128x64 SSD1306.
  *        Adjust the constructor as needed for your hardware/board.
+ *
+ * Drawing calls only touch the RAM frame buffer. Never call sendBuffer():
+ * hand finished frames to the render task with oledSubmitFrame().
  */
-extern U8G2_SSD1306_128X64_NONAME_F_SW_I2C display;
+extern U8G2_SSD1306_128X64_NONAME_F_HW_I2C display;
 #endif
 
+/**
+ * @brief Frame pipeline counters (compose = drawing in loop(), transfer =
+ *        I2C time in the render task)
+ */
+struct OledRenderStats {
+    uint32_t framesSubmitted = 0;
+    uint32_t framesSent = 0;          // Frames with at least one dirty tile
+    uint32_t framesUnchanged = 0;     // Frames identical to what's on the panel
+    uint32_t framesSkipped = 0;       // Overwritten before the task picked them up
+    uint32_t tilesSent = 0;
+    uint32_t bytesSent = 0;           // Tile payload bytes (excludes addressing)
+    uint32_t lastComposeUs = 0;
+    uint32_t maxComposeUs = 0;
+    uint32_t lastTransferUs = 0;
+    uint32_t maxTransferUs = 0;
+    uint8_t lastDirtyTiles = 0;
+};
+
 /**
  * @brief Initialize the display (powering on, setting fonts, etc.).
  *        If OLED is disabled, this becomes a no-op.
  */
 void setupDisplay();
 
+/**
+ * @brief Run setupDisplay() in a background task so it overlaps the rest of
+ *        setup(). Nothing may draw until waitForDisplayReady() returns.
+ *        Falls back to a blocking setupDisplay() if the task can't be created.
+ */
+void setupDisplayAsync();
+
+/**
+ * @brief Block until the init task started by setupDisplayAsync() has finished.
+ *        There is no timeout: the task drives U8G2 and I2C until then, so
+ *        nothing else may touch the display.
+ */
+void waitForDisplayReady();
+
+/**
+ * @brief Hand the current U8G2 buffer to the render task. Never blocks on I2C:
+ *        the frame is copied and the caller returns immediately. A frame not
+ *        yet picked up by the task is replaced by the newer one.
+ * @param composeUs Time the caller spent drawing the frame (for stats)
+ */
+void oledSubmitFrame(uint32_t composeUs);
+
+/**
+ * @brief Copy the frame pipeline counters
+ */
+void oledGetRenderStats(OledRenderStats& out);
+
 /**
  * @brief Example functions to toggle external power if your board has it.
  *        If OLED is disabled, these become no-ops.
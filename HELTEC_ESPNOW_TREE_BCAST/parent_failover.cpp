@@ -0,0 +1,642 @@
+#include "parent_failover.h"
+#include "debug.h"
+#include "espnow_wrapper.h"
+#include "channel_bridge.h"
+
+// Logging macros for the parent failover module
+#define MODULE_TITLE       "FAILOVER"
+#define MODULE_DEBUG_LEVEL 1
+#define failoverLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// FAILOVER STATE
+// ============================================================================
+
+#define FAILOVER_CANDIDATE_SKIP_MS  5000    // Refused candidates are left alone this long
+#define FAILOVER_PENDING_ACKS       4
+
+struct FailoverCandidate {
+    uint16_t hid;               // 0 = unused
+    uint16_t upstreamHID;
+    uint8_t  flags;
+    int8_t   rssi;
+    uint32_t lastHeardMs;
+    uint32_t skipUntilMs;
+};
+
+struct FailoverAdoption {
+    uint16_t hid;               // 0 = unused
+    uint32_t lastRenewMs;
+};
+
+struct FailoverPendingAck {
+    uint16_t hid;
+    uint8_t  status;
+    uint8_t  nonce;
+};
+
+// Orphan side (loop task, except where noted)
+static volatile uint8_t state = FAILOVER_STATE_NORMAL;
+static uint16_t configuredHID = 0;
+static volatile uint16_t fosterHID = 0;
+static volatile uint32_t lastParentHeardMs = 0;     // Wi-Fi task
+static volatile uint32_t lastParentOkMs = 0;        // Wi-Fi task: parent beacon with a path to the root
+static volatile uint32_t lastFosterHeardMs = 0;     // Wi-Fi task
+static uint32_t lossDetectedMs = 0;
+static uint32_t upstreamLostAtMs = 0;               // Last frame from the parent (or foster) that was lost
+static uint32_t adoptedAtMs = 0;
+static uint32_t lastRenewMs = 0;
+static uint32_t lastBeaconMs = 0;
+
+// Outstanding adopt request; the ACK fields are written by the Wi-Fi task
+static uint16_t requestHID = 0;
+static uint8_t requestNonce = 0;
+static uint32_t requestSentMs = 0;
+static bool ackReceived = false;
+static uint8_t ackStatus = ADOPT_STATUS_ACCEPTED;
+static uint32_t ackMs = 0;
+
+static FailoverCandidate candidates[FAILOVER_MAX_CANDIDATES];
+
+// Foster side
+static FailoverAdoption adoptions[FAILOVER_MAX_ADOPTED];
+static FailoverPendingAck pendingAcks[FAILOVER_PENDING_ACKS];
+static uint8_t pendingAckCount = 0;
+
+static FailoverStatus stats;
+
+// Beacons and adopt frames arrive on the Wi-Fi task, everything else runs in loop()
+static portMUX_TYPE failoverMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static uint8_t missThreshold() {
+    uint8_t misses = DATA_MGR.getNodeConfig().failoverMisses;
+    if (misses == 0) return FAILOVER_DEFAULT_MISSES;
+    return misses > FAILOVER_MAX_MISSES ? FAILOVER_MAX_MISSES : misses;
+}
+
+// A bridge only hears its parent while on the parent's channel (channel_bridge.h)
+static uint32_t silenceLimitMs() {
+    return (uint32_t)missThreshold() * FAILOVER_BEACON_INTERVAL_MS * 100 / bridgeParentListenPct();
+}
+
+/**
+ * @brief Tree depth of a HID; the root is depth 0
+ */
+static int8_t hidDepth(uint16_t hid) {
+    return treeAddrDepth(hid);
+}
+
+/**
+ * @brief True if hid lies strictly below ancestor in the HID tree
+ * @note Arithmetic, so it is safe on the receive path
+ */
+static bool isBelow(uint16_t hid, uint16_t ancestor) {
+    if (ancestor == 0 || hid == BROADCAST_HID) return false;
+    return treeAddrIsAncestor(ancestor, hid);
+}
+
+static bool parentAlive(uint32_t now) {
+    return (int32_t)(now - lastParentHeardMs) < (int32_t)silenceLimitMs();
+}
+
+/**
+ * @brief True if this node can currently carry traffic to the root
+ */
+static bool hasUpstreamPath(uint32_t now) {
+    if (DATA_MGR.isRoot()) return true;
+    if (state == FAILOVER_STATE_ADOPTED) return true;
+    return state == FAILOVER_STATE_NORMAL && parentAlive(now);
+}
+
+static uint8_t adoptedCountLocked() {
+    uint8_t count = 0;
+    for (const FailoverAdoption& adoption : adoptions) {
+        if (adoption.hid != 0) count++;
+    }
+    return count;
+}
+
+// ============================================================================
+// RECEIVE PATH (Wi-Fi task)
+// ============================================================================
+
+void failoverNoteFrame(const TreeMessageHeader* header) {
+#if ENABLE_PARENT_FAILOVER
+    uint16_t broadcaster = header->broadcaster_hid;
+    if (broadcaster == 0) return;
+    uint32_t now = millis();
+    if (broadcaster == DATA_MGR.getParentHID()) {
+        lastParentHeardMs = now;
+    }
+    if (broadcaster == fosterHID) {
+        lastFosterHeardMs = now;
+    }
+#endif
+}
+
+static void handleBeacon(const TreeMessageHeader* header, const LinkBeaconPayload* beacon, int8_t rssi) {
+    uint16_t hid = header->broadcaster_hid;
+    uint32_t now = millis();
+
+    if (hid == DATA_MGR.getParentHID() && (beacon->flags & FAILOVER_BEACON_UPSTREAM_OK)) {
+        lastParentOkMs = now;
+    }
+
+    portENTER_CRITICAL(&failoverMux);
+    int slot = -1;
+    int freeSlot = -1;
+    int oldest = 0;
+    for (int i = 0; i < FAILOVER_MAX_CANDIDATES; i++) {
+        if (candidates[i].hid == hid) {
+            slot = i;
+            break;
+        }
+        if (candidates[i].hid == 0 && freeSlot < 0) freeSlot = i;
+        if ((int32_t)(candidates[i].lastHeardMs - candidates[oldest].lastHeardMs) < 0) oldest = i;
+    }
+    if (slot < 0) {
+        // New neighbour: take a free entry or replace the one heard least recently
+        slot = (freeSlot >= 0) ? freeSlot : oldest;
+        candidates[slot].hid = hid;
+        candidates[slot].skipUntilMs = now;
+    }
+    candidates[slot].upstreamHID = beacon->upstreamHID;
+    candidates[slot].flags = beacon->flags;
+    candidates[slot].rssi = rssi;
+    candidates[slot].lastHeardMs = now;
+    portEXIT_CRITICAL(&failoverMux);
+}
+
+static void handleAdoptRequest(const TreeMessageHeader* header, const AdoptRequestPayload* request) {
+    uint16_t hid = header->src_hid;
+    uint16_t myHID = DATA_MGR.getMyHID();
+    uint32_t now = millis();
+
+    // Decided before taking the lock; reads only loop-owned scalars
+    uint8_t status = ADOPT_STATUS_ACCEPTED;
+    if (isBelow(myHID, hid) || hid == fosterHID) {
+        status = ADOPT_STATUS_LOOP;
+    } else if (!hasUpstreamPath(now)) {
+        status = ADOPT_STATUS_NO_PATH;
+    }
+
+    portENTER_CRITICAL(&failoverMux);
+    int slot = -1;
+    int freeSlot = -1;
+    for (int i = 0; i < FAILOVER_MAX_ADOPTED; i++) {
+        if (adoptions[i].hid == hid) slot = i;
+        if (adoptions[i].hid == 0 && freeSlot < 0) freeSlot = i;
+    }
+
+    if (request->action == ADOPT_ACTION_RELEASE) {
+        if (slot >= 0) adoptions[slot].hid = 0;
+        portEXIT_CRITICAL(&failoverMux);
+        return;
+    }
+
+    if (status == ADOPT_STATUS_ACCEPTED) {
+        if (slot < 0) slot = freeSlot;
+        if (slot < 0) {
+            status = ADOPT_STATUS_FULL;
+        } else {
+            adoptions[slot].hid = hid;
+            adoptions[slot].lastRenewMs = now;
+        }
+    } else if (slot >= 0) {
+        adoptions[slot].hid = 0;
+    }
+
+    // Dropped if full; the requester times out and asks again
+    if (pendingAckCount < FAILOVER_PENDING_ACKS) {
+        FailoverPendingAck& ack = pendingAcks[pendingAckCount++];
+        ack.hid = hid;
+        ack.status = status;
+        ack.nonce = request->nonce;
+    }
+    portEXIT_CRITICAL(&failoverMux);
+}
+
+static void handleAdoptAck(const TreeMessageHeader* header, const AdoptAckPayload* ack) {
+    portENTER_CRITICAL(&failoverMux);
+    if (header->src_hid == requestHID && ack->nonce == requestNonce && !ackReceived) {
+        ackReceived = true;
+        ackStatus = ack->status;
+        ackMs = millis();
+    }
+    portEXIT_CRITICAL(&failoverMux);
+}
+
+bool failoverHandleFrame(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen, int8_t rssi) {
+#if ENABLE_PARENT_FAILOVER
+    if (!DATA_MGR.isHIDConfigured() || header->broadcaster_hid == DATA_MGR.getMyHID()) {
+        return false;
+    }
+
+    switch (static_cast<TreeMessageType>(header->msg_type)) {
+        case MSG_LINK_BEACON:
+            if (payloadLen != sizeof(LinkBeaconPayload)) return false;
+            handleBeacon(header, (const LinkBeaconPayload*)payload, rssi);
+            return true;
+
+        case MSG_ADOPT_REQUEST:
+            if (header->dest_hid != DATA_MGR.getMyHID() || payloadLen != sizeof(AdoptRequestPayload)) return false;
+            handleAdoptRequest(header, (const AdoptRequestPayload*)payload);
+            return true;
+
+        case MSG_ADOPT_ACK:
+            if (header->dest_hid != DATA_MGR.getMyHID() || payloadLen != sizeof(AdoptAckPayload)) return false;
+            handleAdoptAck(header, (const AdoptAckPayload*)payload);
+            return true;
+
+        default:
+            return false;
+    }
+#else
+    return false;
+#endif
+}
+
+// ============================================================================
+// QUERIES (any task)
+// ============================================================================
+
+uint16_t failoverGetFosterHID() {
+    return fosterHID;
+}
+
+bool failoverIsAdopted(uint16_t hid) {
+#if ENABLE_PARENT_FAILOVER
+    if (hid == 0) return false;
+    bool adopted = false;
+    portENTER_CRITICAL(&failoverMux);
+    for (const FailoverAdoption& adoption : adoptions) {
+        if (adoption.hid == hid) {
+            adopted = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&failoverMux);
+    return adopted;
+#else
+    return false;
+#endif
+}
+
+bool failoverCoversHID(uint16_t hid) {
+#if ENABLE_PARENT_FAILOVER
+    bool covered = false;
+    portENTER_CRITICAL(&failoverMux);
+    for (const FailoverAdoption& adoption : adoptions) {
+        if (adoption.hid != 0 && (hid == adoption.hid || isBelow(hid, adoption.hid))) {
+            covered = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&failoverMux);
+    return covered;
+#else
+    return false;
+#endif
+}
+
+// ============================================================================
+// LOOP TASK
+// ============================================================================
+
+static void sendBeacon(uint32_t now) {
+    LinkBeaconPayload beacon;
+    beacon.upstreamHID = DATA_MGR.isRoot() ? 0 : (fosterHID ? fosterHID : DATA_MGR.getParentHID());
+    beacon.flags = hasUpstreamPath(now) ? FAILOVER_BEACON_UPSTREAM_OK : 0;
+    portENTER_CRITICAL(&failoverMux);
+    beacon.adoptedCount = adoptedCountLocked();
+    portEXIT_CRITICAL(&failoverMux);
+    sendTreeCommand(BROADCAST_HID, MSG_LINK_BEACON, (const uint8_t*)&beacon, sizeof(beacon));
+}
+
+static void sendPendingAcks() {
+    FailoverPendingAck acks[FAILOVER_PENDING_ACKS];
+    portENTER_CRITICAL(&failoverMux);
+    uint8_t count = pendingAckCount;
+    memcpy(acks, pendingAcks, sizeof(FailoverPendingAck) * count);
+    pendingAckCount = 0;
+    portEXIT_CRITICAL(&failoverMux);
+
+    for (uint8_t i = 0; i < count; i++) {
+        AdoptAckPayload ack;
+        ack.status = acks[i].status;
+        ack.nonce = acks[i].nonce;
+        sendTreeCommand(acks[i].hid, MSG_ADOPT_ACK, (const uint8_t*)&ack, sizeof(ack));
+        if (acks[i].status == ADOPT_STATUS_ACCEPTED) {
+            failoverLog("Fostering " + DATA_MGR.formatHID(acks[i].hid), 3);
+        } else {
+            failoverLog("Refused to foster " + DATA_MGR.formatHID(acks[i].hid) + " (" + String(acks[i].status) + ")", 2);
+        }
+    }
+}
+
+static void expireAdoptions(uint32_t now) {
+    portENTER_CRITICAL(&failoverMux);
+    for (FailoverAdoption& adoption : adoptions) {
+        if (adoption.hid != 0 && now - adoption.lastRenewMs > FAILOVER_ADOPTION_TIMEOUT_MS) {
+            adoption.hid = 0;
+        }
+    }
+    portEXIT_CRITICAL(&failoverMux);
+}
+
+/**
+ * @brief Best neighbour to ask for adoption, or 0 if none qualifies
+ *
+ * Downstream unicasts for this node follow its own ancestors (each forwards
+ * only to its descendants), so a foster must be on that path: an ancestor,
+ * or a child of an ancestor that still hangs off its real parent. A cousin
+ * would forward upstream traffic but never receive anything for us.
+ *
+ * Fewest hops to the root first, then the parent's siblings, then signal.
+ */
+static uint16_t pickCandidate(uint32_t now) {
+    uint16_t myHID = DATA_MGR.getMyHID();
+    uint16_t parentHID = DATA_MGR.getParentHID();
+    uint32_t limit = silenceLimitMs();
+
+    uint16_t best = 0;
+    int8_t bestDepth = 0;
+    bool bestSibling = false;
+    int8_t bestRssi = 0;
+
+    portENTER_CRITICAL(&failoverMux);
+    for (const FailoverCandidate& candidate : candidates) {
+        uint16_t hid = candidate.hid;
+        if (hid == 0 || hid == myHID || hid == parentHID) continue;
+        if (now - candidate.lastHeardMs > limit) continue;
+        if ((int32_t)(now - candidate.skipUntilMs) < 0) continue;
+        if (!(candidate.flags & FAILOVER_BEACON_UPSTREAM_OK)) continue;
+        // Anything whose path to the root runs through this node would loop
+        if (isBelow(hid, myHID) || candidate.upstreamHID == myHID || isBelow(candidate.upstreamHID, myHID)) continue;
+        // Must be reachable from the root along this node's own ancestry
+        if (!isBelow(myHID, hid) &&
+            !(isBelow(myHID, treeAddrParent(hid)) && candidate.upstreamHID == treeAddrParent(hid))) continue;
+
+        int8_t depth = hidDepth(hid);
+        bool sibling = (treeAddrParent(hid) == treeAddrParent(parentHID));
+        bool better = best == 0 ||
+                      depth < bestDepth ||
+                      (depth == bestDepth && sibling && !bestSibling) ||
+                      (depth == bestDepth && sibling == bestSibling && candidate.rssi > bestRssi);
+        if (better) {
+            best = hid;
+            bestDepth = depth;
+            bestSibling = sibling;
+            bestRssi = candidate.rssi;
+        }
+    }
+    portEXIT_CRITICAL(&failoverMux);
+    return best;
+}
+
+static void skipCandidate(uint16_t hid, uint32_t now) {
+    portENTER_CRITICAL(&failoverMux);
+    for (FailoverCandidate& candidate : candidates) {
+        if (candidate.hid == hid) {
+            candidate.skipUntilMs = now + FAILOVER_CANDIDATE_SKIP_MS;
+        }
+    }
+    portEXIT_CRITICAL(&failoverMux);
+}
+
+static void sendAdoptRequest(uint16_t hid, uint8_t action, uint32_t now) {
+    AdoptRequestPayload request;
+    request.action = action;
+    request.nonce = 0;
+
+    if (action == ADOPT_ACTION_ATTACH) {
+        portENTER_CRITICAL(&failoverMux);
+        requestHID = hid;
+        requestNonce++;
+        ackReceived = false;
+        portEXIT_CRITICAL(&failoverMux);
+        request.nonce = requestNonce;
+        requestSentMs = now;
+    }
+    sendTreeCommand(hid, MSG_ADOPT_REQUEST, (const uint8_t*)&request, sizeof(request));
+}
+
+static void clearRequest() {
+    portENTER_CRITICAL(&failoverMux);
+    requestHID = 0;
+    ackReceived = false;
+    portEXIT_CRITICAL(&failoverMux);
+}
+
+/**
+ * @brief Collect the ACK for the outstanding request
+ * @return true if an ACK arrived (status and time in the out parameters)
+ */
+static bool takeAck(uint8_t& status, uint32_t& receivedMs) {
+    bool received;
+    portENTER_CRITICAL(&failoverMux);
+    received = ackReceived && requestHID != 0;
+    status = ackStatus;
+    receivedMs = ackMs;
+    portEXIT_CRITICAL(&failoverMux);
+    return received;
+}
+
+static void enterSearching(uint32_t now) {
+    state = FAILOVER_STATE_SEARCHING;
+    fosterHID = 0;
+    lossDetectedMs = now;
+    clearRequest();
+}
+
+static void returnToParent(const char* reason) {
+    stats.recoveries++;
+    state = FAILOVER_STATE_NORMAL;
+    fosterHID = 0;
+    clearRequest();
+    failoverLog(String("Back on parent ") + DATA_MGR.formatHID(DATA_MGR.getParentHID()) + " (" + reason + ")", 1);
+    DATA_MGR.updateStatus("Parent restored");
+}
+
+static void updateSearching(uint32_t now) {
+    // Parent came back before anyone took us in
+    if ((int32_t)(lastParentHeardMs - lossDetectedMs) > 0) {
+        returnToParent("recovered while searching");
+        return;
+    }
+
+    if (requestHID != 0) {
+        uint8_t status;
+        uint32_t receivedMs;
+        if (takeAck(status, receivedMs)) {
+            uint16_t foster = requestHID;
+            clearRequest();
+            if (status != ADOPT_STATUS_ACCEPTED) {
+                stats.refusals++;
+                skipCandidate(foster, now);
+                failoverLog(DATA_MGR.formatHID(foster) + " refused adoption (" + String(status) + ")", 2);
+                return;
+            }
+
+            state = FAILOVER_STATE_ADOPTED;
+            lastFosterHeardMs = receivedMs;
+            fosterHID = foster;
+            adoptedAtMs = receivedMs;
+            lastRenewMs = receivedMs;
+            stats.failovers++;
+            stats.lastOutageMs = receivedMs - upstreamLostAtMs;
+            stats.lastAdoptRttMs = receivedMs - requestSentMs;
+            stats.lastAddedHops = hidDepth(foster) - hidDepth(DATA_MGR.getParentHID());
+            failoverLog("Adopted by " + DATA_MGR.formatHID(foster) + " after " + String(stats.lastOutageMs) +
+                        " ms outage, " + String(stats.lastAddedHops) + " added hops, handshake " +
+                        String(stats.lastAdoptRttMs) + " ms", 1);
+            DATA_MGR.updateStatus("Foster " + DATA_MGR.formatHID(foster));
+            return;
+        }
+        if (now - requestSentMs < FAILOVER_ADOPT_TIMEOUT_MS) {
+            return;
+        }
+        stats.refusals++;
+        skipCandidate(requestHID, now);
+        clearRequest();
+    }
+
+    uint16_t candidate = pickCandidate(now);
+    if (candidate != 0) {
+        failoverLog("Asking " + DATA_MGR.formatHID(candidate) + " to adopt", 2);
+        sendAdoptRequest(candidate, ADOPT_ACTION_ATTACH, now);
+    }
+}
+
+static void updateAdopted(uint32_t now) {
+    // Real parent is back with a path to the root
+    if ((int32_t)(lastParentOkMs - adoptedAtMs) > 0) {
+        sendAdoptRequest(fosterHID, ADOPT_ACTION_RELEASE, now);
+        returnToParent("parent beacon");
+        return;
+    }
+
+    if ((int32_t)(now - lastFosterHeardMs) >= (int32_t)silenceLimitMs()) {
+        failoverLog("Foster " + DATA_MGR.formatHID(fosterHID) + " went silent", 1);
+        skipCandidate(fosterHID, now);
+        upstreamLostAtMs = lastFosterHeardMs;
+        enterSearching(now);
+        return;
+    }
+
+    if (requestHID != 0) {
+        uint8_t status;
+        uint32_t receivedMs;
+        if (takeAck(status, receivedMs)) {
+            clearRequest();
+            if (status != ADOPT_STATUS_ACCEPTED) {
+                failoverLog("Foster " + DATA_MGR.formatHID(fosterHID) + " dropped us (" + String(status) + ")", 1);
+                stats.refusals++;
+                skipCandidate(fosterHID, now);
+                upstreamLostAtMs = now;
+                enterSearching(now);
+            }
+        } else if (now - requestSentMs >= FAILOVER_ADOPT_TIMEOUT_MS) {
+            clearRequest();     // Renewals are retried on schedule
+        }
+    } else if (now - lastRenewMs >= FAILOVER_RENEW_MS) {
+        lastRenewMs = now;
+        sendAdoptRequest(fosterHID, ADOPT_ACTION_ATTACH, now);
+    }
+}
+
+void failoverUpdate() {
+#if ENABLE_PARENT_FAILOVER
+    if (!DATA_MGR.isHIDConfigured()) {
+        return;
+    }
+
+    uint32_t now = millis();
+    uint16_t myHID = DATA_MGR.getMyHID();
+    if (myHID != configuredHID) {
+        // New identity: start over and give the new parent a full window
+        configuredHID = myHID;
+        state = FAILOVER_STATE_NORMAL;
+        fosterHID = 0;
+        lastParentHeardMs = now;
+        clearRequest();
+        portENTER_CRITICAL(&failoverMux);
+        memset(candidates, 0, sizeof(candidates));
+        memset(adoptions, 0, sizeof(adoptions));
+        pendingAckCount = 0;
+        portEXIT_CRITICAL(&failoverMux);
+    }
+
+    sendPendingAcks();
+    expireAdoptions(now);
+
+    if (now - lastBeaconMs >= FAILOVER_BEACON_INTERVAL_MS) {
+        lastBeaconMs = now;
+        sendBeacon(now);
+    }
+
+    if (DATA_MGR.isRoot()) {
+        return;
+    }
+
+    switch (state) {
+        case FAILOVER_STATE_NORMAL:
+            if (!parentAlive(now)) {
+                upstreamLostAtMs = lastParentHeardMs;
+                enterSearching(now);
+                stats.lastDetectMs = now - lastParentHeardMs;
+                failoverLog("Parent " + DATA_MGR.formatHID(DATA_MGR.getParentHID()) + " silent for " +
+                            String(stats.lastDetectMs) + " ms, looking for a foster", 1);
+                DATA_MGR.updateStatus("Parent lost");
+                updateSearching(now);
+            }
+            break;
+
+        case FAILOVER_STATE_SEARCHING:
+            updateSearching(now);
+            break;
+
+        case FAILOVER_STATE_ADOPTED:
+            updateAdopted(now);
+            break;
+    }
+#endif
+}
+
+// ============================================================================
+// STATUS
+// ============================================================================
+
+void failoverGetStatus(FailoverStatus& out) {
+    uint32_t now = millis();
+    out = stats;
+    out.state = state;
+    out.missThreshold = missThreshold();
+    out.parentHID = DATA_MGR.getParentHID();
+    out.fosterHID = fosterHID;
+    out.parentSilentMs = DATA_MGR.isRoot() ? 0 : now - lastParentHeardMs;
+
+    out.candidates = 0;
+    out.adoptedCount = 0;
+    portENTER_CRITICAL(&failoverMux);
+    for (const FailoverCandidate& candidate : candidates) {
+        if (candidate.hid != 0 && now - candidate.lastHeardMs <= silenceLimitMs()) out.candidates++;
+    }
+    for (const FailoverAdoption& adoption : adoptions) {
+        if (adoption.hid != 0) out.adoptedHIDs[out.adoptedCount++] = adoption.hid;
+    }
+    portEXIT_CRITICAL(&failoverMux);
+}
+
+const char* failoverStateName(uint8_t failoverState) {
+    switch (failoverState) {
+        case FAILOVER_STATE_NORMAL:    return "NORMAL";
+        case FAILOVER_STATE_SEARCHING: return "SEARCHING";
+        case FAILOVER_STATE_ADOPTED:   return "ADOPTED";
+        default:                       return "UNKNOWN";
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef PARENT_FAILOVER_H
+#define PARENT_FAILOVER_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+
+// ============================================================================
+// PARENT FAILOVER CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Temporary re-attachment to another upstream node when the parent dies.
+ *
+ * Routing follows the tree address (treeAddrParent() in tree_address.h), so a
+ * dead parent normally cuts off its whole subtree. With failover enabled:
+ *
+ * 1. Every node broadcasts a small MSG_LINK_BEACON every
+ *    FAILOVER_BEACON_INTERVAL_MS. The beacon says whether the node currently
+ *    has a working path to the root.
+ * 2. A node counts any frame whose broadcaster is its parent as proof of
+ *    life. After the configured number of beacon intervals with nothing from
+ *    the parent (NodeConfigRecord::failoverMisses), the parent is lost.
+ * 3. The node then asks the best neighbour it can hear to act as a foster
+ *    parent (MSG_ADOPT_REQUEST). Neighbours that are closer to the root come
+ *    first, then the parent's siblings, then stronger signal. A neighbour is
+ *    skipped if it is in this node's subtree or has no path to the root. It
+ *    must also be an ancestor of this node, or a child of one attached to its
+ *    real parent: downstream frames only travel along this node's ancestors,
+ *    so a cousin could never pass them on.
+ * 4. The foster answers with MSG_ADOPT_ACK. From then on it treats the
+ *    adopted node like one of its children: it forwards the node's upstream
+ *    traffic and passes on downstream traffic for the node's subtree. The
+ *    adopted node accepts shared I/O updates from the foster instead of the
+ *    parent.
+ * 5. The adopted node renews the adoption every FAILOVER_RENEW_MS. As soon as
+ *    a beacon from the real parent says it has a path to the root again, the
+ *    node releases the foster and goes back to its parent.
+ *
+ * Reported per failover:
+ * - Detection time: from the parent's last frame until it is declared lost.
+ * - Outage time: from the parent's last frame until the adoption is
+ *   confirmed.
+ * - Added hops: how many more hops the foster path has than the parent path.
+ * - Handshake round trip.
+ * The estimated extra latency is added hops times half the round trip.
+ *
+ * Firmware distribution (tree_ota.h) still only follows the real parent.
+ *
+ * Set to 0 to compile the feature out. No beacons are sent then, and only
+ * real children are accepted.
+ */
+#define ENABLE_PARENT_FAILOVER 1
+
+#define FAILOVER_BEACON_INTERVAL_MS   1000
+#define FAILOVER_DEFAULT_MISSES       3       // Used when NodeConfigRecord::failoverMisses is 0
+#define FAILOVER_MAX_MISSES           30
+#define FAILOVER_ADOPT_TIMEOUT_MS     500     // No ACK within this: try the next candidate
+#define FAILOVER_RENEW_MS             2000
+#define FAILOVER_ADOPTION_TIMEOUT_MS  (3 * FAILOVER_RENEW_MS)   // Foster drops silent adoptees
+#define FAILOVER_MAX_CANDIDATES       8
+#define FAILOVER_MAX_ADOPTED          4       // Adoptees one foster will carry
+
+enum FailoverState : uint8_t {
+    FAILOVER_STATE_NORMAL    = 0,   // Parent alive (or this is the root)
+    FAILOVER_STATE_SEARCHING = 1,   // Parent lost, asking candidates
+    FAILOVER_STATE_ADOPTED   = 2    // Attached to a foster parent
+};
+
+// Beacon flags
+#define FAILOVER_BEACON_UPSTREAM_OK   0x01    // Sender has a working path to the root
+
+/**
+ * @brief MSG_LINK_BEACON payload (broadcast, not forwarded)
+ */
+typedef struct {
+    uint16_t upstreamHID;       // Current parent or foster; 0 on the root
+    uint8_t  flags;             // FAILOVER_BEACON_*
+    uint8_t  adoptedCount;
+} __attribute__((packed)) LinkBeaconPayload;
+
+enum AdoptAction : uint8_t {
+    ADOPT_ACTION_ATTACH  = 0,   // Also used to renew
+    ADOPT_ACTION_RELEASE = 1
+};
+
+/**
+ * @brief MSG_ADOPT_REQUEST payload (orphan to foster, one hop)
+ */
+typedef struct {
+    uint8_t  action;            // AdoptAction
+    uint8_t  nonce;             // Echoed in the ACK to time the handshake
+} __attribute__((packed)) AdoptRequestPayload;
+
+enum AdoptStatus : uint8_t {
+    ADOPT_STATUS_ACCEPTED = 0,
+    ADOPT_STATUS_FULL     = 1,  // FAILOVER_MAX_ADOPTED reached
+    ADOPT_STATUS_NO_PATH  = 2,  // Foster has no path to the root itself
+    ADOPT_STATUS_LOOP     = 3   // Requester is upstream of the foster
+};
+
+/**
+ * @brief MSG_ADOPT_ACK payload (foster to orphan, one hop)
+ */
+typedef struct {
+    uint8_t  status;            // AdoptStatus
+    uint8_t  nonce;
+} __attribute__((packed)) AdoptAckPayload;
+
+struct FailoverStatus {
+    uint8_t  state = FAILOVER_STATE_NORMAL;
+    uint8_t  missThreshold = FAILOVER_DEFAULT_MISSES;
+    uint16_t parentHID = 0;
+    uint16_t fosterHID = 0;
+    uint32_t parentSilentMs = 0;        // Since the parent's last frame
+    uint8_t  candidates = 0;            // Neighbours heard recently
+    uint8_t  adoptedCount = 0;          // Nodes this node is fostering
+    uint16_t adoptedHIDs[FAILOVER_MAX_ADOPTED] = {0};
+    uint32_t failovers = 0;             // Adoptions completed
+    uint32_t recoveries = 0;            // Returns to the real parent
+    uint32_t refusals = 0;              // Candidates that refused or didn't answer
+    uint32_t lastDetectMs = 0;          // Last frame to parent declared lost
+    uint32_t lastOutageMs = 0;          // Last frame to adoption confirmed
+    uint32_t lastAdoptRttMs = 0;        // Request to ACK
+    int8_t   lastAddedHops = 0;         // Foster path minus parent path
+};
+
+// ============================================================================
+// PARENT FAILOVER API
+// ============================================================================
+
+/**
+ * @brief Send beacons, detect a lost parent, adopt, renew and revert.
+ *        Call from loop().
+ */
+void failoverUpdate();
+
+/**
+ * @brief Receive path hook for every valid tree frame; notes parent liveness.
+ *        Called from the Wi-Fi task.
+ */
+void failoverNoteFrame(const TreeMessageHeader* header);
+
+/**
+ * @brief Receive path hook for MSG_LINK_BEACON, MSG_ADOPT_REQUEST and
+ *        MSG_ADOPT_ACK. Called from the Wi-Fi task; only records state.
+ * @return true if the frame was addressed to this node or was a beacon
+ */
+bool failoverHandleFrame(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen, int8_t rssi);
+
+/**
+ * @brief Node currently used as upstream: the foster while adopted, else 0
+ */
+uint16_t failoverGetFosterHID();
+
+/**
+ * @brief True if hid is a node this node is fostering
+ */
+bool failoverIsAdopted(uint16_t hid);
+
+/**
+ * @brief True if hid is a fostered node or one of its descendants
+ */
+bool failoverCoversHID(uint16_t hid);
+
+void failoverGetStatus(FailoverStatus& out);
+const char* failoverStateName(uint8_t state);
+
+#endif // PARENT_FAILOVER_H
@@ -0,0 +1,319 @@
+#include "rate_control.h"
+#include "debug.h"
+#include "espnow_wrapper.h"
+
+// Logging macros for the rate adaptation module
+#define MODULE_TITLE       "RATE"
+#define MODULE_DEBUG_LEVEL 1
+#define rateLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// RATE LADDER
+// ============================================================================
+
+struct RateLadderEntry {
+    wifi_phy_mode_t mode;
+    wifi_phy_rate_t rate;
+    uint16_t kbps;
+    uint16_t preambleUs;        // Preamble and PHY header, approximate
+    int8_t   minRssi;           // Weakest signal this rate is used at
+    const char* name;
+};
+
+static const RateLadderEntry ladder[RATE_STEP_COUNT] = {
+    {WIFI_PHY_MODE_LR,  WIFI_PHY_RATE_LORA_250K, 250,   400, -128, "LR_250K"},
+    {WIFI_PHY_MODE_LR,  WIFI_PHY_RATE_LORA_500K, 500,   400, -98,  "LR_500K"},
+    {WIFI_PHY_MODE_11B, WIFI_PHY_RATE_1M_L,      1000,  192, -92,  "1M"},
+    {WIFI_PHY_MODE_11B, WIFI_PHY_RATE_2M_L,      2000,  192, -89,  "2M"},
+    {WIFI_PHY_MODE_11G, WIFI_PHY_RATE_6M,        6000,  20,  -85,  "6M"},
+    {WIFI_PHY_MODE_11G, WIFI_PHY_RATE_12M,       12000, 20,  -81,  "12M"},
+    {WIFI_PHY_MODE_11G, WIFI_PHY_RATE_24M,       24000, 20,  -76,  "24M"}
+};
+
+#define RATE_FRAME_OVERHEAD     43      // 802.11 header, ESP-NOW vendor element and FCS
+#define RATE_RSSI_UNKNOWN       INT8_MIN
+
+static uint32_t airtimeUs(uint8_t step, size_t len) {
+    return ladder[step].preambleUs + (uint32_t)(len + RATE_FRAME_OVERHEAD) * 8000 / ladder[step].kbps;
+}
+
+// ============================================================================
+// PEER STATE
+// ============================================================================
+
+struct RatePeer {
+    RatePeerInfo info;
+    uint16_t windowAcked;
+    uint16_t windowFailed;
+    uint32_t windowStartMs;
+    uint8_t  goodWindows;
+    uint8_t  consecutiveFailures;
+    uint32_t holdoffUntilMs;
+};
+
+static RatePeer peers[RATE_MAX_PEERS];
+static uint8_t baseStep = RATE_STEP_LR_250K;
+static uint32_t totalSavedUs = 0;
+static uint32_t rateChanges = 0;
+static uint32_t applyErrors = 0;
+
+// Sends come from both tasks, results and RSSI from the Wi-Fi task
+static portMUX_TYPE rateMux = portMUX_INITIALIZER_UNLOCKED;
+
+static int findPeerLocked(const uint8_t* mac) {
+    for (int i = 0; i < RATE_MAX_PEERS; i++) {
+        if (peers[i].info.used && memcmp(peers[i].info.mac, mac, 6) == 0) return i;
+    }
+    return -1;
+}
+
+static int findOrAddPeerLocked(const uint8_t* mac, uint32_t now) {
+    int slot = findPeerLocked(mac);
+    if (slot >= 0) return slot;
+
+    slot = 0;
+    for (int i = 0; i < RATE_MAX_PEERS; i++) {
+        if (!peers[i].info.used) {
+            slot = i;
+            break;
+        }
+        if ((int32_t)(peers[i].info.lastUsedMs - peers[slot].info.lastUsedMs) < 0) slot = i;
+    }
+    memset(&peers[slot], 0, sizeof(RatePeer));
+    RatePeerInfo& info = peers[slot].info;
+    memcpy(info.mac, mac, 6);
+    info.used = true;
+    info.step = baseStep;
+    info.rssi = RATE_RSSI_UNKNOWN;
+    info.lastUsedMs = now;
+    peers[slot].windowStartMs = now;
+    peers[slot].holdoffUntilMs = now;
+    return slot;
+}
+
+static bool isBroadcast(const uint8_t* mac) {
+    return memcmp(mac, broadcastMAC, 6) == 0;
+}
+
+static void applyRate(const uint8_t* mac, uint8_t step) {
+#if ENABLE_RATE_ADAPTATION
+    esp_now_rate_config_t config = {};
+    config.phymode = ladder[step].mode;
+    config.rate = ladder[step].rate;
+    esp_err_t result = esp_now_set_peer_rate_config(mac, &config);
+    if (result != ESP_OK) {
+        portENTER_CRITICAL(&rateMux);
+        applyErrors++;
+        portEXIT_CRITICAL(&rateMux);
+        rateLog("Failed to set " + String(ladder[step].name) + " for " + macToString(mac) + ": " + String(result), 2);
+    }
+#endif
+}
+
+// ============================================================================
+// HOOKS
+// ============================================================================
+
+void rateInit() {
+#if ENABLE_RATE_ADAPTATION
+    baseStep = isLongRangeModeEnabled() ? RATE_STEP_LR_250K : RATE_STEP_1M;
+    applyRate(broadcastMAC, baseStep);
+    rateLog("Base rate " + String(ladder[baseStep].name), 3);
+#endif
+}
+
+void rateOnModeChange() {
+#if ENABLE_RATE_ADAPTATION
+    uint8_t changedMACs[RATE_MAX_PEERS][6];
+    uint8_t changedSteps[RATE_MAX_PEERS];
+    uint8_t changed = 0;
+
+    portENTER_CRITICAL(&rateMux);
+    baseStep = isLongRangeModeEnabled() ? RATE_STEP_LR_250K : RATE_STEP_1M;
+    for (RatePeer& peer : peers) {
+        if (peer.info.used && peer.info.step < baseStep) {
+            peer.info.step = baseStep;
+            memcpy(changedMACs[changed], peer.info.mac, 6);
+            changedSteps[changed++] = baseStep;
+        }
+    }
+    portEXIT_CRITICAL(&rateMux);
+
+    if (esp_now_is_peer_exist(broadcastMAC)) {
+        applyRate(broadcastMAC, baseStep);
+    }
+    for (uint8_t i = 0; i < changed; i++) {
+        applyRate(changedMACs[i], changedSteps[i]);
+    }
+#endif
+}
+
+void rateOnPeerAdded(const uint8_t* mac) {
+#if ENABLE_RATE_ADAPTATION
+    if (isBroadcast(mac)) {
+        return;
+    }
+    portENTER_CRITICAL(&rateMux);
+    uint8_t step = peers[findOrAddPeerLocked(mac, millis())].info.step;
+    portEXIT_CRITICAL(&rateMux);
+    applyRate(mac, step);
+#endif
+}
+
+void rateNoteSend(const uint8_t* mac, size_t len) {
+#if ENABLE_RATE_ADAPTATION
+    if (isBroadcast(mac)) {
+        return;
+    }
+    uint32_t now = millis();
+    portENTER_CRITICAL(&rateMux);
+    RatePeerInfo& info = peers[findOrAddPeerLocked(mac, now)].info;
+    uint32_t used = airtimeUs(info.step, len);
+    uint32_t saved = airtimeUs(baseStep, len) - used;
+    info.lastUsedMs = now;
+    info.airtimeUs += used;
+    info.airtimeSavedUs += saved;
+    totalSavedUs += saved;
+    portEXIT_CRITICAL(&rateMux);
+#endif
+}
+
+void rateNoteResult(const uint8_t* mac, bool delivered) {
+#if ENABLE_RATE_ADAPTATION
+    if (!mac || isBroadcast(mac)) {
+        return;
+    }
+    portENTER_CRITICAL(&rateMux);
+    int slot = findPeerLocked(mac);
+    if (slot >= 0) {
+        RatePeer& peer = peers[slot];
+        if (delivered) {
+            peer.info.acked++;
+            peer.windowAcked++;
+            peer.consecutiveFailures = 0;
+        } else {
+            peer.info.failed++;
+            peer.windowFailed++;
+            peer.consecutiveFailures++;
+        }
+    }
+    portEXIT_CRITICAL(&rateMux);
+#endif
+}
+
+void rateNoteRx(const uint8_t* mac, int8_t rssi) {
+#if ENABLE_RATE_ADAPTATION
+    if (!mac || rssi == 0) {
+        return;
+    }
+    portENTER_CRITICAL(&rateMux);
+    int slot = findPeerLocked(mac);
+    if (slot >= 0) {
+        RatePeerInfo& info = peers[slot].info;
+        info.rssi = (info.rssi == RATE_RSSI_UNKNOWN) ? rssi : (int8_t)((3 * info.rssi + rssi) / 4);
+    }
+    portEXIT_CRITICAL(&rateMux);
+#endif
+}
+
+// ============================================================================
+// LOOP TASK AND QUERIES
+// ============================================================================
+
+void rateUpdate() {
+#if ENABLE_RATE_ADAPTATION
+    uint32_t now = millis();
+    uint8_t changedMACs[RATE_MAX_PEERS][6];
+    uint8_t changedSteps[RATE_MAX_PEERS];
+    uint8_t changed = 0;
+
+    portENTER_CRITICAL(&rateMux);
+    for (RatePeer& peer : peers) {
+        if (!peer.info.used) continue;
+        RatePeerInfo& info = peer.info;
+        uint16_t results = peer.windowAcked + peer.windowFailed;
+        bool fastDown = peer.consecutiveFailures >= RATE_FAST_DOWN_FAILURES;
+        bool windowDone = results >= RATE_EVAL_FRAMES ||
+                          (results >= RATE_EVAL_MIN_FRAMES && now - peer.windowStartMs >= RATE_EVAL_MS);
+        if (!fastDown && !windowDone) continue;
+
+        uint8_t deliveryPct = results ? peer.windowAcked * 100 / results : 0;
+        bool rssiKnown = info.rssi != RATE_RSSI_UNKNOWN;
+        uint8_t step = info.step;
+
+        if (fastDown || deliveryPct < RATE_DOWN_DELIVERY_PCT || (rssiKnown && info.rssi < ladder[step].minRssi)) {
+            if (step > baseStep) {
+                step--;
+                info.stepDowns++;
+                peer.holdoffUntilMs = now + RATE_HOLDOFF_MS;
+            }
+            peer.goodWindows = 0;
+        } else if (deliveryPct >= RATE_UP_DELIVERY_PCT && step + 1 < RATE_STEP_COUNT && rssiKnown &&
+                   info.rssi >= ladder[step + 1].minRssi + RATE_UP_MARGIN_DB &&
+                   (int32_t)(now - peer.holdoffUntilMs) >= 0) {
+            if (++peer.goodWindows >= RATE_UP_WINDOWS) {
+                step++;
+                info.stepUps++;
+                peer.goodWindows = 0;
+            }
+        } else {
+            peer.goodWindows = 0;
+        }
+
+        peer.windowAcked = 0;
+        peer.windowFailed = 0;
+        peer.consecutiveFailures = 0;
+        peer.windowStartMs = now;
+        if (step != info.step) {
+            info.step = step;
+            rateChanges++;
+            memcpy(changedMACs[changed], info.mac, 6);
+            changedSteps[changed++] = step;
+        }
+    }
+    portEXIT_CRITICAL(&rateMux);
+
+    for (uint8_t i = 0; i < changed; i++) {
+        if (esp_now_is_peer_exist(changedMACs[i])) {
+            applyRate(changedMACs[i], changedSteps[i]);
+        }
+        rateLog(macToString(changedMACs[i]) + " now at " + String(ladder[changedSteps[i]].name), 3);
+    }
+#endif
+}
+
+void rateGetStats(RateStats& out) {
+    portENTER_CRITICAL(&rateMux);
+    out.baseStep = baseStep;
+    out.airtimeSavedUs = totalSavedUs;
+    out.rateChanges = rateChanges;
+    out.applyErrors = applyErrors;
+    out.peerCount = 0;
+    for (const RatePeer& peer : peers) {
+        if (peer.info.used) {
+            out.peers[out.peerCount++] = peer.info;
+        }
+    }
+    portEXIT_CRITICAL(&rateMux);
+}
+
+void rateResetStats() {
+    portENTER_CRITICAL(&rateMux);
+    totalSavedUs = 0;
+    rateChanges = 0;
+    applyErrors = 0;
+    for (RatePeer& peer : peers) {
+        RatePeerInfo& info = peer.info;
+        info.acked = 0;
+        info.failed = 0;
+        info.stepUps = 0;
+        info.stepDowns = 0;
+        info.airtimeUs = 0;
+        info.airtimeSavedUs = 0;
+    }
+    portEXIT_CRITICAL(&rateMux);
+}
+
+const char* rateStepName(uint8_t step) {
+    return step < RATE_STEP_COUNT ? ladder[step].name : "unknown";
+}
@@ -0,0 +1,133 @@
+#ifndef RATE_CONTROL_H
+#define RATE_CONTROL_H
+
+#include <Arduino.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+
+// ============================================================================
+// RATE ADAPTATION CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Per-peer PHY rate for unicast links (uplink.h).
+ *
+ * With Long Range mode on, every frame used to go out at LR 250 kbps, even
+ * between nodes a metre apart. Now the radio keeps 11b/g/n enabled
+ * alongside LR:
+ * - Broadcasts stay at the base rate so every neighbour still hears them.
+ *   The base rate is LR 250 kbps, or 1 Mbps with LR off.
+ * - Each unicast peer gets its own rate from the ladder below, set with
+ *   esp_now_set_peer_rate_config.
+ *
+ * Each peer is checked after RATE_EVAL_FRAMES send results, or after
+ * RATE_EVAL_MS with at least RATE_EVAL_MIN_FRAMES. The check uses the
+ * delivery ratio from the send callback and the RSSI of frames received
+ * from that peer.
+ * - Step up one rate after RATE_UP_WINDOWS good windows in a row. A good
+ *   window has delivery of at least RATE_UP_DELIVERY_PCT and RSSI at least
+ *   RATE_UP_MARGIN_DB above the next rate's threshold.
+ * - Step down at once when delivery falls below RATE_DOWN_DELIVERY_PCT,
+ *   when RSSI falls below the current rate's threshold, or after
+ *   RATE_FAST_DOWN_FAILURES unacknowledged frames in a row. A step down
+ *   blocks stepping up again for RATE_HOLDOFF_MS.
+ *
+ * Airtime for each unicast frame is estimated at the rate it was sent at
+ * and at the base rate. The difference is reported as airtime saved (RATE
+ * command).
+ *
+ * Needs esp_now_set_peer_rate_config (ESP-IDF 5.x). Set to 0 on older
+ * cores; everything then runs at the base rate as before.
+ */
+#define ENABLE_RATE_ADAPTATION 1
+
+#define RATE_MAX_PEERS              4
+#define RATE_EVAL_FRAMES            20
+#define RATE_EVAL_MIN_FRAMES        5
+#define RATE_EVAL_MS                10000
+#define RATE_UP_DELIVERY_PCT        95
+#define RATE_DOWN_DELIVERY_PCT      80
+#define RATE_UP_WINDOWS             2
+#define RATE_UP_MARGIN_DB           5
+#define RATE_FAST_DOWN_FAILURES     2
+#define RATE_HOLDOFF_MS             30000
+
+enum RateStep : uint8_t {
+    RATE_STEP_LR_250K = 0,
+    RATE_STEP_LR_500K,
+    RATE_STEP_1M,
+    RATE_STEP_2M,
+    RATE_STEP_6M,
+    RATE_STEP_12M,
+    RATE_STEP_24M,
+    RATE_STEP_COUNT
+};
+
+struct RatePeerInfo {
+    uint8_t  mac[6];
+    bool     used;
+    uint8_t  step;              // RateStep
+    int8_t   rssi;              // Smoothed, from frames received from the peer
+    uint32_t lastUsedMs;
+    uint32_t acked;
+    uint32_t failed;
+    uint32_t stepUps;
+    uint32_t stepDowns;
+    uint32_t airtimeUs;         // Estimated, at the rates actually used
+    uint32_t airtimeSavedUs;    // Estimated, against the base rate
+};
+
+struct RateStats {
+    uint8_t  baseStep = RATE_STEP_LR_250K;
+    uint32_t airtimeSavedUs = 0;        // All peers, including evicted ones
+    uint32_t rateChanges = 0;
+    uint32_t applyErrors = 0;           // esp_now_set_peer_rate_config failures
+    uint8_t  peerCount = 0;
+    RatePeerInfo peers[RATE_MAX_PEERS];
+};
+
+// ============================================================================
+// RATE ADAPTATION API
+// ============================================================================
+
+/**
+ * @brief Set the broadcast peer to the base rate. Call once the broadcast
+ *        peer is registered.
+ */
+void rateInit();
+
+/**
+ * @brief Long Range mode was switched: move the base rate and clamp peers
+ */
+void rateOnModeChange();
+
+/**
+ * @brief A unicast peer was just registered; give it its current rate
+ */
+void rateOnPeerAdded(const uint8_t* mac);
+
+/**
+ * @brief Account a unicast frame handed to the radio (airtime estimate)
+ */
+void rateNoteSend(const uint8_t* mac, size_t len);
+
+/**
+ * @brief Send callback hook. Called from onDataSent.
+ */
+void rateNoteResult(const uint8_t* mac, bool delivered);
+
+/**
+ * @brief Receive hook: RSSI of a frame from mac. Called from the Wi-Fi task.
+ */
+void rateNoteRx(const uint8_t* mac, int8_t rssi);
+
+/**
+ * @brief Evaluate windows and apply rate changes. Call from loop().
+ */
+void rateUpdate();
+
+void rateGetStats(RateStats& out);
+void rateResetStats();
+const char* rateStepName(uint8_t step);
+
+#endif // RATE_CONTROL_H
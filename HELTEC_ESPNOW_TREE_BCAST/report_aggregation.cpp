@@ -0,0 +1,195 @@
+#include "report_aggregation.h"
+#include "debug.h"
+#include "espnow_wrapper.h"
+#include "uplink.h"
+
+// Logging macros for the report aggregation module
+#define MODULE_TITLE       "AGG"
+#define MODULE_DEBUG_LEVEL 1
+#define aggLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// BATCH STATE
+// ============================================================================
+
+struct AggBatch {
+    uint8_t count;
+    AggregatedReportRecord records[AGG_MAX_RECORDS];
+} __attribute__((packed));
+
+static AggBatch pending;
+static uint32_t firstHeldMs = 0;
+static AggStats stats;
+
+// Root rate window
+static uint32_t rateWindowStartMs = 0;
+static uint32_t windowFrames = 0;
+static uint32_t windowRecords = 0;
+
+// Reports arrive on the Wi-Fi task, the window closes in loop()
+static portMUX_TYPE aggMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t windowMs() {
+    uint8_t window = DATA_MGR.getNodeConfig().reportWindowMs;
+    return window > AGG_MAX_WINDOW_MS ? AGG_MAX_WINDOW_MS : window;
+}
+
+/**
+ * @brief Records carried by a report or batch frame; 0 if it isn't one
+ * @param records Receives a pointer to batch records (nullptr for a single report)
+ */
+static uint8_t recordCount(const uint8_t* data, int len, const AggregatedReportRecord** records) {
+    const TreeMessageHeader* header = (const TreeMessageHeader*)data;
+    const uint8_t* payload = data + TREE_MSG_HEADER_SIZE;
+    size_t payloadLen = len - TREE_MSG_OVERHEAD;
+    *records = nullptr;
+
+    if (header->msg_type == MSG_DEVICE_DATA_REPORT) {
+        return (payloadLen == sizeof(DeviceSpecificData) ||
+                payloadLen == sizeof(DeviceSpecificData) + sizeof(TopologyTrailer)) ? 1 : 0;
+    }
+    if (header->msg_type == MSG_DEVICE_DATA_BATCH && payloadLen >= 1) {
+        uint8_t count = payload[0];
+        if (count == 0 || count > AGG_MAX_RECORDS || payloadLen != 1 + count * sizeof(AggregatedReportRecord)) {
+            return 0;
+        }
+        *records = (const AggregatedReportRecord*)(payload + 1);
+        return count;
+    }
+    return 0;
+}
+
+/**
+ * @brief Send one batch upstream. Runs in whichever task closed it.
+ */
+static void sendBatch(const AggBatch& batch) {
+    uint8_t buffer[TREE_MSG_OVERHEAD + sizeof(AggBatch)];
+    size_t payloadLen = 1 + batch.count * sizeof(AggregatedReportRecord);
+    if (!DATA_MGR.createTreeMessage(buffer, sizeof(buffer), ROOT_HID, MSG_DEVICE_DATA_BATCH,
+                                    (const uint8_t*)&batch, payloadLen)) {
+        return;
+    }
+    uint8_t nextHop[6];
+    uplinkSelectMAC(nextHop);
+    espnowSendData(nextHop, buffer, TREE_MSG_OVERHEAD + payloadLen);
+}
+
+// Hands the pending batch to the caller and starts an empty one
+static void takePendingLocked(AggBatch& out) {
+    memcpy(&out, &pending, 1 + pending.count * sizeof(AggregatedReportRecord));
+    pending.count = 0;
+    stats.batchesSent++;
+}
+
+// ============================================================================
+// FORWARDING AND ROOT HOOKS
+// ============================================================================
+
+bool aggAbsorbFrame(const uint8_t* data, int len) {
+#if ENABLE_REPORT_AGGREGATION
+    if (windowMs() == 0 || len < TREE_MSG_OVERHEAD || DATA_MGR.isRoot()) {
+        return false;
+    }
+    const AggregatedReportRecord* records;
+    uint8_t count = recordCount(data, len, &records);
+    if (count == 0) {
+        return false;
+    }
+
+    AggregatedReportRecord single;
+    if (!records) {
+        const TreeMessageHeader* header = (const TreeMessageHeader*)data;
+        const uint8_t* payload = data + TREE_MSG_HEADER_SIZE;
+        memset(&single, 0, sizeof(single));
+        single.src_hid = header->src_hid;
+        memcpy(&single.data, payload, sizeof(DeviceSpecificData));
+        if ((size_t)len - TREE_MSG_OVERHEAD > sizeof(DeviceSpecificData)) {
+            single.flags = AGG_RECORD_HAS_TRAILER;
+            memcpy(&single.trailer, payload + sizeof(DeviceSpecificData), sizeof(TopologyTrailer));
+        }
+        records = &single;
+    }
+
+    AggBatch full;
+    bool sendFull = false;
+    portENTER_CRITICAL(&aggMux);
+    if (pending.count + count > AGG_MAX_RECORDS) {
+        takePendingLocked(full);
+        stats.fullFlushes++;
+        sendFull = true;
+    }
+    if (pending.count == 0) {
+        firstHeldMs = millis();
+    }
+    memcpy(&pending.records[pending.count], records, count * sizeof(AggregatedReportRecord));
+    pending.count += count;
+    stats.framesAbsorbed++;
+    stats.recordsAbsorbed += count;
+    portEXIT_CRITICAL(&aggMux);
+
+    if (sendFull) {
+        sendBatch(full);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void aggNoteRootFrame(uint8_t records) {
+    portENTER_CRITICAL(&aggMux);
+    stats.rootFrames++;
+    stats.rootRecords += records;
+    windowFrames++;
+    windowRecords += records;
+    portEXIT_CRITICAL(&aggMux);
+}
+
+// ============================================================================
+// LOOP TASK AND QUERIES
+// ============================================================================
+
+void aggUpdate() {
+    uint32_t now = millis();
+    AggBatch batch;
+    bool send = false;
+
+    portENTER_CRITICAL(&aggMux);
+    if (now - rateWindowStartMs >= AGG_RATE_WINDOW_MS) {
+        uint32_t elapsed = now - rateWindowStartMs;
+        stats.rootFramesPerSec = windowFrames * 1000.0f / elapsed;
+        stats.rootRecordsPerSec = windowRecords * 1000.0f / elapsed;
+        windowFrames = 0;
+        windowRecords = 0;
+        rateWindowStartMs = now;
+    }
+#if ENABLE_REPORT_AGGREGATION
+    if (pending.count > 0 && now - firstHeldMs >= windowMs()) {
+        takePendingLocked(batch);
+        send = true;
+    }
+#endif
+    portEXIT_CRITICAL(&aggMux);
+
+    if (send) {
+        aggLog("Sending " + String(batch.count) + " reports in one frame", 4);
+        sendBatch(batch);
+    }
+}
+
+void aggGetStats(AggStats& out) {
+    portENTER_CRITICAL(&aggMux);
+    out = stats;
+    out.pending = pending.count;
+    portEXIT_CRITICAL(&aggMux);
+    out.windowMs = windowMs();
+}
+
+void aggResetStats() {
+    portENTER_CRITICAL(&aggMux);
+    stats = AggStats();
+    windowFrames = 0;
+    windowRecords = 0;
+    rateWindowStartMs = millis();
+    portEXIT_CRITICAL(&aggMux);
+}
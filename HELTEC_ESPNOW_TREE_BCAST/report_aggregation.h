@@ -0,0 +1,97 @@
+#ifndef REPORT_AGGREGATION_H
+#define REPORT_AGGREGATION_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+#include "child_table.h"
+#include "frame_auth.h"
+
+// ============================================================================
+// REPORT AGGREGATION CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Forwarders combine child reports into one upstream frame.
+ *
+ * Each MSG_DEVICE_DATA_REPORT used to be forwarded on its own at every hop,
+ * so a leaf at depth 3 cost three frames and the root's neighbourhood
+ * filled up first. With NodeConfigRecord::reportWindowMs set, a forwarder
+ * works like this:
+ * - It holds the reports it would forward upstream, for up to that many ms
+ *   after the first one arrives.
+ * - It then sends them as one MSG_DEVICE_DATA_BATCH to the root. The payload
+ *   is a record count, then one AggregatedReportRecord per report.
+ * - A batch is sent early when the next report would not fit in one frame
+ *   (AGG_MAX_RECORDS).
+ * - Batches from children are unpacked into the forwarder's own batch, so
+ *   aggregation compounds up the tree.
+ * - The node's own reports are not held.
+ *
+ * Forwarders with a window of 0 pass batches on unchanged. The root unpacks
+ * batches into updateDeviceData() just like single reports. Roots older
+ * than this drop batches, so update the root first.
+ *
+ * The root counts report frames and records per second over
+ * AGG_RATE_WINDOW_MS (AGG command). Compare the numbers with the forwarders'
+ * windows at 0 and non-zero.
+ *
+ * Set to 0 to always forward reports one by one.
+ */
+#define ENABLE_REPORT_AGGREGATION 1
+
+#define AGG_MAX_WINDOW_MS       250
+#define AGG_RATE_WINDOW_MS      10000
+
+#define AGG_RECORD_HAS_TRAILER  0x01    // The report carried a TopologyTrailer
+
+typedef struct {
+    uint16_t src_hid;
+    uint8_t  flags;                     // AGG_RECORD_*
+    DeviceSpecificData data;
+    TopologyTrailer trailer;            // Zero unless AGG_RECORD_HAS_TRAILER
+} __attribute__((packed)) AggregatedReportRecord;
+
+// One count byte, then as many records as fit in one ESP-NOW frame
+#define AGG_MAX_RECORDS ((TREE_FRAME_MAX_LEN - TREE_MSG_OVERHEAD - 1) / sizeof(AggregatedReportRecord))
+
+struct AggStats {
+    uint8_t  windowMs = 0;
+    // Forwarder
+    uint8_t  pending = 0;               // Records waiting for the window to close
+    uint32_t framesAbsorbed = 0;        // Reports and batches taken in instead of forwarded
+    uint32_t recordsAbsorbed = 0;
+    uint32_t batchesSent = 0;
+    uint32_t fullFlushes = 0;           // Batches sent early because the next report didn't fit
+    // Root
+    uint32_t rootFrames = 0;            // Report and batch frames accepted
+    uint32_t rootRecords = 0;           // Device reports in them
+    float    rootFramesPerSec = 0;      // Over the last complete AGG_RATE_WINDOW_MS
+    float    rootRecordsPerSec = 0;
+};
+
+// ============================================================================
+// REPORT AGGREGATION API
+// ============================================================================
+
+/**
+ * @brief Upstream forwarding hook: take a report or batch into the pending
+ *        batch. Called from the Wi-Fi task.
+ * @return true if the frame was absorbed and must not be forwarded
+ */
+bool aggAbsorbFrame(const uint8_t* data, int len);
+
+/**
+ * @brief Root hook: a report frame carrying records device reports was accepted
+ */
+void aggNoteRootFrame(uint8_t records);
+
+/**
+ * @brief Send the pending batch once its window closes and roll the root's
+ *        rate window. Call from loop().
+ */
+void aggUpdate();
+
+void aggGetStats(AggStats& out);
+void aggResetStats();
+
+#endif // REPORT_AGGREGATION_H
@@ -0,0 +1,128 @@
+#include "serial_protocol.h"
+
+// ============================================================================
+// CRC
+// ============================================================================
+
+uint16_t serialCrc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// ============================================================================
+// COBS
+// ============================================================================
+
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out, size_t outSize) {
+    if (outSize == 0) {
+        return 0;
+    }
+
+    size_t codeIndex = 0;
+    size_t outIndex = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (outIndex >= outSize) {
+            return 0;
+        }
+        if (in[i] == 0) {
+            out[codeIndex] = code;
+            codeIndex = outIndex++;
+            code = 1;
+            continue;
+        }
+        out[outIndex++] = in[i];
+        if (++code == 0xFF) {
+            // Block full: close it and start a new one
+            if (outIndex >= outSize) {
+                return 0;
+            }
+            out[codeIndex] = code;
+            codeIndex = outIndex++;
+            code = 1;
+        }
+    }
+    out[codeIndex] = code;
+    return outIndex;
+}
+
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t outSize) {
+    size_t inIndex = 0;
+    size_t outIndex = 0;
+
+    while (inIndex < len) {
+        uint8_t code = in[inIndex++];
+        if (code == 0 || inIndex + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            if (outIndex >= outSize) {
+                return 0;
+            }
+            out[outIndex++] = in[inIndex++];
+        }
+        // A block shorter than 0xFF implies a zero, except at the very end
+        if (code != 0xFF && inIndex < len) {
+            if (outIndex >= outSize) {
+                return 0;
+            }
+            out[outIndex++] = 0;
+        }
+    }
+    return outIndex;
+}
+
+// ============================================================================
+// FRAMES
+// ============================================================================
+
+size_t serialBuildFrame(uint8_t msgId, uint8_t seq, const uint8_t* payload, size_t payloadLen,
+                        uint8_t* out, size_t outSize) {
+    if (payloadLen > SERIAL_FRAME_MAX_PAYLOAD || outSize < 3) {
+        return 0;
+    }
+
+    uint8_t raw[SERIAL_FRAME_MAX_RAW];
+    raw[0] = msgId;
+    raw[1] = seq;
+    if (payloadLen > 0) {
+        memcpy(raw + 2, payload, payloadLen);
+    }
+    uint16_t crc = serialCrc16(raw, payloadLen + 2);
+    raw[payloadLen + 2] = crc & 0xFF;
+    raw[payloadLen + 3] = crc >> 8;
+
+    out[0] = 0x00;
+    size_t encodedLen = cobsEncode(raw, payloadLen + SERIAL_FRAME_OVERHEAD, out + 1, outSize - 2);
+    if (encodedLen == 0) {
+        return 0;
+    }
+    out[encodedLen + 1] = 0x00;
+    return encodedLen + 2;
+}
+
+uint8_t serialParseFrame(const uint8_t* encoded, size_t encodedLen, uint8_t* raw,
+                         uint8_t& msgId, uint8_t& seq, const uint8_t*& payload, size_t& payloadLen) {
+    size_t rawLen = cobsDecode(encoded, encodedLen, raw, SERIAL_FRAME_MAX_RAW);
+    if (rawLen < SERIAL_FRAME_OVERHEAD) {
+        return SMSG_ERR_BAD_LENGTH;
+    }
+
+    msgId = raw[0];
+    seq = raw[1];
+    uint16_t received = raw[rawLen - 2] | ((uint16_t)raw[rawLen - 1] << 8);
+    if (serialCrc16(raw, rawLen - 2) != received) {
+        return SMSG_ERR_BAD_CRC;
+    }
+
+    payload = raw + 2;
+    payloadLen = rawLen - SERIAL_FRAME_OVERHEAD;
+    return 0;
+}
@@ -0,0 +1,346 @@
+#ifndef SERIAL_PROTOCOL_H
+#define SERIAL_PROTOCOL_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+
+// ============================================================================
+// BINARY SERIAL PROTOCOL
+// ============================================================================
+//
+// Binary request/response channel sharing the USB serial port with the text
+// commands and log output.
+//
+// Wire format:   0x00 | COBS( msg_id | seq | payload | crc16 ) | 0x00
+//
+// - Text never contains 0x00 and COBS output never contains 0x00, so a zero
+//   byte unambiguously starts (and ends) a binary frame on either side.
+// - A line noise 0x00 still opens a frame. If that "frame" fails to decode,
+//   fails its CRC, outgrows the buffer or stays open for
+//   SERIAL_FRAME_IDLE_TIMEOUT_MS, its bytes are replayed as text (when they
+//   are printable), so a following text command is not lost.
+// - crc16 is CRC-16/CCITT-FALSE over msg_id..payload, little-endian.
+// - Responses echo the request seq and set SMSG_RESPONSE_FLAG in msg_id.
+// - All multi-byte fields are little-endian (native on ESP32).
+//
+// Negotiation: the host sends SMSG_HELLO after opening the port. Firmware
+// without the binary channel answers "ERROR: Unknown command" in text (or
+// nothing), so a host that gets no HELLO response falls back to text polling.
+// Other binary requests are rejected with SMSG_ERR_NOT_NEGOTIATED until a
+// HELLO has been accepted.
+//
+// Subscriptions: instead of polling, the host can send SMSG_SUBSCRIBE with a
+// topic mask. The device then sends SMSG_PUSH frames carrying only the fields
+// that changed since the previous push of that topic (the first push after
+// SUBSCRIBE is a full snapshot). Pushes of a topic are at least minIntervalMs
+// apart; changes inside that window are coalesced into the next push. Every
+// push carries a 16-bit pushSeq so the host can detect a dropped frame and
+// re-subscribe for a fresh snapshot. The subscription is a lease: it lapses
+// if no binary request arrives for SERIAL_SUBSCRIPTION_LEASE_MS, so a closed
+// page stops the stream. HELLO cancels any subscription.
+
+// Version 2 widened the I/O payloads to 16 inputs and outputs; version 1
+// hosts are refused at HELLO and fall back to text commands.
+#define SERIAL_PROTOCOL_VERSION   2
+#define SERIAL_FRAME_MAX_PAYLOAD  200
+#define SERIAL_FRAME_OVERHEAD     4     // msg_id + seq + crc16
+#define SERIAL_FRAME_MAX_RAW      (SERIAL_FRAME_MAX_PAYLOAD + SERIAL_FRAME_OVERHEAD)
+// COBS adds one byte per 254 plus the leading code byte; +2 for delimiters
+#define SERIAL_FRAME_MAX_ENCODED  (SERIAL_FRAME_MAX_RAW + SERIAL_FRAME_MAX_RAW / 254 + 1 + 2)
+// A frame with no closing 0x00 after this long was a stray zero byte; its
+// bytes go back to the text parser
+#define SERIAL_FRAME_IDLE_TIMEOUT_MS   100
+
+#define SMSG_RESPONSE_FLAG        0x80
+
+#define SERIAL_SUBSCRIPTION_LEASE_MS   10000
+#define SERIAL_PUSH_MIN_INTERVAL_MS    20      // Floor for the requested minIntervalMs
+#define SERIAL_PUSH_MAX_STATS_HZ       20
+
+/**
+ * @brief Binary message IDs (requests; responses add SMSG_RESPONSE_FLAG)
+ */
+enum SerialMessageId : uint8_t {
+    SMSG_HELLO          = 0x01,
+    SMSG_STATUS         = 0x02,
+    SMSG_NETWORK_STATUS = 0x03,
+    SMSG_NETWORK_STATS  = 0x04,
+    SMSG_IO_STATUS      = 0x05,
+    SMSG_DEVICE_DATA    = 0x06,
+    SMSG_SUBSCRIBE      = 0x07,
+    SMSG_DEVICE_TABLE   = 0x08,
+    SMSG_REPLAY_FRAME   = 0x09,
+    SMSG_OTA_BEGIN      = 0x0A,
+    SMSG_OTA_DATA       = 0x0B,
+    SMSG_OTA_STATUS     = 0x0C,
+    SMSG_PUSH           = 0x40,    // Device -> host only, never has SMSG_RESPONSE_FLAG
+    SMSG_ERROR          = 0x7F
+};
+
+enum SerialErrorCode : uint8_t {
+    SMSG_ERR_UNKNOWN_MSG     = 0x01,
+    SMSG_ERR_NOT_NEGOTIATED  = 0x02,
+    SMSG_ERR_BAD_LENGTH      = 0x03,
+    SMSG_ERR_BAD_CRC         = 0x04,
+    SMSG_ERR_VERSION         = 0x05,
+    SMSG_ERR_STATE           = 0x06     // Not allowed in the current mode (e.g. replay not started)
+};
+
+// ============================================================================
+// MESSAGE PAYLOADS
+// ============================================================================
+
+typedef struct {
+    uint8_t  version;           // Highest protocol version the host speaks
+} __attribute__((packed)) SerialHelloRequest;
+
+typedef struct {
+    uint8_t  version;           // Protocol version the device will use
+    uint8_t  reserved;
+    uint16_t maxPayload;        // SERIAL_FRAME_MAX_PAYLOAD
+    uint32_t messageMask;       // Bit n set = request msg_id n supported
+} __attribute__((packed)) SerialHelloResponse;
+
+typedef struct {
+    uint32_t uptimeMs;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;
+    uint8_t  mac[6];
+} __attribute__((packed)) SerialStatusPayload;
+
+// SerialNetworkStatusPayload.flags
+#define SMSG_NET_FLAG_ROOT        0x01
+#define SMSG_NET_FLAG_CONFIGURED  0x02
+
+typedef struct {
+    uint16_t hid;
+    uint16_t parentHid;
+    uint8_t  bitIndex;
+    uint8_t  treeDepth;
+    uint8_t  childCount;
+    uint8_t  flags;
+} __attribute__((packed)) SerialNetworkStatusPayload;
+
+typedef struct {
+    uint32_t messagesSent;
+    uint32_t messagesReceived;
+    uint32_t messagesForwarded;
+    uint32_t messagesIgnored;
+    uint32_t securityViolations;
+    uint32_t lastMessageTime;
+    uint8_t  lastSenderMAC[6];  // All zero if no sender yet
+    int8_t   rssi;
+    uint8_t  reserved;
+} __attribute__((packed)) SerialNetworkStatsPayload;
+
+typedef struct {
+    uint16_t inputStates;
+    uint16_t outputStates;
+    uint8_t  bitIndex;
+    uint8_t  reserved;
+    uint32_t myBits;            // Bits 0-15: my bit in shared input n; bits 16-31: in shared output n
+    uint32_t ioVersion;         // Shared I/O snapshot version
+    uint32_t inputChangeCount;
+    uint32_t lastInputChangeMs;
+    uint32_t sharedInputs[MAX_INPUTS][SHARED_DATA_WORDS];
+    uint32_t sharedOutputs[MAX_INPUTS][SHARED_DATA_WORDS];
+} __attribute__((packed)) SerialIOStatusPayload;
+
+typedef struct {
+    uint32_t uptimeMs;
+    DeviceSpecificData data;
+} __attribute__((packed)) SerialDeviceDataPayload;
+
+// ============================================================================
+// SUBSCRIPTIONS
+// ============================================================================
+
+// Topic mask bits (SerialSubscribeRequest.topics, SerialPushHeader.topic)
+#define SMSG_TOPIC_IO        0x01   // Local input/output states
+#define SMSG_TOPIC_SHARED    0x02   // Distributed shared input/output snapshot
+#define SMSG_TOPIC_STATS     0x04   // Network counters, sampled at statsHz
+#define SMSG_TOPIC_DEVICES   0x08   // Aggregated device table (root only)
+#define SMSG_TOPIC_CAPTURE   0x10   // Raw frame capture ring (frame_capture.h); enables capture
+#define SMSG_TOPIC_ALL       0x1F
+#define SMSG_TOPIC_COUNT     5
+
+typedef struct {
+    uint8_t  topics;            // SMSG_TOPIC_* mask, 0 unsubscribes
+    uint8_t  statsHz;           // SMSG_TOPIC_STATS sample rate, capped at SERIAL_PUSH_MAX_STATS_HZ
+    uint16_t minIntervalMs;     // Minimum gap between pushes of one topic
+} __attribute__((packed)) SerialSubscribeRequest;
+
+typedef SerialSubscribeRequest SerialSubscribeResponse;   // Echoes the accepted values
+
+typedef struct {
+    uint16_t pushSeq;           // +1 per push frame across all topics
+    uint8_t  topic;             // One SMSG_TOPIC_* bit
+    uint8_t  fieldMask;         // Which fields follow, in bit order (see below)
+} __attribute__((packed)) SerialPushHeader;
+
+// SMSG_TOPIC_IO fields
+#define SMSG_PUSH_IO_INPUTS          0x01   // uint16_t
+#define SMSG_PUSH_IO_OUTPUTS         0x02   // uint16_t
+#define SMSG_PUSH_IO_CHANGE_COUNT    0x04   // uint32_t
+#define SMSG_PUSH_IO_LAST_CHANGE     0x08   // uint32_t
+
+// SMSG_TOPIC_SHARED fields
+#define SMSG_PUSH_SHARED_VERSION     0x01   // uint32_t
+#define SMSG_PUSH_SHARED_INPUTS      0x02   // uint32_t[MAX_INPUTS][SHARED_DATA_WORDS]
+#define SMSG_PUSH_SHARED_OUTPUTS     0x04   // uint32_t[MAX_INPUTS][SHARED_DATA_WORDS]
+#define SMSG_PUSH_SHARED_MY_BITS     0x08   // uint32_t, as SerialIOStatusPayload.myBits
+#define SMSG_PUSH_SHARED_BIT_INDEX   0x10   // uint8_t
+
+// SMSG_TOPIC_STATS fields: bits 0-5 are the six uint32_t counters of
+// SerialNetworkStatsPayload in order, then:
+#define SMSG_PUSH_STATS_RSSI         0x40   // int8_t
+#define SMSG_PUSH_STATS_LAST_SENDER  0x80   // uint8_t[6]
+
+// SMSG_TOPIC_DEVICES: fieldMask bits 0-6 hold the number of SerialDeviceRecord
+// entries that follow (changed devices only). SMSG_PUSH_DEVICES_RESET marks
+// the first frame of a full table snapshot: the host drops any device not
+// listed in the snapshot frames. Sent after SUBSCRIBE and whenever a device
+// leaves the table.
+#define SMSG_PUSH_DEVICES_RESET      0x80
+#define SMSG_PUSH_DEVICES_COUNT_MASK 0x7F
+
+typedef struct {
+    uint16_t hid;
+    uint8_t  bitIndex;
+    uint8_t  reserved;
+    uint16_t inputStates;
+    uint16_t outputStates;
+    uint16_t analog[2];
+    uint32_t ageMs;             // Time since the device's last report
+} __attribute__((packed)) SerialDeviceRecord;
+
+#define SERIAL_PUSH_MAX_DEVICE_RECORDS \
+    ((SERIAL_FRAME_MAX_PAYLOAD - sizeof(SerialPushHeader)) / sizeof(SerialDeviceRecord))
+
+// SMSG_TOPIC_CAPTURE: fieldMask holds the number of captured frames that
+// follow. Each is a CapturedFrame header (CAPTURED_FRAME_HEADER_SIZE bytes)
+// followed by capLen frame bytes. Capture pushes are not rate limited: the
+// ring drains as fast as the port allows.
+
+// ============================================================================
+// CAPTURE REPLAY
+// ============================================================================
+//
+// After the text command "REPLAY BEGIN" (radio TX muted), each
+// SMSG_REPLAY_FRAME runs one captured frame through the receive path and
+// returns the routing verdict, so a capture can be replayed into a bench node
+// to reproduce its decisions. "REPLAY END" unmutes the radio.
+
+typedef struct {
+    uint8_t  srcMAC[6];
+    int8_t   rssi;
+    uint8_t  reserved;
+    // Followed by the frame bytes
+} __attribute__((packed)) SerialReplayFrameRequest;
+
+typedef struct {
+    uint8_t  verdict;           // CaptureVerdict
+    uint8_t  reserved;
+    uint16_t txSuppressed;      // Frames the node tried to send in response
+} __attribute__((packed)) SerialReplayFrameResponse;
+
+// ============================================================================
+// DEVICE TABLE EXPORT
+// ============================================================================
+//
+// SMSG_DEVICE_TABLE pages through the root's aggregated device table. The
+// host asks for startIndex 0, then keeps asking from startIndex + recordCount
+// until it reaches totalCount. If updateSeq changes between pages, entries
+// may have moved (removals compact the table) and the host should restart.
+
+typedef struct {
+    uint8_t  startIndex;
+    uint8_t  maxRecords;        // 0 = as many as fit in one frame
+} __attribute__((packed)) SerialDeviceTableRequest;
+
+typedef struct {
+    uint32_t updateSeq;         // DataManager::getAggregatedUpdateSeq() when the page was read
+    uint8_t  totalCount;
+    uint8_t  startIndex;
+    uint8_t  recordCount;       // SerialDeviceRecord entries that follow
+    uint8_t  reserved;
+} __attribute__((packed)) SerialDeviceTableHeader;
+
+#define SERIAL_DEVICE_TABLE_MAX_RECORDS \
+    ((SERIAL_FRAME_MAX_PAYLOAD - sizeof(SerialDeviceTableHeader)) / sizeof(SerialDeviceRecord))
+
+// ============================================================================
+// FIRMWARE UPLOAD
+// ============================================================================
+//
+// Uploads an image for distribution down the tree (tree_ota.h). The host
+// sends SMSG_OTA_BEGIN with the size and SHA-256 of the .bin file, then the
+// file in order as SMSG_OTA_DATA chunks, waiting for each response. A chunk
+// at the wrong offset is refused with SMSG_ERR_STATE; the host reads
+// bytesReceived from SMSG_OTA_STATUS and resumes from there. After the last
+// chunk the node verifies the image and starts serving its children; poll
+// SMSG_OTA_STATUS to follow progress. All three reply with
+// SerialOtaStatusPayload.
+
+typedef struct {
+    uint32_t imageSize;
+    uint8_t  sha256[32];
+} __attribute__((packed)) SerialOtaBeginRequest;
+
+typedef struct {
+    uint32_t offset;
+    // Followed by up to SERIAL_OTA_MAX_CHUNK image bytes
+} __attribute__((packed)) SerialOtaDataHeader;
+
+#define SERIAL_OTA_MAX_CHUNK 192
+
+typedef struct {
+    uint8_t  state;             // TreeOtaState
+    uint8_t  error;             // TreeOtaError
+    uint8_t  childrenActive;
+    uint8_t  childrenVerified;
+    uint32_t imageSize;
+    uint32_t bytesReceived;
+    uint16_t blockCount;
+    uint16_t blocksSent;
+    uint16_t repairsPending;
+    uint16_t reserved;
+} __attribute__((packed)) SerialOtaStatusPayload;
+
+// ============================================================================
+// FRAMING FUNCTIONS
+// ============================================================================
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ */
+uint16_t serialCrc16(const uint8_t* data, size_t len);
+
+/**
+ * @brief COBS-encode len bytes into out (no delimiters added)
+ * @return encoded length, or 0 if outSize is too small
+ */
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out, size_t outSize);
+
+/**
+ * @brief Decode a COBS block (delimiters already stripped)
+ * @return decoded length, or 0 if the input is malformed or too long
+ */
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t outSize);
+
+/**
+ * @brief Build a complete wire frame including both 0x00 delimiters
+ * @return bytes written to out, 0 on error
+ */
+size_t serialBuildFrame(uint8_t msgId, uint8_t seq, const uint8_t* payload, size_t payloadLen,
+                        uint8_t* out, size_t outSize);
+
+/**
+ * @brief Decode and verify a received frame body (delimiters stripped)
+ * @param raw Scratch buffer of at least SERIAL_FRAME_MAX_RAW bytes; payload points into it
+ * @return SMSG_ERR_* code, or 0 on success
+ */
+uint8_t serialParseFrame(const uint8_t* encoded, size_t encodedLen, uint8_t* raw,
+                         uint8_t& msgId, uint8_t& seq, const uint8_t*& payload, size_t& payloadLen);
+
+#endif // SERIAL_PROTOCOL_H
@@ -0,0 +1,143 @@
+#include "tree_address.h"
+#include "DataManager.h"
+
+// ============================================================================
+// BIT-FIELD FORMAT
+// ============================================================================
+
+#define LEVEL_BITS  TREE_ADDR_BITS_PER_LEVEL
+#define LEVEL_MASK  ((1U << LEVEL_BITS) - 1)
+
+// Bits after the leading 1; a valid HID has a whole number of levels there
+static uint8_t pathBits(uint16_t hid) {
+    return 31 - __builtin_clz((uint32_t)hid);
+}
+
+static bool bitfieldValid(uint16_t hid, uint8_t bits) {
+    return hid != UNCONFIGURED_HID && hid != BROADCAST_HID && pathBits(hid) % bits == 0;
+}
+
+static uint8_t bitfieldDepth(uint16_t hid, uint8_t bits) {
+    return hid ? pathBits(hid) / bits : 0;
+}
+
+// ============================================================================
+// HIERARCHY
+// ============================================================================
+
+uint16_t treeAddrParent(uint16_t hid) {
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+    return bitfieldValid(hid, LEVEL_BITS) ? hid >> LEVEL_BITS : UNCONFIGURED_HID;
+#else
+    return hid / 10;
+#endif
+}
+
+uint8_t treeAddrDepth(uint16_t hid) {
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+    return bitfieldDepth(hid, LEVEL_BITS);
+#else
+    uint8_t depth = 0;
+    while (hid >= 10) {
+        hid /= 10;
+        depth++;
+    }
+    return depth;
+#endif
+}
+
+uint16_t treeAddrChild(uint16_t hid, uint8_t index) {
+    if (index >= TREE_ADDR_MAX_CHILDREN) return UNCONFIGURED_HID;
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+    uint32_t child = ((uint32_t)hid << LEVEL_BITS) | index;
+    return (child < BROADCAST_HID && bitfieldValid(hid, LEVEL_BITS)) ? child : UNCONFIGURED_HID;
+#else
+    uint32_t child = (uint32_t)hid * 10 + index;
+    return child < BROADCAST_HID ? child : UNCONFIGURED_HID;
+#endif
+}
+
+uint8_t treeAddrChildIndex(uint16_t hid) {
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+    return hid & LEVEL_MASK;
+#else
+    return hid % 10;
+#endif
+}
+
+bool treeAddrIsAncestor(uint16_t ancestor, uint16_t hid) {
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+    if (!bitfieldValid(ancestor, LEVEL_BITS) || !bitfieldValid(hid, LEVEL_BITS)) return false;
+    uint8_t ancestorBits = pathBits(ancestor);
+    uint8_t hidBits = pathBits(hid);
+    return hidBits > ancestorBits && (hid >> (hidBits - ancestorBits)) == ancestor;
+#else
+    if (ancestor == UNCONFIGURED_HID) return false;
+    while (hid > ancestor) {
+        hid /= 10;
+        if (hid == ancestor) return true;
+    }
+    return false;
+#endif
+}
+
+bool treeAddrIsValid(uint16_t hid) {
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+    return bitfieldValid(hid, LEVEL_BITS);
+#else
+    return hid != UNCONFIGURED_HID && hid <= MAX_HID_VALUE;
+#endif
+}
+
+// ============================================================================
+// COMPATIBILITY AND DISPLAY
+// ============================================================================
+
+uint16_t treeAddrConvert(uint16_t hid, uint8_t fromTag) {
+    if (fromTag == TREE_ADDR_FORMAT_TAG || hid == UNCONFIGURED_HID) {
+        return hid;
+    }
+
+    // Walk the stored HID's path from the root, one child index per level
+    uint8_t path[16];
+    uint8_t depth = 0;
+    if (fromTag == TREE_ADDR_TAG_DECIMAL) {
+        while (hid >= 10) {
+            path[depth++] = hid % 10;
+            hid /= 10;
+        }
+        if (hid != ROOT_HID) return UNCONFIGURED_HID;
+    } else {
+        uint8_t bits = fromTag & ~TREE_ADDR_TAG_BITFIELD;
+        if ((fromTag & TREE_ADDR_TAG_BITFIELD) == 0 || bits == 0 || bits > 8 || !bitfieldValid(hid, bits)) {
+            return UNCONFIGURED_HID;
+        }
+        for (uint8_t level = bitfieldDepth(hid, bits); level > 0; level--) {
+            path[depth++] = hid & ((1U << bits) - 1);
+            hid >>= bits;
+        }
+    }
+
+    uint16_t converted = ROOT_HID;
+    while (depth > 0) {
+        converted = treeAddrChild(converted, path[--depth]);
+        if (converted == UNCONFIGURED_HID) return UNCONFIGURED_HID;
+    }
+    return treeAddrIsValid(converted) ? converted : UNCONFIGURED_HID;
+}
+
+void treeAddrFormat(uint16_t hid, char* out, size_t outLen) {
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+    if (!bitfieldValid(hid, LEVEL_BITS)) {
+        snprintf(out, outLen, "%u", hid);
+        return;
+    }
+    size_t pos = snprintf(out, outLen, "1");
+    uint8_t depth = bitfieldDepth(hid, LEVEL_BITS);
+    for (int8_t level = depth - 1; level >= 0 && pos < outLen; level--) {
+        pos += snprintf(out + pos, outLen - pos, ".%u", (hid >> (level * LEVEL_BITS)) & LEVEL_MASK);
+    }
+#else
+    snprintf(out, outLen, "%u", hid);
+#endif
+}
@@ -0,0 +1,118 @@
+#ifndef TREE_ADDRESS_H
+#define TREE_ADDRESS_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// TREE ADDRESS CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Hierarchy arithmetic on HIDs: parent, depth, children, ancestry.
+ *
+ * Two formats, chosen at build time. Every node on a site must use the same
+ * one. Both fit the 16-bit HID fields, so frames and payloads don't change.
+ *
+ * TREE_ADDR_DECIMAL (original): each decimal digit is a level. The root is 1,
+ * its children are 10-19, theirs are 100-199, and so on. Parent = HID / 10.
+ * MAX_HID_VALUE (999) limits this to two levels below the root.
+ *
+ * TREE_ADDR_BITFIELD: a leading 1 bit followed by TREE_ADDR_BITS_PER_LEVEL
+ * bits per level. The root is still 1, child n of a node is
+ * (hid << bits) | n, and parent = hid >> bits. Depth comes from the position
+ * of the highest set bit, and an ancestor check is one shift and compare.
+ * With 4 bits per level this gives 16 children per node and three levels
+ * below the root. With 3 bits, it gives 8 children and five levels. Logs
+ * show a bit-field HID as its path, e.g. "1.3.12".
+ *
+ * HIDs are stored with a format tag (NodeConfigRecord::hidFormat, and next
+ * to the root's bit leases). When a node boots with another format compiled
+ * in, stored HIDs are converted level by level. A decimal HID maps to a
+ * bit-field HID if it is under root 1, every digit fits in a level and it is
+ * not too deep; the reverse needs every level below 10. HIDs that cannot be
+ * mapped are cleared and must be set again.
+ */
+#define TREE_ADDR_DECIMAL   0
+#define TREE_ADDR_BITFIELD  1
+
+#define TREE_ADDRESS_FORMAT        TREE_ADDR_DECIMAL
+#define TREE_ADDR_BITS_PER_LEVEL   4       // Bit-field format only
+
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+#define TREE_ADDR_MAX_CHILDREN  (1 << TREE_ADDR_BITS_PER_LEVEL)
+#define TREE_ADDR_MAX_DEPTH     (15 / TREE_ADDR_BITS_PER_LEVEL)   // Levels below the root
+#else
+#define TREE_ADDR_MAX_CHILDREN  10
+#define TREE_ADDR_MAX_DEPTH     3          // Deepest level the HID menu offers
+#endif
+
+// Stored next to persisted HIDs: 0 = decimal, 0x10 | bits per level = bit-field
+#define TREE_ADDR_TAG_DECIMAL   0x00
+#define TREE_ADDR_TAG_BITFIELD  0x10
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+#define TREE_ADDR_FORMAT_TAG    (TREE_ADDR_TAG_BITFIELD | TREE_ADDR_BITS_PER_LEVEL)
+#else
+#define TREE_ADDR_FORMAT_TAG    TREE_ADDR_TAG_DECIMAL
+#endif
+
+#define TREE_ADDR_FORMAT_LEN    24         // Buffer for treeAddrFormat()
+
+// Largest HID the format can encode, and a description for config errors and
+// the schema. In the bit-field format not every value below the maximum is a
+// valid path, so callers must still check treeAddrIsValid().
+#define TREE_ADDR_STR_(x)       #x
+#define TREE_ADDR_STR(x)        TREE_ADDR_STR_(x)
+#if TREE_ADDRESS_FORMAT == TREE_ADDR_BITFIELD
+#define TREE_ADDR_MAX_HID       ((1L << (1 + TREE_ADDR_MAX_DEPTH * TREE_ADDR_BITS_PER_LEVEL)) - 1)
+#define TREE_ADDR_RANGE_TEXT    "a leading 1 bit, then " TREE_ADDR_STR(TREE_ADDR_BITS_PER_LEVEL) " bits per level"
+#else
+#define TREE_ADDR_MAX_HID       MAX_HID_VALUE
+#define TREE_ADDR_RANGE_TEXT    "1-" TREE_ADDR_STR(MAX_HID_VALUE) ", one digit per level"
+#endif
+
+// ============================================================================
+// TREE ADDRESS API
+// ============================================================================
+
+/**
+ * @brief Parent of hid; UNCONFIGURED_HID for the root or an invalid hid
+ */
+uint16_t treeAddrParent(uint16_t hid);
+
+/**
+ * @brief Levels below the root (root = 0)
+ */
+uint8_t treeAddrDepth(uint16_t hid);
+
+/**
+ * @brief Child number index of hid; UNCONFIGURED_HID if it doesn't fit
+ */
+uint16_t treeAddrChild(uint16_t hid, uint8_t index);
+
+/**
+ * @brief Position of hid under its parent (0 .. TREE_ADDR_MAX_CHILDREN-1)
+ */
+uint8_t treeAddrChildIndex(uint16_t hid);
+
+/**
+ * @brief True if ancestor is hid's parent, grandparent, ... (not hid itself)
+ */
+bool treeAddrIsAncestor(uint16_t ancestor, uint16_t hid);
+
+/**
+ * @brief True if hid can be assigned to a node in the compiled format
+ */
+bool treeAddrIsValid(uint16_t hid);
+
+/**
+ * @brief Map a HID stored under another format tag to the compiled format
+ * @return Converted HID, or UNCONFIGURED_HID if it has no equivalent
+ */
+uint16_t treeAddrConvert(uint16_t hid, uint8_t fromTag);
+
+/**
+ * @brief Human-readable HID: decimal digits, or the dotted bit-field path
+ */
+void treeAddrFormat(uint16_t hid, char* out, size_t outLen);
+
+#endif // TREE_ADDRESS_H
@@ -0,0 +1,668 @@
+#include "tree_ota.h"
+#include "debug.h"
+#include "espnow_wrapper.h"
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+#include <Preferences.h>
+
+// Logging macros for the tree OTA module
+#define MODULE_TITLE       "OTA"
+#define MODULE_DEBUG_LEVEL 1
+#define otaLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+#define OTA_SECTOR_SIZE   4096
+#define OTA_HASH_CHUNK    1024
+#define OTA_HASH_CHUNKS_PER_PASS 4
+#define OTA_CHILD_UNKNOWN 0xFF
+
+// ============================================================================
+// SESSION STATE
+// ============================================================================
+
+static volatile uint8_t otaState = OTA_STATE_IDLE;
+static uint8_t otaError = OTA_ERR_NONE;
+static const esp_partition_t* otaPartition = nullptr;
+static uint32_t otaImageSize = 0;
+static uint8_t otaSha[OTA_SHA256_SIZE];
+static volatile uint32_t otaSessionId = 0;
+static uint16_t otaBlockCount = 0;
+static bool otaFromSerial = false;          // Image came over serial, not from the parent
+static uint32_t otaSerialOffset = 0;
+
+// Receiving
+#if ENABLE_TREE_OTA
+static uint8_t receivedMap[OTA_BITMAP_BYTES];
+static uint8_t repairMap[OTA_BITMAP_BYTES];
+#endif
+static uint16_t receivedBlocks = 0;
+static uint32_t erasedThrough = 0;          // Partition bytes erased so far
+static uint16_t parentBlocksSent = 0;
+static uint32_t lastAnnounceRxMs = 0;
+static uint32_t lastStatusTxMs = 0;
+static bool statusDue = false;
+static bool parentOffersInstalled = false;  // Parent's image is the one already running
+
+// Verifying
+static uint32_t hashOffset = 0;
+static mbedtls_sha256_context hashCtx;
+
+// Serving
+struct OtaChild {
+    uint8_t  state;                         // TreeOtaState reported, or OTA_CHILD_UNKNOWN
+    uint32_t lastMs;
+};
+static OtaChild children[OTA_MAX_CHILDREN];
+static uint16_t serveCursor = 0;            // Next block of the first pass
+static uint16_t repairCursor = 0;
+static uint16_t repairsPending = 0;
+static uint32_t serveStartMs = 0;
+static uint32_t lastAnnounceTxMs = 0;
+static uint32_t lastBlockTxMs = 0;
+static uint32_t rebootAtMs = 0;
+
+static uint8_t installedSha[OTA_SHA256_SIZE];
+static bool installedShaValid = false;
+
+// Frames from the Wi-Fi task, handled in loop()
+struct OtaQueuedFrame {
+    uint8_t  msgType;
+    uint16_t srcHID;
+    uint8_t  len;
+    uint8_t  data[OTA_FRAME_PAYLOAD_MAX];
+};
+#if ENABLE_TREE_OTA
+static OtaQueuedFrame rxQueue[OTA_RX_QUEUE_SIZE];
+#endif
+static uint8_t rxQueueHead = 0;
+static uint8_t rxQueueCount = 0;
+static uint32_t rxQueueDrops = 0;
+static portMUX_TYPE otaMux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool testBit(const uint8_t* map, uint16_t index) {
+    return map[index >> 3] & (1 << (index & 7));
+}
+
+static void setBit(uint8_t* map, uint16_t index) {
+    map[index >> 3] |= (1 << (index & 7));
+}
+
+static void clearBit(uint8_t* map, uint16_t index) {
+    map[index >> 3] &= ~(1 << (index & 7));
+}
+
+static uint32_t sessionIdFor(const uint8_t* sha256) {
+    uint32_t id;
+    memcpy(&id, sha256, sizeof(id));
+    return id;
+}
+
+static uint16_t blockLen(uint16_t index) {
+    uint32_t remaining = otaImageSize - (uint32_t)index * OTA_BLOCK_SIZE;
+    return (remaining < OTA_BLOCK_SIZE) ? remaining : OTA_BLOCK_SIZE;
+}
+
+const char* treeOtaStateName(uint8_t state) {
+    switch (state) {
+        case OTA_STATE_IDLE:      return "idle";
+        case OTA_STATE_RECEIVING: return "receiving";
+        case OTA_STATE_VERIFYING: return "verifying";
+        case OTA_STATE_SERVING:   return "serving";
+        case OTA_STATE_DONE:      return "done";
+        case OTA_STATE_FAILED:    return "failed";
+        default:                  return "unknown";
+    }
+}
+
+// ============================================================================
+// FLASH
+// ============================================================================
+
+static void fail(uint8_t error) {
+    otaLog("Update failed, error " + String(error), 1);
+    otaError = error;
+    otaState = OTA_STATE_FAILED;
+    statusDue = true;
+}
+
+/**
+ * @brief Erase sectors up to endOffset, as writes reach them
+ */
+static bool ensureErased(uint32_t endOffset) {
+    while (erasedThrough < endOffset) {
+        if (esp_partition_erase_range(otaPartition, erasedThrough, OTA_SECTOR_SIZE) != ESP_OK) {
+            return false;
+        }
+        erasedThrough += OTA_SECTOR_SIZE;
+    }
+    return true;
+}
+
+static bool writeImage(uint32_t offset, const uint8_t* data, size_t len) {
+    if (!ensureErased(offset + len) || esp_partition_write(otaPartition, offset, data, len) != ESP_OK) {
+        fail(OTA_ERR_FLASH);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Point the bootloader back at the running image if we had switched it
+ */
+static void revertBootPartition() {
+    if (otaState == OTA_STATE_SERVING || otaState == OTA_STATE_DONE) {
+        esp_ota_set_boot_partition(esp_ota_get_running_partition());
+    }
+}
+
+static bool startSession(uint32_t imageSize, const uint8_t* sha256, bool fromSerial) {
+#if ENABLE_TREE_OTA
+    revertBootPartition();
+    if (otaState == OTA_STATE_VERIFYING) {
+        mbedtls_sha256_free(&hashCtx);
+    }
+
+    otaPartition = esp_ota_get_next_update_partition(nullptr);
+    otaError = OTA_ERR_NONE;
+    if (!otaPartition) {
+        fail(OTA_ERR_NO_PARTITION);
+        return false;
+    }
+    if (imageSize == 0 || imageSize > otaPartition->size || imageSize > (uint32_t)OTA_MAX_BLOCKS * OTA_BLOCK_SIZE) {
+        fail(OTA_ERR_TOO_LARGE);
+        return false;
+    }
+
+    portENTER_CRITICAL(&otaMux);
+    rxQueueCount = 0;               // Blocks of a previous session
+    portEXIT_CRITICAL(&otaMux);
+
+    otaImageSize = imageSize;
+    memcpy(otaSha, sha256, OTA_SHA256_SIZE);
+    otaSessionId = sessionIdFor(sha256);
+    otaBlockCount = (imageSize + OTA_BLOCK_SIZE - 1) / OTA_BLOCK_SIZE;
+    otaFromSerial = fromSerial;
+    otaSerialOffset = 0;
+    memset(receivedMap, 0, sizeof(receivedMap));
+    receivedBlocks = 0;
+    erasedThrough = 0;
+    parentBlocksSent = 0;
+    statusDue = !fromSerial;
+    otaState = OTA_STATE_RECEIVING;
+
+    otaLog("Receiving " + String(imageSize) + " byte image (" + String(otaBlockCount) + " blocks) from " +
+           String(fromSerial ? "serial" : "parent"), 2);
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void beginVerify() {
+    otaState = OTA_STATE_VERIFYING;
+    hashOffset = 0;
+    mbedtls_sha256_init(&hashCtx);
+    mbedtls_sha256_starts(&hashCtx, 0);
+}
+
+// ============================================================================
+// RECEIVING
+// ============================================================================
+
+static void markReceived(uint16_t index) {
+#if ENABLE_TREE_OTA
+    if (!testBit(receivedMap, index)) {
+        setBit(receivedMap, index);
+        receivedBlocks++;
+    }
+    if (receivedBlocks == otaBlockCount) {
+        beginVerify();
+    }
+#endif
+}
+
+static void handleBlock(const uint8_t* payload, size_t len) {
+#if ENABLE_TREE_OTA
+    if (len < sizeof(OtaBlockHeader) || otaState != OTA_STATE_RECEIVING || otaFromSerial) {
+        return;
+    }
+    OtaBlockHeader block;
+    memcpy(&block, payload, sizeof(block));
+    if (block.sessionId != otaSessionId || block.blockIndex >= otaBlockCount ||
+        len - sizeof(block) != blockLen(block.blockIndex) || testBit(receivedMap, block.blockIndex)) {
+        return;
+    }
+    if (writeImage((uint32_t)block.blockIndex * OTA_BLOCK_SIZE, payload + sizeof(block), len - sizeof(block))) {
+        markReceived(block.blockIndex);
+    }
+#endif
+}
+
+/**
+ * @brief What to tell the parent about its session
+ */
+static uint8_t reportedState() {
+    if (parentOffersInstalled) {
+        return OTA_STATE_SERVING;           // Already running that image
+    }
+    switch (otaState) {
+        case OTA_STATE_DONE:
+            return OTA_STATE_SERVING;
+        default:
+            return otaState;
+    }
+}
+
+static void handleAnnounce(const uint8_t* payload, size_t len, uint32_t now) {
+    if (len < sizeof(OtaAnnouncePayload)) {
+        return;
+    }
+    OtaAnnouncePayload announce;
+    memcpy(&announce, payload, sizeof(announce));
+    uint32_t sessionId = sessionIdFor(announce.sha256);
+
+    if (lastAnnounceRxMs == 0 || now - lastAnnounceRxMs > OTA_PARENT_TIMEOUT_MS) {
+        statusDue = true;                   // Parent (re)started serving
+    }
+    lastAnnounceRxMs = now;
+
+    parentOffersInstalled = installedShaValid && memcmp(announce.sha256, installedSha, OTA_SHA256_SIZE) == 0;
+    if (parentOffersInstalled) {
+        return;
+    }
+
+    bool sameSession = otaState != OTA_STATE_IDLE && sessionId == otaSessionId;
+    if (sameSession) {
+        parentBlocksSent = announce.blocksSent;
+        if (otaState == OTA_STATE_FAILED && otaError == OTA_ERR_HASH) {
+            startSession(announce.imageSize, announce.sha256, false);   // Corrupt block got through: start over
+        }
+        return;
+    }
+    if (otaFromSerial && otaState != OTA_STATE_IDLE && otaState != OTA_STATE_FAILED) {
+        return;                             // A local upload takes precedence
+    }
+    if (startSession(announce.imageSize, announce.sha256, false)) {
+        parentBlocksSent = announce.blocksSent;
+    }
+}
+
+static void sendStatus(uint32_t now) {
+#if ENABLE_TREE_OTA
+    OtaStatusPayload status = {};
+    status.sessionId = parentOffersInstalled ? 0 : otaSessionId;
+    status.state = reportedState();
+
+    if (otaState == OTA_STATE_RECEIVING && !parentOffersInstalled) {
+        uint16_t base = 0;
+        while (base < otaBlockCount && testBit(receivedMap, base)) {
+            base++;
+        }
+        status.baseBlock = base;
+        for (uint16_t n = 0; n < OTA_NACK_BITMAP_BYTES * 8; n++) {
+            uint16_t index = base + n;
+            if (index >= otaBlockCount || index >= parentBlocksSent) {
+                break;                      // Not sent yet, no point asking
+            }
+            if (!testBit(receivedMap, index)) {
+                status.missing[n >> 3] |= (1 << (n & 7));
+            }
+        }
+    }
+
+    sendTreeCommand(DATA_MGR.getParentHID(), MSG_OTA_STATUS, (const uint8_t*)&status, sizeof(status));
+    lastStatusTxMs = now;
+    statusDue = false;
+#endif
+}
+
+static void reportToParent(uint32_t now) {
+    if (lastAnnounceRxMs == 0 || now - lastAnnounceRxMs > OTA_PARENT_TIMEOUT_MS) {
+        return;                             // Parent isn't serving
+    }
+    // Spread the children's reports over the interval
+    uint32_t stagger = treeAddrChildIndex(DATA_MGR.getMyHID()) * (OTA_STATUS_INTERVAL_MS / OTA_MAX_CHILDREN);
+    if (statusDue || now - lastStatusTxMs >= OTA_STATUS_INTERVAL_MS + stagger) {
+        sendStatus(now);
+    }
+}
+
+// ============================================================================
+// VERIFYING
+// ============================================================================
+
+static void verifyStep() {
+    uint8_t chunk[OTA_HASH_CHUNK];
+    for (int i = 0; i < OTA_HASH_CHUNKS_PER_PASS && hashOffset < otaImageSize; i++) {
+        uint32_t len = (otaImageSize - hashOffset < OTA_HASH_CHUNK) ? otaImageSize - hashOffset : OTA_HASH_CHUNK;
+        if (esp_partition_read(otaPartition, hashOffset, chunk, len) != ESP_OK) {
+            mbedtls_sha256_free(&hashCtx);
+            fail(OTA_ERR_FLASH);
+            return;
+        }
+        mbedtls_sha256_update(&hashCtx, chunk, len);
+        hashOffset += len;
+    }
+    if (hashOffset < otaImageSize) {
+        return;
+    }
+
+    uint8_t digest[OTA_SHA256_SIZE];
+    mbedtls_sha256_finish(&hashCtx, digest);
+    mbedtls_sha256_free(&hashCtx);
+
+    if (memcmp(digest, otaSha, OTA_SHA256_SIZE) != 0) {
+        fail(OTA_ERR_HASH);
+        return;
+    }
+    if (esp_ota_set_boot_partition(otaPartition) != ESP_OK) {
+        fail(OTA_ERR_IMAGE);
+        return;
+    }
+
+    Preferences prefs;
+    if (prefs.begin("tree_ota", false)) {
+        prefs.putBytes("sha256", otaSha, OTA_SHA256_SIZE);
+        prefs.end();
+    }
+
+    otaLog("Image verified, boot partition switched to " + String(otaPartition->label), 2);
+    for (OtaChild& child : children) {
+        child.state = OTA_CHILD_UNKNOWN;
+        child.lastMs = 0;
+    }
+#if ENABLE_TREE_OTA
+    memset(repairMap, 0, sizeof(repairMap));
+#endif
+    repairsPending = 0;
+    repairCursor = 0;
+    serveCursor = 0;
+    serveStartMs = millis();
+    lastAnnounceTxMs = 0;
+    statusDue = true;
+    otaState = OTA_STATE_SERVING;
+}
+
+// ============================================================================
+// SERVING
+// ============================================================================
+
+static void handleChildStatus(uint16_t childHID, const uint8_t* payload, size_t len, uint32_t now) {
+#if ENABLE_TREE_OTA
+    if (len < sizeof(OtaStatusPayload) || otaState != OTA_STATE_SERVING) {
+        return;
+    }
+    OtaStatusPayload status;
+    memcpy(&status, payload, sizeof(status));
+    OtaChild& child = children[treeAddrChildIndex(childHID)];
+    if (status.sessionId != otaSessionId && status.sessionId != 0) {
+        return;                             // Still on an older session
+    }
+    child.state = status.state;
+    child.lastMs = now;
+
+    if (status.state != OTA_STATE_RECEIVING) {
+        return;
+    }
+    for (uint16_t n = 0; n < OTA_NACK_BITMAP_BYTES * 8; n++) {
+        uint32_t index = (uint32_t)status.baseBlock + n;
+        if (index >= serveCursor) {
+            break;                          // The first pass will get there
+        }
+        if ((status.missing[n >> 3] & (1 << (n & 7))) && !testBit(repairMap, index)) {
+            setBit(repairMap, index);
+            repairsPending++;
+        }
+    }
+#endif
+}
+
+static void countChildren(uint32_t now, uint8_t& active, uint8_t& verified) {
+    active = 0;
+    verified = 0;
+    for (const OtaChild& child : children) {
+        if (child.state == OTA_STATE_SERVING) {
+            verified++;
+        } else if ((child.state == OTA_STATE_RECEIVING || child.state == OTA_STATE_VERIFYING) &&
+                   now - child.lastMs < OTA_CHILD_TIMEOUT_MS) {
+            active++;
+        }
+    }
+}
+
+static void sendAnnounce(uint32_t now) {
+    OtaAnnouncePayload announce;
+    announce.imageSize = otaImageSize;
+    memcpy(announce.sha256, otaSha, OTA_SHA256_SIZE);
+    announce.blocksSent = serveCursor;
+    announce.reserved = 0;
+    sendTreeCommand(BROADCAST_HID, MSG_OTA_ANNOUNCE, (const uint8_t*)&announce, sizeof(announce));
+    lastAnnounceTxMs = now;
+}
+
+static void sendNextBlock(uint32_t now) {
+#if ENABLE_TREE_OTA
+    if (now - lastBlockTxMs < OTA_BLOCK_INTERVAL_MS || now - espnowGetLastForegroundTxMs() < OTA_IO_HOLDOFF_MS) {
+        return;
+    }
+
+    int32_t index = -1;
+    if (repairsPending > 0) {
+        for (uint16_t n = 0; n < otaBlockCount; n++) {
+            uint16_t candidate = (repairCursor + n) % otaBlockCount;
+            if (testBit(repairMap, candidate)) {
+                clearBit(repairMap, candidate);
+                repairsPending--;
+                repairCursor = candidate + 1;
+                index = candidate;
+                break;
+            }
+        }
+    } else if (serveCursor < otaBlockCount) {
+        index = serveCursor++;
+    }
+    if (index < 0) {
+        return;
+    }
+
+    uint8_t payload[OTA_FRAME_PAYLOAD_MAX];
+    OtaBlockHeader block;
+    block.sessionId = otaSessionId;
+    block.blockIndex = index;
+    uint16_t len = blockLen(index);
+    memcpy(payload, &block, sizeof(block));
+    if (esp_partition_read(otaPartition, (uint32_t)index * OTA_BLOCK_SIZE, payload + sizeof(block), len) != ESP_OK) {
+        return;
+    }
+    sendTreeCommand(BROADCAST_HID, MSG_OTA_BLOCK, payload, sizeof(block) + len);
+    lastBlockTxMs = now;
+#endif
+}
+
+static void serveStep(uint32_t now) {
+    if (now - lastAnnounceTxMs >= OTA_ANNOUNCE_INTERVAL_MS) {
+        sendAnnounce(now);
+    }
+
+    uint8_t active, verified;
+    countChildren(now, active, verified);
+
+    if (active > 0) {
+        sendNextBlock(now);
+        return;
+    }
+    // Nobody is waiting: every child that took part has verified, failed or gone quiet
+    if (now - serveStartMs >= OTA_DISCOVERY_MS) {
+        otaLog("Serving finished (" + String(verified) + " children verified), restarting in " +
+               String(OTA_REBOOT_DELAY_MS) + " ms", 2);
+        otaState = OTA_STATE_DONE;
+        rebootAtMs = now + OTA_REBOOT_DELAY_MS;
+    }
+}
+
+// ============================================================================
+// TREE OTA API
+// ============================================================================
+
+void treeOtaInit() {
+    Preferences prefs;
+    if (prefs.begin("tree_ota", true)) {
+        installedShaValid = prefs.getBytes("sha256", installedSha, OTA_SHA256_SIZE) == OTA_SHA256_SIZE;
+        prefs.end();
+    }
+    for (OtaChild& child : children) {
+        child.state = OTA_CHILD_UNKNOWN;
+    }
+}
+
+bool treeOtaBeginLocal(uint32_t imageSize, const uint8_t* sha256) {
+    parentOffersInstalled = false;
+    return startSession(imageSize, sha256, true);
+}
+
+bool treeOtaWriteLocal(uint32_t offset, const uint8_t* data, size_t len) {
+#if ENABLE_TREE_OTA
+    if (otaState != OTA_STATE_RECEIVING || !otaFromSerial || offset != otaSerialOffset ||
+        len == 0 || offset + len > otaImageSize) {
+        return false;
+    }
+    if (!writeImage(offset, data, len)) {
+        return false;
+    }
+    otaSerialOffset += len;
+    if (otaSerialOffset == otaImageSize) {
+        memset(receivedMap, 0xFF, sizeof(receivedMap));
+        receivedBlocks = otaBlockCount;
+        beginVerify();
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void treeOtaAbort() {
+    if (otaState == OTA_STATE_SERVING || otaState == OTA_STATE_DONE) {
+        Preferences prefs;
+        if (prefs.begin("tree_ota", false)) {
+            prefs.remove("sha256");         // Still running the old image
+            prefs.end();
+        }
+    }
+    revertBootPartition();
+    if (otaState == OTA_STATE_VERIFYING) {
+        mbedtls_sha256_free(&hashCtx);
+    }
+    if (otaState != OTA_STATE_IDLE) {
+        otaLog("Update aborted", 2);
+        otaError = OTA_ERR_ABORTED;
+    }
+    otaState = OTA_STATE_IDLE;
+    otaSessionId = 0;
+    otaFromSerial = false;
+}
+
+void treeOtaHandleFrame(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen) {
+#if ENABLE_TREE_OTA
+    if (!payload || payloadLen == 0 || payloadLen > OTA_FRAME_PAYLOAD_MAX || !DATA_MGR.isHIDConfigured()) {
+        return;
+    }
+    if (header->msg_type == MSG_OTA_STATUS) {
+        if (header->dest_hid != DATA_MGR.getMyHID() || treeAddrParent(header->src_hid) != DATA_MGR.getMyHID()) {
+            return;                         // Only from direct children
+        }
+    } else {
+        if (DATA_MGR.isRoot() || header->broadcaster_hid != DATA_MGR.getParentHID()) {
+            return;                         // Images only come from the parent
+        }
+        if (header->msg_type == MSG_OTA_BLOCK && otaState != OTA_STATE_RECEIVING) {
+            return;
+        }
+    }
+
+    portENTER_CRITICAL(&otaMux);
+    if (rxQueueCount < OTA_RX_QUEUE_SIZE) {
+        OtaQueuedFrame& frame = rxQueue[(rxQueueHead + rxQueueCount) % OTA_RX_QUEUE_SIZE];
+        frame.msgType = header->msg_type;
+        frame.srcHID = header->src_hid;
+        frame.len = payloadLen;
+        memcpy(frame.data, payload, payloadLen);
+        rxQueueCount++;
+    } else {
+        rxQueueDrops++;                     // A missed block is NACKed later
+    }
+    portEXIT_CRITICAL(&otaMux);
+#endif
+}
+
+void treeOtaUpdate() {
+#if ENABLE_TREE_OTA
+    uint32_t now = millis();
+
+    // Drain what the Wi-Fi task queued; flash writes happen here
+    OtaQueuedFrame frame;
+    while (true) {
+        portENTER_CRITICAL(&otaMux);
+        bool available = rxQueueCount > 0;
+        if (available) {
+            const OtaQueuedFrame& queued = rxQueue[rxQueueHead];
+            memcpy(&frame, &queued, offsetof(OtaQueuedFrame, data) + queued.len);
+            rxQueueHead = (rxQueueHead + 1) % OTA_RX_QUEUE_SIZE;
+            rxQueueCount--;
+        }
+        portEXIT_CRITICAL(&otaMux);
+        if (!available) {
+            break;
+        }
+
+        switch (frame.msgType) {
+            case MSG_OTA_ANNOUNCE:
+                handleAnnounce(frame.data, frame.len, now);
+                break;
+            case MSG_OTA_BLOCK:
+                handleBlock(frame.data, frame.len);
+                break;
+            case MSG_OTA_STATUS:
+                handleChildStatus(frame.srcHID, frame.data, frame.len, now);
+                break;
+        }
+    }
+
+    switch (otaState) {
+        case OTA_STATE_VERIFYING:
+            verifyStep();
+            break;
+        case OTA_STATE_SERVING:
+            serveStep(now);
+            break;
+        case OTA_STATE_DONE:
+            if ((int32_t)(now - rebootAtMs) >= 0) {
+                otaLog("Restarting into the new image", 1);
+                delay(100);
+                ESP.restart();
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (!DATA_MGR.isRoot() && !otaFromSerial) {
+        reportToParent(now);
+    }
+#endif
+}
+
+void treeOtaGetStatus(TreeOtaStatus& out) {
+    uint32_t now = millis();
+    out.state = otaState;
+    out.error = otaError;
+    out.imageSize = otaImageSize;
+    out.blockCount = otaBlockCount;
+    out.bytesReceived = otaFromSerial ? otaSerialOffset
+                                      : ((uint32_t)receivedBlocks * OTA_BLOCK_SIZE < otaImageSize
+                                             ? (uint32_t)receivedBlocks * OTA_BLOCK_SIZE : otaImageSize);
+    out.blocksSent = serveCursor;
+    out.repairsPending = repairsPending;
+    out.queueDrops = rxQueueDrops;
+    countChildren(now, out.childrenActive, out.childrenVerified);
+}
@@ -0,0 +1,183 @@
+#ifndef TREE_OTA_H
+#define TREE_OTA_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+#include "frame_auth.h"
+
+// ============================================================================
+// TREE OTA CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Firmware distribution down the ESP-NOW tree.
+ *
+ * The root (or any node) receives a firmware image over serial
+ * (SMSG_OTA_BEGIN / SMSG_OTA_DATA) and writes it to its inactive OTA
+ * partition. Each node then works through the same steps:
+ *
+ * 1. Verify: compute the SHA-256 of the partition and compare it with the
+ *    hash announced with the image. Only on a match is the boot partition
+ *    switched (esp_ota_set_boot_partition also checks the image).
+ * 2. Serve: broadcast MSG_OTA_ANNOUNCE once a second, then send the image
+ *    as MSG_OTA_BLOCK broadcasts to the children.
+ * 3. Children write the blocks to their own inactive partition. Once a
+ *    second each child sends its parent a MSG_OTA_STATUS with a bitmap of
+ *    missing blocks. The parent merges these per-child NACK bitmaps into
+ *    one repair set, and resends each missing block once for all children.
+ * 4. When every child reports VERIFIED, or has gone quiet, the node
+ *    restarts into the new image. Children that verified are serving their
+ *    own children by then.
+ *
+ * A node that hears no child within OTA_DISCOVERY_MS skips serving. A node
+ * whose installed image already matches the announced hash reports VERIFIED
+ * straight away.
+ *
+ * I/O traffic keeps priority:
+ * - Blocks go out from the loop task no more often than every
+ *   OTA_BLOCK_INTERVAL_MS.
+ * - No block is sent within OTA_IO_HOLDOFF_MS of any other frame, so a
+ *   MSG_DISTRIBUTED_IO_UPDATE waits behind at most one block already on
+ *   the air.
+ * - Receivers erase flash one 4 KB sector at a time, as blocks reach it,
+ *   which is about one erase every 18 blocks.
+ *
+ * Needs frame authentication (ENABLE_FRAME_AUTH in frame_auth.h). A node
+ * accepts an image from whichever radio claims to be its parent, and the
+ * only check is the SHA-256 carried in the same announce. Without frame
+ * authentication, any radio in range could flash every node. Set a site
+ * key (FRAME_AUTH_KEY), enable frame authentication, then turn this on.
+ *
+ * Off by default. Set to 1 to enable; the build fails if frame
+ * authentication is off.
+ */
+#define ENABLE_TREE_OTA 0
+
+#if ENABLE_TREE_OTA && !ENABLE_FRAME_AUTH
+#error "ENABLE_TREE_OTA needs ENABLE_FRAME_AUTH: unauthenticated OTA frames would let any radio flash the tree"
+#endif
+
+#if ENABLE_FRAME_AUTH
+#define OTA_BLOCK_SIZE            208     // Multiple of 16, with room for the auth trailer
+#else
+#define OTA_BLOCK_SIZE            224     // Multiple of 16 for flash encryption
+#endif
+#define OTA_MAX_BLOCKS            16384   // 3.5 MB images (3.25 MB with frame auth)
+#define OTA_BITMAP_BYTES          (OTA_MAX_BLOCKS / 8)
+#define OTA_NACK_BITMAP_BYTES     32      // Blocks covered by one status report: 256
+#define OTA_BLOCK_INTERVAL_MS     30
+#define OTA_IO_HOLDOFF_MS         20
+#define OTA_ANNOUNCE_INTERVAL_MS  1000
+#define OTA_STATUS_INTERVAL_MS    1000
+#define OTA_DISCOVERY_MS          3000    // Announce this long before deciding there are no children
+#define OTA_CHILD_TIMEOUT_MS      10000   // Child with no status for this long is given up on
+#define OTA_PARENT_TIMEOUT_MS     5000    // Stop reporting after this long without an announce
+#define OTA_RX_QUEUE_SIZE         8
+#define OTA_REBOOT_DELAY_MS       3000
+#define OTA_SHA256_SIZE           32
+#define OTA_MAX_CHILDREN          TREE_ADDR_MAX_CHILDREN   // Indexed by treeAddrChildIndex()
+
+enum TreeOtaState : uint8_t {
+    OTA_STATE_IDLE      = 0,
+    OTA_STATE_RECEIVING = 1,    // Writing blocks (from serial or the parent)
+    OTA_STATE_VERIFYING = 2,    // Hashing the written image
+    OTA_STATE_SERVING   = 3,    // Verified and boot partition switched; sending to children
+    OTA_STATE_DONE      = 4,    // Restarting shortly
+    OTA_STATE_FAILED    = 5
+};
+
+enum TreeOtaError : uint8_t {
+    OTA_ERR_NONE         = 0,
+    OTA_ERR_NO_PARTITION = 1,
+    OTA_ERR_TOO_LARGE    = 2,
+    OTA_ERR_FLASH        = 3,
+    OTA_ERR_HASH         = 4,   // SHA-256 mismatch
+    OTA_ERR_IMAGE        = 5,   // Hash matched but the image was refused as a boot partition
+    OTA_ERR_ABORTED      = 6
+};
+
+/**
+ * @brief MSG_OTA_ANNOUNCE payload (broadcast by a serving node)
+ */
+typedef struct {
+    uint32_t imageSize;
+    uint8_t  sha256[OTA_SHA256_SIZE];   // First 4 bytes double as the session id
+    uint16_t blocksSent;                // Blocks 0..blocksSent-1 went out at least once
+    uint16_t reserved;
+} __attribute__((packed)) OtaAnnouncePayload;
+
+/**
+ * @brief MSG_OTA_BLOCK payload header, followed by the block data
+ */
+typedef struct {
+    uint32_t sessionId;
+    uint16_t blockIndex;
+} __attribute__((packed)) OtaBlockHeader;
+
+/**
+ * @brief MSG_OTA_STATUS payload (child to parent)
+ */
+typedef struct {
+    uint32_t sessionId;
+    uint8_t  state;                     // TreeOtaState; SERVING means verified
+    uint8_t  reserved;
+    uint16_t baseBlock;                 // First block covered by missing[]
+    uint8_t  missing[OTA_NACK_BITMAP_BYTES];   // Bit n set = baseBlock + n still needed
+} __attribute__((packed)) OtaStatusPayload;
+
+#define OTA_FRAME_PAYLOAD_MAX (sizeof(OtaBlockHeader) + OTA_BLOCK_SIZE)
+
+struct TreeOtaStatus {
+    uint8_t  state = OTA_STATE_IDLE;
+    uint8_t  error = OTA_ERR_NONE;
+    uint8_t  childrenActive = 0;        // Children still receiving or verifying
+    uint8_t  childrenVerified = 0;
+    uint32_t imageSize = 0;
+    uint32_t bytesReceived = 0;
+    uint16_t blockCount = 0;
+    uint16_t blocksSent = 0;            // First pass progress while serving
+    uint16_t repairsPending = 0;
+    uint32_t queueDrops = 0;            // Frames dropped because the receive queue was full
+};
+
+// ============================================================================
+// TREE OTA API
+// ============================================================================
+
+/**
+ * @brief Load the hash of the installed image. Call once from setup().
+ */
+void treeOtaInit();
+
+/**
+ * @brief Write queued blocks, hash, serve, report and restart. Call from loop().
+ */
+void treeOtaUpdate();
+
+/**
+ * @brief Start receiving an image over serial on this node
+ * @return false if the image doesn't fit the OTA partition
+ */
+bool treeOtaBeginLocal(uint32_t imageSize, const uint8_t* sha256);
+
+/**
+ * @brief Write the next chunk of a serial image; chunks must be in order
+ * @return false if offset isn't the next expected byte or the write failed
+ */
+bool treeOtaWriteLocal(uint32_t offset, const uint8_t* data, size_t len);
+
+/**
+ * @brief Stop any session and keep booting the running image
+ */
+void treeOtaAbort();
+
+/**
+ * @brief Receive path hook for the MSG_OTA_* types. Called from the Wi-Fi
+ *        task; only queues the frame.
+ */
+void treeOtaHandleFrame(const TreeMessageHeader* header, const uint8_t* payload, size_t payloadLen);
+
+void treeOtaGetStatus(TreeOtaStatus& out);
+const char* treeOtaStateName(uint8_t state);
+
+#endif // TREE_OTA_H
@@ -0,0 +1,273 @@
+#include "tx_queue.h"
+#include "debug.h"
+#include <esp_now.h>
+
+// Logging macros for the TX queue module
+#define MODULE_TITLE       "TXQ"
+#define MODULE_DEBUG_LEVEL 1
+#define txqLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// QUEUE STATE
+// ============================================================================
+
+struct TxQueueEntry {
+    uint8_t  mac[6];
+    uint8_t  len;
+    uint32_t queuedMs;
+    uint8_t  data[TXQ_MAX_FRAME];
+};
+
+struct TxRing {
+    uint8_t base;               // First slot in entries[]
+    uint8_t capacity;
+    uint8_t head;
+    uint8_t count;
+};
+
+#define TXQ_TOTAL_DEPTH (TXQ_DEPTH_IO + TXQ_DEPTH_CONTROL + TXQ_DEPTH_REPORT + TXQ_DEPTH_BULK)
+
+static TxQueueEntry entries[TXQ_TOTAL_DEPTH];
+static TxRing rings[TXQ_CLASS_COUNT] = {
+    {0, TXQ_DEPTH_IO, 0, 0},
+    {TXQ_DEPTH_IO, TXQ_DEPTH_CONTROL, 0, 0},
+    {TXQ_DEPTH_IO + TXQ_DEPTH_CONTROL, TXQ_DEPTH_REPORT, 0, 0},
+    {TXQ_DEPTH_IO + TXQ_DEPTH_CONTROL + TXQ_DEPTH_REPORT, TXQ_DEPTH_BULK, 0, 0}
+};
+
+static uint8_t inFlight = 0;
+static bool dispatching = false;            // One task feeds the driver at a time
+static uint32_t lastTxActivityMs = 0;       // Last send or completion
+static TxQueueStats stats;
+
+// Frames are queued from both tasks and released from the send callback
+static portMUX_TYPE txMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t maxInFlight() {
+    uint8_t configured = DATA_MGR.getNodeConfig().txInFlight;
+    if (configured == 0) return TXQ_DEFAULT_IN_FLIGHT;
+    return configured > TXQ_MAX_IN_FLIGHT ? TXQ_MAX_IN_FLIGHT : configured;
+}
+
+static TxQueueEntry& headEntry(const TxRing& ring) {
+    return entries[ring.base + ring.head];
+}
+
+static void popHead(TxRing& ring) {
+    ring.head = (ring.head + 1) % ring.capacity;
+    ring.count--;
+}
+
+// ============================================================================
+// DISPATCH
+// ============================================================================
+
+/**
+ * @brief Hand queued frames to the driver until the in-flight limit is reached.
+ *
+ * The head frame is sent from its slot without copying: submitters only
+ * write free slots, and only the dispatcher pops.
+ */
+static void dispatch() {
+    portENTER_CRITICAL(&txMux);
+    if (dispatching) {
+        portEXIT_CRITICAL(&txMux);
+        return;
+    }
+    dispatching = true;
+    portEXIT_CRITICAL(&txMux);
+
+    uint8_t limit = maxInFlight();
+    for (;;) {
+        portENTER_CRITICAL(&txMux);
+        int cls = -1;
+        if (inFlight < limit) {
+            for (int i = 0; i < TXQ_CLASS_COUNT; i++) {
+                if (rings[i].count > 0) {
+                    cls = i;
+                    break;
+                }
+            }
+        }
+        if (cls < 0) {
+            dispatching = false;
+            portEXIT_CRITICAL(&txMux);
+            return;
+        }
+        TxRing& ring = rings[cls];
+        TxQueueEntry& entry = headEntry(ring);
+        inFlight++;
+        portEXIT_CRITICAL(&txMux);
+
+        esp_err_t result = esp_now_send(entry.mac, entry.data, entry.len);
+        uint32_t now = millis();
+
+        portENTER_CRITICAL(&txMux);
+        lastTxActivityMs = now;
+        if (result == ESP_ERR_ESPNOW_NO_MEM) {
+            // Driver queue full: keep the frame and retry on the next completion
+            inFlight--;
+            stats.noMemRetries++;
+            dispatching = false;
+            portEXIT_CRITICAL(&txMux);
+            return;
+        }
+        TxQueueClassStats& classStats = stats.classes[cls];
+        if (result == ESP_OK) {
+            uint32_t waitMs = now - entry.queuedMs;
+            classStats.sent++;
+            classStats.totalWaitMs += waitMs;
+            if (waitMs > classStats.maxWaitMs) classStats.maxWaitMs = waitMs;
+        } else {
+            inFlight--;
+            classStats.errors++;
+        }
+        popHead(ring);
+        portEXIT_CRITICAL(&txMux);
+
+        if (result != ESP_OK) {
+            txqLog("esp_now_send failed: " + String(result), 2);
+        }
+    }
+}
+
+// ============================================================================
+// QUEUE API
+// ============================================================================
+
+uint8_t txQueueClassify(const uint8_t* data, size_t len) {
+    if (len < TREE_MSG_OVERHEAD) {
+        return TXQ_CLASS_BULK;
+    }
+    switch (((const TreeMessageHeader*)data)->msg_type) {
+        case MSG_DISTRIBUTED_IO_UPDATE:
+        case MSG_DISTRIBUTED_IO_SLICE:
+        case MSG_COMMAND_SET_OUTPUTS:
+            return TXQ_CLASS_IO;
+        case MSG_ACKNOWLEDGEMENT:
+        case MSG_NACK:
+        case MSG_REQUEST_BIT_INDEX:
+        case MSG_ASSIGN_BIT_INDEX:
+        case MSG_CONFIRM_BIT_INDEX:
+        case MSG_LINK_BEACON:
+        case MSG_ADOPT_REQUEST:
+        case MSG_ADOPT_ACK:
+            return TXQ_CLASS_CONTROL;
+        case MSG_DEVICE_DATA_REPORT:
+        case MSG_DEVICE_DATA_BATCH:
+            return TXQ_CLASS_REPORT;
+        default:
+            return TXQ_CLASS_BULK;
+    }
+}
+
+bool txQueueSubmit(const uint8_t* peerAddr, const uint8_t* data, size_t len) {
+#if ENABLE_TX_QUEUE
+    if (len == 0 || len > TXQ_MAX_FRAME) {
+        txqLog("Frame length " + String(len) + " not sendable", 1);
+        return false;
+    }
+    uint8_t cls = txQueueClassify(data, len);
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&txMux);
+    TxRing& ring = rings[cls];
+    TxQueueClassStats& classStats = stats.classes[cls];
+    if (ring.count >= ring.capacity) {
+        classStats.drops++;
+        portEXIT_CRITICAL(&txMux);
+        txqLog("Queue " + String(txQueueClassName(cls)) + " full, frame dropped", 2);
+        return false;
+    }
+    TxQueueEntry& entry = entries[ring.base + (ring.head + ring.count) % ring.capacity];
+    memcpy(entry.mac, peerAddr, 6);
+    memcpy(entry.data, data, len);
+    entry.len = len;
+    entry.queuedMs = now;
+    ring.count++;
+    classStats.queued++;
+    if (ring.count > classStats.peakDepth) classStats.peakDepth = ring.count;
+    portEXIT_CRITICAL(&txMux);
+
+    dispatch();
+    return true;
+#else
+    esp_err_t result = esp_now_send(peerAddr, data, len);
+    if (result != ESP_OK) {
+        txqLog("Failed to queue data: " + String(result), 2);
+    }
+    return result == ESP_OK;
+#endif
+}
+
+void txQueueOnSent() {
+#if ENABLE_TX_QUEUE
+    portENTER_CRITICAL(&txMux);
+    if (inFlight > 0) inFlight--;
+    lastTxActivityMs = millis();
+    portEXIT_CRITICAL(&txMux);
+
+    dispatch();
+#endif
+}
+
+void txQueueUpdate() {
+#if ENABLE_TX_QUEUE
+    uint32_t now = millis();
+    portENTER_CRITICAL(&txMux);
+    if (inFlight > 0 && now - lastTxActivityMs > TXQ_SEND_TIMEOUT_MS) {
+        // Callbacks for frames sent outside the queue can leave the count off
+        inFlight = 0;
+        stats.timeouts++;
+    }
+    portEXIT_CRITICAL(&txMux);
+
+    dispatch();
+#endif
+}
+
+bool txQueueIdle() {
+#if ENABLE_TX_QUEUE
+    portENTER_CRITICAL(&txMux);
+    bool idle = inFlight == 0;
+    for (int i = 0; i < TXQ_CLASS_COUNT && idle; i++) {
+        idle = rings[i].count == 0;
+    }
+    portEXIT_CRITICAL(&txMux);
+    return idle;
+#else
+    return true;
+#endif
+}
+
+// ============================================================================
+// STATISTICS
+// ============================================================================
+
+void txQueueGetStats(TxQueueStats& out) {
+    portENTER_CRITICAL(&txMux);
+    out = stats;
+    out.inFlight = inFlight;
+    for (int i = 0; i < TXQ_CLASS_COUNT; i++) {
+        out.classes[i].depth = rings[i].count;
+        out.classes[i].capacity = rings[i].capacity;
+    }
+    portEXIT_CRITICAL(&txMux);
+    out.maxInFlight = maxInFlight();
+}
+
+void txQueueResetStats() {
+    portENTER_CRITICAL(&txMux);
+    stats = TxQueueStats();
+    portEXIT_CRITICAL(&txMux);
+}
+
+const char* txQueueClassName(uint8_t cls) {
+    switch (cls) {
+        case TXQ_CLASS_IO:      return "io";
+        case TXQ_CLASS_CONTROL: return "control";
+        case TXQ_CLASS_REPORT:  return "report";
+        case TXQ_CLASS_BULK:    return "bulk";
+        default:                return "unknown";
+    }
+}
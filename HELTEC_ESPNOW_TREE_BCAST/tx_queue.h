@@ -0,0 +1,113 @@
+#ifndef TX_QUEUE_H
+#define TX_QUEUE_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+
+// ============================================================================
+// TX QUEUE CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Prioritized transmit queue in front of esp_now_send.
+ *
+ * Every frame sent by espnowSendData() is copied into one of four bounded
+ * queues, chosen by its message type:
+ *
+ * 1. TXQ_CLASS_IO      - shared I/O updates and output commands
+ * 2. TXQ_CLASS_CONTROL - ACK/NACK, link beacons, adoption, bit allocation
+ * 3. TXQ_CLASS_REPORT  - device data reports
+ * 4. TXQ_CLASS_BULK    - bulk transfers, OTA and anything unrecognized
+ *
+ * At most the configured number of frames (NodeConfigRecord::txInFlight) are
+ * handed to the driver at once. The send callback (onDataSent) releases the
+ * next frame, always from the highest non-empty class, so control traffic
+ * never waits behind diagnostics. A frame the driver refuses with
+ * ESP_ERR_ESPNOW_NO_MEM stays at the head of its queue and is retried on the
+ * next completion instead of being lost.
+ *
+ * A full queue drops the new frame. Depth, drops and queueing delay are
+ * counted per class (TXQ command).
+ *
+ * Set to 0 to send every frame straight to esp_now_send as before.
+ */
+#define ENABLE_TX_QUEUE 1
+
+#define TXQ_DEFAULT_IN_FLIGHT   2       // Used when NodeConfigRecord::txInFlight is 0
+#define TXQ_MAX_IN_FLIGHT       8
+#define TXQ_DEPTH_IO            8
+#define TXQ_DEPTH_CONTROL       8
+#if NODE_ROLE_HAS_ROOT
+#define TXQ_DEPTH_REPORT        6
+#define TXQ_DEPTH_BULK          6
+#else
+#define TXQ_DEPTH_REPORT        10      // Router and leaf builds have no device table (NODE_ROLE)
+#define TXQ_DEPTH_BULK          8
+#endif
+#define TXQ_MAX_FRAME           250     // ESP_NOW_MAX_DATA_LEN
+#define TXQ_SEND_TIMEOUT_MS     100     // In-flight frame with no send callback is written off
+
+enum TxQueueClass : uint8_t {
+    TXQ_CLASS_IO      = 0,
+    TXQ_CLASS_CONTROL = 1,
+    TXQ_CLASS_REPORT  = 2,
+    TXQ_CLASS_BULK    = 3,
+    TXQ_CLASS_COUNT
+};
+
+struct TxQueueClassStats {
+    uint8_t  depth = 0;
+    uint8_t  capacity = 0;
+    uint8_t  peakDepth = 0;
+    uint32_t queued = 0;
+    uint32_t sent = 0;
+    uint32_t drops = 0;             // Queue full
+    uint32_t errors = 0;            // Refused by esp_now_send, other than NO_MEM
+    uint32_t maxWaitMs = 0;         // Queue entry to esp_now_send
+    uint32_t totalWaitMs = 0;       // Divide by sent for the average
+};
+
+struct TxQueueStats {
+    uint8_t  inFlight = 0;
+    uint8_t  maxInFlight = TXQ_DEFAULT_IN_FLIGHT;
+    uint32_t noMemRetries = 0;      // ESP_ERR_ESPNOW_NO_MEM, frame kept for retry
+    uint32_t timeouts = 0;          // Send callbacks that never came
+    TxQueueClassStats classes[TXQ_CLASS_COUNT];
+};
+
+// ============================================================================
+// TX QUEUE API
+// ============================================================================
+
+/**
+ * @brief Queue a frame and start sending if a slot is free.
+ *        Safe from the loop task and the Wi-Fi task.
+ * @return false if the frame was dropped (queue full or too long)
+ */
+bool txQueueSubmit(const uint8_t* peerAddr, const uint8_t* data, size_t len);
+
+/**
+ * @brief Send completion hook; releases the next frame. Called from onDataSent.
+ */
+void txQueueOnSent();
+
+/**
+ * @brief Retry after NO_MEM and write off lost callbacks. Call from loop().
+ */
+void txQueueUpdate();
+
+/**
+ * @brief True when nothing is queued or waiting for a send callback
+ */
+bool txQueueIdle();
+
+/**
+ * @brief Priority class of a frame, from its tree message type
+ */
+uint8_t txQueueClassify(const uint8_t* data, size_t len);
+
+void txQueueGetStats(TxQueueStats& out);
+void txQueueResetStats();
+const char* txQueueClassName(uint8_t cls);
+
+#endif // TX_QUEUE_H
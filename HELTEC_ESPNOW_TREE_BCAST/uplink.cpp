@@ -0,0 +1,209 @@
+#include "uplink.h"
+#include "debug.h"
+#include "espnow_wrapper.h"
+
+// Logging macros for the uplink module
+#define MODULE_TITLE       "UPLINK"
+#define MODULE_DEBUG_LEVEL 1
+#define uplinkLog(msg, lvl) DEBUG_LOG(msg, MODULE_TITLE, lvl, MODULE_DEBUG_LEVEL)
+
+// ============================================================================
+// LINK STATE
+// ============================================================================
+
+static UplinkInfo links[UPLINK_CACHE_SIZE];
+static uint8_t staleMACs[UPLINK_CACHE_SIZE][6];     // Replaced MACs whose peers are still registered
+static uint8_t staleCount = 0;
+static UplinkStatus counters;                       // Only the frame/fallback counters are used
+
+// Frames and send callbacks arrive on the Wi-Fi task, selection also runs in loop()
+static portMUX_TYPE uplinkMux = portMUX_INITIALIZER_UNLOCKED;
+
+static int findByHIDLocked(uint16_t hid) {
+    for (int i = 0; i < UPLINK_CACHE_SIZE; i++) {
+        if (links[i].hid == hid) return i;
+    }
+    return -1;
+}
+
+static int findByMACLocked(const uint8_t* mac) {
+    for (int i = 0; i < UPLINK_CACHE_SIZE; i++) {
+        if (links[i].hid != 0 && memcmp(links[i].mac, mac, 6) == 0) return i;
+    }
+    return -1;
+}
+
+// Known, recently heard, and not in fallback after missed ACKs
+static bool usableLocked(uint16_t hid, uint32_t now) {
+    int slot = findByHIDLocked(hid);
+    return slot >= 0 && now - links[slot].lastHeardMs <= UPLINK_STALE_MS &&
+           (int32_t)(now - links[slot].fallbackUntilMs) >= 0;
+}
+
+static void queueStalePeerLocked(const uint8_t* mac) {
+    if (findByMACLocked(mac) < 0 && staleCount < UPLINK_CACHE_SIZE) {
+        memcpy(staleMACs[staleCount++], mac, 6);
+    }
+}
+
+// ============================================================================
+// RECEIVE AND SEND HOOKS (Wi-Fi task)
+// ============================================================================
+
+void uplinkNoteFrame(const TreeMessageHeader* header, const uint8_t* senderMAC) {
+#if ENABLE_UNICAST_UPLINK
+    uint16_t hid = header->broadcaster_hid;
+    if (!senderMAC || hid == UNCONFIGURED_HID ||
+        (hid != DATA_MGR.getUpstreamHID() && hid != DATA_MGR.getParentHID())) {
+        return;
+    }
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&uplinkMux);
+    int slot = findByHIDLocked(hid);
+    if (slot < 0) {
+        int oldest = 0;
+        for (int i = 0; i < UPLINK_CACHE_SIZE; i++) {
+            if (links[i].hid == 0) {
+                oldest = i;
+                break;
+            }
+            if ((int32_t)(links[i].lastHeardMs - links[oldest].lastHeardMs) < 0) oldest = i;
+        }
+        slot = oldest;
+        UplinkInfo old = links[slot];
+        memset(&links[slot], 0, sizeof(UplinkInfo));
+        if (old.hid != 0) {
+            queueStalePeerLocked(old.mac);
+        }
+        links[slot].hid = hid;
+        memcpy(links[slot].mac, senderMAC, 6);
+        links[slot].learnedMs = now;
+        links[slot].fallbackUntilMs = now;
+    } else if (memcmp(links[slot].mac, senderMAC, 6) != 0) {
+        // Same HID on another radio (node replaced): start over on the new MAC
+        uint8_t oldMAC[6];
+        memcpy(oldMAC, links[slot].mac, 6);
+        memcpy(links[slot].mac, senderMAC, 6);
+        queueStalePeerLocked(oldMAC);
+        links[slot].learnedMs = now;
+        links[slot].consecutiveFailures = 0;
+        links[slot].fallbackUntilMs = now;
+        counters.macChanges++;
+    }
+    links[slot].lastHeardMs = now;
+    portEXIT_CRITICAL(&uplinkMux);
+#endif
+}
+
+void uplinkOnSent(const uint8_t* mac, bool delivered) {
+#if ENABLE_UNICAST_UPLINK
+    if (!mac || memcmp(mac, broadcastMAC, 6) == 0) {
+        return;                             // Broadcasts are never acknowledged
+    }
+    uint32_t now = millis();
+    bool fellBack = false;
+    uint16_t hid = 0;
+
+    portENTER_CRITICAL(&uplinkMux);
+    int slot = findByMACLocked(mac);
+    if (slot >= 0) {
+        UplinkInfo& link = links[slot];
+        if (delivered) {
+            link.acked++;
+            link.consecutiveFailures = 0;
+        } else {
+            link.failed++;
+            if (++link.consecutiveFailures >= UPLINK_MAX_FAILURES) {
+                link.consecutiveFailures = 0;
+                link.fallbackUntilMs = now + UPLINK_FALLBACK_MS;
+                counters.fallbacks++;
+                fellBack = true;
+                hid = link.hid;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&uplinkMux);
+
+    if (fellBack) {
+        uplinkLog("No ACKs from " + DATA_MGR.formatHID(hid) + ", broadcasting upstream for a while", 2);
+    }
+#endif
+}
+
+bool uplinkSelectMAC(uint8_t* mac) {
+    memcpy(mac, broadcastMAC, 6);
+#if ENABLE_UNICAST_UPLINK
+    uint16_t hid = DATA_MGR.getUpstreamHID();
+    if (DATA_MGR.isRoot() || hid == UNCONFIGURED_HID) {
+        return false;
+    }
+    uint32_t now = millis();
+    bool unicast = false;
+
+    portENTER_CRITICAL(&uplinkMux);
+    if (usableLocked(hid, now)) {
+        memcpy(mac, links[findByHIDLocked(hid)].mac, 6);
+        unicast = true;
+        counters.unicastFrames++;
+    } else {
+        counters.broadcastFrames++;
+    }
+    portEXIT_CRITICAL(&uplinkMux);
+    return unicast;
+#else
+    return false;
+#endif
+}
+
+// ============================================================================
+// LOOP TASK AND QUERIES
+// ============================================================================
+
+void uplinkUpdate() {
+#if ENABLE_UNICAST_UPLINK
+    uint8_t pending[UPLINK_CACHE_SIZE][6];
+    uint8_t count;
+    portENTER_CRITICAL(&uplinkMux);
+    count = staleCount;
+    memcpy(pending, staleMACs, sizeof(pending));
+    staleCount = 0;
+    portEXIT_CRITICAL(&uplinkMux);
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (esp_now_is_peer_exist(pending[i])) {
+            esp_now_del_peer(pending[i]);
+            uplinkLog("Removed peer " + macToString(pending[i]), 3);
+        }
+    }
+#endif
+}
+
+void uplinkGetStatus(UplinkStatus& out) {
+    out.upstreamHID = DATA_MGR.isRoot() ? UNCONFIGURED_HID : DATA_MGR.getUpstreamHID();
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&uplinkMux);
+    out.unicast = ENABLE_UNICAST_UPLINK && out.upstreamHID != UNCONFIGURED_HID && usableLocked(out.upstreamHID, now);
+    out.unicastFrames = counters.unicastFrames;
+    out.broadcastFrames = counters.broadcastFrames;
+    out.fallbacks = counters.fallbacks;
+    out.macChanges = counters.macChanges;
+    out.linkCount = 0;
+    for (const UplinkInfo& link : links) {
+        if (link.hid != 0) {
+            out.links[out.linkCount++] = link;
+        }
+    }
+    portEXIT_CRITICAL(&uplinkMux);
+}
+
+void uplinkResetStats() {
+    portENTER_CRITICAL(&uplinkMux);
+    counters = UplinkStatus();
+    for (UplinkInfo& link : links) {
+        link.acked = 0;
+        link.failed = 0;
+    }
+    portEXIT_CRITICAL(&uplinkMux);
+}
@@ -0,0 +1,95 @@
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include <Arduino.h>
+#include "DataManager.h"
+
+// ============================================================================
+// UNICAST UPLINK CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief Upstream frames sent unicast to the parent's MAC.
+ *
+ * Data reports and upstream forwards used to go to the broadcast MAC. The
+ * radio doesn't acknowledge or retry broadcast frames, and every neighbour
+ * has to receive and discard them. Sent unicast, a frame is acknowledged by
+ * the parent's radio and retried by the MAC layer.
+ *
+ * A node learns its upstream node's MAC from any frame whose broadcaster_hid
+ * is getUpstreamHID(). That is the parent, or the foster while failed over
+ * (parent_failover.h). A few MACs are cached by HID, so switching back
+ * to the parent doesn't need to learn the MAC again.
+ *
+ * Upstream frames go out by broadcast when:
+ * - the MAC is not known yet;
+ * - nothing was heard from the upstream node for UPLINK_STALE_MS;
+ * - UPLINK_MAX_FAILURES unicast frames in a row went unacknowledged. The
+ *   link then stays on broadcast for UPLINK_FALLBACK_MS.
+ *
+ * The send callback counts acknowledged and failed frames for each link
+ * (UPLINK command).
+ *
+ * Set to 0 to keep sending everything by broadcast.
+ */
+#define ENABLE_UNICAST_UPLINK 1
+
+#define UPLINK_CACHE_SIZE       3
+#define UPLINK_STALE_MS         10000
+#define UPLINK_MAX_FAILURES     3       // Unacknowledged frames in a row before falling back
+#define UPLINK_FALLBACK_MS      5000
+
+struct UplinkInfo {
+    uint16_t hid;               // 0 = unused
+    uint8_t  mac[6];
+    uint32_t learnedMs;
+    uint32_t lastHeardMs;
+    uint32_t acked;             // Unicast frames acknowledged by this node's radio
+    uint32_t failed;            // Unicast frames sent without an ACK
+    uint8_t  consecutiveFailures;
+    uint32_t fallbackUntilMs;   // Broadcast until then after repeated failures
+};
+
+struct UplinkStatus {
+    uint16_t upstreamHID = 0;
+    bool     unicast = false;           // Next upstream frame goes unicast
+    uint32_t unicastFrames = 0;         // Upstream frames sent unicast
+    uint32_t broadcastFrames = 0;       // Upstream frames sent by broadcast (no usable MAC)
+    uint32_t fallbacks = 0;             // Links put on broadcast after repeated failures
+    uint32_t macChanges = 0;            // A known HID showed up with a new MAC
+    uint8_t  linkCount = 0;
+    UplinkInfo links[UPLINK_CACHE_SIZE];
+};
+
+// ============================================================================
+// UNICAST UPLINK API
+// ============================================================================
+
+/**
+ * @brief Receive path hook: learn the upstream node's MAC.
+ *        Called from the Wi-Fi task for every valid tree frame.
+ */
+void uplinkNoteFrame(const TreeMessageHeader* header, const uint8_t* senderMAC);
+
+/**
+ * @brief Send completion hook; counts delivery for unicast uplink frames.
+ *        Called from onDataSent.
+ */
+void uplinkOnSent(const uint8_t* mac, bool delivered);
+
+/**
+ * @brief Next-hop MAC for an upstream frame: the upstream node, or broadcast
+ * @param mac Receives 6 bytes
+ * @return true if unicast
+ */
+bool uplinkSelectMAC(uint8_t* mac);
+
+/**
+ * @brief Remove peers for MACs that were replaced. Call from loop().
+ */
+void uplinkUpdate();
+
+void uplinkGetStatus(UplinkStatus& out);
+void uplinkResetStats();
+
+#endif // UPLINK_H
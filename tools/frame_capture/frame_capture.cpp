@@ -0,0 +1,625 @@
+/**
+ * frame_capture - record, decode and replay raw ESP-NOW tree captures
+ *
+ * Host-side companion to frame_capture.h in the firmware. Talks to a node
+ * over its USB serial port using the binary protocol (serial_protocol.h).
+ *
+ *   frame_capture record <port> <out.pcap> [seconds]
+ *       Subscribe to SMSG_TOPIC_CAPTURE and write every captured frame to a
+ *       pcap file (LINKTYPE_USER0, see below). Stops after [seconds] or Ctrl-C.
+ *
+ *   frame_capture decode <in.pcap>
+ *       Print a timeline: time, sender MAC, RSSI, routing verdict and the
+ *       decoded TreeMessageHeader/payload of every frame.
+ *
+ *   frame_capture replay <in.pcap> <port>
+ *       Put a bench node in replay mode (radio TX muted), feed it every
+ *       captured frame in order and compare its routing verdicts with the
+ *       recorded ones. Configure the bench node with the HID of the node the
+ *       capture came from first, or the verdicts will differ by design.
+ *
+ * Build (Linux/macOS, no dependencies):
+ *   g++ -std=c++17 -O2 -Wall -o frame_capture frame_capture.cpp
+ *
+ * pcap records carry an 8-byte pseudo-header before the tree frame:
+ *   src_mac[6] | rssi (int8) | verdict (CaptureVerdict | 0x80 if injected)
+ * Timestamps are the node's esp_timer clock (time since boot).
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+// ============================================================================
+// PROTOCOL CONSTANTS (mirror serial_protocol.h, frame_capture.h, DataManager.h)
+// ============================================================================
+
+static const uint8_t SERIAL_PROTOCOL_VERSION = 2;
+static const uint8_t SMSG_HELLO = 0x01;
+static const uint8_t SMSG_STATUS = 0x02;
+static const uint8_t SMSG_SUBSCRIBE = 0x07;
+static const uint8_t SMSG_REPLAY_FRAME = 0x09;
+static const uint8_t SMSG_PUSH = 0x40;
+static const uint8_t SMSG_ERROR = 0x7F;
+static const uint8_t SMSG_RESPONSE_FLAG = 0x80;
+static const uint8_t SMSG_TOPIC_CAPTURE = 0x10;
+static const size_t SERIAL_FRAME_MAX_PAYLOAD = 200;
+
+static const size_t CAPTURED_FRAME_HEADER_SIZE = 14;
+static const uint8_t CAPTURE_FLAG_INJECTED = 0x80;
+
+static const uint8_t TREE_MSG_SOH = 0xAA;
+static const uint8_t TREE_MSG_EOT = 0x55;
+static const size_t TREE_MSG_HEADER_SIZE = 10;
+static const size_t TREE_MSG_OVERHEAD = 12;
+
+static const uint32_t PCAP_LINKTYPE_USER0 = 147;
+static const size_t PSEUDO_HEADER_SIZE = 8;
+
+struct Capture {
+    uint64_t timeUs;            // Unwrapped node time
+    uint8_t srcMAC[6];
+    int8_t rssi;
+    uint8_t verdict;
+    uint32_t origLen;           // Frame length on the air
+    std::vector<uint8_t> data;  // May be shorter than origLen (snaplen)
+};
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+// ============================================================================
+// FRAMING (same algorithms as serial_protocol.cpp)
+// ============================================================================
+
+static uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static std::vector<uint8_t> cobsEncode(const std::vector<uint8_t>& in) {
+    std::vector<uint8_t> out(1);
+    size_t codeIndex = 0;
+    uint8_t code = 1;
+    for (uint8_t b : in) {
+        if (b != 0) {
+            out.push_back(b);
+            code++;
+        }
+        if (b == 0 || code == 0xFF) {
+            out[codeIndex] = code;
+            codeIndex = out.size();
+            out.push_back(0);
+            code = 1;
+        }
+    }
+    out[codeIndex] = code;
+    return out;
+}
+
+static bool cobsDecode(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < in.size()) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > in.size()) {
+            return false;
+        }
+        for (uint8_t j = 1; j < code; j++) {
+            out.push_back(in[i++]);
+        }
+        if (code != 0xFF && i < in.size()) {
+            out.push_back(0);
+        }
+    }
+    return true;
+}
+
+static std::vector<uint8_t> buildFrame(uint8_t msgId, uint8_t seq, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> raw = { msgId, seq };
+    raw.insert(raw.end(), payload.begin(), payload.end());
+    uint16_t crc = crc16(raw.data(), raw.size());
+    raw.push_back(crc & 0xFF);
+    raw.push_back(crc >> 8);
+
+    std::vector<uint8_t> frame = { 0x00 };
+    std::vector<uint8_t> encoded = cobsEncode(raw);
+    frame.insert(frame.end(), encoded.begin(), encoded.end());
+    frame.push_back(0x00);
+    return frame;
+}
+
+static uint16_t le16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ============================================================================
+// SERIAL PORT
+// ============================================================================
+
+class SerialLink {
+public:
+    explicit SerialLink(const char* path) {
+        fd = open(path, O_RDWR | O_NOCTTY);
+        if (fd < 0) {
+            return;
+        }
+        termios tty;
+        tcgetattr(fd, &tty);
+        cfmakeraw(&tty);
+        cfsetspeed(&tty, B115200);   // Ignored by USB CDC, needed for UART bridges
+        tty.c_cc[VMIN] = 0;
+        tty.c_cc[VTIME] = 1;         // read() returns after 100 ms without data
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+
+    ~SerialLink() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    void writeBytes(const std::vector<uint8_t>& bytes) {
+        size_t done = 0;
+        while (done < bytes.size()) {
+            ssize_t n = write(fd, bytes.data() + done, bytes.size() - done);
+            if (n <= 0 && errno != EINTR) return;
+            if (n > 0) done += n;
+        }
+    }
+
+    void writeText(const std::string& text) {
+        writeBytes(std::vector<uint8_t>(text.begin(), text.end()));
+    }
+
+    uint8_t sendRequest(uint8_t msgId, const std::vector<uint8_t>& payload) {
+        seq++;
+        writeBytes(buildFrame(msgId, seq, payload));
+        return seq;
+    }
+
+    /**
+     * Read until one binary frame is decoded. Text between frames (logs,
+     * text responses) is skipped.
+     * @return false on timeout
+     */
+    bool readFrame(uint8_t& msgId, uint8_t& frameSeq, std::vector<uint8_t>& payload, int timeoutMs) {
+        long waitedMs = 0;
+        while (waitedMs < timeoutMs && !stopRequested) {
+            uint8_t buf[256];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                waitedMs += 100;
+                continue;
+            }
+            pending.insert(pending.end(), buf, buf + n);
+            if (extractFrame(msgId, frameSeq, payload)) {
+                return true;
+            }
+        }
+        return extractFrame(msgId, frameSeq, payload);
+    }
+
+private:
+    bool extractFrame(uint8_t& msgId, uint8_t& frameSeq, std::vector<uint8_t>& payload) {
+        while (true) {
+            // Frames are 0x00 | body | 0x00; anything before the opener is text
+            size_t open = 0;
+            while (open < pending.size() && pending[open] != 0x00) open++;
+            size_t close = open + 1;
+            while (close < pending.size() && pending[close] != 0x00) close++;
+            if (close >= pending.size()) {
+                pending.erase(pending.begin(), pending.begin() + open);
+                return false;
+            }
+            if (close == open + 1) {
+                // Back-to-back delimiters: the second one opens the next frame
+                pending.erase(pending.begin(), pending.begin() + open + 1);
+                continue;
+            }
+
+            std::vector<uint8_t> body(pending.begin() + open + 1, pending.begin() + close);
+            pending.erase(pending.begin(), pending.begin() + close + 1);
+
+            std::vector<uint8_t> raw;
+            if (!cobsDecode(body, raw) || raw.size() < 4) continue;
+            if (crc16(raw.data(), raw.size() - 2) != le16(&raw[raw.size() - 2])) continue;
+            msgId = raw[0];
+            frameSeq = raw[1];
+            payload.assign(raw.begin() + 2, raw.end() - 2);
+            return true;
+        }
+    }
+
+    int fd = -1;
+    uint8_t seq = 0;
+    std::vector<uint8_t> pending;
+};
+
+static bool negotiate(SerialLink& link) {
+    uint8_t seq = link.sendRequest(SMSG_HELLO, { SERIAL_PROTOCOL_VERSION });
+    uint8_t msgId, frameSeq;
+    std::vector<uint8_t> payload;
+    while (link.readFrame(msgId, frameSeq, payload, 1500)) {
+        if (msgId == (SMSG_HELLO | SMSG_RESPONSE_FLAG) && frameSeq == seq) {
+            return true;
+        }
+    }
+    fprintf(stderr, "Device did not answer HELLO (binary protocol not available?)\n");
+    return false;
+}
+
+// ============================================================================
+// PCAP FILES
+// ============================================================================
+
+static void writePcapHeader(FILE* f) {
+    uint32_t header[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, PCAP_LINKTYPE_USER0 };
+    fwrite(header, sizeof(header), 1, f);
+}
+
+static void writePcapRecord(FILE* f, const Capture& c) {
+    uint32_t record[4] = {
+        (uint32_t)(c.timeUs / 1000000), (uint32_t)(c.timeUs % 1000000),
+        (uint32_t)(PSEUDO_HEADER_SIZE + c.data.size()), (uint32_t)(PSEUDO_HEADER_SIZE + c.origLen)
+    };
+    fwrite(record, sizeof(record), 1, f);
+    fwrite(c.srcMAC, 6, 1, f);
+    fputc((uint8_t)c.rssi, f);
+    fputc(c.verdict, f);
+    fwrite(c.data.data(), c.data.size(), 1, f);
+}
+
+static bool readPcap(const char* path, std::vector<Capture>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    uint32_t header[6];
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != 0xA1B2C3D4 || header[5] != PCAP_LINKTYPE_USER0) {
+        fprintf(stderr, "%s is not a frame_capture pcap file\n", path);
+        fclose(f);
+        return false;
+    }
+    uint32_t record[4];
+    while (fread(record, sizeof(record), 1, f) == 1) {
+        std::vector<uint8_t> bytes(record[2]);
+        if (record[2] < PSEUDO_HEADER_SIZE || fread(bytes.data(), 1, bytes.size(), f) != bytes.size()) break;
+        Capture c;
+        c.timeUs = (uint64_t)record[0] * 1000000 + record[1];
+        memcpy(c.srcMAC, bytes.data(), 6);
+        c.rssi = (int8_t)bytes[6];
+        c.verdict = bytes[7];
+        c.origLen = record[3] - PSEUDO_HEADER_SIZE;
+        c.data.assign(bytes.begin() + PSEUDO_HEADER_SIZE, bytes.end());
+        out.push_back(c);
+    }
+    fclose(f);
+    return true;
+}
+
+// ============================================================================
+// DECODING
+// ============================================================================
+
+static const char* verdictName(uint8_t verdict) {
+    switch (verdict & ~CAPTURE_FLAG_INJECTED) {
+        case 0x00: return "rejected";
+        case 0x01: return "processed";
+        case 0x02: return "fwd-up";
+        case 0x03: return "fwd-down";
+        default:   return "?";
+    }
+}
+
+static const char* messageTypeName(uint8_t type) {
+    switch (type) {
+        case 0x01: return "DATA_REPORT";
+        case 0x02: return "ACK";
+        case 0x03: return "NACK";
+        case 0x04: return "DATA_BATCH";
+        case 0x10: return "SET_OUTPUTS";
+        case 0x22: return "IO_UPDATE";
+        case 0x23: return "IO_SLICE";
+        case 0x30: return "REQ_BIT";
+        case 0x31: return "ASSIGN_BIT";
+        case 0x32: return "CONFIRM_BIT";
+        default:   return "UNKNOWN";
+    }
+}
+
+static std::string describeFrame(const Capture& c) {
+    char text[256];
+    const std::vector<uint8_t>& d = c.data;
+    if (d.size() < TREE_MSG_HEADER_SIZE || d[0] != TREE_MSG_SOH) {
+        snprintf(text, sizeof(text), "non-tree frame (%u bytes)", c.origLen);
+        return text;
+    }
+
+    uint8_t frameLen = d[1];
+    uint16_t dest = le16(&d[2]);
+    uint16_t src = le16(&d[4]);
+    uint16_t broadcaster = le16(&d[6]);
+    uint8_t type = d[8];
+    uint8_t seq = d[9];
+    std::string result;
+    snprintf(text, sizeof(text), "%-11s seq=%-3u src=%-5u dst=%-5u via=%-5u len=%u",
+             messageTypeName(type), seq, src, dest, broadcaster, frameLen);
+    result = text;
+
+    if (d.size() < c.origLen) {
+        return result + " [truncated]";
+    }
+    if (frameLen != c.origLen || c.origLen < TREE_MSG_OVERHEAD || d[c.origLen - 1] != TREE_MSG_EOT) {
+        return result + " [bad framing]";
+    }
+    size_t payloadLen = c.origLen - TREE_MSG_OVERHEAD;
+    if (crc8(&d[1], TREE_MSG_HEADER_SIZE - 1 + payloadLen) != d[c.origLen - 2]) {
+        return result + " [bad crc]";
+    }
+
+    const uint8_t* payload = &d[TREE_MSG_HEADER_SIZE];
+    if (type == 0x01 && payloadLen >= 16) {
+        snprintf(text, sizeof(text), " | in=0x%04X out=0x%04X mem=0x%04X a=%u,%u bit=%u",
+                 le16(payload), le16(payload + 2), le16(payload + 4), le16(payload + 6), le16(payload + 8),
+                 payload[14]);
+        result += text;
+        if (payloadLen >= 20) {
+            // TopologyTrailer: child bitmap, fostered count, forwarded frames/s
+            snprintf(text, sizeof(text), " children=0x%03X fostered=%u fwd=%u/s",
+                     le16(payload + 16), payload[18], payload[19]);
+            result += text;
+        }
+    } else if (type == 0x04 && payloadLen >= 1) {
+        // Count, then 23-byte records: HID, flags, DeviceSpecificData, TopologyTrailer
+        snprintf(text, sizeof(text), " | %u reports:", payload[0]);
+        result += text;
+        for (size_t off = 1; off + 23 <= payloadLen; off += 23) {
+            snprintf(text, sizeof(text), " %u(in=0x%04X)", le16(payload + off), le16(payload + off + 3));
+            result += text;
+        }
+    } else if (type == 0x22 && payloadLen >= 12) {
+        // 16 I then 16 Q planes of one word; older firmware sends 3 I (12 bytes) or 3 I + 3 Q (24).
+        // Planes past the last non-zero one are not printed.
+        size_t planes = payloadLen >= 128 ? 16 : 3;
+        size_t shown = 3;
+        for (size_t i = 3; i < planes; i++) {
+            if (le32(payload + i * 4) || le32(payload + (planes + i) * 4)) shown = i + 1;
+        }
+        result += " | I=";
+        for (size_t i = 0; i < shown; i++) {
+            snprintf(text, sizeof(text), "%s%08X", i ? "," : "", le32(payload + i * 4));
+            result += text;
+        }
+        if (payloadLen >= planes * 8) {
+            result += " Q=";
+            for (size_t i = 0; i < shown; i++) {
+                snprintf(text, sizeof(text), "%s%08X", i ? "," : "", le32(payload + (planes + i) * 4));
+                result += text;
+            }
+        }
+    } else if (type == 0x23 && payloadLen >= 1) {
+        // Count, then 5-byte entries: bit index, I states, Q states (bit n = plane n)
+        snprintf(text, sizeof(text), " | %u bits:", payload[0]);
+        result += text;
+        for (size_t off = 1; off + 5 <= payloadLen; off += 5) {
+            snprintf(text, sizeof(text), " %u(I=%X,Q=%X)", payload[off], le16(payload + off + 1), le16(payload + off + 3));
+            result += text;
+        }
+    }
+    return result;
+}
+
+static void printCapture(const Capture& c, uint64_t startUs) {
+    printf("%10.6f  %02X:%02X:%02X:%02X:%02X:%02X  %4d dBm  %-9s%s  %s\n",
+           (c.timeUs - startUs) / 1e6,
+           c.srcMAC[0], c.srcMAC[1], c.srcMAC[2], c.srcMAC[3], c.srcMAC[4], c.srcMAC[5],
+           c.rssi, verdictName(c.verdict), (c.verdict & CAPTURE_FLAG_INJECTED) ? "*" : " ",
+           describeFrame(c).c_str());
+}
+
+// ============================================================================
+// COMMANDS
+// ============================================================================
+
+static int commandRecord(const char* port, const char* outPath, int seconds) {
+    SerialLink link(port);
+    if (!link.isOpen()) {
+        fprintf(stderr, "Cannot open %s: %s\n", port, strerror(errno));
+        return 1;
+    }
+    if (!negotiate(link)) return 1;
+
+    FILE* out = fopen(outPath, "wb");
+    if (!out) {
+        fprintf(stderr, "Cannot create %s\n", outPath);
+        return 1;
+    }
+    writePcapHeader(out);
+
+    // topics, statsHz, minIntervalMs
+    link.sendRequest(SMSG_SUBSCRIBE, { SMSG_TOPIC_CAPTURE, 0, 0, 0 });
+    fprintf(stderr, "Recording from %s to %s (Ctrl-C to stop)\n", port, outPath);
+
+    time_t started = time(nullptr);
+    time_t lastRenew = started;
+    uint32_t frames = 0;
+    uint32_t lostPushes = 0;
+    int lastPushSeq = -1;
+    uint32_t lastTimeUs = 0;
+    uint64_t wrapOffset = 0;
+
+    while (!stopRequested && (seconds <= 0 || time(nullptr) - started < seconds)) {
+        // Any request renews the subscription lease; HELLO would cancel it
+        if (time(nullptr) - lastRenew >= 2) {
+            link.sendRequest(SMSG_STATUS, {});
+            lastRenew = time(nullptr);
+        }
+
+        uint8_t msgId, frameSeq;
+        std::vector<uint8_t> payload;
+        if (!link.readFrame(msgId, frameSeq, payload, 500)) continue;
+        if (msgId != SMSG_PUSH || payload.size() < 4 || payload[2] != SMSG_TOPIC_CAPTURE) continue;
+
+        uint16_t pushSeq = le16(&payload[0]);
+        if (lastPushSeq >= 0 && pushSeq != ((lastPushSeq + 1) & 0xFFFF)) {
+            lostPushes += (pushSeq - lastPushSeq - 1) & 0xFFFF;
+        }
+        lastPushSeq = pushSeq;
+
+        size_t offset = 4;
+        for (uint8_t i = 0; i < payload[3] && offset + CAPTURED_FRAME_HEADER_SIZE <= payload.size(); i++) {
+            const uint8_t* r = &payload[offset];
+            uint8_t capLen = r[13];
+            if (offset + CAPTURED_FRAME_HEADER_SIZE + capLen > payload.size()) break;
+
+            // esp_timer microseconds wrap every ~71 minutes in 32 bits
+            uint32_t timeUs = le32(r);
+            if (frames > 0 && timeUs < lastTimeUs) wrapOffset += 1ULL << 32;
+            lastTimeUs = timeUs;
+
+            Capture c;
+            c.timeUs = wrapOffset + timeUs;
+            memcpy(c.srcMAC, r + 4, 6);
+            c.rssi = (int8_t)r[10];
+            c.verdict = r[11];
+            c.origLen = r[12];
+            c.data.assign(r + CAPTURED_FRAME_HEADER_SIZE, r + CAPTURED_FRAME_HEADER_SIZE + capLen);
+            writePcapRecord(out, c);
+            offset += CAPTURED_FRAME_HEADER_SIZE + capLen;
+            frames++;
+        }
+        fflush(out);
+    }
+
+    link.sendRequest(SMSG_SUBSCRIBE, { 0, 0, 0, 0 });
+    fclose(out);
+    fprintf(stderr, "%u frames recorded, %u push frames lost on the serial link\n", frames, lostPushes);
+    fprintf(stderr, "Capture stays enabled on the node; send \"CAPTURE OFF\" to stop it\n");
+    return 0;
+}
+
+static int commandDecode(const char* inPath) {
+    std::vector<Capture> captures;
+    if (!readPcap(inPath, captures)) return 1;
+    if (captures.empty()) {
+        printf("No frames in %s\n", inPath);
+        return 0;
+    }
+    printf("%10s  %-17s  %8s  %-10s %s\n", "time (s)", "sender", "rssi", "verdict", "frame");
+    for (const Capture& c : captures) {
+        printCapture(c, captures.front().timeUs);
+    }
+    printf("%zu frames over %.3f s (* = injected by soak/replay)\n", captures.size(),
+           (captures.back().timeUs - captures.front().timeUs) / 1e6);
+    return 0;
+}
+
+static int commandReplay(const char* inPath, const char* port) {
+    std::vector<Capture> captures;
+    if (!readPcap(inPath, captures)) return 1;
+
+    SerialLink link(port);
+    if (!link.isOpen()) {
+        fprintf(stderr, "Cannot open %s: %s\n", port, strerror(errno));
+        return 1;
+    }
+    link.writeText("REPLAY BEGIN\n");
+    if (!negotiate(link)) return 1;
+
+    uint32_t replayed = 0, skipped = 0, mismatches = 0;
+    for (const Capture& c : captures) {
+        if (stopRequested) break;
+        if (c.data.size() < c.origLen || 8 + c.data.size() > SERIAL_FRAME_MAX_PAYLOAD) {
+            skipped++;   // Truncated by the snaplen, can't be replayed faithfully
+            continue;
+        }
+        std::vector<uint8_t> payload(c.srcMAC, c.srcMAC + 6);
+        payload.push_back((uint8_t)c.rssi);
+        payload.push_back(0);
+        payload.insert(payload.end(), c.data.begin(), c.data.end());
+        uint8_t seq = link.sendRequest(SMSG_REPLAY_FRAME, payload);
+
+        uint8_t msgId = 0, frameSeq = 0;
+        std::vector<uint8_t> response;
+        bool answered = false;
+        while (link.readFrame(msgId, frameSeq, response, 1000)) {
+            if (frameSeq == seq && (msgId & SMSG_RESPONSE_FLAG)) {
+                answered = true;
+                break;
+            }
+        }
+        if (!answered || msgId == (SMSG_ERROR | SMSG_RESPONSE_FLAG) || response.size() < 4) {
+            fprintf(stderr, "Replay rejected by the device (was REPLAY BEGIN accepted?)\n");
+            break;
+        }
+
+        replayed++;
+        uint8_t recorded = c.verdict & ~CAPTURE_FLAG_INJECTED;
+        if (response[0] != recorded) {
+            mismatches++;
+            printf("MISMATCH recorded=%-9s replayed=%-9s ", verdictName(recorded), verdictName(response[0]));
+            printCapture(c, captures.front().timeUs);
+        }
+    }
+
+    link.writeText("REPLAY END\n");
+    printf("%u frames replayed, %u skipped (truncated), %u verdict mismatches\n", replayed, skipped, mismatches);
+    return mismatches ? 2 : 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: frame_capture record <port> <out.pcap> [seconds]\n"
+            "       frame_capture decode <in.pcap>\n"
+            "       frame_capture replay <in.pcap> <port>\n");
+}
+
+int main(int argc, char** argv) {
+    signal(SIGINT, onSignal);
+    if (argc >= 4 && strcmp(argv[1], "record") == 0) {
+        return commandRecord(argv[2], argv[3], argc >= 5 ? atoi(argv[4]) : 0);
+    }
+    if (argc >= 3 && strcmp(argv[1], "decode") == 0) {
+        return commandDecode(argv[2]);
+    }
+    if (argc >= 4 && strcmp(argv[1], "replay") == 0) {
+        return commandReplay(argv[2], argv[3]);
+    }
+    usage();
+    return 1;
+}
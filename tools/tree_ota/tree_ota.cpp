@@ -0,0 +1,495 @@
+/**
+ * tree_ota - upload a firmware image for distribution down the ESP-NOW tree
+ *
+ * Host-side companion to tree_ota.h in the firmware. Talks to a node (usually
+ * the root) over its USB serial port using the binary protocol
+ * (serial_protocol.h).
+ *
+ *   tree_ota push <port> <firmware.bin>
+ *       Send the image with its SHA-256, then follow the node while it
+ *       verifies the image and serves it to its children. Exits once the
+ *       node restarts into the new image or reports a failure.
+ *
+ *   tree_ota status <port>
+ *       Print the node's distribution state once.
+ *
+ * Build (Linux/macOS, no dependencies):
+ *   g++ -std=c++17 -O2 -Wall -o tree_ota tree_ota.cpp
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+// ============================================================================
+// PROTOCOL CONSTANTS (mirror serial_protocol.h and tree_ota.h)
+// ============================================================================
+
+static const uint8_t SERIAL_PROTOCOL_VERSION = 2;
+static const uint8_t SMSG_HELLO = 0x01;
+static const uint8_t SMSG_OTA_BEGIN = 0x0A;
+static const uint8_t SMSG_OTA_DATA = 0x0B;
+static const uint8_t SMSG_OTA_STATUS = 0x0C;
+static const uint8_t SMSG_ERROR = 0x7F;
+static const uint8_t SMSG_RESPONSE_FLAG = 0x80;
+static const uint8_t SMSG_ERR_STATE = 0x06;
+static const size_t SERIAL_OTA_MAX_CHUNK = 192;
+
+static const uint8_t OTA_STATE_IDLE = 0;
+static const uint8_t OTA_STATE_RECEIVING = 1;
+static const uint8_t OTA_STATE_DONE = 4;
+static const uint8_t OTA_STATE_FAILED = 5;
+
+static const char* const OTA_STATE_NAMES[] = { "idle", "receiving", "verifying", "serving", "done", "failed" };
+static const char* const OTA_ERROR_NAMES[] = { "none", "no OTA partition", "image too large", "flash error",
+                                               "SHA-256 mismatch", "image rejected", "aborted" };
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+// ============================================================================
+// FRAMING (same algorithms as serial_protocol.cpp)
+// ============================================================================
+
+static uint16_t crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static std::vector<uint8_t> cobsEncode(const std::vector<uint8_t>& in) {
+    std::vector<uint8_t> out(1);
+    size_t codeIndex = 0;
+    uint8_t code = 1;
+    for (uint8_t b : in) {
+        if (b != 0) {
+            out.push_back(b);
+            code++;
+        }
+        if (b == 0 || code == 0xFF) {
+            out[codeIndex] = code;
+            codeIndex = out.size();
+            out.push_back(0);
+            code = 1;
+        }
+    }
+    out[codeIndex] = code;
+    return out;
+}
+
+static bool cobsDecode(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < in.size()) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > in.size()) {
+            return false;
+        }
+        for (uint8_t j = 1; j < code; j++) {
+            out.push_back(in[i++]);
+        }
+        if (code != 0xFF && i < in.size()) {
+            out.push_back(0);
+        }
+    }
+    return true;
+}
+
+static std::vector<uint8_t> buildFrame(uint8_t msgId, uint8_t seq, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> raw = { msgId, seq };
+    raw.insert(raw.end(), payload.begin(), payload.end());
+    uint16_t crc = crc16(raw.data(), raw.size());
+    raw.push_back(crc & 0xFF);
+    raw.push_back(crc >> 8);
+
+    std::vector<uint8_t> frame = { 0x00 };
+    std::vector<uint8_t> encoded = cobsEncode(raw);
+    frame.insert(frame.end(), encoded.begin(), encoded.end());
+    frame.push_back(0x00);
+    return frame;
+}
+
+static uint16_t le16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ============================================================================
+// SERIAL PORT
+// ============================================================================
+
+class SerialLink {
+public:
+    explicit SerialLink(const char* path) {
+        fd = open(path, O_RDWR | O_NOCTTY);
+        if (fd < 0) {
+            return;
+        }
+        termios tty;
+        tcgetattr(fd, &tty);
+        cfmakeraw(&tty);
+        cfsetspeed(&tty, B115200);   // Ignored by USB CDC, needed for UART bridges
+        tty.c_cc[VMIN] = 0;
+        tty.c_cc[VTIME] = 1;         // read() returns after 100 ms without data
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+
+    ~SerialLink() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    void writeBytes(const std::vector<uint8_t>& bytes) {
+        size_t done = 0;
+        while (done < bytes.size()) {
+            ssize_t n = write(fd, bytes.data() + done, bytes.size() - done);
+            if (n <= 0 && errno != EINTR) return;
+            if (n > 0) done += n;
+        }
+    }
+
+    void writeText(const std::string& text) {
+        writeBytes(std::vector<uint8_t>(text.begin(), text.end()));
+    }
+
+    uint8_t sendRequest(uint8_t msgId, const std::vector<uint8_t>& payload) {
+        seq++;
+        writeBytes(buildFrame(msgId, seq, payload));
+        return seq;
+    }
+
+    /**
+     * Read until one binary frame is decoded. Text between frames (logs,
+     * text responses) is skipped.
+     * @return false on timeout
+     */
+    bool readFrame(uint8_t& msgId, uint8_t& frameSeq, std::vector<uint8_t>& payload, int timeoutMs) {
+        long waitedMs = 0;
+        while (waitedMs < timeoutMs && !stopRequested) {
+            uint8_t buf[256];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                waitedMs += 100;
+                continue;
+            }
+            pending.insert(pending.end(), buf, buf + n);
+            if (extractFrame(msgId, frameSeq, payload)) {
+                return true;
+            }
+        }
+        return extractFrame(msgId, frameSeq, payload);
+    }
+
+private:
+    bool extractFrame(uint8_t& msgId, uint8_t& frameSeq, std::vector<uint8_t>& payload) {
+        while (true) {
+            // Frames are 0x00 | body | 0x00; anything before the opener is text
+            size_t open = 0;
+            while (open < pending.size() && pending[open] != 0x00) open++;
+            size_t close = open + 1;
+            while (close < pending.size() && pending[close] != 0x00) close++;
+            if (close >= pending.size()) {
+                pending.erase(pending.begin(), pending.begin() + open);
+                return false;
+            }
+            if (close == open + 1) {
+                // Back-to-back delimiters: the second one opens the next frame
+                pending.erase(pending.begin(), pending.begin() + open + 1);
+                continue;
+            }
+
+            std::vector<uint8_t> body(pending.begin() + open + 1, pending.begin() + close);
+            pending.erase(pending.begin(), pending.begin() + close + 1);
+
+            std::vector<uint8_t> raw;
+            if (!cobsDecode(body, raw) || raw.size() < 4) continue;
+            if (crc16(raw.data(), raw.size() - 2) != le16(&raw[raw.size() - 2])) continue;
+            msgId = raw[0];
+            frameSeq = raw[1];
+            payload.assign(raw.begin() + 2, raw.end() - 2);
+            return true;
+        }
+    }
+
+    int fd = -1;
+    uint8_t seq = 0;
+    std::vector<uint8_t> pending;
+};
+
+static bool negotiate(SerialLink& link) {
+    uint8_t seq = link.sendRequest(SMSG_HELLO, { SERIAL_PROTOCOL_VERSION });
+    uint8_t msgId, frameSeq;
+    std::vector<uint8_t> payload;
+    while (link.readFrame(msgId, frameSeq, payload, 1500)) {
+        if (msgId == (SMSG_HELLO | SMSG_RESPONSE_FLAG) && frameSeq == seq) {
+            return true;
+        }
+    }
+    fprintf(stderr, "Device did not answer HELLO (binary protocol not available?)\n");
+    return false;
+}
+
+// ============================================================================
+// SHA-256 (FIPS 180-4)
+// ============================================================================
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void sha256Block(uint32_t h[8], const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | (block[i * 4 + 1] << 16) | (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+static std::vector<uint8_t> sha256(const std::vector<uint8_t>& data) {
+    uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    std::vector<uint8_t> padded = data;
+    uint64_t bits = (uint64_t)data.size() * 8;
+    padded.push_back(0x80);
+    while (padded.size() % 64 != 56) padded.push_back(0);
+    for (int i = 7; i >= 0; i--) padded.push_back((uint8_t)(bits >> (i * 8)));
+    for (size_t i = 0; i < padded.size(); i += 64) {
+        sha256Block(h, &padded[i]);
+    }
+    std::vector<uint8_t> digest;
+    for (uint32_t word : h) {
+        for (int i = 3; i >= 0; i--) digest.push_back((uint8_t)(word >> (i * 8)));
+    }
+    return digest;
+}
+
+// ============================================================================
+// COMMANDS
+// ============================================================================
+
+struct OtaStatus {
+    uint8_t state = 0;
+    uint8_t error = 0;
+    uint8_t childrenActive = 0;
+    uint8_t childrenVerified = 0;
+    uint32_t imageSize = 0;
+    uint32_t bytesReceived = 0;
+    uint16_t blockCount = 0;
+    uint16_t blocksSent = 0;
+    uint16_t repairsPending = 0;
+};
+
+/**
+ * Send one request and wait for its response.
+ * @return 1 = status filled in, 0 = SMSG_ERROR (code in errorCode), -1 = no answer
+ */
+static int request(SerialLink& link, uint8_t msgId, const std::vector<uint8_t>& payload, OtaStatus& status,
+                   uint8_t& errorCode) {
+    uint8_t seq = link.sendRequest(msgId, payload);
+    uint8_t rxId = 0, frameSeq = 0;
+    std::vector<uint8_t> response;
+    while (link.readFrame(rxId, frameSeq, response, 2000)) {
+        if (frameSeq != seq || !(rxId & SMSG_RESPONSE_FLAG)) continue;
+        if (rxId == (SMSG_ERROR | SMSG_RESPONSE_FLAG)) {
+            errorCode = response.size() >= 2 ? response[1] : 0;
+            return 0;
+        }
+        if (response.size() < 18) return -1;
+        status.state = response[0];
+        status.error = response[1];
+        status.childrenActive = response[2];
+        status.childrenVerified = response[3];
+        status.imageSize = le32(&response[4]);
+        status.bytesReceived = le32(&response[8]);
+        status.blockCount = le16(&response[12]);
+        status.blocksSent = le16(&response[14]);
+        status.repairsPending = le16(&response[16]);
+        return 1;
+    }
+    return -1;
+}
+
+static void printStatus(const OtaStatus& s) {
+    printf("%-9s received %u/%u bytes, sent %u/%u blocks, %u repairs pending, children %u active / %u verified",
+           s.state <= OTA_STATE_FAILED ? OTA_STATE_NAMES[s.state] : "?", s.bytesReceived, s.imageSize,
+           s.blocksSent, s.blockCount, s.repairsPending, s.childrenActive, s.childrenVerified);
+    if (s.state == OTA_STATE_FAILED && s.error < sizeof(OTA_ERROR_NAMES) / sizeof(OTA_ERROR_NAMES[0])) {
+        printf(" (%s)", OTA_ERROR_NAMES[s.error]);
+    }
+    printf("\n");
+}
+
+static int commandPush(const char* port, const char* imagePath) {
+    FILE* f = fopen(imagePath, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", imagePath);
+        return 1;
+    }
+    std::vector<uint8_t> image;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) image.insert(image.end(), buf, buf + n);
+    fclose(f);
+    if (image.empty()) {
+        fprintf(stderr, "%s is empty\n", imagePath);
+        return 1;
+    }
+
+    SerialLink link(port);
+    if (!link.isOpen()) {
+        fprintf(stderr, "Cannot open %s: %s\n", port, strerror(errno));
+        return 1;
+    }
+    if (!negotiate(link)) return 1;
+
+    std::vector<uint8_t> digest = sha256(image);
+    std::vector<uint8_t> begin = { (uint8_t)image.size(), (uint8_t)(image.size() >> 8),
+                                   (uint8_t)(image.size() >> 16), (uint8_t)(image.size() >> 24) };
+    begin.insert(begin.end(), digest.begin(), digest.end());
+
+    OtaStatus status;
+    uint8_t errorCode = 0;
+    if (request(link, SMSG_OTA_BEGIN, begin, status, errorCode) != 1) {
+        fprintf(stderr, "Node refused the image (does it fit the OTA partition?)\n");
+        return 1;
+    }
+    printf("Uploading %zu bytes, SHA-256 ", image.size());
+    for (uint8_t b : digest) printf("%02x", b);
+    printf("\n");
+
+    uint32_t offset = 0;
+    int lastPercent = -1;
+    int silent = 0;
+    while (offset < image.size() && !stopRequested) {
+        size_t len = image.size() - offset < SERIAL_OTA_MAX_CHUNK ? image.size() - offset : SERIAL_OTA_MAX_CHUNK;
+        std::vector<uint8_t> chunk = { (uint8_t)offset, (uint8_t)(offset >> 8), (uint8_t)(offset >> 16),
+                                       (uint8_t)(offset >> 24) };
+        chunk.insert(chunk.end(), image.begin() + offset, image.begin() + offset + len);
+
+        int result = request(link, SMSG_OTA_DATA, chunk, status, errorCode);
+        if (result == 0 && errorCode == SMSG_ERR_STATE) {
+            // Out of step (lost response): resume from what the node has
+            if (request(link, SMSG_OTA_STATUS, {}, status, errorCode) != 1 || status.state != OTA_STATE_RECEIVING) {
+                fprintf(stderr, "\nUpload rejected by the node\n");
+                return 1;
+            }
+            offset = status.bytesReceived;
+            continue;
+        }
+        if (result != 1) {
+            if (++silent >= 5) {
+                fprintf(stderr, "\nNode stopped answering\n");
+                return 1;
+            }
+            continue;   // Resend; if the chunk did land, the node answers ERR_STATE and we resync
+        }
+        silent = 0;
+        offset = status.bytesReceived;
+        int percent = (int)((uint64_t)offset * 100 / image.size());
+        if (percent != lastPercent) {
+            printf("\rUploaded %3d%%", percent);
+            fflush(stdout);
+            lastPercent = percent;
+        }
+    }
+    printf("\n");
+    if (stopRequested) return 1;
+
+    // Follow verification and distribution until the node restarts
+    while (!stopRequested) {
+        sleep(2);
+        int result = request(link, SMSG_OTA_STATUS, {}, status, errorCode);
+        if (result != 1) {
+            printf("Node stopped answering: restarting into the new image\n");
+            return 0;
+        }
+        printStatus(status);
+        if (status.state == OTA_STATE_FAILED || status.state == OTA_STATE_IDLE) {
+            return 2;
+        }
+        if (status.state == OTA_STATE_DONE) {
+            printf("Distribution finished\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int commandStatus(const char* port) {
+    SerialLink link(port);
+    if (!link.isOpen()) {
+        fprintf(stderr, "Cannot open %s: %s\n", port, strerror(errno));
+        return 1;
+    }
+    if (!negotiate(link)) return 1;
+
+    OtaStatus status;
+    uint8_t errorCode = 0;
+    if (request(link, SMSG_OTA_STATUS, {}, status, errorCode) != 1) {
+        fprintf(stderr, "No OTA status from the node (firmware without tree OTA?)\n");
+        return 1;
+    }
+    printStatus(status);
+    return 0;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: tree_ota push <port> <firmware.bin>\n"
+            "       tree_ota status <port>\n");
+}
+
+int main(int argc, char** argv) {
+    signal(SIGINT, onSignal);
+    if (argc >= 4 && strcmp(argv[1], "push") == 0) {
+        return commandPush(argv[2], argv[3]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "status") == 0) {
+        return commandStatus(argv[2]);
+    }
+    usage();
+    return 1;
+}
@@ -3,6 +3,257 @@
  * Focused on device communication and configuration management
  */
 
+// ============================================================================
+// BINARY SERIAL PROTOCOL HELPERS
+// ============================================================================
+// Mirrors serial_protocol.h: frames are 0x00 | COBS(id, seq, payload, crc16) | 0x00
+
+const SERIAL_PROTOCOL_VERSION = 2;
+
+const SERIAL_MSG = {
+    HELLO: 0x01,
+    STATUS: 0x02,
+    NETWORK_STATUS: 0x03,
+    NETWORK_STATS: 0x04,
+    IO_STATUS: 0x05,
+    DEVICE_DATA: 0x06,
+    SUBSCRIBE: 0x07,
+    PUSH: 0x40,
+    ERROR: 0x7F,
+    RESPONSE_FLAG: 0x80
+};
+
+const SERIAL_ERR = {
+    UNKNOWN_MSG: 0x01,
+    NOT_NEGOTIATED: 0x02,
+    BAD_LENGTH: 0x03,
+    BAD_CRC: 0x04,
+    VERSION: 0x05
+};
+
+const SERIAL_TOPIC = {
+    IO: 0x01,
+    SHARED: 0x02,
+    STATS: 0x04,
+    DEVICES: 0x08
+};
+
+const SERIAL_INPUT_COUNT = 16;  // MAX_INPUTS (SHARED_DATA_WORDS is 1)
+
+function serialCrc16(bytes) {
+    let crc = 0xFFFF;
+    for (const b of bytes) {
+        crc ^= b << 8;
+        for (let bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF;
+        }
+    }
+    return crc;
+}
+
+function cobsEncode(bytes) {
+    const out = [0];
+    let codeIndex = 0;
+    let code = 1;
+    for (const b of bytes) {
+        if (b === 0) {
+            out[codeIndex] = code;
+            codeIndex = out.length;
+            out.push(0);
+            code = 1;
+            continue;
+        }
+        out.push(b);
+        if (++code === 0xFF) {
+            out[codeIndex] = code;
+            codeIndex = out.length;
+            out.push(0);
+            code = 1;
+        }
+    }
+    out[codeIndex] = code;
+    return out;
+}
+
+function cobsDecode(bytes) {
+    const out = [];
+    let i = 0;
+    while (i < bytes.length) {
+        const code = bytes[i++];
+        if (code === 0 || i + code - 1 > bytes.length) {
+            return null;
+        }
+        for (let j = 1; j < code; j++) {
+            out.push(bytes[i++]);
+        }
+        if (code !== 0xFF && i < bytes.length) {
+            out.push(0);
+        }
+    }
+    return Uint8Array.from(out);
+}
+
+function buildSerialFrame(msgId, seq, payload) {
+    const raw = new Uint8Array(payload.length + 4);
+    raw[0] = msgId;
+    raw[1] = seq;
+    raw.set(payload, 2);
+    const crc = serialCrc16(raw.subarray(0, payload.length + 2));
+    raw[payload.length + 2] = crc & 0xFF;
+    raw[payload.length + 3] = crc >> 8;
+    return Uint8Array.from([0, ...cobsEncode(raw), 0]);
+}
+
+function parseSerialFrame(encoded) {
+    const raw = cobsDecode(encoded);
+    if (!raw || raw.length < 4) {
+        return null;
+    }
+    const crc = raw[raw.length - 2] | (raw[raw.length - 1] << 8);
+    if (serialCrc16(raw.subarray(0, raw.length - 2)) !== crc) {
+        return null;
+    }
+    return { msgId: raw[0], seq: raw[1], payload: raw.subarray(2, raw.length - 2) };
+}
+
+function formatMacBytes(view, offset) {
+    const parts = [];
+    let nonZero = false;
+    for (let i = 0; i < 6; i++) {
+        const b = view.getUint8(offset + i);
+        nonZero = nonZero || b !== 0;
+        parts.push(b.toString(16).padStart(2, '0').toUpperCase());
+    }
+    return nonZero ? parts.join(':') : 'None';
+}
+
+// Decoders return the same shape as the matching JSON_RESPONSE so the panels
+// don't care which channel the data came from
+
+function decodeNetworkStatus(view) {
+    const flags = view.getUint8(7);
+    const isConfigured = (flags & 0x02) !== 0;
+    return {
+        hid: view.getUint16(0, true),
+        parent_hid: view.getUint16(2, true),
+        bit_index: view.getUint8(4),
+        tree_depth: view.getUint8(5),
+        child_count: view.getUint8(6),
+        is_root: (flags & 0x01) !== 0,
+        is_configured: isConfigured,
+        configuration_status: isConfigured ? 'Configured' : 'Unconfigured'
+    };
+}
+
+function decodeNetworkStats(view) {
+    return {
+        messages_sent: view.getUint32(0, true),
+        messages_received: view.getUint32(4, true),
+        messages_forwarded: view.getUint32(8, true),
+        messages_ignored: view.getUint32(12, true),
+        security_violations: view.getUint32(16, true),
+        last_message_time: view.getUint32(20, true),
+        last_sender_mac: formatMacBytes(view, 24),
+        signal_strength: view.getInt8(30)
+    };
+}
+
+function decodeIOStatus(view) {
+    const inputCount = SERIAL_INPUT_COUNT;
+    const words = (view.byteLength - 22) / (2 * 4 * inputCount);
+    const myBits = view.getUint32(6, true);
+    const sharedInputs = [];
+    const sharedOutputs = [];
+    const myInputBits = [];
+    const myOutputBits = [];
+    for (let i = 0; i < inputCount; i++) {
+        sharedInputs.push(view.getUint32(22 + i * words * 4, true));
+        sharedOutputs.push(view.getUint32(22 + (inputCount + i) * words * 4, true));
+        myInputBits.push((myBits & (1 << i)) !== 0);
+        myOutputBits.push((myBits & (0x10000 << i)) !== 0);
+    }
+    return {
+        input_states: view.getUint16(0, true),
+        output_states: view.getUint16(2, true),
+        shared_data_single: sharedInputs[0],
+        my_bit_state_single: myInputBits[0],
+        shared_data_array: sharedInputs,
+        my_bit_states_array: myInputBits,
+        shared_output_array: sharedOutputs,
+        my_output_states_array: myOutputBits,
+        input_change_count: view.getUint32(14, true),
+        last_input_change: view.getUint32(18, true)
+    };
+}
+
+function decodeDeviceData(view) {
+    return {
+        uptime: view.getUint32(0, true),
+        memory_states: view.getUint16(6, true),
+        analog_value1: view.getUint16(8, true),
+        analog_value2: view.getUint16(10, true),
+        integer_value1: view.getUint16(12, true),
+        integer_value2: view.getUint16(14, true),
+        sequence_counter: 0
+    };
+}
+
+// Pushes carry only changed fields, in fieldMask bit order; apply them on top
+// of the last full response so the panels still get a complete object
+
+function applyIOPush(state, view, fields) {
+    let offset = 4;
+    if (fields & 0x01) { state.input_states = view.getUint16(offset, true); offset += 2; }
+    if (fields & 0x02) { state.output_states = view.getUint16(offset, true); offset += 2; }
+    if (fields & 0x04) { state.input_change_count = view.getUint32(offset, true); offset += 4; }
+    if (fields & 0x08) { state.last_input_change = view.getUint32(offset, true); offset += 4; }
+}
+
+function applySharedPush(state, view, fields) {
+    let offset = 4;
+    if (fields & 0x01) {
+        offset += 4;   // ioVersion: only used for change detection on the device
+    }
+    if (fields & 0x02) {
+        state.shared_data_array = [];
+        for (let i = 0; i < SERIAL_INPUT_COUNT; i++, offset += 4) {
+            state.shared_data_array.push(view.getUint32(offset, true));
+        }
+        state.shared_data_single = state.shared_data_array[0];
+    }
+    if (fields & 0x04) {
+        state.shared_output_array = [];
+        for (let i = 0; i < SERIAL_INPUT_COUNT; i++, offset += 4) {
+            state.shared_output_array.push(view.getUint32(offset, true));
+        }
+    }
+    if (fields & 0x08) {
+        const myBits = view.getUint32(offset, true);
+        offset += 4;
+        state.my_bit_states_array = [];
+        state.my_output_states_array = [];
+        for (let i = 0; i < SERIAL_INPUT_COUNT; i++) {
+            state.my_bit_states_array.push((myBits & (1 << i)) !== 0);
+            state.my_output_states_array.push((myBits & (0x10000 << i)) !== 0);
+        }
+        state.my_bit_state_single = state.my_bit_states_array[0];
+    }
+}
+
+function applyStatsPush(state, view, fields) {
+    const counters = ['messages_sent', 'messages_received', 'messages_forwarded',
+                      'messages_ignored', 'security_violations', 'last_message_time'];
+    let offset = 4;
+    for (let i = 0; i < counters.length; i++) {
+        if (fields & (1 << i)) {
+            state[counters[i]] = view.getUint32(offset, true);
+            offset += 4;
+        }
+    }
+    if (fields & 0x40) { state.signal_strength = view.getInt8(offset); offset += 1; }
+    if (fields & 0x80) { state.last_sender_mac = formatMacBytes(view, offset); offset += 6; }
+}
+
 class ESP32DeviceManager {
     constructor() {
         // Serial connection
@@ -12,6 +263,17 @@ class ESP32DeviceManager {
         this.serialReader = null;
         this.serialWriter = null;
         
+        // Binary protocol (COBS frames, negotiated with HELLO at connect)
+        this.binaryProtocol = false;
+        this.binaryFrameBytes = null;   // Non-null while inside a 0x00-delimited frame
+        this.binarySeq = 0;
+        this.binaryHelloTimer = null;
+        this.subscribed = false;        // IO/stats arrive as SMSG_PUSH instead of polls
+        this.lastPushSeq = null;
+        this.pushedIOState = {};
+        this.pushedStatsState = {};
+        this.serialTextDecoder = new TextDecoder();
+        
         // Console states
         this.serialLogPaused = false;
         this.serialBuffer = '';
@@ -198,6 +460,10 @@ class ESP32DeviceManager {
             // Start connection monitoring
             this.startConnectionMonitoring();
             
+            // Offer the binary protocol; polling falls back to text commands
+            // until (unless) the device accepts
+            this.negotiateBinaryProtocol();
+            
             // Start monitoring updates
             this.startMonitoringUpdates();
             
@@ -273,6 +539,7 @@ class ESP32DeviceManager {
             }
             
             this.isSerialConnected = false;
+            this.resetBinaryProtocol();
             this.updateSerialConnectionStatus('Disconnected');
             this.log('Serial connection closed successfully', 'info', 'serial');
             
@@ -332,8 +599,6 @@ class ESP32DeviceManager {
         this.log('Starting serial reader...', 'debug', 'debug');
         
         try {
-            const decoder = new TextDecoder();
-            
             this.log('Serial reader started successfully', 'debug', 'debug');
             
             while (this.isSerialConnected) {
@@ -349,22 +614,12 @@ class ESP32DeviceManager {
                     this.lastActivityTime = Date.now();
                     this.updateStatusPanel();
                     
-                    const text = decoder.decode(value, { stream: true });
-                    this.serialBuffer += text;
-                    
                     if (this.debugMode) {
                         this.log(`Raw data received: ${value.length} bytes`, 'debug', 'debug');
                     }
                     
-                    // Process complete lines
-                    const lines = this.serialBuffer.split('\n');
-                    this.serialBuffer = lines.pop(); // Keep incomplete line in buffer
-                    
-                    for (const line of lines) {
-                        if (line.trim()) {
-                            this.handleSerialData(line.trim());
-                        }
-                    }
+                    // Split text lines from binary frames
+                    this.processSerialBytes(value);
                     
                 } catch (readError) {
                     // Don't immediately disconnect on read errors
@@ -625,9 +880,9 @@ class ESP32DeviceManager {
                     label: 'Hierarchical ID (HID)', 
                     default: 0, 
                     min: 1, 
-                    max: 999, 
+                    max: 65534, 
                     required: true,
-                    description: 'Device position in tree structure (1-999)'
+                    description: 'Device position in tree structure (range depends on the firmware address format; the device validates it)'
                 },
                 bit_index: { 
                     type: 'number', 
@@ -704,9 +959,12 @@ class ESP32DeviceManager {
         this.monitoringInterval = setInterval(() => {
             if (this.isSerialConnected) {
                 // Send actual commands to device instead of using simulated data
+                // These polls also renew the device's subscription lease
                 this.requestNetworkStatus();
-                this.requestNetworkStats();
-                this.requestIOStatus();
+                if (!this.subscribed) {
+                    this.requestNetworkStats();
+                    this.requestIOStatus();
+                }
                 this.requestDeviceData();
             }
         }, 2000);
@@ -714,25 +972,212 @@ class ESP32DeviceManager {
 
     requestNetworkStatus() {
         if (this.isSerialConnected) {
-            this.sendSerialData('NETWORK_STATUS\n');
+            if (this.binaryProtocol) {
+                this.sendBinaryRequest(SERIAL_MSG.NETWORK_STATUS);
+            } else {
+                this.sendSerialData('NETWORK_STATUS\n');
+            }
         }
     }
 
     requestNetworkStats() {
         if (this.isSerialConnected) {
-            this.sendSerialData('NETWORK_STATS\n');
+            if (this.binaryProtocol) {
+                this.sendBinaryRequest(SERIAL_MSG.NETWORK_STATS);
+            } else {
+                this.sendSerialData('NETWORK_STATS\n');
+            }
         }
     }
 
     requestIOStatus() {
         if (this.isSerialConnected) {
-            this.sendSerialData('IO_STATUS\n');
+            if (this.binaryProtocol) {
+                this.sendBinaryRequest(SERIAL_MSG.IO_STATUS);
+            } else {
+                this.sendSerialData('IO_STATUS\n');
+            }
         }
     }
 
     requestDeviceData() {
         if (this.isSerialConnected) {
-            this.sendSerialData('DEVICE_DATA\n');
+            if (this.binaryProtocol) {
+                this.sendBinaryRequest(SERIAL_MSG.DEVICE_DATA);
+            } else {
+                this.sendSerialData('DEVICE_DATA\n');
+            }
+        }
+    }
+
+    // ========================================================================
+    // BINARY PROTOCOL (see serial_protocol.h in the firmware)
+    // ========================================================================
+
+    negotiateBinaryProtocol() {
+        this.resetBinaryProtocol();
+        this.sendBinaryRequest(SERIAL_MSG.HELLO, new Uint8Array([SERIAL_PROTOCOL_VERSION]));
+        this.binaryHelloTimer = setTimeout(() => {
+            this.binaryHelloTimer = null;
+            if (!this.binaryProtocol) {
+                this.log('Device did not answer binary HELLO - using text commands', 'info', 'debug');
+            }
+        }, 1500);
+    }
+
+    resetBinaryProtocol() {
+        if (this.binaryHelloTimer) {
+            clearTimeout(this.binaryHelloTimer);
+            this.binaryHelloTimer = null;
+        }
+        this.binaryProtocol = false;
+        this.binaryFrameBytes = null;
+        this.subscribed = false;
+        this.lastPushSeq = null;
+    }
+
+    subscribeTelemetry() {
+        // I/O and shared data as they change (50 ms coalescing), stats at 1 Hz
+        const payload = new Uint8Array(4);
+        const view = new DataView(payload.buffer);
+        view.setUint8(0, SERIAL_TOPIC.IO | SERIAL_TOPIC.SHARED | SERIAL_TOPIC.STATS);
+        view.setUint8(1, 1);
+        view.setUint16(2, 50, true);
+        this.lastPushSeq = null;
+        this.sendBinaryRequest(SERIAL_MSG.SUBSCRIBE, payload);
+    }
+
+    handlePush(view) {
+        const pushSeq = view.getUint16(0, true);
+        const topic = view.getUint8(2);
+        const fields = view.getUint8(3);
+        
+        // A gap means a lost frame: the cached state is stale, ask for a new snapshot
+        if (this.lastPushSeq !== null && pushSeq !== ((this.lastPushSeq + 1) & 0xFFFF)) {
+            this.log(`Push sequence gap (${this.lastPushSeq} -> ${pushSeq}), resubscribing`, 'warning', 'debug');
+            this.subscribeTelemetry();
+            return;
+        }
+        this.lastPushSeq = pushSeq;
+        
+        switch (topic) {
+            case SERIAL_TOPIC.IO:
+                applyIOPush(this.pushedIOState, view, fields);
+                this.updateIOStatusPanelWithRealData(this.pushedIOState);
+                break;
+            case SERIAL_TOPIC.SHARED:
+                applySharedPush(this.pushedIOState, view, fields);
+                this.updateIOStatusPanelWithRealData(this.pushedIOState);
+                break;
+            case SERIAL_TOPIC.STATS:
+                applyStatsPush(this.pushedStatsState, view, fields);
+                this.updateNetworkStatsPanelWithRealData(this.pushedStatsState);
+                break;
+            default:
+                break;
+        }
+    }
+
+    async sendBinaryRequest(msgId, payload = new Uint8Array(0)) {
+        if (!this.isSerialConnected || !this.serialWriter) {
+            return;
+        }
+        this.binarySeq = (this.binarySeq + 1) & 0xFF;
+        try {
+            await this.serialWriter.write(buildSerialFrame(msgId, this.binarySeq, payload));
+        } catch (error) {
+            this.log('Error sending binary request: ' + error.message, 'error', 'serial');
+        }
+    }
+
+    processSerialBytes(bytes) {
+        let textStart = 0;
+        for (let i = 0; i < bytes.length; i++) {
+            const b = bytes[i];
+            if (this.binaryFrameBytes !== null) {
+                if (b !== 0x00) {
+                    this.binaryFrameBytes.push(b);
+                } else if (this.binaryFrameBytes.length > 0) {
+                    this.handleBinaryFrame(Uint8Array.from(this.binaryFrameBytes));
+                    this.binaryFrameBytes = null;
+                }
+                textStart = i + 1;
+            } else if (b === 0x00) {
+                this.appendSerialText(bytes.subarray(textStart, i));
+                this.binaryFrameBytes = [];
+                textStart = i + 1;
+            }
+        }
+        if (this.binaryFrameBytes === null && textStart < bytes.length) {
+            this.appendSerialText(bytes.subarray(textStart));
+        }
+    }
+
+    appendSerialText(bytes) {
+        if (bytes.length === 0) return;
+        this.serialBuffer += this.serialTextDecoder.decode(bytes, { stream: true });
+        
+        // Process complete lines
+        const lines = this.serialBuffer.split('\n');
+        this.serialBuffer = lines.pop(); // Keep incomplete line in buffer
+        
+        for (const line of lines) {
+            if (line.trim()) {
+                this.handleSerialData(line.trim());
+            }
+        }
+    }
+
+    handleBinaryFrame(encoded) {
+        const frame = parseSerialFrame(encoded);
+        if (!frame) {
+            this.log('Dropped malformed binary frame (' + encoded.length + ' bytes)', 'warning', 'debug');
+            return;
+        }
+        
+        const view = new DataView(frame.payload.buffer, frame.payload.byteOffset, frame.payload.byteLength);
+        const msgId = frame.msgId & ~SERIAL_MSG.RESPONSE_FLAG;
+        
+        try {
+            switch (msgId) {
+                case SERIAL_MSG.HELLO:
+                    this.binaryProtocol = true;
+                    this.log(`Binary protocol v${view.getUint8(0)} negotiated`, 'success', 'serial');
+                    if (view.getUint32(4, true) & (1 << SERIAL_MSG.SUBSCRIBE)) {
+                        this.subscribeTelemetry();
+                    }
+                    break;
+                case SERIAL_MSG.SUBSCRIBE:
+                    this.subscribed = view.getUint8(0) !== 0;
+                    this.log(`Subscribed to telemetry pushes (topics 0x${view.getUint8(0).toString(16)})`, 'info', 'debug');
+                    break;
+                case SERIAL_MSG.PUSH:
+                    this.handlePush(view);
+                    break;
+                case SERIAL_MSG.NETWORK_STATUS:
+                    this.updateNetworkStatusPanelWithRealData(decodeNetworkStatus(view));
+                    break;
+                case SERIAL_MSG.NETWORK_STATS:
+                    this.updateNetworkStatsPanelWithRealData(decodeNetworkStats(view));
+                    break;
+                case SERIAL_MSG.IO_STATUS:
+                    this.updateIOStatusPanelWithRealData(decodeIOStatus(view));
+                    break;
+                case SERIAL_MSG.DEVICE_DATA:
+                    this.updateDeviceDataPanelWithRealData(decodeDeviceData(view));
+                    break;
+                case SERIAL_MSG.ERROR:
+                    this.log(`Binary request 0x${view.getUint8(0).toString(16)} failed: error ${view.getUint8(1)}`, 'warning', 'debug');
+                    if (view.getUint8(1) === SERIAL_ERR.NOT_NEGOTIATED) {
+                        this.negotiateBinaryProtocol();
+                    }
+                    break;
+                default:
+                    this.log('Unhandled binary message 0x' + frame.msgId.toString(16), 'debug', 'debug');
+                    break;
+            }
+        } catch (error) {
+            this.log('Error decoding binary message: ' + error.message, 'error', 'debug');
         }
     }
 
@@ -1929,12 +2374,27 @@ class ESP32DeviceManager {
             lastInputChange: jsonData.last_input_change || 'N/A'
         };
         
+        // Nodes have up to 16 inputs and outputs. Show the configured pins
+        // (text IO_STATUS lists them) and every plane in use, at least three.
+        const highestBit = (value) => 32 - Math.clz32(value);
+        let planeCount = 3;
+        [ioData.sharedDataArray, ioData.sharedOutputArray].forEach((planes) => {
+            (planes || []).forEach((word, index) => {
+                if (word) planeCount = Math.max(planeCount, index + 1);
+            });
+        });
+        const inputCount = Array.isArray(jsonData.input_pins) ? jsonData.input_pins.length
+                                                              : Math.max(3, highestBit(ioData.inputStates));
+        const outputCount = Array.isArray(jsonData.output_pins) ? jsonData.output_pins.length
+                                                                : Math.max(3, highestBit(ioData.outputStates));
+        planeCount = Math.max(planeCount, inputCount, outputCount);
+        
         indicator.textContent = 'Connected';
         indicator.className = 'panel-status connected';
         
         // Create input pin display
         const inputPins = [];
-        for (let i = 0; i < 3; i++) {
+        for (let i = 0; i < inputCount; i++) {
             const inputActive = (ioData.inputStates & (1 << i)) !== 0;
             inputPins.push(`
                 <div class="io-pin ${inputActive ? 'active' : 'inactive'}">
@@ -1946,7 +2406,7 @@ class ESP32DeviceManager {
         
         // Create output pin display
         const outputPins = [];
-        for (let i = 0; i < 3; i++) {
+        for (let i = 0; i < outputCount; i++) {
             const outputActive = (ioData.outputStates & (1 << i)) !== 0;
             outputPins.push(`
                 <div class="io-pin ${outputActive ? 'active' : 'inactive'}">
@@ -1965,7 +2425,7 @@ class ESP32DeviceManager {
         // Check if we have the new multi-input format
         if (Array.isArray(ioData.sharedDataArray) && ioData.sharedDataArray.length >= 3) {
             // New multi-input format - Horizontal inputs+outputs per bit, grouped and tiled
-            sharedDataHTML += `<h6>Shared Data Overview (32 bits × 3 inputs × 3 outputs)</h6>`;
+            sharedDataHTML += `<h6>Shared Data Overview (32 bits × ${planeCount} inputs × ${planeCount} outputs)</h6>`;
             sharedDataHTML += `<div class="shared-data-display">`;
             sharedDataHTML += `<div class="shared-data-bits horizontal-overview">`;
             
@@ -1973,19 +2433,19 @@ class ESP32DeviceManager {
                 const isMyBit = bitIndex === deviceBitIndex; // Use actual device bit index
                 sharedDataHTML += `<div class="bit-group ${isMyBit ? 'my-bit-group' : ''}">`;
                 sharedDataHTML += `<div class="bit-group-label">B${bitIndex}</div>`;
-                // Inputs row (row label + 3 cells)
+                // Inputs row (row label + one cell per plane)
                 sharedDataHTML += `<div class="input-group row-i">`;
                 sharedDataHTML += `<div class="row-label">I:</div>`;
-                for (let inputIndex = 0; inputIndex < 3; inputIndex++) {
+                for (let inputIndex = 0; inputIndex < planeCount; inputIndex++) {
                     const inputSharedData = ioData.sharedDataArray[inputIndex] || 0;
                     const bitActive = (inputSharedData & (1 << bitIndex)) !== 0;
                     sharedDataHTML += `<div class="bit-item ${bitActive ? 'active' : 'inactive'} ${isMyBit ? 'my-bit' : ''}">${inputIndex + 1}</div>`;
                 }
                 sharedDataHTML += `</div>`; // Close inputs
-                // Outputs row (row label + 3 cells)
+                // Outputs row (row label + one cell per plane)
                 sharedDataHTML += `<div class="input-group row-q">`;
                 sharedDataHTML += `<div class="row-label">Q:</div>`;
-                for (let outIndex = 0; outIndex < 3; outIndex++) {
+                for (let outIndex = 0; outIndex < planeCount; outIndex++) {
                     const outputSharedData = (ioData.sharedOutputArray && ioData.sharedOutputArray[outIndex]) || 0;
                     const bitActiveQ = (outputSharedData & (1 << bitIndex)) !== 0;
                     sharedDataHTML += `<div class="bit-item ${bitActiveQ ? 'active' : 'inactive'} ${isMyBit ? 'my-bit' : ''}">${outIndex + 1}</div>`;
@@ -1995,7 +2455,7 @@ class ESP32DeviceManager {
             }
             
             sharedDataHTML += `</div>`;
-            sharedDataHTML += `<small class="text-muted">Format per bit: I:[1..3] then Q:[1..3]. Highlighted group (B${deviceBitIndex}) is this device's assigned bit.${!this.isSerialConnected ? ' (Simulated Data)' : ''}</small>`;
+            sharedDataHTML += `<small class="text-muted">Format per bit: I:[1..${planeCount}] then Q:[1..${planeCount}]. Highlighted group (B${deviceBitIndex}) is this device's assigned bit.${!this.isSerialConnected ? ' (Simulated Data)' : ''}</small>`;
             sharedDataHTML += `</div>`;
         } else {
             // Backward compatibility - single input format
@@ -2018,7 +2478,7 @@ class ESP32DeviceManager {
             sharedDataHTML += `</div>`;
         }
         
-        sharedDataHTML += `<small class="text-muted">Format per bit: I1 I2 I3 then Q1 Q2 Q3. Highlighted group (B${deviceBitIndex}) is this device's assigned bit.${!this.isSerialConnected ? ' (Simulated Data)' : ''}</small>`;
+        sharedDataHTML += `<small class="text-muted">Format per bit: I1..I${planeCount} then Q1..Q${planeCount}. Highlighted group (B${deviceBitIndex}) is this device's assigned bit.${!this.isSerialConnected ? ' (Simulated Data)' : ''}</small>`;
         sharedDataHTML += `</div>`;
         
         console.log('📄 Generated shared data HTML length:', sharedDataHTML.length);
@@ -2030,14 +2490,14 @@ class ESP32DeviceManager {
                     <div class="label">Input States</div>
                     <div class="value boolean ${ioData.inputStates > 0 ? 'true' : 'false'}">
                         <i class="fas fa-${ioData.inputStates > 0 ? 'check' : 'times'}"></i>
-                        ${ioData.inputStates} (0b${ioData.inputStates.toString(2).padStart(3, '0')})
+                        ${ioData.inputStates} (0b${ioData.inputStates.toString(2).padStart(inputCount, '0')})
                     </div>
                 </div>
                 <div class="monitoring-item">
                     <div class="label">Output States</div>
                     <div class="value boolean ${ioData.outputStates > 0 ? 'true' : 'false'}">
                         <i class="fas fa-${ioData.outputStates > 0 ? 'check' : 'times'}"></i>
-                        ${ioData.outputStates} (0b${ioData.outputStates.toString(2).padStart(3, '0')})
+                        ${ioData.outputStates} (0b${ioData.outputStates.toString(2).padStart(outputCount, '0')})
                     </div>
                 </div>
                 <div class="monitoring-item">